@@ -7,15 +7,19 @@ LOCAL_CFLAGS     := -Werror -fexceptions -frtti -DDYNAMIC_ES3
 LOCAL_C_INCLUDES += ${LOCAL_PATH}/../oiio/lib/OpenEXR
 LOCAL_C_INCLUDES += ${NDKROOT}/sources/cxx-stl/gnu-libstdc++/4.8/include
 LOCAL_SRC_FILES  := \
+                    AsyncIO.cpp \
                     Base64.cpp \
                     GlesUtil.cpp \
                     Json.cpp \
                     lodepng.cpp \
+                    MappedFile.cpp \
+                    Memory.cpp \
                     TaskMgr.cpp \
                     Thread.cpp \
                     Timer.cpp \
                     TouchUI.cpp \
-                    TriStrip.cpp
+                    TriStrip.cpp \
+                    Watchdog.cpp
 
 LOCAL_EXPORT_C_INCLUDE += ${LOCAL_PATH}
 
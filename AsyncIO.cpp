@@ -0,0 +1,536 @@
+//  Copyright (c) 2013 The 11ers. All rights reserved.
+
+#include "AsyncIO.h"
+
+#include "TaskMgr.h"
+#include "Thread.h"
+#include "Watchdog.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <set>
+#include <unistd.h>
+#include <vector>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define UTIL_IO_URING 1
+#include <linux/io_uring.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+
+using namespace mt;
+
+
+// Blocking read of the request, returning the bytes read or -errno
+static long ReadFile(ReadRequest *request) {
+  int fd = open(request->path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return -errno;
+  size_t done = 0;
+  while (done < request->size) {
+    ssize_t len = pread(fd, request->buffer + done, request->size - done,
+                        request->offset + done);
+    if (len < 0 && errno == EINTR)
+      continue;
+    if (len < 0) {
+      done = size_t(-errno);
+      break;
+    }
+    if (len == 0)                                   // End of file
+      break;
+    done += size_t(len);
+  }
+  close(fd);
+  return long(done);
+}
+
+
+//
+// Thread pool
+//
+
+class PoolReadTask : public Task {
+public:
+  PoolReadTask(AsyncIO *io, ReadRequest *request)
+    : mIO(io), mRequest(request) {}
+  virtual bool operator()() {
+    mRequest->result = ReadFile(mRequest);
+    mIO->Complete(mRequest);
+    return true;
+  }
+  virtual const char *Name() const { return "AsyncIO::Read"; }
+
+private:
+  AsyncIO *mIO;
+  ReadRequest *mRequest;
+};
+
+
+//
+// io_uring
+//
+
+#if UTIL_IO_URING
+
+// Reads open the file, then read it: the open is tagged in user_data
+static const uint64_t kOpenTag = 1;
+static const uint64_t kStopTag = 0;                 // NOP ending the reaper
+static const size_t kMaxReadLen = 1 << 30;          // Per READ, as pread
+static const unsigned kMaxBackoffUs = 1000;         // Ring busy
+
+
+// The kernel is out of resources or its completions are not yet reaped
+static bool IsRingBusy(int error) {
+  return error == EAGAIN || error == EBUSY;
+}
+
+
+class mt::AsyncIORing {
+public:
+  AsyncIORing(AsyncIO *io)
+    : mIO(io), mFd(-1), mSq(MAP_FAILED), mCq(MAP_FAILED), mSqes(MAP_FAILED),
+      mSqSize(0), mCqSize(0), mSqesSize(0), mUnsubmitted(0), mStopped(true) {}
+  ~AsyncIORing();
+
+  bool Init(unsigned entries);
+  bool Submit(ReadRequest *request);                // Open, then read
+  void Reap();                                      // Reaper thread main
+
+private:
+  typedef std::vector<ReadRequest *> RequestVec;
+
+  io_uring_sqe *Push(uint8_t opcode, uint64_t userData);
+  void PushRead(ReadRequest *request);              // Read the rest
+  bool Flush();                                     // Submit pushed SQEs
+  void Retract(int error, RequestVec &doneVec);     // Fail unsubmitted SQEs
+  void Fail(int error, RequestVec &doneVec);        // Fail all in flight
+  bool Supported();                                 // Kernel has our ops
+
+  AsyncIO *mIO;
+  int mFd;                                          // Ring
+  void *mSq, *mCq, *mSqes;                          // Mapped rings
+  size_t mSqSize, mCqSize, mSqesSize;
+  unsigned *mSqHead, *mSqTail, *mSqMask, *mSqArray;
+  unsigned *mCqHead, *mCqTail, *mCqMask;
+  io_uring_cqe *mCqes;
+  Mutex mMutex;                                     // Protect SQ
+  unsigned mUnsubmitted;                            // Pushed SQEs
+  std::set<ReadRequest *> mInFlightSet;             // Submitted, not reaped
+  bool mStopped;                                    // Reaper exited
+  ConditionVariable mStoppedCond;
+};
+
+
+class RingReaper : public Thread {
+public:
+  explicit RingReaper(AsyncIORing *ring) : mRing(ring) {}
+  virtual void Run() {
+    SetName("AsyncIO");
+    mRing->Reap();
+    delete this;                                    // SUICIDE!
+  }
+
+private:
+  AsyncIORing *mRing;
+};
+
+
+static int RingSetup(unsigned entries, io_uring_params *params) {
+  return int(syscall(__NR_io_uring_setup, entries, params));
+}
+
+
+static int RingEnter(int fd, unsigned toSubmit, unsigned minComplete,
+                     unsigned flags) {
+  return int(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags,
+                     NULL, 0));
+}
+
+
+bool AsyncIORing::Init(unsigned entries) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  mFd = RingSetup(entries, &params);
+  if (mFd < 0)
+    return false;
+  if (!Supported())
+    return false;
+
+  mSqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  mCqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single)
+    mSqSize = mCqSize = mSqSize > mCqSize ? mSqSize : mCqSize;
+  mSq = mmap(NULL, mSqSize, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, mFd, IORING_OFF_SQ_RING);
+  if (mSq == MAP_FAILED)
+    return false;
+  if (!single) {
+    mCq = mmap(NULL, mCqSize, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, mFd, IORING_OFF_CQ_RING);
+    if (mCq == MAP_FAILED)
+      return false;
+  }
+  mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+  mSqes = mmap(NULL, mSqesSize, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, mFd, IORING_OFF_SQES);
+  if (mSqes == MAP_FAILED)
+    return false;
+
+  char *sq = (char *)mSq;
+  char *cq = (char *)(single ? mSq : mCq);
+  mSqHead = (unsigned *)(sq + params.sq_off.head);
+  mSqTail = (unsigned *)(sq + params.sq_off.tail);
+  mSqMask = (unsigned *)(sq + params.sq_off.ring_mask);
+  mSqArray = (unsigned *)(sq + params.sq_off.array);
+  mCqHead = (unsigned *)(cq + params.cq_off.head);
+  mCqTail = (unsigned *)(cq + params.cq_off.tail);
+  mCqMask = (unsigned *)(cq + params.cq_off.ring_mask);
+  mCqes = (io_uring_cqe *)(cq + params.cq_off.cqes);
+
+  RingReaper *reaper = new RingReaper(this);
+  mStopped = false;
+  if (!reaper->Init()) {
+    delete reaper;
+    mStopped = true;
+    return false;
+  }
+  return true;
+}
+
+
+// Opening and reading by io_uring needs Linux 5.6
+bool AsyncIORing::Supported() {
+  const size_t size = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+  io_uring_probe *probe = (io_uring_probe *)calloc(1, size);
+  bool ok = probe && syscall(__NR_io_uring_register, mFd,
+                             IORING_REGISTER_PROBE, probe, 256) == 0 &&
+            probe->last_op >= IORING_OP_READ &&
+            (probe->ops[IORING_OP_OPENAT].flags & IO_URING_OP_SUPPORTED) &&
+            (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED);
+  free(probe);
+  return ok;
+}
+
+
+AsyncIORing::~AsyncIORing() {
+  mMutex.Lock();
+  if (!mStopped) {
+    Push(IORING_OP_NOP, kStopTag);
+    Flush();
+    while (!mStopped)
+      mStoppedCond.Wait(mMutex);
+  }
+  mMutex.Unlock();
+  if (mSqes != MAP_FAILED)
+    munmap(mSqes, mSqesSize);
+  if (mCq != MAP_FAILED)
+    munmap(mCq, mCqSize);
+  if (mSq != MAP_FAILED)
+    munmap(mSq, mSqSize);
+  if (mFd >= 0)
+    close(mFd);
+}
+
+
+// Fill the next SQE, with the mutex locked. The SQ is never full, since
+// each read in flight has at most one SQE pushed and not yet submitted.
+io_uring_sqe *AsyncIORing::Push(uint8_t opcode, uint64_t userData) {
+  const unsigned tail = *mSqTail;
+  const unsigned index = tail & *mSqMask;
+  io_uring_sqe *sqe = (io_uring_sqe *)mSqes + index;
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = opcode;
+  sqe->user_data = userData;
+  mSqArray[index] = index;
+  __atomic_store_n(mSqTail, tail + 1, __ATOMIC_RELEASE);
+  ++mUnsubmitted;
+  return sqe;
+}
+
+
+// Read the bytes of the request after those in result, up to its size,
+// from the file it opened
+void AsyncIORing::PushRead(ReadRequest *request) {
+  const size_t done = size_t(request->result);
+  const size_t left = request->size - done;
+  io_uring_sqe *sqe = Push(IORING_OP_READ, uint64_t(request));
+  sqe->fd = request->fd;
+  sqe->addr = uint64_t(request->buffer + done);
+  sqe->len = unsigned(left < kMaxReadLen ? left : kMaxReadLen);
+  sqe->off = request->offset + done;
+}
+
+
+// Submit the pushed SQEs, with the mutex locked. While the ring is busy,
+// the mutex is released between growing waits, so that completions can
+// be reaped and others can push. False on any other error.
+bool AsyncIORing::Flush() {
+  unsigned backoffUs = 10;
+  while (mUnsubmitted) {
+    int count = RingEnter(mFd, mUnsubmitted, 0, 0);
+    if (count > 0) {
+      mUnsubmitted -= unsigned(count);
+      backoffUs = 10;
+      continue;
+    }
+    if (count < 0 && errno == EINTR)
+      continue;
+    if (count < 0 && !IsRingBusy(errno))
+      return false;
+    mMutex.Unlock();
+    usleep(backoffUs);
+    mMutex.Lock();
+    backoffUs = 2 * backoffUs < kMaxBackoffUs ? 2 * backoffUs : kMaxBackoffUs;
+  }
+  return true;
+}
+
+
+// Take back the SQEs pushed but not submitted, with the mutex locked,
+// failing their requests, which are completed by the caller once the
+// mutex is released
+void AsyncIORing::Retract(int error, RequestVec &doneVec) {
+  unsigned tail = *mSqTail;
+  for (; mUnsubmitted; --mUnsubmitted) {
+    const io_uring_sqe &sqe = ((io_uring_sqe *)mSqes)[--tail & *mSqMask];
+    if (sqe.user_data == kStopTag)
+      continue;
+    ReadRequest *request = (ReadRequest *)(sqe.user_data & ~kOpenTag);
+    if (request->fd >= 0)
+      close(request->fd);
+    request->fd = -1;
+    request->result = -error;
+    mInFlightSet.erase(request);
+    doneVec.push_back(request);
+  }
+  __atomic_store_n(mSqTail, tail, __ATOMIC_RELEASE);
+}
+
+
+// Fail every request in flight, with the mutex locked, once the ring can
+// no longer be entered. The kernel may still hold their SQEs until the
+// ring is closed.
+void AsyncIORing::Fail(int error, RequestVec &doneVec) {
+  Retract(error, doneVec);
+  for (std::set<ReadRequest *>::iterator i = mInFlightSet.begin();
+       i != mInFlightSet.end(); ++i) {
+    ReadRequest *request = *i;
+    if (request->fd >= 0)
+      close(request->fd);
+    request->fd = -1;
+    request->result = -error;
+    doneVec.push_back(request);
+  }
+  mInFlightSet.clear();
+}
+
+
+// Returns false once the request is completed with an error, if it could
+// not be submitted
+bool AsyncIORing::Submit(ReadRequest *request) {
+  RequestVec doneVec;
+  bool ok = false;
+  mMutex.Lock();
+  if (mStopped) {
+    request->result = -EIO;
+    doneVec.push_back(request);
+  } else {
+    io_uring_sqe *sqe = Push(IORING_OP_OPENAT, uint64_t(request) | kOpenTag);
+    sqe->fd = AT_FDCWD;
+    sqe->addr = uint64_t(request->path);
+    sqe->open_flags = O_RDONLY | O_CLOEXEC;
+    mInFlightSet.insert(request);
+    ok = Flush();
+    if (!ok)
+      Retract(errno, doneVec);                      // Also reads of Reap
+  }
+  mMutex.Unlock();
+  for (size_t i = 0; i < doneVec.size(); ++i)
+    mIO->Complete(doneVec[i]);
+  return ok;
+}
+
+
+// Reap completions until the NOP pushed by the destructor, reading the
+// files opened, until their size or end, and completing the reads. If the
+// ring cannot be entered, other than while it is busy, the reads in
+// flight are completed with the error.
+void AsyncIORing::Reap() {
+  RequestVec doneVec;
+  bool stop = false;
+  unsigned backoffUs = 10;
+  while (!stop) {
+    if (RingEnter(mFd, 0, 1, IORING_ENTER_GETEVENTS) >= 0 || errno == EINTR) {
+      backoffUs = 10;
+    } else if (IsRingBusy(errno)) {
+      usleep(backoffUs);                            // Then reap what is in
+      backoffUs = 2 * backoffUs < kMaxBackoffUs ? 2 * backoffUs : kMaxBackoffUs;
+    } else {
+      const int error = errno;
+      mMutex.Lock();
+      Fail(error, doneVec);
+      mStopped = true;
+      mStoppedCond.NotifyAll();
+      mMutex.Unlock();
+      for (size_t i = 0; i < doneVec.size(); ++i)
+        mIO->Complete(doneVec[i]);
+      return;
+    }
+    unsigned head = *mCqHead;
+    const unsigned tail = __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE);
+    mMutex.Lock();
+    for (; head != tail; ++head) {
+      const io_uring_cqe &cqe = mCqes[head & *mCqMask];
+      if (cqe.user_data == kStopTag) {
+        stop = true;
+        continue;
+      }
+      ReadRequest *request = (ReadRequest *)(cqe.user_data & ~kOpenTag);
+      if (cqe.user_data & kOpenTag) {
+        if (cqe.res < 0) {
+          request->result = cqe.res;
+          mInFlightSet.erase(request);
+          doneVec.push_back(request);
+        } else {
+          request->fd = cqe.res;
+          PushRead(request);
+        }
+        continue;
+      }
+
+      // Short reads continue, as ReadFile does, until the size or the end
+      if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+        PushRead(request);
+        continue;
+      }
+      if (cqe.res > 0) {
+        request->result += cqe.res;
+        if (size_t(request->result) < request->size) {
+          PushRead(request);
+          continue;
+        }
+      } else if (cqe.res < 0) {
+        request->result = cqe.res;
+      }
+      close(request->fd);
+      request->fd = -1;
+      mInFlightSet.erase(request);
+      doneVec.push_back(request);
+    }
+    __atomic_store_n(mCqHead, head, __ATOMIC_RELEASE);
+    if (!Flush())
+      Retract(errno, doneVec);
+    mMutex.Unlock();
+    for (size_t i = 0; i < doneVec.size(); ++i)
+      mIO->Complete(doneVec[i]);
+    doneVec.clear();
+  }
+
+  MutexLockGuard guard(mMutex);
+  mStopped = true;
+  mStoppedCond.NotifyAll();
+}
+
+#else   // UTIL_IO_URING
+
+class mt::AsyncIORing {
+public:
+  AsyncIORing(AsyncIO *) {}
+  bool Init(unsigned) { return false; }
+  bool Submit(ReadRequest *) { return false; }      // Never initialized
+};
+
+#endif  // !UTIL_IO_URING
+
+
+//
+// AsyncIO
+//
+
+AsyncIO::AsyncIO()
+  : mTaskMgr(NULL), mPool(NULL), mRing(NULL), mMutex(new Mutex),
+    mDoneCond(new ConditionVariable), mQueueDepth(0), mPending(0) {}
+
+
+AsyncIO::~AsyncIO() {
+  Wait();
+  delete mRing;                                     // Stops reaper
+  delete mPool;                                     // Stops pool threads
+  delete mDoneCond;
+  delete mMutex;
+}
+
+
+bool AsyncIO::Init(TaskMgr *taskMgr, size_t queueDepth, bool threadPool,
+                   size_t poolThreads) {
+  if (mRing || mPool || !queueDepth)
+    return false;
+  mTaskMgr = taskMgr;
+  mQueueDepth = queueDepth;
+  if (!threadPool) {
+    mRing = new AsyncIORing(this);
+    if (mRing->Init(unsigned(queueDepth)))
+      return true;
+    delete mRing;                                   // Fall back to the pool
+    mRing = NULL;
+  }
+  mPool = new TaskMgr;
+  return mPool->Init(poolThreads ? poolThreads : 1);
+}
+
+
+bool AsyncIO::Read(ReadRequest *request) {
+  StallZone zone("AsyncIO::Read");
+  mMutex->Lock();
+  while (mPending >= mQueueDepth)
+    mDoneCond->Wait(*mMutex);
+  ++mPending;
+  mMutex->Unlock();
+  request->result = 0;
+  request->fd = -1;
+  if (mRing) {
+    return mRing->Submit(request);                  // Completes on failure
+  } else if (mPool) {
+    mPool->Schedule(new PoolReadTask(this, request));
+    return true;
+  }
+  request->result = -EIO;
+  Complete(request);
+  return false;
+}
+
+
+void AsyncIO::Complete(ReadRequest *request) {
+  Task *then = request->then;                       // May free request
+  if (then && mTaskMgr) {
+    mTaskMgr->Schedule(then);
+  } else if (then) {
+    (*then)();
+    delete then;
+  }
+  MutexLockGuard guard(*mMutex);
+  --mPending;
+  mDoneCond->NotifyAll();
+}
+
+
+void AsyncIO::Wait() {
+  StallZone zone("AsyncIO::Wait");
+  MutexLockGuard guard(*mMutex);
+  while (mPending)
+    mDoneCond->Wait(*mMutex);
+}
+
+
+size_t AsyncIO::Pending() const {
+  MutexLockGuard guard(*mMutex);
+  return mPending;
+}
@@ -0,0 +1,85 @@
+//  Copyright (c) 2013 The 11ers. All rights reserved.
+
+#ifndef ASYNCIO_H
+#define ASYNCIO_H
+
+#include <stddef.h>
+
+
+// Asynchronous file reads, so that tasks loading images and caches do not
+// keep TaskMgr workers blocked in read(). A task submits reads, each with
+// a continuation task, and returns; each continuation is scheduled on the
+// TaskMgr once its read completes, resuming the work on the data.
+//
+// On Linux, files are opened and read by io_uring, with the completions
+// reaped by a thread of the engine. Elsewhere, if io_uring is unavailable
+// or if a thread pool is requested, reads are blocking calls on a pool of
+// threads of the engine, which only keeps the TaskMgr workers free.
+
+namespace mt {
+
+class AsyncIORing;                                  // io_uring state
+class ConditionVariable;
+class Mutex;
+class Task;
+class TaskMgr;
+
+
+// A read of up to size bytes at offset in a file. The request belongs to
+// the caller, and must not be changed or freed until it completes.
+struct ReadRequest {
+  ReadRequest() : path(0), buffer(0), size(0), offset(0), then(0), data(0),
+                  result(0), fd(-1) {}
+
+  const char *path;                                 // File to read
+  unsigned char *buffer;                            // At least size bytes
+  size_t size;                                      // Bytes to read
+  size_t offset;                                    // Position in file
+  Task *then;                                       // Continuation or NULL
+  void *data;                                       // For the caller
+
+  long result;                                      // Bytes read or -errno
+  int fd;                                           // Internal, while open
+};
+
+
+class AsyncIO {
+public:
+  AsyncIO();
+  virtual ~AsyncIO();                               // Waits for all reads
+
+  // Start the engine, with up to queueDepth reads in flight. Continuations
+  // are scheduled on taskMgr, or run and deleted on the engine's thread if
+  // it is NULL. The thread pool has poolThreads threads.
+  virtual bool Init(TaskMgr *taskMgr, size_t queueDepth = 256,
+                    bool threadPool = false, size_t poolThreads = 8);
+  bool IsThreadPool() const { return mRing == NULL; }
+
+  // Submit a read, blocking while queueDepth reads are in flight. Once it
+  // completes, result holds the bytes read, or -errno if the file could
+  // not be opened or read, and the continuation is scheduled. Returns
+  // false if the read could not be submitted, once it has completed.
+  virtual bool Read(ReadRequest *request);
+
+  virtual void Wait();                              // Until all completed
+  size_t Pending() const;                           // Submitted, not done
+
+  void Complete(ReadRequest *request);              // Called by backends
+
+private:
+  AsyncIO(const AsyncIO &);                         // Disallow copy
+  void operator=(const AsyncIO &);                  // Disallow assignment
+
+  TaskMgr *mTaskMgr;                                // Continuations
+  TaskMgr *mPool;                                   // Blocking reads
+  AsyncIORing *mRing;                               // Or NULL for the pool
+  Mutex *mMutex;                                    // Protect counts
+  ConditionVariable *mDoneCond;                     // A read completed
+  size_t mQueueDepth;                               // Max reads in flight
+  size_t mPending;                                  // Reads in flight
+};
+
+
+}       // namespace mt
+
+#endif  // ASYNCIO_H
@@ -1,6 +1,22 @@
 // Copyright (c) by The 11ers.  All rights reserved.
 
 #include "Base64.h"
+#include "TaskMgr.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// SSSE3 and AVX2 are not baseline on x86, so their vector kernels are
+// compiled for them by function attributes and chosen at run time by the
+// features of the CPU. Both produce exactly the output of the scalar
+// code, which handles the ends and any noise.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BASE64_SSSE3 1
+#define BASE64_AVX2 1
+#define BASE64_SSSE3_FN __attribute__((target("ssse3")))
+#define BASE64_AVX2_FN __attribute__((target("avx2")))
+#endif
 
 namespace Base64 {
 
@@ -9,120 +25,697 @@ static const char cb64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
                            "abcdefghijklmnopqrstuvwxyz"
                            "0123456789-_"; // URL encode + to -, / to _
 
-// Decoding translation table
-static const char cd64[] = "|$$$}rstuvwxyz{$$$$$$$>?@"
-                           "ABCDEFGHIJKLMNOPQRSTUVW$$$$$$XYZ"
-                           "[\\]^_`abcdefghijklmnopq";
+// Decoding translation table, accepting both the standard and URL-safe
+// characters for 62 and 63, with 255 for noise that is skipped
+static const unsigned char kDecode[256] = {
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  62, 255,  62, 255,  63,
+   52,  53,  54,  55,  56,  57,  58,  59,  60,  61, 255, 255, 255, 255, 255, 255,
+  255,   0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,
+   15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25, 255, 255, 255, 255,  63,
+  255,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,
+   41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  51, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+};
 
-  
-// Encode 3 8-bit binary bytes as four 6-bit characters
-static void EncodeBlock(unsigned char in[3], unsigned char out[4], int len) {
-  out[0] = cb64[in[0] >> 2];
-  out[1] = cb64[((in[0] & 0x03) << 4) | ((in[1] & 0xf0) >> 4)];
-  out[2] = (unsigned char) (len > 1 ? cb64[((in[1] & 0x0f) << 2) | ((in[2] & 0xc0) >> 6)] : '=');
-  out[3] = (unsigned char) (len > 2 ? cb64[in[2] & 0x3f] : '=');
+static const unsigned char kNoise = 255;
+
+
+#ifdef BASE64_SSSE3
+
+// Split the 12 bytes at the start of each 16-byte lane into sixteen 6-bit
+// indices, one per byte (Wojciech Mula's multiply-shift method)
+BASE64_SSSE3_FN static inline __m128i EncodeUnpack128(__m128i in) {
+  in = _mm_shuffle_epi8(in, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4,
+                                          7, 6, 8, 7, 10, 9, 11, 10));
+  __m128i hi = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)),
+                               _mm_set1_epi32(0x04000040));
+  __m128i lo = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)),
+                               _mm_set1_epi32(0x01000010));
+  return _mm_or_si128(hi, lo);
 }
 
-  
-// Encode a source buffer, adding padding and line breaks
+
+// Map 6-bit indices to characters
+BASE64_SSSE3_FN static inline __m128i EncodeIndices128(__m128i indices) {
+  // Offset from index to character by range: 13 for A-Z, 0 for a-z,
+  // 1 to 10 for 0-9 and 11 and 12 for '-' and '_'
+  const __m128i offsets = _mm_setr_epi8(71, -4, -4, -4, -4, -4, -4, -4, -4,
+                                        -4, -4, -17, 32, 65, 0, 0);
+  __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+  __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+  range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+  return _mm_add_epi8(indices, _mm_shuffle_epi8(offsets, range));
+}
+
+
+// Translate 16 characters to 6-bit values, returning false for noise
+BASE64_SSSE3_FN static inline bool DecodeValues128(__m128i c, __m128i *values) {
+  // Characters are below 128, so signed compares reject the others
+  __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('A' - 1)),
+                                _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), c));
+  __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('a' - 1)),
+                                _mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), c));
+  __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+                                _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), c));
+  __m128i plus = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('+')),
+                              _mm_cmpeq_epi8(c, _mm_set1_epi8('-')));
+  __m128i slash = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('/')),
+                               _mm_cmpeq_epi8(c, _mm_set1_epi8('_')));
+  __m128i valid = _mm_or_si128(_mm_or_si128(upper, lower),
+                               _mm_or_si128(_mm_or_si128(digit, plus), slash));
+  if (_mm_movemask_epi8(valid) != 0xFFFF)
+    return false;
+  __m128i shift = _mm_or_si128(
+    _mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-65)),
+                 _mm_and_si128(lower, _mm_set1_epi8(-71))),
+    _mm_and_si128(digit, _mm_set1_epi8(4)));
+  __m128i special = _mm_or_si128(_mm_and_si128(plus, _mm_set1_epi8(62)),
+                                 _mm_and_si128(slash, _mm_set1_epi8(63)));
+  *values = _mm_or_si128(
+    _mm_and_si128(_mm_add_epi8(c, shift),
+                  _mm_or_si128(_mm_or_si128(upper, lower), digit)),
+    special);
+  return true;
+}
+
+
+// Pack sixteen 6-bit values into 12 bytes, in the low 12 of each lane
+BASE64_SSSE3_FN static inline __m128i DecodePack128(__m128i values) {
+  __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+  __m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+  return _mm_shuffle_epi8(quads, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8,
+                                               14, 13, 12, -1, -1, -1, -1));
+}
+
+#endif  // BASE64_SSSE3
+
+
+#ifdef BASE64_AVX2
+
+BASE64_AVX2_FN static inline __m256i EncodeUnpack256(__m256i in) {
+  in = _mm256_shuffle_epi8(in, _mm256_setr_epi8(
+    1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+    1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+  __m256i hi = _mm256_mulhi_epu16(
+    _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)),
+    _mm256_set1_epi32(0x04000040));
+  __m256i lo = _mm256_mullo_epi16(
+    _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)),
+    _mm256_set1_epi32(0x01000010));
+  return _mm256_or_si256(hi, lo);
+}
+
+
+BASE64_AVX2_FN static inline __m256i EncodeIndices256(__m256i indices) {
+  const __m256i offsets = _mm256_setr_epi8(
+    71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -17, 32, 65, 0, 0,
+    71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -17, 32, 65, 0, 0);
+  __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+  __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+  range = _mm256_or_si256(range, _mm256_and_si256(upper, _mm256_set1_epi8(13)));
+  return _mm256_add_epi8(indices, _mm256_shuffle_epi8(offsets, range));
+}
+
+
+BASE64_AVX2_FN static inline bool DecodeValues256(__m256i c, __m256i *values) {
+  __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('A' - 1)),
+                                   _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), c));
+  __m256i lower = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('a' - 1)),
+                                   _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), c));
+  __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)),
+                                   _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), c));
+  __m256i plus = _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('+')),
+                                 _mm256_cmpeq_epi8(c, _mm256_set1_epi8('-')));
+  __m256i slash = _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('/')),
+                                  _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_')));
+  __m256i letter = _mm256_or_si256(_mm256_or_si256(upper, lower), digit);
+  __m256i valid = _mm256_or_si256(letter, _mm256_or_si256(plus, slash));
+  if (_mm256_movemask_epi8(valid) != -1)
+    return false;
+  __m256i shift = _mm256_or_si256(
+    _mm256_or_si256(_mm256_and_si256(upper, _mm256_set1_epi8(-65)),
+                    _mm256_and_si256(lower, _mm256_set1_epi8(-71))),
+    _mm256_and_si256(digit, _mm256_set1_epi8(4)));
+  __m256i special = _mm256_or_si256(_mm256_and_si256(plus, _mm256_set1_epi8(62)),
+                                    _mm256_and_si256(slash, _mm256_set1_epi8(63)));
+  *values = _mm256_or_si256(_mm256_and_si256(_mm256_add_epi8(c, shift), letter),
+                            special);
+  return true;
+}
+
+
+// Pack thirty-two 6-bit values into 24 consecutive bytes
+BASE64_AVX2_FN static inline __m256i DecodePack256(__m256i values) {
+  __m256i pairs = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+  __m256i quads = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+  __m256i packed = _mm256_shuffle_epi8(quads, _mm256_setr_epi8(
+    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+  return _mm256_permutevar8x32_epi32(packed,
+                                     _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+}
+
+
+// Features of the CPU, checked once
+static bool HasAvx2() {
+  static const bool has = (__builtin_cpu_init(),
+                           __builtin_cpu_supports("avx2") != 0);
+  return has;
+}
+
+
+static bool HasSsse3() {
+  static const bool has = (__builtin_cpu_init(),
+                           __builtin_cpu_supports("ssse3") != 0);
+  return has;
+}
+
+#endif  // BASE64_AVX2
+
+
+#ifdef BASE64_SSSE3
+
+// Encode 24 bytes at a time while 28 remain before end, as loads read 4
+// bytes past the 24 they encode, advancing src and dst
+BASE64_AVX2_FN
+static void EncodeAvx2(const unsigned char *&src, const unsigned char *end,
+                       unsigned char *&dst) {
+  for (; end - src >= 28; src += 24, dst += 32) {
+    __m256i in = _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)src)),
+      _mm_loadu_si128((const __m128i *)(src + 12)), 1);
+    _mm256_storeu_si256((__m256i *)dst,
+                        EncodeIndices256(EncodeUnpack256(in)));
+  }
+}
+
+
+// Encode 12 bytes at a time while 16 remain before end
+BASE64_SSSE3_FN
+static void EncodeSsse3(const unsigned char *&src, const unsigned char *end,
+                        unsigned char *&dst) {
+  for (; end - src >= 16; src += 12, dst += 16) {
+    __m128i in = _mm_loadu_si128((const __m128i *)src);
+    _mm_storeu_si128((__m128i *)dst, EncodeIndices128(EncodeUnpack128(in)));
+  }
+}
+
+
+// Decode 32 characters at a time while 64 remain before end, stopping at
+// noise, advancing src and dst
+BASE64_AVX2_FN
+static void DecodeAvx2(const unsigned char *&src, const unsigned char *end,
+                       unsigned char *&dst) {
+  __m256i values;
+  for (; end - src >= 64 &&
+       DecodeValues256(_mm256_loadu_si256((const __m256i *)src), &values);
+       src += 32, dst += 24)
+    _mm256_storeu_si256((__m256i *)dst, DecodePack256(values));
+}
+
+
+// Decode 16 characters at a time while 32 remain before end
+BASE64_SSSE3_FN
+static void DecodeSsse3(const unsigned char *&src, const unsigned char *end,
+                        unsigned char *&dst) {
+  __m128i values;
+  for (; end - src >= 32 &&
+       DecodeValues128(_mm_loadu_si128((const __m128i *)src), &values);
+       src += 16, dst += 12)
+    _mm_storeu_si128((__m128i *)dst, DecodePack128(values));
+}
+
+#endif  // BASE64_SSSE3
+
+
+// Encode the whole 3-byte blocks of src, returning the end of the output
+static unsigned char *EncodeBlocks(const unsigned char *src, size_t len,
+                                   unsigned char *dst) {
+  const unsigned char *end = src + len - len % 3;
+#ifdef BASE64_SSSE3
+  if (HasAvx2())
+    EncodeAvx2(src, end, dst);
+  if (HasSsse3())
+    EncodeSsse3(src, end, dst);
+#endif
+  for (; src != end; src += 3, dst += 4) {
+    unsigned int bits = src[0] << 16 | src[1] << 8 | src[2];
+    dst[0] = cb64[bits >> 18];
+    dst[1] = cb64[(bits >> 12) & 0x3f];
+    dst[2] = cb64[(bits >> 6) & 0x3f];
+    dst[3] = cb64[bits & 0x3f];
+  }
+  return dst;
+}
+
+
+// Encode the final 1 or 2 bytes, with percent-encoded '=' padding
+static unsigned char *EncodeTail(const unsigned char *src, size_t len,
+                                 unsigned char *dst) {
+  unsigned int bits = src[0] << 16 | (len > 1 ? src[1] << 8 : 0);
+  *dst++ = cb64[bits >> 18];
+  *dst++ = cb64[(bits >> 12) & 0x3f];
+  if (len > 1)
+    *dst++ = cb64[(bits >> 6) & 0x3f];
+  for (size_t i = len; i < 3; ++i, dst += 3)
+    memcpy(dst, "%3D", 3);
+  return dst;
+}
+
+
+size_t EncodedSize(size_t len) {
+  const size_t tail = len % 3;
+  return len / 3 * 4 + (tail ? 10 - 2 * tail : 0);   // 2 or 3 and "%3D"s
+}
+
+
+// Encode a source buffer, adding percent-encoded padding, without line
+// breaks, which are illegal in JSON
+size_t Encode(const unsigned char *src, size_t len, unsigned char *dst) {
+  const size_t tail = len % 3;
+  unsigned char *out = EncodeBlocks(src, len, dst);
+  if (tail)
+    out = EncodeTail(src + len - tail, tail, out);
+  return out - dst;
+}
+
+
 void Encode(const unsigned char *src, size_t len,
             std::vector<unsigned char> &dst) {
-  const size_t lineSize = 0;  // Do not insert linefeeds (illegal in JSON)
-  size_t blocksOut = 0;
-  for (size_t j = 0; j < len; /*EMPTY*/) {
-    size_t k = 0;
-    unsigned char in[3], out[4];
-    for (size_t i = 0; i < 3; ++i) {
-      if (j < len) {
-        ++k;
-        in[i] = src[j++];
-      } else {
-        in[i] = 0;
-      }
-    }
-    if (k) {
-      EncodeBlock(in, out, k);
-      ++blocksOut;
-      for (size_t i = 0; i < 4; ++i)
-        dst.push_back(out[i]);
-    }
-    if (lineSize > 0 && (blocksOut >= lineSize/4 || j >= len)) {
-      if (blocksOut) {
-        dst.push_back('\r');
-        dst.push_back('\n');
+  const size_t start = dst.size();
+  dst.resize(start + EncodedSize(len));
+  Encode(src, len, dst.data() + start);
+}
+
+
+// Decode the characters in [src, end) after the count 6-bit values already
+// in group, skipping noise, and writing each complete group of 4 as 3 bytes
+static unsigned char *DecodeChars(const unsigned char *src,
+                                  const unsigned char *end, unsigned char *dst,
+                                  unsigned int *group, size_t *count) {
+  for (;;) {
+    // Vector loops stop at noise, which is rare, and resume after the
+    // scalar code completes the group it splits
+    if (!*count) {
+#ifdef BASE64_SSSE3
+      if (HasAvx2())
+        DecodeAvx2(src, end, dst);
+      if (HasSsse3())
+        DecodeSsse3(src, end, dst);
+#endif
+      // Four characters at a time
+      for (; end - src >= 4; src += 4, dst += 3) {
+        unsigned int a = kDecode[src[0]], b = kDecode[src[1]];
+        unsigned int c = kDecode[src[2]], d = kDecode[src[3]];
+        if ((a | b | c | d) == kNoise)     // Any noise sets all bits
+          break;
+        unsigned int bits = a << 18 | b << 12 | c << 6 | d;
+        dst[0] = (unsigned char)(bits >> 16);
+        dst[1] = (unsigned char)(bits >> 8);
+        dst[2] = (unsigned char)bits;
       }
-      blocksOut = 0;
     }
-  }
-  
-  // Percent-encode any trailing equals signs
-  size_t neq = 0;
-  for (size_t i = 0; i < 4; ++i)
-    if (dst[dst.size() - 1 - i] == '=')
-      neq++;
-  if (neq) {
-    dst.resize(dst.size() - neq);
-    for (size_t i = 0; i < neq; ++i) {
-      dst.push_back('%');
-      dst.push_back('3');
-      dst.push_back('D');
+    if (src == end)
+      return dst;
+
+    unsigned char v = kDecode[*src++];
+    if (v == kNoise)
+      continue;
+    *group = *group << 6 | v;
+    if (++*count == 4) {
+      dst[0] = (unsigned char)(*group >> 16);
+      dst[1] = (unsigned char)(*group >> 8);
+      dst[2] = (unsigned char)*group;
+      dst += 3;
+      *group = 0;
+      *count = 0;
     }
   }
 }
 
 
-// Decode 4 6-bit characters into 3 8-bit binary bytes
-static void DecodeBlock(unsigned char in[4], unsigned char out[3]) {   
-  out[0] = (unsigned char) (in[0] << 2 | in[1] >> 4);
-  out[1] = (unsigned char) (in[1] << 4 | in[2] >> 2);
-  out[2] = (unsigned char) (((in[2] << 6) & 0xc0) | in[3]);
+// Write the count - 1 bytes of a final partial group
+static unsigned char *DecodeTail(unsigned int group, size_t count,
+                                 unsigned char *dst) {
+  group <<= 6 * (4 - count);
+  for (size_t i = 1; i < count; ++i)
+    *dst++ = (unsigned char)(group >> (24 - 8 * i));
+  return dst;
 }
 
 
-// Decode a Base64 encoded buffer, discarding padding, line breaks and noise
-void Decode(unsigned char *src, size_t len,
-            std::vector<unsigned char> &dst) {
+size_t DecodedMaxSize(size_t len) {
+  return len / 4 * 3 + (len % 4 > 1 ? len % 4 - 1 : 0);
+}
+
+
+// Decode the end of an input: all of it, or at least its last kHoldLen
+// characters. Percent signs near the end are taken as the first of as
+// many "%3D"s, which are skipped: the characters decoded are those before
+// the first sign and after the signs, to the length of one '=' for each.
+static unsigned char *DecodeEnd(const unsigned char *src, size_t len,
+                                unsigned char *dst, unsigned int *group,
+                                size_t *count) {
   size_t neq = 0;
   size_t firstPercentIdx = 0;
-  for (size_t j = 1; j < 14; ++j) {
+  for (size_t j = 1; j < 14 && j <= len; ++j) {
     if (src[len - j] == '%') {
       neq++;
       firstPercentIdx = len - j;
     }
   }
+  size_t skipFirst = len, skipLast = len;
   if (neq) {
-    len -= 2 * neq;
-    for (size_t j = 0; j < neq; ++j)
-      src[firstPercentIdx + j] = '=';
+    len = 2 * neq < len ? len - 2 * neq : 0;
+    skipFirst = firstPercentIdx < len ? firstPercentIdx : len;
+    skipLast = firstPercentIdx + neq < len ? firstPercentIdx + neq : len;
+  }
+  dst = DecodeChars(src, src + skipFirst, dst, group, count);
+  return DecodeChars(src + skipLast, src + len, dst, group, count);
+}
+
+
+// Decode a Base64 encoded buffer, discarding padding, line breaks and noise
+size_t Decode(const unsigned char *src, size_t len, unsigned char *dst) {
+  const size_t end = len < Decoder::kHoldLen ? len : Decoder::kHoldLen;
+  unsigned int group = 0;
+  size_t count = 0;
+  unsigned char *out = DecodeChars(src, src + len - end, dst, &group, &count);
+  out = DecodeEnd(src + len - end, end, out, &group, &count);
+  out = DecodeTail(group, count, out);
+  return out - dst;
+}
+
+
+void Decode(const unsigned char *src, size_t len,
+            std::vector<unsigned char> &dst) {
+  const size_t start = dst.size();
+  dst.resize(start + DecodedMaxSize(len));
+  dst.resize(start + Decode(src, len, dst.data() + start));
+}
+
+
+//
+// Parallel
+//
+
+static const size_t kParallelMin = 64 * 1024;     // Smallest segment
+
+
+// Part of the input coded by one task
+struct Segment {
+  const unsigned char *src;
+  size_t len;
+  unsigned char *dst;                             // Where its output goes
+  size_t written;                                 // Bytes output
+  bool last;                                      // Ends the input
+  bool ok;                                        // Output fills its place
+};
+
+typedef void (*SegmentFunc)(Segment *segment);
+
+
+static void EncodeSegment(Segment *segment) {
+  segment->written = Encode(segment->src, segment->len, segment->dst);
+  segment->ok = true;
+}
+
+
+// Segments before the last are whole groups, which end where the next
+// segment starts only if they are free of noise
+static void DecodeSegment(Segment *segment) {
+  if (segment->last) {
+    segment->written = Decode(segment->src, segment->len, segment->dst);
+    segment->ok = true;
+    return;
+  }
+  unsigned int group = 0;
+  size_t count = 0;
+  segment->written = DecodeChars(segment->src, segment->src + segment->len,
+                                 segment->dst, &group, &count) - segment->dst;
+  segment->ok = !count && segment->written == segment->len / 4 * 3;
+}
+
+
+// Segments coded by one function, run as ranges
+struct SegmentRanges {
+  SegmentFunc func;
+  Segment *segment;
+};
+
+
+static void CodeSegment(void *context, size_t range) {
+  SegmentRanges *ranges = (SegmentRanges *)context;
+  ranges->func(&ranges->segment[range]);
+}
+
+
+// Code the input as segments of whole blocks of inBlock bytes, each
+// written at the offset of its first block times outBlock / inBlock.
+// Returns false if the input is not split or a segment is out of place.
+static bool CodeParallel(const unsigned char *src, size_t len,
+                         unsigned char *dst, mt::TaskMgr *taskMgr,
+                         size_t tasks, size_t inBlock, size_t outBlock,
+                         SegmentFunc func, size_t *written) {
+  if (tasks > len / kParallelMin)
+    tasks = len / kParallelMin;
+  if (tasks < 2)
+    return false;
+  const size_t blocks = len / inBlock / tasks;    // Per segment but last
+  std::vector<Segment> segments(tasks);
+  for (size_t i = 0; i < tasks; ++i) {
+    Segment &segment = segments[i];
+    segment.src = src + i * blocks * inBlock;
+    segment.len = i + 1 < tasks ? blocks * inBlock : src + len - segment.src;
+    segment.dst = dst + i * blocks * outBlock;
+    segment.last = i + 1 == tasks;
   }
   
-  for (size_t j = 0; j < len; /*EMPTY*/) {
-    size_t k = 0;
-    unsigned char in[4], out[3];
-    for (size_t i = 0; i < 4 && j < len; ++i) {
-      unsigned char v = 0;
-      while (j < len && v == 0) {
-        v = src[j++];
-        if (v == '-') v = '+';    // Reverse URL decode
-        if (v == '_') v = '/';
-        v = (unsigned char) ((v < 43 || v > 122) ? 0 : cd64[v - 43]);
-        if (v)
-          v = (unsigned char) ((v == '$') ? 0 : v - 61);
-      }
-      if (j < len) {
-        ++k;
-        if (v)
-          in[i] = (unsigned char)(v - 1);
-      } else {
-        in[i] = 0;
-      }      
+  SegmentRanges ranges = { func, &segments[0] };
+  mt::RunRanges(taskMgr, "Base64", tasks, CodeSegment, &ranges);
+  
+  *written = 0;
+  for (size_t i = 0; i < tasks; ++i) {
+    if (!segments[i].ok)
+      return false;
+    *written += segments[i].written;
+  }
+  return true;
+}
+
+
+size_t EncodeParallel(const unsigned char *src, size_t len,
+                      unsigned char *dst, mt::TaskMgr *taskMgr, size_t tasks) {
+  size_t written;
+  if (!CodeParallel(src, len, dst, taskMgr, tasks, 3, 4, EncodeSegment,
+                    &written))
+    return Encode(src, len, dst);
+  return written;
+}
+
+
+size_t DecodeParallel(const unsigned char *src, size_t len,
+                      unsigned char *dst, mt::TaskMgr *taskMgr, size_t tasks) {
+  size_t written;
+  if (!CodeParallel(src, len, dst, taskMgr, tasks, 4, 3, DecodeSegment,
+                    &written))
+    return Decode(src, len, dst);
+  return written;
+}
+
+
+//
+// Streaming
+//
+
+static const size_t kMinBufferSize = 64;
+
+
+Encoder::Encoder(Sink &sink, size_t bufferSize)
+: mSink(sink),
+  mBuffer(bufferSize < kMinBufferSize ? kMinBufferSize : bufferSize),
+  mBufferLen(0), mCarryLen(0), mFailed(false) {}
+
+
+bool Encoder::Write(const unsigned char *src, size_t len) {
+  if (mFailed)
+    return false;
+  
+  // Complete the block carried from the last call
+  if (mCarryLen && mCarryLen + len >= 3) {
+    unsigned char block[3];
+    const size_t n = 3 - mCarryLen;
+    memcpy(block, mCarry, mCarryLen);
+    memcpy(block + mCarryLen, src, n);
+    src += n;
+    len -= n;
+    mCarryLen = 0;
+    if (mBuffer.size() - mBufferLen < 4 && !Flush())
+      return false;
+    mBufferLen += Encode(block, 3, &mBuffer[mBufferLen]);
+  }
+  
+  // Whole blocks straight from src, as many as the buffer holds at a time
+  while (!mCarryLen && len >= 3) {
+    const size_t room = (mBuffer.size() - mBufferLen) / 4 * 3;
+    if (room < 3) {
+      if (!Flush())
+        return false;
+      continue;
     }
-    if (k) {
-      DecodeBlock(in, out);
-      for (size_t i = 0; i < k - 1; ++i)
-        dst.push_back(out[i]);
+    const size_t n = len / 3 * 3 < room ? len / 3 * 3 : room;
+    mBufferLen += Encode(src, n, &mBuffer[mBufferLen]);
+    src += n;
+    len -= n;
+  }
+  
+  memcpy(mCarry + mCarryLen, src, len);
+  mCarryLen += len;
+  return true;
+}
+
+
+bool Encoder::Finish() {
+  bool ok = !mFailed;
+  if (ok && mCarryLen) {
+    if (mBuffer.size() - mBufferLen < EncodedSize(mCarryLen))
+      ok = Flush();
+    if (ok)
+      mBufferLen += Encode(mCarry, mCarryLen, &mBuffer[mBufferLen]);
+  }
+  ok = ok && Flush();
+  mBufferLen = 0;
+  mCarryLen = 0;
+  mFailed = false;
+  return ok;
+}
+
+
+bool Encoder::Flush() {
+  if (mBufferLen && !mFailed && !mSink(&mBuffer[0], mBufferLen))
+    mFailed = true;
+  mBufferLen = 0;
+  return !mFailed;
+}
+
+
+Decoder::Decoder(Sink &sink, size_t bufferSize)
+: mSink(sink),
+  mBuffer(bufferSize < kMinBufferSize ? kMinBufferSize : bufferSize),
+  mBufferLen(0), mHoldLen(0), mGroup(0), mCount(0), mFailed(false) {}
+
+
+bool Decoder::Write(const unsigned char *src, size_t len) {
+  if (mFailed)
+    return false;
+  if (mHoldLen + len <= kHoldLen) {
+    memcpy(mHold + mHoldLen, src, len);
+    mHoldLen += len;
+    return true;
+  }
+  
+  // Decode all but the last kHoldLen characters, held first
+  const size_t ready = mHoldLen + len - kHoldLen;
+  const size_t held = ready < mHoldLen ? ready : mHoldLen;
+  if (!Decode(mHold, held))
+    return false;
+  memmove(mHold, mHold + held, mHoldLen - held);
+  mHoldLen -= held;
+  if (!Decode(src, ready - held))
+    return false;
+  src += ready - held;
+  len -= ready - held;
+  memcpy(mHold + mHoldLen, src, len);
+  mHoldLen += len;
+  return true;
+}
+
+
+bool Decoder::Finish() {
+  // The end and a partial group decode to at most 21 bytes
+  bool ok = !mFailed;
+  if (ok && mBuffer.size() - mBufferLen < kMinBufferSize)
+    ok = Flush();
+  if (ok) {
+    unsigned char *out = DecodeEnd(mHold, mHoldLen, &mBuffer[mBufferLen],
+                                   &mGroup, &mCount);
+    out = DecodeTail(mGroup, mCount, out);
+    mBufferLen = out - &mBuffer[0];
+    ok = Flush();
+  }
+  mBufferLen = 0;
+  mHoldLen = 0;
+  mGroup = 0;
+  mCount = 0;
+  mFailed = false;
+  return ok;
+}
+
+
+// Decode characters that are not at the end, in pieces whose output,
+// with the slack of vector stores, fits in the free part of the buffer
+bool Decoder::Decode(const unsigned char *src, size_t len) {
+  while (len) {
+    const size_t room = mBuffer.size() - mBufferLen;
+    if (room < kMinBufferSize) {
+      if (!Flush())
+        return false;
+      continue;
     }
+    const size_t max = (room / 3 - 2) * 4;
+    const size_t n = len < max ? len : max;
+    unsigned char *out = DecodeChars(src, src + n, &mBuffer[mBufferLen],
+                                     &mGroup, &mCount);
+    mBufferLen = out - &mBuffer[0];
+    src += n;
+    len -= n;
   }
+  return true;
+}
+
+
+bool Decoder::Flush() {
+  if (mBufferLen && !mFailed && !mSink(&mBuffer[0], mBufferLen))
+    mFailed = true;
+  mBufferLen = 0;
+  return !mFailed;
+}
+
+
+template <class Codec>
+static bool PipeFile(const char *path, Sink &sink, size_t chunkSize) {
+  FILE *fp = fopen(path, "rb");
+  if (!fp)
+    return false;
+  Codec codec(sink, chunkSize);
+  std::vector<unsigned char> chunk(chunkSize < kMinBufferSize ?
+                                   kMinBufferSize : chunkSize);
+  bool ok = true;
+  size_t len;
+  while (ok && (len = fread(&chunk[0], 1, chunk.size(), fp)) > 0)
+    ok = codec.Write(&chunk[0], len);
+  ok = ok && !ferror(fp);
+  fclose(fp);
+  return ok && codec.Finish();
+}
+
+
+bool EncodeFile(const char *path, Sink &sink, size_t chunkSize) {
+  return PipeFile<Encoder>(path, sink, chunkSize);
+}
+
+
+bool DecodeFile(const char *path, Sink &sink, size_t chunkSize) {
+  return PipeFile<Decoder>(path, sink, chunkSize);
 }
 
-};  // namespace Base64
\ No newline at end of file
+};  // namespace Base64
@@ -6,6 +6,8 @@
 #include <stdlib.h>
 #include <vector>
 
+namespace mt { class TaskMgr; }
+
 // Implements URL-safe Base-64 encoding of arbitrary binary data.
 // Base64 encoded 3 8-bit values into 4 6-bit values using only the
 // safe ASCII values. However, it normally uses some characters that
@@ -15,11 +17,102 @@
 // encode any trailing '=' characters.
 
 namespace Base64 {
+  // Exact size of the encoding of len bytes, padding included, and the
+  // largest number of bytes that len characters can decode to
+  size_t EncodedSize(size_t len);
+  size_t DecodedMaxSize(size_t len);
+  
+  // Write into dst, which must hold EncodedSize(len) or DecodedMaxSize(len)
+  // bytes, and return the number of bytes written
+  size_t Encode(const unsigned char *src, size_t len, unsigned char *dst);
+  size_t Decode(const unsigned char *src, size_t len, unsigned char *dst);
+  
+  // Append to dst, growing it once
   void Encode(const unsigned char *src, size_t len,
               std::vector<unsigned char> &dst);
   
-  void Decode(unsigned char *src, size_t len,
+  void Decode(const unsigned char *src, size_t len,
               std::vector<unsigned char> &dst);
+  
+  // Encode or Decode into dst like the functions above, with the input
+  // split at block boundaries into up to tasks segments that are coded
+  // concurrently straight into their place in dst, one on the calling
+  // thread and the others on the workers of taskMgr, or all on the calling
+  // thread if it is NULL. Small inputs are coded on the calling thread.
+  // Segments are placed for input without noise: if noise moves the output
+  // of a segment, the input is decoded again sequentially. Must not be
+  // called from a task of taskMgr, whose workers could all be waiting.
+  size_t EncodeParallel(const unsigned char *src, size_t len,
+                        unsigned char *dst, mt::TaskMgr *taskMgr,
+                        size_t tasks);
+  size_t DecodeParallel(const unsigned char *src, size_t len,
+                        unsigned char *dst, mt::TaskMgr *taskMgr,
+                        size_t tasks);
+  
+  
+  // Receives the output of a streaming codec, returning false to stop it
+  struct Sink {
+    virtual ~Sink() {}
+    virtual bool operator()(const unsigned char *data, size_t len) = 0;
+  };
+  
+  
+  // Incremental encoder, producing the same output as Encode from input
+  // written in chunks of any size. Output is collected in a buffer of
+  // bufferSize bytes and passed to the sink whenever it fills, so memory
+  // use does not depend on the input size. Write and Finish return false
+  // once the sink has failed. Finish writes the padding, and the encoder
+  // can then be reused.
+  class Encoder {
+  public:
+    explicit Encoder(Sink &sink, size_t bufferSize = 64 * 1024);
+    
+    bool Write(const unsigned char *src, size_t len);
+    bool Finish();                                  // Pad and flush
+    
+  private:
+    bool Flush();                                   // Pass buffer to sink
+    
+    Sink &mSink;                                    // Output
+    std::vector<unsigned char> mBuffer;             // Pending output
+    size_t mBufferLen;                              // Bytes in mBuffer
+    unsigned char mCarry[2];                        // Partial 3-byte block
+    size_t mCarryLen;                               // Bytes in mCarry
+    bool mFailed;                                   // Sink returned false
+  };
+  
+  
+  // Incremental decoder, producing the same output as Decode. The last
+  // characters written are held back until Finish, since the padding is
+  // recognized from the end of the input.
+  class Decoder {
+  public:
+    explicit Decoder(Sink &sink, size_t bufferSize = 64 * 1024);
+    
+    bool Write(const unsigned char *src, size_t len);
+    bool Finish();                                  // Decode end and flush
+    
+    static const size_t kHoldLen = 26;              // Padding rule window
+    
+  private:
+    bool Decode(const unsigned char *src, size_t len);
+    bool Flush();
+    
+    Sink &mSink;
+    std::vector<unsigned char> mBuffer;
+    size_t mBufferLen;
+    unsigned char mHold[kHoldLen];                  // Last characters
+    size_t mHoldLen;
+    unsigned int mGroup;                            // Partial 4-char group
+    size_t mCount;                                  //   of mCount values
+    bool mFailed;
+  };
+  
+  
+  // Stream the file at path through an encoder or a decoder to sink,
+  // reading it in chunks of chunkSize bytes. False on a read error.
+  bool EncodeFile(const char *path, Sink &sink, size_t chunkSize = 64 * 1024);
+  bool DecodeFile(const char *path, Sink &sink, size_t chunkSize = 64 * 1024);
 };
 
 #endif // BASE64_H
@@ -0,0 +1,159 @@
+//  Copyright (c) 2013 The 11ers. All rights reserved.
+
+#include "Bench.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+double bench::gMinSec = 0.5;
+size_t bench::gScale = 1;
+
+
+struct Suite {
+  const char *name;
+  bench::SuiteFunc func;
+  const char *desc;
+};
+
+static const Suite gSuite[] = {
+  { "asyncio",  bench::AsyncIOSuite,  "Reading small files with AsyncIO" },
+  { "base64",   bench::Base64Suite,   "Base64 encode & decode" },
+  { "filename", bench::FilenameSuite, "Path splitting and file queries" },
+  { "geometry", bench::GeometrySuite, "CPU-side GlesUtil tristrip builders" },
+#if UTIL_GL_STUB
+  { "gl",       bench::GlSuite,       "GlesUtil call volume, headless GL" },
+#endif
+  { "json",     bench::JsonSuite,     "json_parse on synthetic album data" },
+  { "png",      bench::PngSuite,      "lodepng inflate and PNG decoding" },
+  { "watchdog", bench::WatchdogSuite, "UI thread stall detection overhead" },
+};
+
+static const size_t gSuiteCount = sizeof(gSuite) / sizeof(gSuite[0]);
+
+
+void bench::Report(const char *suite, const char *name, double sec,
+                   size_t iters, double bytes) {
+  double usec = iters ? 1e6 * sec / iters : 0;
+  if (bytes > 0)
+    printf("%-10s %-36s %10.3f us/iter %10.1f MB/s\n", suite, name, usec,
+           sec > 0 ? bytes / sec / (1024 * 1024) : 0);
+  else
+    printf("%-10s %-36s %10.3f us/iter\n", suite, name, usec);
+  fflush(stdout);
+}
+
+
+bool bench::Fail(const char *suite, const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  fprintf(stderr, "%s: FAILED: ", suite);
+  vfprintf(stderr, fmt, ap);
+  fprintf(stderr, "\n");
+  va_end(ap);
+  return false;
+}
+
+
+bool bench::DropCaches() {
+  sync();
+  FILE *fp = fopen("/proc/sys/vm/drop_caches", "w");
+  if (!fp)
+    return false;
+  bool ok = fputs("3\n", fp) >= 0;
+  return fclose(fp) == 0 && ok;
+}
+
+
+std::string bench::AlbumJson(size_t albumCount, size_t imagesPerAlbum,
+                             bool pretty) {
+  static const char *keyword[] = { "family", "beach", "sunset", "portrait",
+                                   "caf\\u00e9", "snow", "\\\"best\\\"" };
+  const char *nl = pretty ? "\n" : "";
+  const char *ind = pretty ? "  " : "";
+  const char *sp = pretty ? " " : "";
+  Random rnd(42);
+  std::string s;
+  char buf[1024];
+  s += "{"; s += nl;
+  s += ind; s += "\"albums\":"; s += sp; s += "["; s += nl;
+  for (size_t a = 0; a < albumCount; ++a) {
+    snprintf(buf, sizeof(buf), "%s%s{\"name\":%s\"Album %zu\",%s\"url\":%s"
+             "\"assets-library:\\/\\/group\\/?id=%08X\",%s\"count\":%s%zu,%s"
+             "\"images\":%s[%s", ind, ind, sp, a, sp, sp, rnd.Next(), sp, sp,
+             imagesPerAlbum, sp, sp, nl);
+    s += buf;
+    for (size_t i = 0; i < imagesPerAlbum; ++i) {
+      const unsigned int w = 640 + rnd.Next(4000), h = 480 + rnd.Next(3000);
+      snprintf(buf, sizeof(buf), "%s%s%s{\"name\":%s\"IMG_%04zu.JPG\",%s"
+               "\"url\":%s\"assets-library:\\/\\/asset\\/asset.JPG?id=%08X-"
+               "%04X\",%s\"date\":%s%u.%03u,%s\"size\":%s%u,%s\"w\":%s%u,%s"
+               "\"h\":%s%u,%s\"flagged\":%s%s,%s\"rating\":%s%u,%s"
+               "\"exposure\":%s%.6g,%s\"keywords\":%s[\"%s\",%s\"%s\"],%s"
+               "\"comment\":%snull}%s%s", ind, ind, ind, sp, i, sp, sp,
+               rnd.Next(), rnd.Next(0x10000), sp, sp,
+               1300000000 + rnd.Next(100000000), rnd.Next(1000), sp, sp,
+               100000 + rnd.Next(20000000), sp, sp, w, sp, sp, h, sp, sp,
+               rnd.Next(8) ? "false" : "true", sp, sp, rnd.Next(6), sp, sp,
+               -2 + 4 * rnd.Unit(), sp, sp, keyword[rnd.Next(7)], sp,
+               keyword[rnd.Next(7)], sp, sp,
+               i + 1 < imagesPerAlbum ? "," : "", nl);
+      s += buf;
+    }
+    s += ind; s += ind; s += "]}";
+    if (a + 1 < albumCount)
+      s += ",";
+    s += nl;
+  }
+  s += ind; s += "]"; s += nl; s += "}"; s += nl;
+  return s;
+}
+
+
+static void Usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [-t minSec] [-s scale] [suite ...]\n", prog);
+  for (size_t i = 0; i < gSuiteCount; ++i)
+    fprintf(stderr, "  %-10s %s\n", gSuite[i].name, gSuite[i].desc);
+}
+
+
+int main(int argc, char *argv[]) {
+  std::vector<const Suite *> run;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+      bench::gMinSec = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+      bench::gScale = size_t(atoi(argv[++i]));
+    } else if (argv[i][0] == '-') {
+      Usage(argv[0]);
+      return 1;
+    } else {
+      size_t j = 0;
+      while (j < gSuiteCount && strcmp(gSuite[j].name, argv[i]))
+        ++j;
+      if (j == gSuiteCount) {
+        fprintf(stderr, "Unknown suite \"%s\"\n", argv[i]);
+        Usage(argv[0]);
+        return 1;
+      }
+      run.push_back(&gSuite[j]);
+    }
+  }
+  if (run.empty()) {
+    for (size_t i = 0; i < gSuiteCount; ++i)
+      run.push_back(&gSuite[i]);
+  }
+  if (bench::gScale < 1)
+    bench::gScale = 1;
+  
+  int failures = 0;
+  for (size_t i = 0; i < run.size(); ++i) {
+    if (!run[i]->func())
+      ++failures;
+  }
+  
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,61 @@
+//  Copyright (c) 2013 The 11ers. All rights reserved.
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+
+// Minimal benchmark harness for the Linux build.
+// Each suite is a function registered in Bench.cpp and selected by name
+// on the command line. Suites verify their results against a reference
+// before reporting timings and return false on any mismatch.
+
+namespace bench {
+
+typedef bool (*SuiteFunc)();
+
+// Global options parsed from the command line
+extern double gMinSec;                              // Min time per measure
+extern size_t gScale;                               // Input size multiplier
+
+// Report a timing line. Throughput is printed when bytes > 0.
+void Report(const char *suite, const char *name, double sec, size_t iters,
+            double bytes = 0);
+
+// Print a failure message and return false
+bool Fail(const char *suite, const char *fmt, ...);
+
+// Deterministic pseudo-random numbers for building synthetic inputs
+class Random {
+public:
+  Random(unsigned int seed = 1) : mState(seed) {}
+  unsigned int Next() { mState = mState * 1664525 + 1013904223; return mState; }
+  unsigned int Next(unsigned int n) { return (Next() >> 8) % n; }
+  double Unit() { return (Next() >> 8) / double(1 << 24); }
+private:
+  unsigned int mState;
+};
+
+// Flush the page, dentry and inode caches for cold timings, which needs
+// root. Returns false if they cannot be flushed.
+bool DropCaches();
+
+// Synthetic inputs shared across suites
+std::string AlbumJson(size_t albumCount, size_t imagesPerAlbum, bool pretty);
+
+// Suites
+bool AsyncIOSuite();
+bool Base64Suite();
+bool FilenameSuite();
+bool GeometrySuite();
+bool GlSuite();
+bool JsonSuite();
+bool PngSuite();
+bool WatchdogSuite();
+
+}       // namespace bench
+
+#endif  // BENCH_H
@@ -0,0 +1,324 @@
+//  Copyright (c) 2013 The 11ers. All rights reserved.
+
+#include "Bench.h"
+
+#include "AsyncIO.h"
+#include "TaskMgr.h"
+#include "Thread.h"
+#include "Timer.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+
+using namespace bench;
+
+
+static const char *kSuite = "asyncio";
+
+
+static uint64_t Checksum(const unsigned char *data, size_t len) {
+  uint64_t sum = 0;
+  for (size_t i = 0; i < len; ++i)
+    sum = sum * 31 + data[i];
+  return sum;
+}
+
+
+// Creates a directory of thumbnail-sized files of random bytes
+class Thumbnails {
+public:
+  Thumbnails(size_t count) : mBytes(0) {
+    strcpy(mDir, "/tmp/utilbenchXXXXXX");
+    if (!mkdtemp(mDir)) {
+      mDir[0] = '\0';
+      return;
+    }
+    Random rnd(13);
+    std::vector<unsigned char> data;
+    for (size_t i = 0; i < count; ++i) {
+      char path[PATH_MAX];
+      snprintf(path, sizeof(path), "%s/thumb_%06zu.png", mDir, i);
+      data.resize(2048 + rnd.Next(14 * 1024));
+      for (size_t j = 0; j < data.size(); ++j)
+        data[j] = (unsigned char)(rnd.Next() >> 24);
+      FILE *fp = fopen(path, "wb");
+      if (!fp)
+        break;
+      bool ok = fwrite(&data[0], 1, data.size(), fp) == data.size();
+      fclose(fp);
+      mPathVec.push_back(path);
+      if (!ok)
+        break;
+      mSizeVec.push_back(data.size());
+      mSumVec.push_back(Checksum(&data[0], data.size()));
+      mBytes += data.size();
+    }
+  }
+  ~Thumbnails() {
+    for (size_t i = 0; i < mPathVec.size(); ++i)
+      unlink(mPathVec[i].c_str());
+    if (mDir[0])
+      rmdir(mDir);
+  }
+  size_t Count() const { return mSumVec.size(); }
+  size_t Bytes() const { return mBytes; }
+  const char *Path(size_t i) const { return mPathVec[i].c_str(); }
+  size_t Size(size_t i) const { return mSizeVec[i]; }
+  uint64_t Sum(size_t i) const { return mSumVec[i]; }
+
+private:
+  char mDir[PATH_MAX];
+  std::vector<std::string> mPathVec;
+  std::vector<size_t> mSizeVec;
+  std::vector<uint64_t> mSumVec;
+  size_t mBytes;
+};
+
+
+// Counts down the files processed by tasks
+struct FilesDone {
+  mt::Mutex mutex;
+  mt::ConditionVariable done;
+  size_t pending;
+
+  void Finish() {
+    mt::MutexLockGuard guard(mutex);
+    if (--pending == 0)
+      done.NotifyAll();
+  }
+  void Wait() {
+    mt::MutexLockGuard guard(mutex);
+    while (pending)
+      done.Wait(mutex);
+  }
+};
+
+
+// Continuation of a read, standing in for decoding the file
+class SumTask : public mt::Task {
+public:
+  SumTask(const mt::ReadRequest *request, uint64_t *sum, FilesDone *done)
+    : mRequest(request), mSum(sum), mDone(done) {}
+  virtual bool operator()() {
+    *mSum = mRequest->result < 0 ? 0 :
+            Checksum(mRequest->buffer, size_t(mRequest->result));
+    mDone->Finish();
+    return true;
+  }
+  virtual const char *Name() const { return "SumTask"; }
+
+private:
+  const mt::ReadRequest *mRequest;
+  uint64_t *mSum;
+  FilesDone *mDone;
+};
+
+
+// Reads a file with blocking calls and sums it, as tasks do today
+class BlockingReadTask : public mt::Task {
+public:
+  BlockingReadTask(const char *path, unsigned char *buffer, size_t size,
+                   uint64_t *sum, FilesDone *done)
+    : mPath(path), mBuffer(buffer), mSize(size), mSum(sum), mDone(done) {}
+  virtual bool operator()() {
+    FILE *fp = fopen(mPath, "rb");
+    size_t len = fp ? fread(mBuffer, 1, mSize, fp) : 0;
+    if (fp)
+      fclose(fp);
+    *mSum = Checksum(mBuffer, len);
+    mDone->Finish();
+    return true;
+  }
+  virtual const char *Name() const { return "BlockingReadTask"; }
+
+private:
+  const char *mPath;
+  unsigned char *mBuffer;
+  size_t mSize;
+  uint64_t *mSum;
+  FilesDone *mDone;
+};
+
+
+// Reads every file with the engine, summing each in a continuation task
+static bool ReadAll(mt::AsyncIO &io, const Thumbnails &thumbs,
+                    std::vector<unsigned char> &buffer,
+                    std::vector<mt::ReadRequest> &requestVec,
+                    std::vector<uint64_t> &sumVec) {
+  const size_t count = thumbs.Count();
+  FilesDone done;
+  done.pending = count;
+  unsigned char *next = &buffer[0];
+  for (size_t i = 0; i < count; ++i) {
+    mt::ReadRequest &request = requestVec[i];
+    request.path = thumbs.Path(i);
+    request.buffer = next;
+    request.size = thumbs.Size(i);
+    request.offset = 0;
+    request.then = new SumTask(&request, &sumVec[i], &done);
+    next += thumbs.Size(i);
+    if (!io.Read(&request))
+      return false;
+  }
+  done.Wait();
+  return true;
+}
+
+
+static bool CheckSums(const Thumbnails &thumbs,
+                      const std::vector<uint64_t> &sumVec) {
+  for (size_t i = 0; i < thumbs.Count(); ++i) {
+    if (sumVec[i] != thumbs.Sum(i))
+      return false;
+  }
+  return true;
+}
+
+
+// Errors, partial reads and reads without a continuation or a TaskMgr
+static bool CheckEngine(bool threadPool, const Thumbnails &thumbs) {
+  const char *name = threadPool ? "thread pool" : "io_uring";
+  mt::AsyncIO io;
+  if (!io.Init(NULL, 4, threadPool))
+    return Fail(kSuite, "AsyncIO::Init (%s)", name);
+  if (io.IsThreadPool() != threadPool) {
+    printf("%-10s %-36s unavailable, using the thread pool\n", kSuite,
+           "io_uring");
+    return true;
+  }
+  unsigned char buf[400];
+  mt::ReadRequest missing, part, whole, tail;
+  missing.path = "/nonexistent/file";
+  missing.buffer = buf;
+  missing.size = 100;
+  part.path = thumbs.Path(0);
+  part.buffer = buf;
+  part.size = 100;
+  part.offset = 50;
+  whole.path = thumbs.Path(1);
+  whole.buffer = buf + 100;
+  whole.size = 200;
+  tail.path = thumbs.Path(2);                      // Short read at the end
+  tail.buffer = buf + 300;
+  tail.size = 100;
+  tail.offset = thumbs.Size(2) - 10;
+  FilesDone done;
+  done.pending = 1;
+  uint64_t sum = 0;
+  whole.then = new SumTask(&whole, &sum, &done);   // Run by the engine
+  bool ok = io.Read(&missing) && io.Read(&part) && io.Read(&whole) &&
+            io.Read(&tail);
+  io.Wait();
+  ok = ok && !io.Pending() && !done.pending && missing.result == -ENOENT &&
+       part.result == 100 && whole.result == 200 &&
+       tail.result == 10 && sum == Checksum(buf + 100, 200);
+
+  // The same bytes read by stdio
+  unsigned char expected[310];
+  FILE *fp = fopen(thumbs.Path(0), "rb");
+  ok = ok && fp && fseek(fp, 50, SEEK_SET) == 0 &&
+       fread(expected, 1, 100, fp) == 100;
+  if (fp)
+    fclose(fp);
+  fp = fopen(thumbs.Path(1), "rb");
+  ok = ok && fp && fread(expected + 100, 1, 200, fp) == 200;
+  if (fp)
+    fclose(fp);
+  fp = fopen(thumbs.Path(2), "rb");
+  ok = ok && fp && fseek(fp, tail.offset, SEEK_SET) == 0 &&
+       fread(expected + 300, 1, 10, fp) == 10 && !memcmp(buf, expected, 310);
+  if (fp)
+    fclose(fp);
+  if (!ok)
+    return Fail(kSuite, "AsyncIO (%s) results %ld %ld %ld %ld", name,
+                missing.result, part.result, whole.result, tail.result);
+  return true;
+}
+
+
+// Times reading and summing every file on the calling thread, in blocking
+// tasks on 4 workers, and with each engine and continuations on 4 workers
+static bool ReadPasses(const Thumbnails &thumbs, bool cold) {
+  const size_t count = thumbs.Count();
+  std::vector<unsigned char> buffer(thumbs.Bytes());
+  std::vector<mt::ReadRequest> requestVec(count);
+  std::vector<uint64_t> sumVec(count);
+  mt::TaskMgr taskMgr;
+  bool ok = taskMgr.Init(4);
+  char name[64];
+  const char *suffix = cold ? ", cold" : "";
+
+  for (int method = 0; ok && method < 4; ++method) {
+    mt::AsyncIO io;
+    if (method >= 2)
+      ok = io.Init(&taskMgr, 256, method == 3);
+    if (method == 2 && io.IsThreadPool())
+      continue;                                     // No io_uring
+    double sec = 0;
+    size_t iters = 0;
+    do {
+      if (cold)
+        DropCaches();
+      memset(&sumVec[0], 0, count * sizeof(uint64_t));
+      Timer timer;
+      if (method == 0) {
+        unsigned char *next = &buffer[0];
+        for (size_t i = 0; i < count; ++i) {
+          FILE *fp = fopen(thumbs.Path(i), "rb");
+          size_t len = fp ? fread(next, 1, thumbs.Size(i), fp) : 0;
+          if (fp)
+            fclose(fp);
+          sumVec[i] = Checksum(next, len);
+          next += thumbs.Size(i);
+        }
+      } else if (method == 1) {
+        FilesDone done;
+        done.pending = count;
+        unsigned char *next = &buffer[0];
+        for (size_t i = 0; i < count; ++i) {
+          taskMgr.Schedule(new BlockingReadTask(thumbs.Path(i), next,
+                                                thumbs.Size(i), &sumVec[i],
+                                                &done));
+          next += thumbs.Size(i);
+        }
+        done.Wait();
+      } else {
+        ok = ReadAll(io, thumbs, buffer, requestVec, sumVec);
+      }
+      sec += timer.Elapsed();
+      ++iters;
+      ok = ok && CheckSums(thumbs, sumVec);
+    } while (ok && !cold && sec < gMinSec);
+    static const char *kMethod[] = { "fread", "fread in 4 tasks",
+                                     "AsyncIO io_uring", "AsyncIO threads" };
+    snprintf(name, sizeof(name), "%s %zuk files%s", kMethod[method],
+             count / 1000, suffix);
+    Report(kSuite, name, sec, iters, double(thumbs.Bytes()) * iters);
+  }
+  if (!ok)
+    return Fail(kSuite, "Sums of the files read differ");
+  return true;
+}
+
+
+bool bench::AsyncIOSuite() {
+  Thumbnails thumbs(10000 * gScale);
+  if (thumbs.Count() != 10000 * gScale)
+    return Fail(kSuite, "Cannot create %zu files in /tmp", 10000 * gScale);
+  if (!CheckEngine(false, thumbs) || !CheckEngine(true, thumbs))
+    return false;
+  if (!ReadPasses(thumbs, false))
+    return false;
+  if (!DropCaches()) {
+    printf("%-10s %-36s skipped, cannot drop caches\n", kSuite, "Cold cache");
+    return true;
+  }
+  return ReadPasses(thumbs, true);
+}
@@ -0,0 +1,465 @@
+//  Copyright (c) 2013 The 11ers. All rights reserved.
+
+#include "Bench.h"
+
+#include "Base64.h"
+#include "TaskMgr.h"
+#include "Timer.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+
+using namespace bench;
+
+
+static const char *kSuite = "base64";
+
+
+// The original scalar codec, one block and one push_back at a time, as the
+// reference for output format and speed
+namespace reference {
+
+static const char cb64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                           "abcdefghijklmnopqrstuvwxyz"
+                           "0123456789-_";
+static const char cd64[] = "|$$$}rstuvwxyz{$$$$$$$>?@"
+                           "ABCDEFGHIJKLMNOPQRSTUVW$$$$$$XYZ"
+                           "[\\]^_`abcdefghijklmnopq";
+
+static void Encode(const unsigned char *src, size_t len,
+                   std::vector<unsigned char> &dst) {
+  for (size_t j = 0; j < len; /*EMPTY*/) {
+    size_t k = 0;
+    unsigned char in[3];
+    for (size_t i = 0; i < 3; ++i)
+      in[i] = j < len ? (++k, src[j++]) : 0;
+    dst.push_back(cb64[in[0] >> 2]);
+    dst.push_back(cb64[((in[0] & 0x03) << 4) | ((in[1] & 0xf0) >> 4)]);
+    dst.push_back(k > 1 ? cb64[((in[1] & 0x0f) << 2) | ((in[2] & 0xc0) >> 6)] : '=');
+    dst.push_back(k > 2 ? cb64[in[2] & 0x3f] : '=');
+  }
+  size_t neq = 0;
+  for (size_t i = 0; i < 4 && i < dst.size(); ++i)
+    if (dst[dst.size() - 1 - i] == '=')
+      neq++;
+  dst.resize(dst.size() - neq);
+  for (size_t i = 0; i < neq; ++i) {
+    dst.push_back('%');
+    dst.push_back('3');
+    dst.push_back('D');
+  }
+}
+
+static void Decode(unsigned char *src, size_t len,
+                   std::vector<unsigned char> &dst) {
+  size_t neq = 0;
+  size_t firstPercentIdx = 0;
+  for (size_t j = 1; j < 14 && j <= len; ++j) {
+    if (src[len - j] == '%') {
+      neq++;
+      firstPercentIdx = len - j;
+    }
+  }
+  if (neq) {
+    len -= 2 * neq;
+    for (size_t j = 0; j < neq; ++j)
+      src[firstPercentIdx + j] = '=';
+  }
+  for (size_t j = 0; j < len; /*EMPTY*/) {
+    size_t k = 0;
+    unsigned char in[4] = { 0, 0, 0, 0 };
+    for (size_t i = 0; i < 4 && j < len; ++i) {
+      unsigned char v = 0;
+      while (j < len && v == 0) {
+        v = src[j++];
+        if (v == '-') v = '+';
+        if (v == '_') v = '/';
+        v = (unsigned char) ((v < 43 || v > 122) ? 0 : cd64[v - 43]);
+        if (v)
+          v = (unsigned char) ((v == '$') ? 0 : v - 61);
+      }
+      if (v) {
+        ++k;
+        in[i] = (unsigned char)(v - 1);
+      }
+    }
+    unsigned char out[3] = {
+      (unsigned char) (in[0] << 2 | in[1] >> 4),
+      (unsigned char) (in[1] << 4 | in[2] >> 2),
+      (unsigned char) (((in[2] << 6) & 0xc0) | in[3]),
+    };
+    for (size_t i = 0; i + 1 < k; ++i)
+      dst.push_back(out[i]);
+  }
+}
+
+}       // namespace reference
+
+
+// Encode and Decode must match the reference exactly, on every small size
+// for all padding cases and vector loop ends, and on input with noise
+static bool CheckCodec() {
+  Random rnd(7);
+  for (size_t len = 1; len < 300; ++len) {
+    std::vector<unsigned char> src(len), enc, expected, dec;
+    for (size_t i = 0; i < len; ++i)
+      src[i] = (unsigned char)rnd.Next();
+    Base64::Encode(&src[0], len, enc);
+    reference::Encode(&src[0], len, expected);
+    if (enc != expected)
+      return Fail(kSuite, "Encoding of %zu bytes differs from reference", len);
+    Base64::Decode(&enc[0], enc.size(), dec);
+    if (dec != src || enc != expected)
+      return Fail(kSuite, "Round trip mismatch for %zu bytes", len);
+
+    // Caller buffers of the queried sizes, followed by a guard
+    const size_t encSize = Base64::EncodedSize(len);
+    const size_t decSize = Base64::DecodedMaxSize(encSize);
+    std::vector<unsigned char> buf(encSize + decSize + 64, 0xA5);
+    if (Base64::Encode(&src[0], len, &buf[0]) != encSize ||
+        memcmp(&buf[0], &enc[0], encSize) || buf[encSize] != 0xA5)
+      return Fail(kSuite, "Encoding %zu bytes into a buffer", len);
+    unsigned char *out = &buf[encSize + 1];
+    if (decSize < len || Base64::Decode(&buf[0], encSize, out) != len ||
+        memcmp(out, &src[0], len) ||
+        std::count(out + decSize, &buf[0] + buf.size(), 0xA5) != 64 - 1)
+      return Fail(kSuite, "Decoding %zu bytes into a buffer", len);
+
+    // Line breaks, standard characters and junk between groups
+    static const char kNoise[] = "\r\n =!*~\x80\xff";
+    std::vector<unsigned char> noisy;
+    for (size_t i = 0; i < enc.size(); ++i) {
+      unsigned char c = enc[i];
+      if (c == '-' || c == '_')
+        c = rnd.Next(2) ? c : (c == '-' ? '+' : '/');
+      noisy.push_back(c);
+      if (i + 16 < enc.size() && !rnd.Next(24))
+        noisy.push_back(kNoise[rnd.Next(sizeof(kNoise) - 1)]);
+    }
+    dec.clear();
+    Base64::Decode(&noisy[0], noisy.size(), dec);
+    std::vector<unsigned char> expectedDec, work(noisy);
+    reference::Decode(&work[0], work.size(), expectedDec);
+    if (dec != expectedDec)
+      return Fail(kSuite, "Decoding %zu noisy bytes differs from reference",
+                  noisy.size());
+  }
+  return true;
+}
+
+
+// Collects streamed output, optionally failing after some calls
+struct VectorSink : public Base64::Sink {
+  VectorSink(size_t failAfter = size_t(-1)) : calls(0), failAfter(failAfter) {}
+  virtual bool operator()(const unsigned char *data, size_t len) {
+    if (++calls > failAfter)
+      return false;
+    out.insert(out.end(), data, data + len);
+    return true;
+  }
+  std::vector<unsigned char> out;
+  size_t calls, failAfter;
+};
+
+
+// Counts streamed output without keeping it
+struct CountSink : public Base64::Sink {
+  CountSink() : bytes(0) {}
+  virtual bool operator()(const unsigned char *, size_t len) {
+    bytes += len;
+    return true;
+  }
+  size_t bytes;
+};
+
+
+// Write src to a streaming codec in chunks of random sizes up to maxChunk
+template <class Codec>
+static std::vector<unsigned char> Stream(const std::vector<unsigned char> &src,
+                                         size_t maxChunk, size_t bufferSize,
+                                         Random &rnd) {
+  VectorSink sink;
+  Codec codec(sink, bufferSize);
+  for (size_t i = 0; i < src.size(); ) {
+    size_t n = 1 + rnd.Next(unsigned(maxChunk));
+    n = n < src.size() - i ? n : src.size() - i;
+    codec.Write(&src[i], n);
+    i += n;
+  }
+  codec.Finish();
+  return sink.out;
+}
+
+
+// Streamed output must be that of Encode and Decode for any chunking
+static bool CheckStreaming() {
+  Random rnd(42);
+  static const size_t kMaxChunk[] = { 1, 2, 3, 7, 64, 1000, 100000 };
+  static const size_t kBufferSize[] = { 0, 70, 99, 100, 4096 };  // Any mod 4
+  for (size_t t = 0; t < 60; ++t) {
+    const size_t len = t < 30 ? t : rnd.Next(20000);
+    std::vector<unsigned char> src(len), enc, dec;
+    for (size_t i = 0; i < len; ++i)
+      src[i] = (unsigned char)rnd.Next();
+    Base64::Encode(src.data(), len, enc);
+    if (t % 3 == 0 && enc.size() > 20)
+      enc[rnd.Next(unsigned(enc.size()))] = '\n';   // Noise
+    if (t % 7 == 0) {                               // Odd padding
+      const size_t back = rnd.Next(unsigned(std::min<size_t>(enc.size(), 12) + 1));
+      enc.insert(enc.end() - back, '%');
+    }
+    Base64::Decode(enc.data(), enc.size(), dec);
+    for (size_t c = 0; c < sizeof(kMaxChunk) / sizeof(kMaxChunk[0]); ++c) {
+      const size_t bufferSize = kBufferSize[(t + c) % 5];
+      std::vector<unsigned char> expected;
+      Base64::Encode(src.data(), len, expected);
+      if (Stream<Base64::Encoder>(src, kMaxChunk[c], bufferSize, rnd) !=
+          expected)
+        return Fail(kSuite, "Streamed encoding of %zu bytes in chunks of "
+                    "up to %zu differs", len, kMaxChunk[c]);
+      if (Stream<Base64::Decoder>(enc, kMaxChunk[c], bufferSize, rnd) != dec)
+        return Fail(kSuite, "Streamed decoding of %zu characters in chunks "
+                    "of up to %zu differs", enc.size(), kMaxChunk[c]);
+    }
+  }
+  
+  // Every tail against every room left in buffers of each size mod 4
+  for (size_t bufferSize = 64; bufferSize < 72; ++bufferSize) {
+    for (size_t len = 0; len < 150; ++len) {
+      std::vector<unsigned char> src(len, (unsigned char)len), expected;
+      Base64::Encode(src.data(), len, expected);
+      if (Stream<Base64::Encoder>(src, len + 1, bufferSize, rnd) != expected)
+        return Fail(kSuite, "Streamed encoding of %zu bytes with a buffer of "
+                    "%zu differs", len, bufferSize);
+    }
+  }
+  
+  // A failing sink stops the codec until Finish
+  std::vector<unsigned char> src(10000, 'x');
+  VectorSink sink(2);
+  Base64::Encoder encoder(sink, 1000);
+  bool ok = encoder.Write(src.data(), src.size());
+  if (ok || encoder.Finish() || sink.calls != 3)
+    return Fail(kSuite, "Encoder did not stop when its sink failed");
+  return true;
+}
+
+
+// Streams a large file through the codec, against reading it whole
+static bool FileBench() {
+  const size_t len = 16 * 1024 * 1024 * gScale;
+  std::vector<unsigned char> src(len);
+  Random rnd(9);
+  for (size_t i = 0; i < len; ++i)
+    src[i] = (unsigned char)rnd.Next();
+  char path[] = "/tmp/utilbenchXXXXXX", encPath[] = "/tmp/utilbenchXXXXXX";
+  int fd = mkstemp(path), encFd = mkstemp(encPath);
+  std::vector<unsigned char> enc;
+  Base64::Encode(src.data(), len, enc);
+  bool ok = fd >= 0 && encFd >= 0 &&
+            write(fd, src.data(), len) == ssize_t(len) &&
+            write(encFd, enc.data(), enc.size()) == ssize_t(enc.size());
+  if (fd >= 0)
+    close(fd);
+  if (encFd >= 0)
+    close(encFd);
+  
+  const size_t chunkSize = 64 * 1024;
+  for (int decode = 0; ok && decode < 2; ++decode) {
+    double sec = 0;
+    size_t iters = 0;
+    CountSink sink;
+    do {
+      sink.bytes = 0;
+      Timer timer;
+      ok = decode ? Base64::DecodeFile(encPath, sink, chunkSize) :
+                    Base64::EncodeFile(path, sink, chunkSize);
+      sec += timer.Elapsed();
+      ++iters;
+    } while (ok && sec < gMinSec);
+    ok = ok && sink.bytes == (decode ? len : enc.size());
+    char name[64];
+    snprintf(name, sizeof(name), "%s %zuMB file, 64KB chunks",
+             decode ? "DecodeFile" : "EncodeFile", len / (1024 * 1024));
+    Report(kSuite, name, sec, iters, double(decode ? enc.size() : len) * iters);
+  }
+  if (ok)
+    printf("%-10s %-36s %zu KB, whole buffers %zu KB\n", kSuite,
+           "EncodeFile peak memory", 2 * chunkSize / 1024,
+           (len + enc.size()) / 1024);
+  unlink(path);
+  unlink(encPath);
+  if (!ok)
+    return Fail(kSuite, "Streaming a file in /tmp");
+  return true;
+}
+
+
+// Codes a buffer too large for the caches with 1 to 8 tasks, on as many
+// threads, against memcpy as the memory bandwidth bound
+static bool ParallelBench() {
+  const size_t len = 256 * 1024 * 1024 * gScale + 1;
+  std::vector<unsigned char> src(len);
+  Random rnd(10);
+  for (size_t i = 0; i + 4 <= len; i += 4) {
+    const unsigned int r = rnd.Next();
+    memcpy(&src[i], &r, 4);
+  }
+  std::vector<unsigned char> enc(Base64::EncodedSize(len));
+  std::vector<unsigned char> dec(Base64::DecodedMaxSize(enc.size()));
+  Base64::Encode(&src[0], len, &enc[0]);
+  
+  // Noise moves the output of later segments, and inputs too small to
+  // split are coded on the calling thread
+  mt::TaskMgr taskMgr;
+  bool ok = taskMgr.Init(3);
+  std::vector<unsigned char> noisy(enc.begin(), enc.begin() + 4000000 + 1);
+  for (size_t i = 1000; i < noisy.size(); i += 76 * 1000)
+    noisy.insert(noisy.begin() + i, '\n');
+  std::vector<unsigned char> expected(Base64::DecodedMaxSize(noisy.size()));
+  expected.resize(Base64::Decode(&noisy[0], noisy.size(), &expected[0]));
+  ok = ok && Base64::DecodeParallel(&noisy[0], noisy.size(), &dec[0],
+                                    &taskMgr, 4) == expected.size() &&
+       !memcmp(&dec[0], &expected[0], expected.size());
+  for (size_t n = 0; ok && n < 300; n += 7) {
+    ok = Base64::EncodeParallel(&src[0], n, &dec[0], &taskMgr, 4) ==
+           Base64::EncodedSize(n) && !memcmp(&dec[0], &enc[0], n / 3 * 4);
+  }
+  if (!ok)
+    return Fail(kSuite, "Parallel decoding of noise or small inputs");
+  
+  double sec = 0;
+  size_t iters = 0;
+  do {
+    Timer timer;
+    memcpy(&dec[0], &src[0], len);
+    sec += timer.Elapsed();
+    ++iters;
+  } while (sec < gMinSec);
+  char name[64];
+  snprintf(name, sizeof(name), "memcpy %zuMB", len / (1024 * 1024));
+  Report(kSuite, name, sec, iters, double(len) * iters);
+  
+  std::vector<unsigned char> out(enc.size());
+  for (size_t threads = 1; ok && threads <= 8; threads *= 2) {
+    mt::TaskMgr *workers = NULL;
+    if (threads > 1) {
+      workers = new mt::TaskMgr;
+      ok = workers->Init(threads - 1);              // And the calling thread
+    }
+    for (int decode = 0; ok && decode < 2; ++decode) {
+      sec = 0;
+      iters = 0;
+      size_t size = 0;
+      do {
+        Timer timer;
+        size = decode ?
+          Base64::DecodeParallel(&enc[0], enc.size(), &dec[0], workers, threads) :
+          Base64::EncodeParallel(&src[0], len, &out[0], workers, threads);
+        sec += timer.Elapsed();
+        ++iters;
+      } while (sec < gMinSec);
+      ok = decode ? size == len && !memcmp(&dec[0], &src[0], len) :
+                    size == enc.size() && out == enc;
+      snprintf(name, sizeof(name), "%s %zuMB, %zu threads",
+               decode ? "DecodeParallel" : "EncodeParallel",
+               len / (1024 * 1024), threads);
+      Report(kSuite, name, sec, iters, double(decode ? enc.size() : len) * iters);
+    }
+    delete workers;
+  }
+  if (!ok)
+    return Fail(kSuite, "Parallel coding differs from Encode and Decode");
+  return true;
+}
+
+
+bool bench::Base64Suite() {
+  if (!CheckCodec() || !CheckStreaming())
+    return false;
+
+  // Throughput on an image-sized buffer
+  Random rnd(8);
+  const size_t len = 4 * 1024 * 1024 * gScale + 1;
+  std::vector<unsigned char> src(len);
+  for (size_t i = 0; i < len; ++i)
+    src[i] = (unsigned char)rnd.Next();
+
+  std::vector<unsigned char> enc;
+  Timer timer;
+  size_t iters = 0;
+  do {
+    enc.clear();
+    reference::Encode(&src[0], len, enc);
+    ++iters;
+  } while (timer.Elapsed() < gMinSec);
+  Report(kSuite, "Encode 4MB, reference", timer.Elapsed(), iters,
+         double(len) * iters);
+
+  timer.Restart();
+  iters = 0;
+  do {
+    enc.clear();
+    Base64::Encode(&src[0], len, enc);
+    ++iters;
+  } while (timer.Elapsed() < gMinSec);
+  Report(kSuite, "Encode 4MB", timer.Elapsed(), iters, double(len) * iters);
+
+  std::vector<unsigned char> buf(Base64::EncodedSize(len));
+  timer.Restart();
+  iters = 0;
+  do {
+    Base64::Encode(&src[0], len, &buf[0]);
+    ++iters;
+  } while (timer.Elapsed() < gMinSec);
+  Report(kSuite, "Encode 4MB, caller buffer", timer.Elapsed(), iters,
+         double(len) * iters);
+  if (buf != enc)
+    return Fail(kSuite, "Encoded buffers differ");
+
+  std::vector<unsigned char> work(enc.size()), dec;
+  double sec = 0;
+  iters = 0;
+  do {
+    memcpy(&work[0], &enc[0], enc.size());      // Reference modifies input
+    dec.clear();
+    Timer t;
+    reference::Decode(&work[0], work.size(), dec);
+    sec += t.Elapsed();
+    ++iters;
+  } while (sec < gMinSec);
+  Report(kSuite, "Decode 4MB, reference", sec, iters,
+         double(enc.size()) * iters);
+
+  timer.Restart();
+  iters = 0;
+  do {
+    dec.clear();
+    Base64::Decode(&enc[0], enc.size(), dec);
+    ++iters;
+  } while (timer.Elapsed() < gMinSec);
+  Report(kSuite, "Decode 4MB", timer.Elapsed(), iters,
+         double(enc.size()) * iters);
+  if (dec != src)
+    return Fail(kSuite, "Decoded buffer does not match source");
+
+  buf.resize(Base64::DecodedMaxSize(enc.size()));
+  size_t size = 0;
+  timer.Restart();
+  iters = 0;
+  do {
+    size = Base64::Decode(&enc[0], enc.size(), &buf[0]);
+    ++iters;
+  } while (timer.Elapsed() < gMinSec);
+  Report(kSuite, "Decode 4MB, caller buffer", timer.Elapsed(), iters,
+         double(enc.size()) * iters);
+  if (size != len || memcmp(&buf[0], &src[0], len))
+    return Fail(kSuite, "Decoded buffer does not match source");
+
+  return FileBench() && ParallelBench();
+}
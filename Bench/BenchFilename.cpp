@@ -0,0 +1,849 @@
+//  Copyright (c) 2013 The 11ers. All rights reserved.
+
+#include "Bench.h"
+
+#include "Filename.h"
+#include "MappedFile.h"
+#include "TaskMgr.h"
+#include "Timer.h"
+#include "lodepng.h"
+
+#include <algorithm>
+#include <dirent.h>
+#include <fnmatch.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+
+using namespace bench;
+
+
+static const char *kSuite = "filename";
+
+
+// Creates a temporary directory filled with small files
+class TempDir {
+public:
+  TempDir(size_t fileCount) {
+    strcpy(mDir, "/tmp/utilbenchXXXXXX");
+    if (!mkdtemp(mDir)) {
+      mDir[0] = '\0';
+      return;
+    }
+    for (size_t i = 0; i < fileCount; ++i) {
+      char path[PATH_MAX];
+      snprintf(path, sizeof(path), "%s/IMG_%06zu.jpg", mDir, i);
+      FILE *fp = fopen(path, "w");
+      if (!fp)
+        break;
+      fprintf(fp, "%zu\n", i);
+      fclose(fp);
+      mFileVec.push_back(path);
+    }
+  }
+  ~TempDir() {
+    for (size_t i = 0; i < mFileVec.size(); ++i)
+      unlink(mFileVec[i].c_str());
+    if (mDir[0])
+      rmdir(mDir);
+  }
+  const char *Dir() const { return mDir; }
+  const std::vector<std::string> &Files() const { return mFileVec; }
+  
+private:
+  char mDir[PATH_MAX];
+  std::vector<std::string> mFileVec;
+};
+
+
+static bool SameInfo(const Filename::StatInfo &a, const Filename::StatInfo &b) {
+  return a.modEpochSec == b.modEpochSec &&
+         a.accessEpochSec == b.accessEpochSec && a.size == b.size &&
+         a.isDirectory == b.isDirectory && a.isReadable == b.isReadable &&
+         a.isWritable == b.isWritable;
+}
+
+
+// Times one pass of each way to query the metadata of every file, in
+// separate passes after flushing the caches when cold
+static bool StatPasses(const std::vector<std::string> &file, bool cold) {
+  const size_t count = file.size();
+  const char *suffix = cold ? ", cold" : "";
+  char name[64];
+  double sec = 0, epoch = 0;
+  size_t iters = 0;
+  do {
+    if (cold)
+      DropCaches();
+    Timer timer;
+    for (size_t i = 0; i < count; ++i) {
+      const char *path = file[i].c_str();
+      if (Filename::IsAccessible(path))
+        epoch += Filename::ModEpochSec(path) + Filename::AccessEpochSec(path) +
+                 Filename::FileSize(path);
+    }
+    sec += timer.Elapsed();
+    ++iters;
+  } while (!cold && sec < gMinSec);
+  snprintf(name, sizeof(name), "4 single queries %zuk%s",
+           count / 1000, suffix);
+  Report(kSuite, name, sec, iters);
+  
+  sec = 0;
+  iters = 0;
+  Filename::StatInfo info;
+  do {
+    if (cold)
+      DropCaches();
+    Timer timer;
+    for (size_t i = 0; i < count; ++i) {
+      if (Filename::Stat(file[i].c_str(), &info) && info.isReadable)
+        epoch += info.modEpochSec + info.accessEpochSec + info.size;
+    }
+    sec += timer.Elapsed();
+    ++iters;
+  } while (!cold && sec < gMinSec);
+  snprintf(name, sizeof(name), "Stat %zuk%s", count / 1000, suffix);
+  Report(kSuite, name, sec, iters);
+  
+  std::vector<Filename::StatInfo> infoVec;
+  bool ok = epoch > 0;
+  for (size_t threads = 1; ok && threads <= 8; threads *= 2) {
+    mt::TaskMgr *workers = NULL;
+    if (threads > 1) {
+      workers = new mt::TaskMgr;
+      ok = workers->Init(threads - 1);              // And the calling thread
+    }
+    sec = 0;
+    iters = 0;
+    size_t found = 0;
+    do {
+      if (cold)
+        DropCaches();
+      Timer timer;
+      found = Filename::StatBatch(file, infoVec, workers, threads);
+      sec += timer.Elapsed();
+      ++iters;
+    } while (!cold && sec < gMinSec);
+    delete workers;
+    snprintf(name, sizeof(name), "StatBatch %zuk, %zu threads%s",
+             count / 1000, threads, suffix);
+    Report(kSuite, name, sec, iters);
+    ok = ok && found == count;
+  }
+  if (!ok)
+    return Fail(kSuite, "StatBatch did not find all %zu files", count);
+  return true;
+}
+
+
+// Checks Stat against the single queries, then times them on many files
+static bool StatBench() {
+  const size_t count = 100000 * gScale;
+  TempDir tmp(count);
+  const std::vector<std::string> &file = tmp.Files();
+  if (file.size() != count)
+    return Fail(kSuite, "Cannot create %zu temporary files in /tmp", count);
+  
+  Filename::StatInfo info;
+  if (Filename::Stat("/nonexistent/file", &info) || info.size)
+    return Fail(kSuite, "Stat of a missing file succeeded");
+  if (!Filename::Stat(tmp.Dir(), &info) || !info.isDirectory ||
+      !info.isReadable)
+    return Fail(kSuite, "Stat of the temporary directory");
+  chmod(file[1].c_str(), 0444);
+  for (size_t i = 0; i < count; i += 997) {
+    const char *path = file[i].c_str();
+    if (!Filename::Stat(path, &info) || info.isDirectory ||
+        info.modEpochSec != Filename::ModEpochSec(path) ||
+        info.accessEpochSec != Filename::AccessEpochSec(path) ||
+        info.size != Filename::FileSize(path) ||
+        info.isReadable != Filename::IsAccessible(path) ||
+        info.isWritable != Filename::IsAccessible(path, true))
+      return Fail(kSuite, "Stat(\"%s\") differs from single queries", path);
+  }
+  
+  std::vector<std::string> pathVec(file.begin(), file.begin() + 1000);
+  pathVec.push_back("/nonexistent/file");
+  std::vector<Filename::StatInfo> infoVec;
+  mt::TaskMgr taskMgr;
+  bool ok = taskMgr.Init(3) &&
+            Filename::StatBatch(pathVec, infoVec, &taskMgr, 4) == 1000 &&
+            infoVec.size() == pathVec.size();
+  for (size_t i = 0; ok && i < pathVec.size(); ++i) {
+    Filename::Stat(pathVec[i].c_str(), &info);
+    ok = SameInfo(info, infoVec[i]);
+  }
+  if (!ok)
+    return Fail(kSuite, "StatBatch differs from Stat");
+  
+  if (!StatPasses(file, false))
+    return false;
+  if (!DropCaches()) {
+    printf("%-10s %-36s skipped, cannot drop caches\n", kSuite, "Cold cache");
+    return true;
+  }
+  return StatPasses(file, true);
+}
+
+
+// Creates a photo cache like tree: files at the top, in 256 hashed
+// subdirectories and in some of their own subdirectories
+class TempTree {
+public:
+  TempTree(size_t filesPerDir) {
+    strcpy(mRoot, "/tmp/utilbenchXXXXXX");
+    if (!mkdtemp(mRoot)) {
+      mRoot[0] = '\0';
+      return;
+    }
+    char dir[PATH_MAX];
+    AddFiles(mRoot, 16);
+    for (unsigned int i = 0; i < 256; ++i) {
+      snprintf(dir, sizeof(dir), "%s/%02x", mRoot, i);
+      if (!AddDir(dir) || !AddFiles(dir, filesPerDir))
+        return;
+      if (i % 16 == 0) {
+        snprintf(dir, sizeof(dir), "%s/%02x/small", mRoot, i);
+        if (!AddDir(dir) || !AddFiles(dir, 20))
+          return;
+      }
+    }
+  }
+  ~TempTree() {
+    for (size_t i = 0; i < mFileVec.size(); ++i)
+      unlink(mFileVec[i].c_str());
+    for (size_t i = mDirVec.size(); i > 0; --i)
+      rmdir(mDirVec[i - 1].c_str());
+    if (mRoot[0])
+      rmdir(mRoot);
+  }
+  const char *Root() const { return mRoot; }
+  const std::vector<std::string> &Files() const { return mFileVec; }
+  
+private:
+  bool AddDir(const char *dir) {
+    if (mkdir(dir, 0755))
+      return false;
+    mDirVec.push_back(dir);
+    return true;
+  }
+  bool AddFiles(const char *dir, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      char path[PATH_MAX];
+      snprintf(path, sizeof(path), "%s/IMG_%06zu.%s", dir, i,
+               i % 2 ? "png" : "jpg");
+      FILE *fp = fopen(path, "w");
+      if (!fp)
+        return false;
+      fclose(fp);
+      mFileVec.push_back(path);
+    }
+    return true;
+  }
+  
+  char mRoot[PATH_MAX];
+  std::vector<std::string> mDirVec;
+  std::vector<std::string> mFileVec;
+};
+
+
+// Recursive listing with opendir and a std::string per path, the way
+// ListDirectory lists one directory
+static void ReaddirTree(const std::string &dirname, const char *pattern,
+                        std::vector<std::string> &pathVec) {
+  DIR *dir = opendir(dirname.c_str());
+  if (!dir)
+    return;
+  std::vector<std::string> subdirVec;
+  for (struct dirent *f = readdir(dir); f != NULL; f = readdir(dir)) {
+    if (f->d_type == DT_REG) {
+      if (!pattern || !fnmatch(pattern, f->d_name, 0))
+        pathVec.push_back(dirname + "/" + f->d_name);
+    } else if (f->d_type == DT_DIR && strcmp(f->d_name, ".") &&
+               strcmp(f->d_name, "..")) {
+      subdirVec.push_back(dirname + "/" + f->d_name);
+    }
+  }
+  closedir(dir);
+  for (size_t i = 0; i < subdirVec.size(); ++i)
+    ReaddirTree(subdirVec[i], pattern, pathVec);
+}
+
+
+static std::vector<std::string> Sorted(const Filename::PathList &pathList) {
+  std::vector<std::string> pathVec;
+  for (size_t i = 0; i < pathList.Size(); ++i)
+    pathVec.push_back(pathList[i]);
+  std::sort(pathVec.begin(), pathVec.end());
+  return pathVec;
+}
+
+
+static bool SameOrder(const Filename::PathList &a, const Filename::PathList &b) {
+  if (a.Size() != b.Size() || a.Bytes() != b.Bytes())
+    return false;
+  for (size_t i = 0; i < a.Size(); ++i) {
+    if (strcmp(a[i], b[i]))
+      return false;
+  }
+  return true;
+}
+
+
+// Times one recursive listing of the tree with readdir and std::string,
+// with ScanDirectory and with ScanDirectory on 2 to 8 threads
+static bool ScanPasses(const char *root, size_t count, bool cold) {
+  const char *suffix = cold ? ", cold" : "";
+  char name[64];
+  double sec = 0;
+  size_t iters = 0;
+  std::vector<std::string> pathVec;
+  do {
+    if (cold)
+      DropCaches();
+    pathVec.clear();
+    Timer timer;
+    ReaddirTree(root, NULL, pathVec);
+    sec += timer.Elapsed();
+    ++iters;
+  } while (!cold && sec < gMinSec);
+  snprintf(name, sizeof(name), "readdir+string %zuk%s", count / 1000, suffix);
+  Report(kSuite, name, sec, iters);
+  
+  Filename::PathList pathList;
+  bool ok = true;
+  for (size_t threads = 1; ok && threads <= 8; threads *= 2) {
+    mt::TaskMgr *workers = NULL;
+    if (threads > 1) {
+      workers = new mt::TaskMgr;
+      ok = workers->Init(threads - 1);              // And the calling thread
+    }
+    sec = 0;
+    iters = 0;
+    do {
+      if (cold)
+        DropCaches();
+      pathList.Clear();
+      Timer timer;
+      ok = ok && Filename::ScanDirectory(root, NULL, true, pathList, workers,
+                                         threads);
+      sec += timer.Elapsed();
+      ++iters;
+    } while (!cold && sec < gMinSec);
+    delete workers;
+    snprintf(name, sizeof(name), "ScanDirectory %zuk, %zu threads%s",
+             count / 1000, threads, suffix);
+    Report(kSuite, name, sec, iters);
+    ok = ok && pathList.Size() == count;
+  }
+  if (!ok)
+    return Fail(kSuite, "ScanDirectory found %zu of %zu files",
+                pathList.Size(), count);
+  return true;
+}
+
+
+static std::string EventString(const std::vector<Filename::DirWatch::Event> &eventVec,
+                               size_t rootLen) {
+  static const char *kChange[] = { "created", "modified", "deleted", "overflow" };
+  std::string s;
+  for (size_t i = 0; i < eventVec.size(); ++i) {
+    s += eventVec[i].path.substr(rootLen) + " ";
+    s += kChange[eventVec[i].change];
+    s += "; ";
+  }
+  return s;
+}
+
+
+// Makes the same changes to a small tree watched each way, and expects the
+// same coalesced events
+static bool CheckWatch(bool polling) {
+  TempTree tree(4);
+  const std::string root = tree.Root();
+  Filename::DirWatch watch;
+  std::vector<Filename::DirWatch::Event> eventVec;
+  if (!watch.Init(tree.Root(), polling) || watch.IsPolling() != polling ||
+      !watch.Poll(eventVec) || !eventVec.empty())
+    return Fail(kSuite, "DirWatch::Init(%s)", polling ? "polling" : "inotify");
+  
+  const std::string added = root + "/00/added.jpg";
+  const std::string temp = root + "/01/temp.jpg";
+  const std::string dir = root + "/new", inDir = dir + "/IMG_1.jpg";
+  FILE *fp = fopen(added.c_str(), "w");
+  if (fp) {
+    fputs("added", fp);                             // Created and modified
+    fclose(fp);
+  }
+  if ((fp = fopen(tree.Files()[20].c_str(), "a"))) {
+    fputs("modified", fp);
+    fclose(fp);
+  }
+  unlink(tree.Files()[30].c_str());
+  if ((fp = fopen(temp.c_str(), "w")))
+    fclose(fp);
+  unlink(temp.c_str());                             // Never seen
+  mkdir(dir.c_str(), 0755);
+  if ((fp = fopen(inDir.c_str(), "w")))
+    fclose(fp);
+  
+  const std::string expected = "/00/added.jpg created; "
+                               "/00/small/IMG_000000.jpg modified; "
+                               "/00/small/IMG_000010.jpg deleted; "
+                               "/new/IMG_1.jpg created; ";
+  bool ok = watch.Poll(eventVec, 1) &&
+            EventString(eventVec, root.size()) == expected;
+  std::string got = EventString(eventVec, root.size());
+  
+  // Deleted and created again, after the events above were taken
+  unlink(added.c_str());
+  if ((fp = fopen(added.c_str(), "w")))
+    fclose(fp);
+  unlink(inDir.c_str());
+  rmdir(dir.c_str());
+  ok = ok && watch.Poll(eventVec, 1) &&
+       EventString(eventVec, root.size()) ==
+         "/00/added.jpg modified; /new/IMG_1.jpg deleted; ";
+  if (ok)
+    got = EventString(eventVec, root.size());
+  unlink(added.c_str());
+  if (!ok)
+    return Fail(kSuite, "DirWatch (%s) events: %s", polling ? "polling" :
+                "inotify", got.c_str());
+  return true;
+}
+
+
+// Times a check for changes in a large tree without any, watched each way
+static bool WatchBench(const char *root, size_t count) {
+  if (!CheckWatch(false) || !CheckWatch(true))
+    return false;
+  std::vector<Filename::DirWatch::Event> eventVec;
+  for (int polling = 0; polling < 2; ++polling) {
+    Filename::DirWatch watch;
+    Timer timer;
+    bool ok = watch.Init(root, polling != 0);
+    char name[64];
+    snprintf(name, sizeof(name), "DirWatch::Init %zuk, %s", count / 1000,
+             polling ? "polling" : "inotify");
+    Report(kSuite, name, timer.Elapsed(), 1);
+    double sec = 0;
+    size_t iters = 0;
+    do {
+      Timer t;
+      ok = ok && watch.Poll(eventVec) && eventVec.empty();
+      sec += t.Elapsed();
+      ++iters;
+    } while (ok && sec < gMinSec);
+    snprintf(name, sizeof(name), "DirWatch::Poll %zuk, %s", count / 1000,
+             polling ? "polling" : "inotify");
+    Report(kSuite, name, sec, iters);
+    if (!ok)
+      return Fail(kSuite, "%s reports changes in an unchanged tree", name);
+  }
+  return true;
+}
+
+
+// Checks ScanDirectory against readdir, then times them on a large tree
+static bool ScanBench() {
+  TempTree tree(400 * gScale);
+  const size_t count = 16 + 256 * 400 * gScale + 16 * 20;
+  if (tree.Files().size() != count)
+    return Fail(kSuite, "Cannot create %zu temporary files in /tmp", count);
+  std::vector<std::string> expected(tree.Files());
+  std::sort(expected.begin(), expected.end());
+  
+  Filename::PathList pathList, parallelList;
+  if (Filename::ScanDirectory("/nonexistent", NULL, true, pathList) ||
+      pathList.Size())
+    return Fail(kSuite, "ScanDirectory of a missing directory succeeded");
+  if (!Filename::ScanDirectory(tree.Root(), NULL, true, pathList) ||
+      Sorted(pathList) != expected)
+    return Fail(kSuite, "ScanDirectory lists %zu of %zu files",
+                pathList.Size(), count);
+  mt::TaskMgr taskMgr;
+  if (!taskMgr.Init(3) ||
+      !Filename::ScanDirectory(tree.Root(), NULL, true, parallelList,
+                               &taskMgr, 4) ||
+      !SameOrder(pathList, parallelList))
+    return Fail(kSuite, "Parallel ScanDirectory differs from sequential");
+  
+  const char *patterns[] = { "*.jpg", "IMG_0*[13579].png", "*" };
+  for (size_t i = 0; i < sizeof(patterns) / sizeof(patterns[0]); ++i) {
+    std::vector<std::string> pathVec;
+    ReaddirTree(tree.Root(), patterns[i], pathVec);
+    std::sort(pathVec.begin(), pathVec.end());
+    pathList.Clear();
+    if (!Filename::ScanDirectory(tree.Root(), patterns[i], true, pathList) ||
+        Sorted(pathList) != pathVec)
+      return Fail(kSuite, "ScanDirectory \"%s\" lists %zu of %zu files",
+                  patterns[i], pathList.Size(), pathVec.size());
+  }
+  std::vector<std::string> nameVec;
+  pathList.Clear();
+  if (!Filename::ListDirectory(tree.Root(), nameVec) ||
+      !Filename::ScanDirectory(tree.Root(), NULL, false, pathList) ||
+      pathList.Size() != nameVec.size() || nameVec.size() != 16)
+    return Fail(kSuite, "ScanDirectory of the top directory lists %zu files",
+                pathList.Size());
+  
+  size_t stringBytes = 0;
+  for (size_t i = 0; i < expected.size(); ++i)
+    stringBytes += sizeof(std::string) + expected[i].capacity() + 1;
+  pathList.Clear();
+  Filename::ScanDirectory(tree.Root(), NULL, true, pathList);
+  printf("%-10s %-36s %zu KB, std::string %zu KB\n", kSuite,
+         "PathList memory", (pathList.Bytes() + count * sizeof(size_t)) / 1024,
+         stringBytes / 1024);
+  
+  if (!ScanPasses(tree.Root(), count, false))
+    return false;
+  if (DropCaches() && !ScanPasses(tree.Root(), count, true))
+    return false;                                   // Else see StatBench
+  return WatchBench(tree.Root(), count);
+}
+
+
+// Sum of the 64-bit words in data, which reads every page
+static uint64_t SumWords(const unsigned char *data, size_t len) {
+  uint64_t sum = 0, word;
+  for (size_t i = 0; i + 8 <= len; i += 8) {
+    memcpy(&word, data + i, 8);
+    sum += word;
+  }
+  return sum;
+}
+
+
+static bool WriteTempFile(char path[], const void *data, size_t len) {
+  int fd = mkstemp(path);
+  if (fd < 0)
+    return false;
+  bool ok = write(fd, data, len) == ssize_t(len);
+  close(fd);
+  return ok;
+}
+
+
+// Checks the modes of MappedFile and decoding a PNG from a mapping
+static bool CheckMapped(const char *path, const std::vector<unsigned char> &src) {
+  MappedFile file;
+  if (file.Open("/nonexistent/file") || file.IsOpen() || file.Open("/tmp"))
+    return Fail(kSuite, "MappedFile opened a missing file or a directory");
+  if (!file.Open(path) || !file.IsMapped() || file.Size() != src.size() ||
+      memcmp(file.Data(), &src[0], src.size()) || file.MutableData() ||
+      !file.Advise(MappedFile::Random, 12345, 100))
+    return Fail(kSuite, "MappedFile differs from the file written");
+  if (!file.Open(path, MappedFile::CopyOnWrite) || !file.MutableData())
+    return Fail(kSuite, "MappedFile cannot be opened copy-on-write");
+  file.MutableData()[0] = ~src[0];
+  if (file.Advise(MappedFile::DontNeed) ||
+      file.Data()[0] != (unsigned char)~src[0])
+    return Fail(kSuite, "MappedFile discarded copy-on-write changes");
+  if (!file.Open(path) || file.Data()[0] != src[0])
+    return Fail(kSuite, "MappedFile copy-on-write changed the file");
+  if (!file.Open("/proc/self/maps") || file.IsMapped() || !file.Size() ||
+      file.Data()[file.Size() - 1] != '\n')
+    return Fail(kSuite, "MappedFile of /proc/self/maps read %zu bytes",
+                file.Size());
+  file.Close();
+  
+  // Synthetic photo-like image, as a PNG file
+  const unsigned w = 512, h = 384;
+  std::vector<unsigned char> rgba(w * h * 4);
+  Random rnd(11);
+  for (size_t i = 0; i < rgba.size(); ++i)
+    rgba[i] = (unsigned char)(i % 4 == 3 ? 255 : (i / 4 % w + rnd.Next(16)));
+  unsigned char *png = NULL, *image = NULL, *expected = NULL;
+  size_t pngSize = 0;
+  char pngPath[] = "/tmp/utilbenchXXXXXX";
+  unsigned pw = 0, ph = 0, ew = 0, eh = 0;
+  bool ok = !lodepng_encode32(&png, &pngSize, &rgba[0], w, h) &&
+            WriteTempFile(pngPath, png, pngSize) &&
+            !lodepng_decode32_file(&image, &pw, &ph, pngPath) &&
+            !lodepng_decode32(&expected, &ew, &eh, png, pngSize) &&
+            pw == w && ph == h && ew == w && eh == h &&
+            !memcmp(image, expected, rgba.size()) &&
+            !memcmp(image, &rgba[0], rgba.size());
+  unsigned char *none = NULL;
+  ok = ok && lodepng_decode32_file(&none, &pw, &ph, "/nonexistent/file") == 78;
+  free(png);
+  lodepng_free_decoded(image);
+  lodepng_free_decoded(expected);
+  unlink(pngPath);
+  if (!ok)
+    return Fail(kSuite, "lodepng_decode32_file differs from lodepng_decode32");
+  return true;
+}
+
+
+// Reads a large file into a buffer, against mapping it
+static bool MappedBench() {
+  const size_t len = 64 * 1024 * 1024 * gScale;
+  std::vector<unsigned char> src(len);
+  Random rnd(12);
+  for (size_t i = 0; i + 4 <= len; i += 4) {
+    const unsigned int r = rnd.Next();
+    memcpy(&src[i], &r, 4);
+  }
+  char path[] = "/tmp/utilbenchXXXXXX";
+  if (!WriteTempFile(path, &src[0], len)) {
+    unlink(path);
+    return Fail(kSuite, "Cannot write %zu bytes in /tmp", len);
+  }
+  bool ok = CheckMapped(path, src);
+  const uint64_t expected = SumWords(&src[0], len);
+  
+  for (int mapped = 0; ok && mapped < 2; ++mapped) {
+    double sec = 0;
+    size_t iters = 0;
+    do {
+      Timer timer;
+      uint64_t sum = 0;
+      if (mapped) {
+        MappedFile file;
+        ok = file.Open(path);
+        sum = SumWords(file.Data(), file.Size());
+      } else {
+        FILE *fp = fopen(path, "rb");
+        unsigned char *buf = (unsigned char *)malloc(len);
+        ok = fp && buf && fread(buf, 1, len, fp) == len;
+        sum = ok ? SumWords(buf, len) : 0;
+        free(buf);
+        if (fp)
+          fclose(fp);
+      }
+      sec += timer.Elapsed();
+      ++iters;
+      ok = ok && sum == expected;
+    } while (ok && sec < gMinSec);
+    char name[64];
+    snprintf(name, sizeof(name), "%s %zuMB file", mapped ? "MappedFile" :
+             "malloc+fread", len / (1024 * 1024));
+    Report(kSuite, name, sec, iters, double(len) * iters);
+  }
+  unlink(path);
+  if (!ok)
+    return Fail(kSuite, "Sums of the file read and mapped differ");
+  return true;
+}
+
+
+// Expected results of the path views on awkward paths
+static bool CheckPathViews() {
+  static const struct {
+    const char *path, *dir, *base, *ext, *normal;
+  } kCase[] = {
+    { "/a/b/c.d", "/a/b/", "c", ".d", "/a/b/c.d" },
+    { "c.tar.gz", "", "c.tar", ".gz", "c.tar.gz" },
+    { "/a.b/c", "/a.b/", "c", "", "/a.b/c" },
+    { "a/.rc", "a/", "", ".rc", "a/.rc" },
+    { "/a/b/", "/a/b/", "", "", "/a/b" },
+    { "/", "/", "", "", "/" },
+    { "", "", "", "", "." },
+    { "//a/./b//../c/", "//a/./b//../c/", "", "", "/a/c" },
+    { "/../a/..", "/../a/", ".", ".", "/" },
+    { "../a/../../b/.", "../a/../../b/", "", ".", "../../b" },
+    { "a/..", "a/", ".", ".", "." },
+  };
+  for (size_t i = 0; i < sizeof(kCase) / sizeof(kCase[0]); ++i) {
+    const char *path = kCase[i].path;
+    Filename::PathView dir, base, ext;
+    Filename::SplitView(path, &dir, &base, &ext);
+    char normal[64];
+    strcpy(normal, path);                           // In place
+    if (!dir.Equals(kCase[i].dir) || !base.Equals(kCase[i].base) ||
+        !ext.Equals(kCase[i].ext) ||
+        !Filename::NameView(path).Equals(path + dir.len) ||
+        !Filename::Normalize(path, normal, sizeof(normal)) ||
+        strcmp(normal, kCase[i].normal))
+      return Fail(kSuite, "Views of \"%s\": \"%s\" \"%s\" \"%s\" \"%s\"",
+                  path, dir.String().c_str(), base.String().c_str(),
+                  ext.String().c_str(), normal);
+  }
+
+  char buf[16];
+  size_t len = 0;
+  bool ok = Filename::Join("/a/", "b", buf, sizeof(buf), &len) &&
+            !strcmp(buf, "/a/b") && len == 4 &&
+            Filename::Join("/a", "/b", buf, sizeof(buf)) && !strcmp(buf, "/a/b") &&
+            Filename::Join("/a/", "/b", buf, sizeof(buf)) && !strcmp(buf, "/a/b") &&
+            Filename::Join("", "b", buf, sizeof(buf)) && !strcmp(buf, "b") &&
+            Filename::ChangeExt("/a.b/c.jpg", ".png", buf, sizeof(buf)) &&
+            !strcmp(buf, "/a.b/c.png") &&
+            Filename::ChangeExt("/a.b/c", ".png", buf, sizeof(buf)) &&
+            !strcmp(buf, "/a.b/c.png") &&
+            !Filename::Join("/0123456", "789abcd", buf, sizeof(buf)) &&
+            !buf[0] && Filename::Join("/0123456", "789abc", buf, sizeof(buf)) &&
+            !Filename::Normalize("/0123456789abcdef", buf, sizeof(buf)) &&
+            !Filename::Normalize("", buf, 1);
+  if (!ok)
+    return Fail(kSuite, "Join, ChangeExt or Normalize results differ");
+
+  char dir[PATH_MAX], base[NAME_MAX], ext[NAME_MAX];
+  std::string longName(NAME_MAX + 100, 'x');        // Used to overflow base
+  Filename::Split(("/a/" + longName + ".d").c_str(), dir, base, ext);
+  if (strcmp(dir, "/a/") || strlen(base) != NAME_MAX - 1 || strcmp(ext, ".d"))
+    return Fail(kSuite, "Split of a long name is not truncated");
+  return true;
+}
+
+
+// Split and rebuild a million cache paths, with Split and snprintf into
+// fixed arrays and with the views, which never copy the components
+static bool PathBench() {
+  if (!CheckPathViews())
+    return false;
+
+  const size_t pathCount = 1000000 * gScale;
+  Filename::PathList pathList;
+  Random rnd(3);
+  for (size_t i = 0; i < pathCount; ++i) {
+    char buf[PATH_MAX];
+    int len = snprintf(buf, sizeof(buf), "/data/cache/thumbs/%02x/%08x_%u.%s",
+                       rnd.Next(256), rnd.Next(), rnd.Next(4096),
+                       rnd.Next(2) ? "jpg" : "png");
+    pathList.Add(buf, size_t(len));
+  }
+  char dir[PATH_MAX], base[NAME_MAX], ext[NAME_MAX], buf[PATH_MAX];
+  for (size_t i = 0; i < pathCount; i += 97) {
+    Filename::PathView dirView, baseView, extView;
+    Filename::SplitView(pathList[i], &dirView, &baseView, &extView);
+    Filename::Split(pathList[i], dir, base, ext);
+    if (!dirView.Equals(dir) || !baseView.Equals(base) || !extView.Equals(ext))
+      return Fail(kSuite, "SplitView and Split of \"%s\" differ", pathList[i]);
+  }
+
+  char name[64];
+  size_t sums[6] = { 0 };
+  for (int method = 0; method < 6; ++method) {
+    size_t &sum = sums[method];
+    Timer timer;
+    size_t iters = 0;
+    do {
+      for (size_t i = 0; i < pathCount; ++i) {
+        const char *path = pathList[i];
+        Filename::PathView dirView, baseView, extView;
+        size_t len = 0;
+        switch (method) {
+          case 0:
+            Filename::Split(path, dir, base, ext);
+            sum += ext[1];
+            break;
+          case 1:
+            Filename::SplitView(path, &dirView, &baseView, &extView);
+            sum += extView.str[1];
+            break;
+          case 2:
+            Filename::Split(path, dir, base, NULL);
+            sum += snprintf(buf, sizeof(buf), "%s%s", dir, base);
+            break;
+          case 3:
+            Filename::SplitView(path, &dirView, &baseView, NULL);
+            Filename::Join(dirView, baseView, buf, sizeof(buf), &len);
+            sum += len;
+            break;
+          case 4:
+            Filename::Split(path, dir, base, ext);
+            sum += snprintf(buf, sizeof(buf), "%s%s.webp", dir, base);
+            break;
+          case 5:
+            Filename::ChangeExt(path, ".webp", buf, sizeof(buf), &len);
+            sum += len;
+            break;
+        }
+      }
+      ++iters;
+    } while (timer.Elapsed() < gMinSec);
+    static const char *kMethod[] = { "Split", "SplitView", "Split+snprintf",
+                                     "SplitView+Join", "Split+snprintf ext",
+                                     "ChangeExt" };
+    snprintf(name, sizeof(name), "%s %zuM paths", kMethod[method],
+             pathCount / 1000000);
+    Report(kSuite, name, timer.Elapsed(), iters);
+    sum /= iters;
+  }
+  if (sums[0] != sums[1] || sums[2] != sums[3] || sums[4] != sums[5])
+    return Fail(kSuite, "Path views and Split give different paths");
+
+  // Normalize paths with redundant parts, into a buffer and in place
+  Filename::PathList messyList;
+  for (size_t i = 0; i < pathCount; ++i) {
+    int len = snprintf(buf, sizeof(buf), "/data//cache/./thumbs/../thumbs/%s",
+                       pathList[i] + 19);
+    messyList.Add(buf, size_t(len));
+  }
+  Timer timer;
+  size_t iters = 0;
+  bool ok = true;
+  do {
+    for (size_t i = 0; i < pathCount; ++i) {
+      size_t len = 0;
+      ok = Filename::Normalize(messyList[i], buf, sizeof(buf), &len) && ok;
+      ok = ok && len == strlen(pathList[i]);
+    }
+    ++iters;
+  } while (timer.Elapsed() < gMinSec);
+  snprintf(name, sizeof(name), "Normalize %zuM paths", pathCount / 1000000);
+  Report(kSuite, name, timer.Elapsed(), iters);
+  for (size_t i = 0; ok && i < pathCount; i += 97) {
+    strcpy(buf, messyList[i]);
+    ok = Filename::Normalize(buf, buf, sizeof(buf)) && !strcmp(buf, pathList[i]);
+  }
+  if (!ok)
+    return Fail(kSuite, "Normalize of messy cache paths differs");
+  return true;
+}
+
+
+bool bench::FilenameSuite() {
+  if (!PathBench())
+    return false;
+
+  Timer timer;
+  size_t iters = 0;
+  
+  // Metadata queries on real files (warm cache)
+  TempDir tmp(1000);
+  const std::vector<std::string> &file = tmp.Files();
+  if (file.size() != 1000)
+    return Fail(kSuite, "Cannot create temporary files in /tmp");
+  
+  std::vector<std::string> listVec;
+  if (!Filename::ListDirectory(tmp.Dir(), listVec) || listVec.size() != 1000)
+    return Fail(kSuite, "ListDirectory returned %zu files", listVec.size());
+  
+  timer.Restart();
+  iters = 0;
+  double epoch = 0;
+  do {
+    for (size_t i = 0; i < file.size(); ++i) {
+      const char *path = file[i].c_str();
+      if (Filename::IsAccessible(path))
+        epoch += Filename::ModEpochSec(path) + Filename::AccessEpochSec(path) +
+                 Filename::FileSize(path);
+    }
+    ++iters;
+  } while (timer.Elapsed() < gMinSec);
+  Report(kSuite, "Access+Mod+AccessEpoch+Size 1k", timer.Elapsed(), iters);
+  if (epoch <= 0)
+    return Fail(kSuite, "File queries returned no data");
+  
+  timer.Restart();
+  iters = 0;
+  do {
+    listVec.clear();
+    Filename::ListDirectory(tmp.Dir(), listVec);
+    ++iters;
+  } while (timer.Elapsed() < gMinSec);
+  Report(kSuite, "ListDirectory 1k", timer.Elapsed(), iters);
+  
+  return MappedBench() && StatBench() && ScanBench();
+}
@@ -0,0 +1,61 @@
+//  Copyright (c) 2013 The 11ers. All rights reserved.
+
+#include "Bench.h"
+
+#include "GlesUtil.h"
+#include "Timer.h"
+
+#include <math.h>
+#include <vector>
+
+
+using namespace bench;
+
+
+static const char *kSuite = "geometry";
+
+
+bool bench::GeometrySuite() {
+  const int segments = 8;
+  unsigned short nv = 0, ni = 0;
+  glt::RoundedRectSize2fi(segments, &nv, &ni);
+  std::vector<float> P(2 * nv), UV(2 * nv);
+  std::vector<unsigned short> idx(ni);
+  
+  glt::BuildRoundedRect2fi(0, 0, 100, 50, 0, 0, 1, 1, 8, 8, segments,
+                           &P[0], &UV[0], &idx[0]);
+  for (size_t i = 0; i < idx.size(); ++i) {
+    if (idx[i] >= nv)
+      return Fail(kSuite, "Rounded rect index %zu out of range", i);
+  }
+  for (size_t i = 0; i < P.size(); ++i) {
+    if (!isfinite(P[i]) || P[i] < 0 || P[i] > 100)
+      return Fail(kSuite, "Rounded rect vertex %zu out of bounds", i / 2);
+  }
+  
+  Timer timer;
+  size_t iters = 0;
+  do {
+    for (int i = 0; i < 1000; ++i)
+      glt::BuildRoundedRect2fi(0, 0, 100 + i, 50, 0, 0, 1, 1, 8, 8, segments,
+                               &P[0], &UV[0], &idx[0]);
+    ++iters;
+  } while (timer.Elapsed() < gMinSec);
+  Report(kSuite, "BuildRoundedRect2fi x1000", timer.Elapsed(), iters);
+  
+  glt::RoundedFrameSize2fi(segments, &nv, &ni);
+  P.resize(2 * nv);
+  UV.resize(2 * nv);
+  idx.resize(ni);
+  timer.Restart();
+  iters = 0;
+  do {
+    for (int i = 0; i < 1000; ++i)
+      glt::BuildRoundedFrame2fi(0, 0, 100 + i, 50, 8, 8, segments,
+                                &P[0], &UV[0], &idx[0]);
+    ++iters;
+  } while (timer.Elapsed() < gMinSec);
+  Report(kSuite, "BuildRoundedFrame2fi x1000", timer.Elapsed(), iters);
+  
+  return true;
+}
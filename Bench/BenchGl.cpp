@@ -0,0 +1,168 @@
+//  Copyright (c) 2013 The 11ers. All rights reserved.
+
+#include "Bench.h"
+
+#include "GlesUtil.h"
+#include "GlStub.h"
+#include "Memory.h"
+#include "Timer.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+
+using namespace bench;
+
+
+static const char *kSuite = "gl";
+
+
+// Widget tree drawn each frame, approximating an album grid view
+static const int kThumbCols = 8, kThumbRows = 12;     // Visible thumbnails
+static const int kButtonCount = 10;                   // 9-slice toolbar
+static const int kLabelCount = kThumbCols * kThumbRows;
+
+
+struct Scene {
+  GLuint thumbTex[kThumbCols * kThumbRows];
+  GLuint buttonTex;
+  glt::Font font;
+  std::vector<unsigned char> pix;
+  
+  bool Init() {
+    pix.resize(128 * 128 * 4, 0x80);
+    for (int i = 0; i < kThumbCols * kThumbRows; ++i) {
+      glGenTextures(1, &thumbTex[i]);
+      if (!glt::StoreTexture(thumbTex[i], GL_TEXTURE_2D, GL_LINEAR, GL_LINEAR,
+                             GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, 128, 128,
+                             GL_RGBA, GL_UNSIGNED_BYTE, &pix[0]))
+        return false;
+    }
+    glGenTextures(1, &buttonTex);
+    if (!glt::StoreTexture(buttonTex, GL_TEXTURE_2D, GL_LINEAR, GL_LINEAR,
+                           GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, 32, 32,
+                           GL_RGBA, GL_UNSIGNED_BYTE, &pix[0]))
+      return false;
+    glGenTextures(1, &font.tex);
+    if (!glt::StoreTexture(font.tex, GL_TEXTURE_2D, GL_LINEAR, GL_LINEAR,
+                           GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, 128, 128,
+                           GL_ALPHA, GL_UNSIGNED_BYTE, &pix[0]))
+      return false;
+    font.charDimPt[0] = font.charDimPt[1] = 8;
+    font.charDimUV[0] = font.charDimUV[1] = 1 / 16.0f;
+    memset(font.charWidthPt, 7, sizeof(font.charWidthPt));
+    return true;
+  }
+  
+  bool Draw() {
+    glViewport(0, 0, 1024, 768);
+    if (!glt::DrawGradientBox2f(-1, -1, 1, 1, true, 0.1, 0.1, 0.1, 0.3,0.3,0.3))
+      return false;
+    const float w = 2.0f / kThumbCols, h = 1.6f / kThumbRows;
+    for (int j = 0; j < kThumbRows; ++j) {
+      for (int i = 0; i < kThumbCols; ++i) {
+        const float x = -1 + i * w, y = -0.8f + j * h;
+        if (!glt::DrawTexture2f(thumbTex[j * kThumbCols + i], x, y,
+                                x + 0.9f * w, y + 0.9f * h, 0, 0, 1, 1))
+          return false;
+      }
+    }
+    glt::FontStyle style;
+    for (int i = 0; i < kLabelCount; ++i) {
+      const float x = -1 + (i % kThumbCols) * w;
+      const float y = -0.8f + (i / kThumbCols) * h;
+      if (!glt::DrawText("IMG_0001.JPG", x, y, &font, 1/512.0f, 1/384.0f,
+                         &style))
+        return false;
+    }
+    for (int i = 0; i < kButtonCount; ++i) {
+      const float x = -1 + i * 0.2f;
+      if (!glt::Draw9SliceTexture2f(buttonTex, x, 0.8f, x + 0.18f, 1, 0, 0,
+                                    1, 1, 32, 32, 1024, 768, 1, 1, 1, 1))
+        return false;
+      if (!glt::DrawColorBoxFrame2f(x, 0.8f, x + 0.18f, 1, 0.01f, 0.01f,
+                                    1, 1, 1, 1))
+        return false;
+    }
+    return true;
+  }
+  
+  void Destroy() {
+    for (int i = 0; i < kThumbCols * kThumbRows; ++i)
+      glt::DeleteTexture(thumbTex[i]);
+    glt::DeleteTexture(buttonTex);
+    glt::DeleteTexture(font.tex);
+  }
+};
+
+
+bool bench::GlSuite() {
+  glstub::Reset();
+  Scene scene;
+  if (!scene.Init())
+    return Fail(kSuite, "Cannot create scene textures");
+  const size_t setupUpload = glstub::Total().textureUploadBytes;
+  const size_t expectedUpload = kThumbCols * kThumbRows * 128*128*4 +
+                                32*32*4 + 128*128;
+  if (setupUpload != expectedUpload)
+    return Fail(kSuite, "Uploaded %zu texture bytes, expected %zu",
+                setupUpload, expectedUpload);
+  if (mem::Bytes(mem::GLTexture) != expectedUpload)
+    return Fail(kSuite, "Accounted %zu texture bytes, expected %zu",
+                mem::Bytes(mem::GLTexture), expectedUpload);
+  
+  // Warm up shader creation, then record one steady-state frame
+  glstub::BeginFrame();
+  if (!scene.Draw())
+    return Fail(kSuite, "Draw failed");
+  glstub::BeginFrame();
+  if (!scene.Draw())
+    return Fail(kSuite, "Draw failed");
+  const glstub::Stats frame = glstub::Frame();
+  
+  const unsigned long expectedDraws = 1 + kThumbCols * kThumbRows +
+                                      kLabelCount + kButtonCount * (9 + 1);
+  if (frame.drawCalls != expectedDraws)
+    return Fail(kSuite, "Frame issued %lu draw calls, expected %lu",
+                frame.drawCalls, expectedDraws);
+  if (frame.textureUploadBytes || frame.call[glstub::CompileShader])
+    return Fail(kSuite, "Steady-state frame uploads textures or shaders");
+  
+  Timer timer;
+  size_t iters = 0;
+  do {
+    glstub::BeginFrame();
+    scene.Draw();
+    ++iters;
+  } while (timer.Elapsed() < gMinSec);
+  Report(kSuite, "Draw album grid frame", timer.Elapsed(), iters);
+  
+  printf("%-10s Per-frame GL activity:\n", kSuite);
+  glstub::Print(frame);
+  
+  mem::Snapshot snapshot;
+  mem::TakeSnapshot(&snapshot);
+  printf("%-10s Memory accounting:\n", kSuite);
+  mem::Print(snapshot);
+  scene.Destroy();
+  if (mem::Bytes(mem::GLTexture) != 0)
+    return Fail(kSuite, "%zu texture bytes remain after delete",
+                mem::Bytes(mem::GLTexture));
+  
+  // Deleted names are unbound, so save/restore code never rebinds them
+  GLuint tex, buf;
+  glGenTextures(1, &tex);
+  glGenBuffers(1, &buf);
+  glBindTexture(GL_TEXTURE_2D, tex);
+  glBindBuffer(GL_ARRAY_BUFFER, buf);
+  glDeleteTextures(1, &tex);
+  glDeleteBuffers(1, &buf);
+  GLint boundTex = -1, boundBuf = -1;
+  glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTex);
+  glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &boundBuf);
+  if (boundTex || boundBuf)
+    return Fail(kSuite, "Deleted texture %d or buffer %d still bound",
+                boundTex, boundBuf);
+  return true;
+}
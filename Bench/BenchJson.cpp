@@ -0,0 +1,1582 @@
+//  Copyright (c) 2013 The 11ers. All rights reserved.
+
+#include "Bench.h"
+
+#include "Json.h"
+#include "MappedFile.h"
+#include "Memory.h"
+#include "TaskMgr.h"
+#include "Timer.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+
+using namespace bench;
+
+
+static const char *kSuite = "json";
+
+
+static size_t CountValues(const json_value *value) {
+  size_t n = 0;
+  for (; value; value = value->next_sibling)
+    n += 1 + CountValues(value->first_child);
+  return n;
+}
+
+
+// Parses doc repeatedly, into a private arena released with json_free
+// for each document when arena is NULL, or into the reused arena
+static bool ParseBench(const char *name, const std::string &doc,
+                       json_arena *arena) {
+  std::vector<char> work(doc.size() + 1);
+  char *errorPos = 0, *errorDesc = 0;
+  int errorLine = 0;
+  double sec = 0;
+  size_t iters = 0, count = 0;
+  do {
+    memcpy(&work[0], doc.c_str(), doc.size() + 1);  // Parsed in place
+    Timer timer;
+    if (arena)
+      json_arena_reset(arena);
+    json_value *root = json_parse(&work[0], &errorPos, &errorDesc, &errorLine,
+                                  arena);
+    if (!root)
+      return Fail(kSuite, "%s: %s at line %d", name, errorDesc, errorLine);
+    sec += timer.Elapsed();
+    ++iters;
+    count = CountValues(root);
+    json_free(root);                                // No-op for given arena
+  } while (sec < gMinSec);
+  Report(kSuite, name, sec, iters, double(doc.size()) * iters);
+  
+  const size_t albums = 10, images = 500 * gScale;
+  const size_t expected = 1 + 1 + albums * (5 + images * 14);
+  if (count != expected)
+    return Fail(kSuite, "%s: parsed %zu values, expected %zu", name, count,
+                expected);
+  return true;
+}
+
+
+// Strings must unescape identically wherever escapes fall relative to the
+// blocks tested by the vectorized scanners
+static bool CheckStrings() {
+  for (size_t pad = 0; pad < 70; ++pad) {
+    const std::string text(pad, 'x');
+    std::string doc = "[\"" + text + "\", \"" + text + "\\n\\u00e9\\\"" + text +
+                      "\\\\\",\n" + std::string(pad, ' ') + "\"" + text + "\"]";
+    const std::string expected[3] = { text, text + "\n\xc3\xa9\"" + text + "\\",
+                                      text };
+    std::vector<char> work(doc.begin(), doc.end());
+    work.push_back('\0');
+    char *errorPos = 0, *errorDesc = 0;
+    int errorLine = 0;
+    json_value *root = json_parse(&work[0], &errorPos, &errorDesc, &errorLine);
+    if (!root)
+      return Fail(kSuite, "String test %zu: %s", pad, errorDesc);
+    const json_value *value = root->first_child;
+    for (size_t i = 0; i < 3; ++i, value = value->next_sibling) {
+      if (!value || value->type != JSON_STRING ||
+          expected[i] != value->string_value) {
+        json_free(root);
+        return Fail(kSuite, "String test %zu: value %zu differs", pad, i);
+      }
+    }
+    json_free(root);
+  }
+  return true;
+}
+
+
+static bool CountEvent(void *data) {
+  ++*(size_t *)data;
+  return true;
+}
+
+
+static bool CountStart(void *data, const char *) {
+  return CountEvent(data);
+}
+
+
+static bool CountValue(void *data, const json_value *) {
+  return CountEvent(data);
+}
+
+
+// Feeds doc to the streaming parser in chunks, as if read from a file
+static bool SaxBench(const char *name, const std::string &doc, size_t chunk) {
+  const json_sax_handler handler = { CountStart, NULL, CountStart, NULL,
+                                     CountValue };
+  double sec = 0;
+  size_t iters = 0, count = 0;
+  do {
+    count = 0;
+    Timer timer;
+    json_sax_parser *parser = json_sax_create(&handler, &count);
+    bool ok = true;
+    for (size_t i = 0; ok && i < doc.size(); i += chunk)
+      ok = json_sax_feed(parser, doc.data() + i,
+                         i + chunk < doc.size() ? chunk : doc.size() - i);
+    ok = ok && json_sax_finish(parser);
+    size_t errorOffset = 0;
+    char *errorDesc = 0;
+    int errorLine = 0;
+    json_sax_error(parser, &errorOffset, &errorDesc, &errorLine);
+    json_sax_destroy(parser);
+    sec += timer.Elapsed();
+    ++iters;
+    if (!ok)
+      return Fail(kSuite, "%s: %s at line %d", name, errorDesc, errorLine);
+  } while (sec < gMinSec);
+  Report(kSuite, name, sec, iters, double(doc.size()) * iters);
+  
+  const size_t albums = 10, images = 500 * gScale;
+  const size_t expected = 1 + 1 + albums * (5 + images * 14);
+  if (count != expected)
+    return Fail(kSuite, "%s: %zu events, expected %zu", name, count, expected);
+  return true;
+}
+
+
+// The streaming parser must report errors like json_parse
+static bool CheckSaxError(const std::string &bad, const char *errorPos,
+                          const char *errorBase, const char *errorDesc,
+                          int errorLine) {
+  const json_sax_handler handler = { NULL, NULL, NULL, NULL, NULL };
+  json_sax_parser *parser = json_sax_create(&handler, NULL);
+  for (size_t i = 0; i < bad.size() && json_sax_feed(parser, &bad[i], 1); ++i)
+    ;
+  size_t saxOffset = 0;
+  char *saxDesc = 0;
+  int saxLine = 0;
+  json_sax_error(parser, &saxOffset, &saxDesc, &saxLine);
+  json_sax_destroy(parser);
+  if (!saxDesc || strcmp(saxDesc, errorDesc) || saxLine != errorLine ||
+      saxOffset != size_t(errorPos - errorBase))
+    return Fail(kSuite, "Streaming error \"%s\" line %d offset %zu, expected "
+                "\"%s\" line %d offset %zu", saxDesc ? saxDesc : "none",
+                saxLine, saxOffset, errorDesc, errorLine,
+                size_t(errorPos - errorBase));
+  return true;
+}
+
+
+// Numbers that are hard to convert: near the limits of the double range,
+// halfway between doubles, longer than 19 digits, or beyond 32 bits
+static const char *kNumberCorpus[] = {
+  "0.0", "-0.0", "1.0", "-1.5", "0.1", "0.3", "1e23", "8.98846567431158e307",
+  "1.7976931348623157e308", "1.7976931348623158e308", "1e309", "-1e400",
+  "2.2250738585072011e-308", "2.2250738585072012e-308", "2.2250738585072014e-308",
+  "4.9e-324", "2.4703282292062327e-324", "2.4703282292062328e-324", "1e-400",
+  "9007199254740993", "9007199254740992.0", "9007199254740993.0",
+  "9007199254740995.0", "1.00000000000000011102230246251565404236316680908203125",
+  "1.00000000000000011102230246251565404236316680908203124",
+  "7.038531e-26", "1448997445238699", "3.141592653589793238462643383279",
+  "0.000000000000000000000000000000000000000000001e45",
+  "123456789012345678901234567890e-30", "5e-324", "1e22", "1e-22",
+  "4503599627370496.5", "4503599627370497.5", "1380000000.123", "1.5e+3",
+  "2E-3", "1.", "-1e", "1e+", "0.000001", "100000000000000000000",
+  "18446744073709551616",
+};
+
+static const char *kIntCorpus[] = {
+  "0", "-1", "2147483648", "4294967296", "-2147483649",
+  "1380000000123", "9223372036854775807", "-9223372036854775808",
+};
+
+
+static json_value *ParseNumber(std::string &doc, const char *number) {
+  doc = std::string("[") + number + "]";
+  char *errorPos = 0, *errorDesc = 0;
+  int errorLine = 0;
+  return json_parse(&doc[0], &errorPos, &errorDesc, &errorLine);
+}
+
+
+// Numbers must convert exactly, as by strtod in the C locale
+static bool CheckNumbers() {
+  std::string doc;
+  for (size_t i = 0; i < sizeof(kNumberCorpus) / sizeof(*kNumberCorpus); ++i) {
+    json_value *root = ParseNumber(doc, kNumberCorpus[i]);
+    const json_value *value = root ? root->first_child : NULL;
+    double expected = strtod(kNumberCorpus[i], NULL);
+    double parsed = !value ? -1 : value->type == JSON_FLOAT ?
+                    value->float_value : double(value->int_value);
+    bool ok = value && memcmp(&parsed, &expected, sizeof(double)) == 0;
+    json_free(root);
+    if (!ok)
+      return Fail(kSuite, "%s parsed as %.17g", kNumberCorpus[i], parsed);
+  }
+  
+  for (size_t i = 0; i < sizeof(kIntCorpus) / sizeof(*kIntCorpus); ++i) {
+    json_value *root = ParseNumber(doc, kIntCorpus[i]);
+    const json_value *value = root ? root->first_child : NULL;
+    bool ok = value && value->type == JSON_INT &&
+              value->int_value == strtoll(kIntCorpus[i], NULL, 10);
+    json_free(root);
+    if (!ok)
+      return Fail(kSuite, "%s not parsed as a 64-bit integer", kIntCorpus[i]);
+  }
+  
+  // Every double printed with 17 digits must parse back to the same bits
+  Random rnd(33);
+  char number[64];
+  for (size_t i = 0; i < 100000; ++i) {
+    uint64_t bits = uint64_t(rnd.Next()) << 32 | rnd.Next();
+    double expected;
+    memcpy(&expected, &bits, sizeof(expected));
+    if (expected != expected || expected - expected != 0)
+      continue;                                     // NaN or infinity
+    snprintf(number, sizeof(number), "%.17g", expected);
+    json_value *root = ParseNumber(doc, number);
+    const json_value *value = root ? root->first_child : NULL;
+    double parsed = !value ? -1 : value->type == JSON_FLOAT ?
+                    value->float_value : double(value->int_value);
+    json_free(root);
+    if (memcmp(&parsed, &expected, sizeof(double)))
+      return Fail(kSuite, "%s parsed as %.17g", number, parsed);
+  }
+  return true;
+}
+
+
+// Array of timestamps, file sizes, ratings and coordinates
+static std::string NumberJson(size_t count, std::vector<std::string> *numbers) {
+  Random rnd(5);
+  std::string doc = "[";
+  char buf[64];
+  for (size_t i = 0; i < count; ++i) {
+    switch (i % 4) {
+      case 0: snprintf(buf, sizeof(buf), "%llu", 1380000000000ull +
+                       rnd.Next()); break;
+      case 1: snprintf(buf, sizeof(buf), "%u.%03u", 1380000000 +
+                       rnd.Next(100000000), rnd.Next(1000)); break;
+      case 2: snprintf(buf, sizeof(buf), "%.17g", 360 * rnd.Unit() - 180);
+              break;
+      case 3: snprintf(buf, sizeof(buf), "%.6g", rnd.Unit() / 1000); break;
+    }
+    numbers->push_back(buf);
+    doc += buf;
+    doc += i + 1 < count ? "," : "]";
+  }
+  return doc;
+}
+
+
+static bool NumberBench() {
+  std::vector<std::string> numbers;
+  const std::string doc = NumberJson(250000 * gScale, &numbers);
+  json_arena *arena = json_arena_create();
+  std::vector<char> work(doc.size() + 1);
+  char *errorPos = 0, *errorDesc = 0;
+  int errorLine = 0;
+  double sec = 0;
+  size_t iters = 0;
+  json_value *root = NULL;
+  do {
+    memcpy(&work[0], doc.c_str(), doc.size() + 1);
+    json_arena_reset(arena);
+    Timer timer;
+    root = json_parse(&work[0], &errorPos, &errorDesc, &errorLine, arena);
+    sec += timer.Elapsed();
+    ++iters;
+    if (!root) {
+      json_arena_destroy(arena);
+      return Fail(kSuite, "Numbers: %s", errorDesc);
+    }
+  } while (sec < gMinSec);
+  Report(kSuite, "json_parse numbers", sec, iters, double(doc.size()) * iters);
+  
+  // Reference: strtod alone on the same numbers
+  sec = 0;
+  iters = 0;
+  double sum = 0;
+  do {
+    Timer timer;
+    for (size_t i = 0; i < numbers.size(); ++i)
+      sum += strtod(numbers[i].c_str(), NULL);
+    sec += timer.Elapsed();
+    ++iters;
+  } while (sec < gMinSec);
+  Report(kSuite, "strtod numbers", sec, iters, double(doc.size()) * iters);
+  
+  // Values must match strtod and strtoll
+  size_t i = 0;
+  for (const json_value *value = root->first_child; value;
+       value = value->next_sibling, ++i) {
+    const char *number = numbers[i].c_str();
+    bool ok = value->type == JSON_INT ?
+              value->int_value == strtoll(number, NULL, 10) :
+              value->float_value == strtod(number, NULL);
+    if (!ok) {
+      json_arena_destroy(arena);
+      return Fail(kSuite, "Numbers: %s parsed differently", number);
+    }
+  }
+  json_arena_destroy(arena);
+  if (i != numbers.size() || sum == 0)
+    return Fail(kSuite, "Numbers: parsed %zu of %zu", i, numbers.size());
+  return true;
+}
+
+
+// The tape must hold the same values as the tree built by json_parse
+static bool CompareTape(json_tape *tape, size_t index, const json_value *value) {
+  for (; value; value = value->next_sibling, index = json_tape_next(tape, index)) {
+    if (index == JSON_TAPE_NONE || json_tape_type(tape, index) != value->type)
+      return false;
+    const char *name = json_tape_name(tape, index);
+    if (!name != !value->name || (name && strcmp(name, value->name)))
+      return false;
+    int64_t i = 0;
+    double d = 0;
+    bool b = false;
+    switch (value->type) {
+      case JSON_OBJECT:
+      case JSON_ARRAY:
+        if (!CompareTape(tape, json_tape_child(tape, index), value->first_child))
+          return false;
+        break;
+      case JSON_STRING:
+        if (strcmp(json_tape_string(tape, index), value->string_value))
+          return false;
+        break;
+      case JSON_INT:
+        if (!json_tape_int(tape, index, &i) || i != value->int_value)
+          return false;
+        break;
+      case JSON_FLOAT:
+        if (!json_tape_double(tape, index, &d) || d != value->float_value)
+          return false;
+        break;
+      case JSON_BOOL:
+        if (!json_tape_bool(tape, index, &b) || b != (value->int_value != 0))
+          return false;
+        break;
+      case JSON_NULL:
+        break;
+    }
+  }
+  return index == JSON_TAPE_NONE;
+}
+
+
+// Reference lookup in the tree, walking siblings like callers do today
+static const json_value *FindMember(const json_value *object, const char *name) {
+  for (const json_value *v = object ? object->first_child : NULL; v;
+       v = v->next_sibling)
+    if (v->name && !strcmp(v->name, name))
+      return v;
+  return NULL;
+}
+
+
+static const json_value *FindElement(const json_value *array, size_t i) {
+  const json_value *v = array ? array->first_child : NULL;
+  for (; v && i; --i)
+    v = v->next_sibling;
+  return v;
+}
+
+
+// Reads four fields of the album document, as most consumers do
+static bool TapeBench(const std::string &doc) {
+  const char *kPath[] = { "albums[3].name", "albums[3].images[7].url",
+                          "albums[9].count", "albums[0].images[0].date" };
+  std::vector<char> work(doc.size() + 1);
+  json_arena *arena = json_arena_create();
+  char *errorPos = 0, *errorDesc = 0;
+  int errorLine = 0;
+  std::string expected[4];
+  double sec = 0;
+  size_t iters = 0;
+  do {
+    memcpy(&work[0], doc.c_str(), doc.size() + 1);
+    json_arena_reset(arena);
+    Timer timer;
+    json_value *root = json_parse(&work[0], &errorPos, &errorDesc, &errorLine,
+                                  arena);
+    const json_value *albums = FindMember(root, "albums");
+    const json_value *album3 = FindElement(albums, 3);
+    const json_value *field[4] = {
+      FindMember(album3, "name"),
+      FindMember(FindElement(FindMember(album3, "images"), 7), "url"),
+      FindMember(FindElement(albums, 9), "count"),
+      FindMember(FindElement(FindMember(FindElement(albums, 0), "images"), 0),
+                 "date"),
+    };
+    sec += timer.Elapsed();
+    ++iters;
+    if (!field[0] || !field[1] || !field[2] || !field[3]) {
+      json_arena_destroy(arena);
+      return Fail(kSuite, "Sparse fields missing from tree");
+    }
+    char buf[64];
+    expected[0] = field[0]->string_value;
+    expected[1] = field[1]->string_value;
+    snprintf(buf, sizeof(buf), "%lld", (long long)field[2]->int_value);
+    expected[2] = buf;
+    snprintf(buf, sizeof(buf), "%.17g", field[3]->float_value);
+    expected[3] = buf;
+  } while (sec < gMinSec);
+  json_arena_destroy(arena);
+  Report(kSuite, "json_parse + 4 fields", sec, iters, double(doc.size()) * iters);
+  
+  size_t errorOffset = 0;
+  sec = 0;
+  iters = 0;
+  do {
+    Timer timer;
+    json_tape *tape = json_tape_parse(doc.data(), doc.size(), &errorOffset,
+                                      &errorDesc, &errorLine);
+    if (!tape)
+      return Fail(kSuite, "Tape: %s at line %d", errorDesc, errorLine);
+    size_t field[4];
+    for (size_t i = 0; i < 4; ++i)
+      field[i] = json_tape_find(tape, 0, kPath[i]);
+    std::string value[4];
+    const char *name = json_tape_string(tape, field[0]);
+    const char *url = json_tape_string(tape, field[1]);
+    int64_t count = 0;
+    double date = 0;
+    bool ok = name && url && json_tape_int(tape, field[2], &count) &&
+              json_tape_double(tape, field[3], &date);
+    if (ok) {
+      value[0] = name;
+      value[1] = url;
+    }
+    json_tape_destroy(tape);
+    sec += timer.Elapsed();
+    ++iters;
+    
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%lld", (long long)count);
+    value[2] = buf;
+    snprintf(buf, sizeof(buf), "%.17g", date);
+    value[3] = buf;
+    for (size_t i = 0; i < 4; ++i)
+      if (!ok || value[i] != expected[i])
+        return Fail(kSuite, "Tape: %s is \"%s\", expected \"%s\"", kPath[i],
+                    value[i].c_str(), expected[i].c_str());
+  } while (sec < gMinSec);
+  Report(kSuite, "json_tape + 4 fields", sec, iters, double(doc.size()) * iters);
+  return true;
+}
+
+
+static bool CheckTape(const std::string &doc) {
+  std::vector<char> work(doc.begin(), doc.end());
+  work.push_back('\0');
+  char *errorPos = 0, *errorDesc = 0;
+  int errorLine = 0;
+  size_t errorOffset = 0;
+  json_value *root = json_parse(&work[0], &errorPos, &errorDesc, &errorLine);
+  json_tape *tape = json_tape_parse(doc.data(), doc.size(), &errorOffset,
+                                    &errorDesc, &errorLine);
+  bool ok = root && tape && CompareTape(tape, 0, root);
+  
+  // Missing paths are JSON_TAPE_NONE, which every accessor accepts
+  const size_t none = ok ? json_tape_find(tape, 0, "x.y") : 0;
+  int64_t i = 0;
+  double d = 0;
+  bool b = false;
+  ok = ok && none == JSON_TAPE_NONE &&
+       json_tape_find(tape, 0, "albums[3].missing.name") == JSON_TAPE_NONE &&
+       json_tape_find(tape, 0, "albums[100000].name") == JSON_TAPE_NONE &&
+       json_tape_type(tape, none) == JSON_NULL &&
+       json_tape_size(tape, none) == 0 &&
+       json_tape_child(tape, none) == JSON_TAPE_NONE &&
+       json_tape_next(tape, none) == JSON_TAPE_NONE &&
+       json_tape_element(tape, none, 0) == JSON_TAPE_NONE &&
+       json_tape_member(tape, none, "x") == JSON_TAPE_NONE &&
+       json_tape_find(tape, none, "x") == JSON_TAPE_NONE &&
+       !json_tape_name(tape, none) && !json_tape_string(tape, none) &&
+       !json_tape_int(tape, none, &i) && !json_tape_double(tape, none, &d) &&
+       !json_tape_bool(tape, none, &b) &&
+       json_tape_type(tape, doc.size()) == JSON_NULL &&
+       !json_tape_string(tape, doc.size());
+  
+  // Strings are decoded once, however often they are accessed
+  const size_t member = ok ? json_tape_child(tape, 0) : JSON_TAPE_NONE;
+  const char *name = ok ? json_tape_name(tape, member) : 0;
+  const size_t bytes = mem::Bytes(mem::JsonDOM);
+  for (int j = 0; ok && j < 1000; ++j)
+    ok = json_tape_name(tape, member) == name;
+  ok = ok && name && mem::Bytes(mem::JsonDOM) == bytes;
+  json_tape_destroy(tape);
+  json_free(root);
+  if (!ok)
+    return Fail(kSuite, "Tape values differ from json_parse");
+  return true;
+}
+
+
+// The tape parser must report errors like json_parse
+static bool CheckTapeError(const std::string &bad, const char *errorPos,
+                           const char *errorBase, const char *errorDesc,
+                           int errorLine) {
+  size_t tapeOffset = 0;
+  char *tapeDesc = 0;
+  int tapeLine = 0;
+  json_tape *tape = json_tape_parse(bad.data(), bad.size(), &tapeOffset,
+                                    &tapeDesc, &tapeLine);
+  json_tape_destroy(tape);
+  if (tape || strcmp(tapeDesc, errorDesc) || tapeLine != errorLine ||
+      tapeOffset != size_t(errorPos - errorBase))
+    return Fail(kSuite, "Tape error \"%s\" line %d offset %zu, expected "
+                "\"%s\" line %d offset %zu", tape ? "none" : tapeDesc,
+                tapeLine, tapeOffset, errorDesc, errorLine,
+                size_t(errorPos - errorBase));
+  return true;
+}
+
+
+// Looks up random keys of a url -> metadata map with count members,
+// by json_find and by walking the members
+static bool FindBench(size_t count) {
+  std::vector<std::string> keys(count);
+  std::string doc = "{";
+  for (size_t i = 0; i < count; ++i) {
+    char key[64];
+    snprintf(key, sizeof(key), "http://example.com/images/%zu.jpg", i);
+    keys[i] = key;
+    snprintf(key, sizeof(key), "%s\"%s\":{\"id\":%zu}", i ? "," : "",
+             keys[i].c_str(), i);
+    doc += key;
+  }
+  doc += "}";
+  
+  std::vector<char> work(doc.size() + 1);
+  json_arena *arena = json_arena_create();
+  char *errorPos = 0, *errorDesc = 0;
+  int errorLine = 0;
+  json_value *root = 0;
+  
+  // The first lookup indexes the object
+  double sec = 0;
+  size_t iters = 0;
+  do {
+    memcpy(&work[0], doc.c_str(), doc.size() + 1);
+    json_arena_reset(arena);
+    root = json_parse(&work[0], &errorPos, &errorDesc, &errorLine, arena);
+    if (!root) {
+      json_arena_destroy(arena);
+      return Fail(kSuite, "Map of %zu: %s at line %d", count, errorDesc,
+                  errorLine);
+    }
+    Timer timer;
+    json_find(root, keys[0].c_str());
+    sec += timer.Elapsed();
+    ++iters;
+  } while (sec < gMinSec);
+  char name[64];
+  snprintf(name, sizeof(name), "json_find first, %zu members", count);
+  Report(kSuite, name, sec, iters);
+  
+  for (size_t i = 0; i < count; ++i) {
+    const json_value *id = json_find(json_find(root, keys[i].c_str()), "id");
+    if (!id || id->int_value != int64_t(i)) {
+      json_arena_destroy(arena);
+      return Fail(kSuite, "json_find \"%s\" in map of %zu", keys[i].c_str(),
+                  count);
+    }
+  }
+  if (json_find(root, "http://example.com/images/missing.jpg") ||
+      json_find(root->first_child, "missing")) {
+    json_arena_destroy(arena);
+    return Fail(kSuite, "json_find found a missing key in map of %zu", count);
+  }
+  
+  const size_t kLookups = 1000;
+  Random random;
+  std::vector<const char *> lookup(kLookups);
+  for (size_t i = 0; i < kLookups; ++i)
+    lookup[i] = keys[random.Next(count)].c_str();
+  
+  size_t found = 0, walked = 0;
+  sec = 0;
+  iters = 0;
+  do {
+    Timer timer;
+    for (size_t i = 0; i < kLookups; ++i)
+      found += json_find(root, lookup[i]) != NULL;
+    sec += timer.Elapsed();
+    iters += kLookups;
+  } while (sec < gMinSec);
+  snprintf(name, sizeof(name), "json_find, %zu members", count);
+  Report(kSuite, name, sec, iters);
+  found -= iters;
+  
+  sec = 0;
+  iters = 0;
+  do {
+    Timer timer;
+    for (size_t i = 0; i < kLookups; ++i)
+      walked += FindMember(root, lookup[i]) != NULL;
+    sec += timer.Elapsed();
+    iters += kLookups;
+  } while (sec < gMinSec);
+  snprintf(name, sizeof(name), "walk members, %zu members", count);
+  Report(kSuite, name, sec, iters);
+  json_arena_destroy(arena);
+  
+  if (found != 0 || walked != iters)
+    return Fail(kSuite, "Lookups missed keys in map of %zu", count);
+  return true;
+}
+
+
+static bool SameTree(const json_value *a, const json_value *b) {
+  for (; a && b; a = a->next_sibling, b = b->next_sibling) {
+    if (a->type != b->type || !a->name != !b->name ||
+        (a->name && strcmp(a->name, b->name)))
+      return false;
+    if (a->type == JSON_STRING && strcmp(a->string_value, b->string_value))
+      return false;
+    if ((a->type == JSON_INT || a->type == JSON_BOOL) &&
+        a->int_value != b->int_value)
+      return false;
+    if (a->type == JSON_FLOAT &&
+        memcmp(&a->float_value, &b->float_value, sizeof(double)))
+      return false;
+    if (!SameTree(a->first_child, b->first_child))
+      return false;
+  }
+  return !a && !b;
+}
+
+
+// Significant digits in a number, without leading or trailing zeros
+static size_t SignificantDigits(const char *number) {
+  std::string digits;
+  for (; *number && *number != 'e'; ++number)
+    if (*number >= '0' && *number <= '9')
+      digits += *number;
+  size_t first = digits.find_first_not_of('0');
+  if (first == std::string::npos)
+    return 1;
+  return digits.find_last_not_of('0') + 1 - first;
+}
+
+
+// Doubles must be written with the fewest digits that parse back exactly,
+// and as floats; strings and trees must survive writing and parsing
+static bool CheckWriter(const std::string &doc) {
+  json_writer *writer = json_writer_create();
+  std::string text, parsed;
+  size_t size = 0;
+  char *errorPos = 0, *errorDesc = 0;
+  int errorLine = 0;
+  Random rnd(36);
+  for (size_t i = 0; i < 200000; ++i) {
+    double expected;
+    if (i % 3 == 0) {
+      uint64_t bits = uint64_t(rnd.Next()) << 32 | rnd.Next();
+      memcpy(&expected, &bits, sizeof(expected));
+    } else if (i % 3 == 1) {
+      expected = (rnd.Next(2000001) - 1000000.0) / (i % 2 ? 1000 : 7);
+    } else {
+      expected = rnd.Unit() * (i % 5 ? 1e-3 : 1e12);
+    }
+    if (expected != expected || expected - expected != 0)
+      continue;
+    json_writer_reset(writer);
+    json_write_double(writer, NULL, expected);
+    text = json_writer_data(writer, &size);
+    
+    char shortest[64];
+    for (int precision = 1; precision <= 17; ++precision) {
+      snprintf(shortest, sizeof(shortest), "%.*g", precision, expected);
+      if (strtod(shortest, NULL) == expected)
+        break;
+    }
+    json_value *root = ParseNumber(parsed, text.c_str());
+    const json_value *value = root ? root->first_child : NULL;
+    bool ok = value && value->type == JSON_FLOAT &&
+              !memcmp(&value->float_value, &expected, sizeof(double));
+    json_free(root);
+    if (!ok || SignificantDigits(text.c_str()) != SignificantDigits(shortest))
+      return Fail(kSuite, "Wrote %.17g as %s, shortest %s", expected,
+                  text.c_str(), shortest);
+  }
+  
+  std::string control;
+  for (int c = 1; c < 0x80; ++c)
+    control += char(c);
+  control += "caf\xc3\xa9";
+  json_writer_reset(writer);
+  json_write_start_object(writer, NULL);
+  json_write_string(writer, control.c_str(), control.c_str());
+  json_write_end_object(writer);
+  text = json_writer_data(writer, &size);
+  json_value *root = json_parse(&text[0], &errorPos, &errorDesc, &errorLine);
+  bool ok = root && root->first_child &&
+            control == root->first_child->name &&
+            control == root->first_child->string_value;
+  json_free(root);
+  if (!ok)
+    return Fail(kSuite, "String written as %s", text.c_str());
+  
+  std::vector<char> work(doc.begin(), doc.end());
+  work.push_back('\0');
+  json_value *tree = json_parse(&work[0], &errorPos, &errorDesc, &errorLine);
+  for (int pretty = 0; pretty < 2 && ok; ++pretty) {
+    json_writer *output = json_writer_create(-1, pretty != 0);
+    json_write_value(output, tree);
+    std::string written = json_writer_data(output, &size);
+    json_writer_destroy(output);
+    
+    // The same output written through a file descriptor
+    FILE *file = tmpfile();
+    output = json_writer_create(fileno(file), pretty != 0);
+    ok = json_write_value(output, tree) && json_writer_flush(output);
+    json_writer_destroy(output);
+    std::string read(written.size() + 1, '\0');
+    rewind(file);
+    read.resize(fread(&read[0], 1, read.size(), file));
+    fclose(file);
+    
+    text = written;
+    root = json_parse(&text[0], &errorPos, &errorDesc, &errorLine);
+    ok = ok && root && SameTree(tree, root) && read == written;
+    json_free(root);
+    if (!ok)
+      Fail(kSuite, "%s tree differs after writing and parsing",
+           pretty ? "Pretty" : "Compact");
+  }
+  
+  // A member written alone is a document, without its name
+  const json_value *member = tree ? tree->first_child : NULL;
+  if (ok && member && member->name) {
+    json_writer *output = json_writer_create(-1, false);
+    ok = json_write_value(output, member);
+    text = json_writer_data(output, &size);
+    json_writer_destroy(output);
+    root = ok ? json_parse(&text[0], &errorPos, &errorDesc, &errorLine) : NULL;
+    ok = root && !root->name && root->type == member->type &&
+         SameTree(member->first_child, root->first_child);
+    json_free(root);
+    if (!ok)
+      Fail(kSuite, "Member written alone as %.40s", text.c_str());
+  }
+  json_free(tree);
+  json_writer_destroy(writer);
+  return ok;
+}
+
+
+// What callers write today: sprintf and std::string concatenation
+static void NaiveWrite(const json_value *value, std::string &out) {
+  char buf[64];
+  for (; value; value = value->next_sibling) {
+    if (value->name) {
+      out += "\"";
+      out += value->name;                           // Names need no escapes
+      out += "\":";
+    }
+    switch (value->type) {
+      case JSON_OBJECT:
+      case JSON_ARRAY:
+        out += value->type == JSON_OBJECT ? "{" : "[";
+        NaiveWrite(value->first_child, out);
+        out += value->type == JSON_OBJECT ? "}" : "]";
+        break;
+      case JSON_STRING:
+        out += "\"";
+        for (const char *c = value->string_value; *c; ++c) {
+          if (*c == '"' || *c == '\\') {
+            out += '\\';
+            out += *c;
+          } else if ((unsigned char)*c < 0x20) {
+            snprintf(buf, sizeof(buf), "\\u%04x", *c);
+            out += buf;
+          } else {
+            out += *c;
+          }
+        }
+        out += "\"";
+        break;
+      case JSON_INT:
+        snprintf(buf, sizeof(buf), "%lld", (long long)value->int_value);
+        out += buf;
+        break;
+      case JSON_FLOAT:
+        snprintf(buf, sizeof(buf), "%.17g", value->float_value);
+        out += buf;
+        break;
+      case JSON_BOOL:
+        out += value->int_value ? "true" : "false";
+        break;
+      case JSON_NULL:
+        out += "null";
+        break;
+    }
+    if (value->next_sibling)
+      out += ",";
+  }
+}
+
+
+static bool WriterBench(const std::string &doc) {
+  std::vector<char> work(doc.begin(), doc.end());
+  work.push_back('\0');
+  char *errorPos = 0, *errorDesc = 0;
+  int errorLine = 0;
+  json_value *tree = json_parse(&work[0], &errorPos, &errorDesc, &errorLine);
+  if (!tree)
+    return Fail(kSuite, "Writer input: %s at line %d", errorDesc, errorLine);
+  
+  size_t size = 0;
+  for (int pretty = 0; pretty < 2; ++pretty) {
+    json_writer *writer = json_writer_create(-1, pretty != 0);
+    double sec = 0;
+    size_t iters = 0;
+    do {
+      Timer timer;
+      json_writer_reset(writer);
+      json_write_value(writer, tree);
+      json_writer_data(writer, &size);
+      sec += timer.Elapsed();
+      ++iters;
+    } while (sec < gMinSec);
+    json_writer_destroy(writer);
+    Report(kSuite, pretty ? "json_writer pretty" : "json_writer compact", sec,
+           iters, double(size) * iters);
+  }
+  
+  double sec = 0;
+  size_t iters = 0;
+  do {
+    Timer timer;
+    std::string out;
+    NaiveWrite(tree, out);
+    size = out.size();
+    sec += timer.Elapsed();
+    ++iters;
+  } while (sec < gMinSec);
+  Report(kSuite, "sprintf + std::string", sec, iters, double(size) * iters);
+  json_free(tree);
+  return true;
+}
+
+
+static bool SameCache(const json_cache_node *node, const json_value *value) {
+  for (size_t i = 0; value; value = value->next_sibling, ++i) {
+    const json_cache_node *child = json_cache_child(node, i);
+    if (!child || json_cache_type(child) != value->type)
+      return false;
+    const char *name = json_cache_name(child);
+    if (!name != !value->name || (name && strcmp(name, value->name)))
+      return false;
+    if (value->type == JSON_STRING &&
+        strcmp(json_cache_string(child), value->string_value))
+      return false;
+    if ((value->type == JSON_INT && json_cache_int(child) != value->int_value) ||
+        (value->type == JSON_BOOL &&
+         json_cache_bool(child) != (value->int_value != 0)) ||
+        (value->type == JSON_FLOAT &&
+         json_cache_double(child) != value->float_value))
+      return false;
+    if (!SameCache(child, value->first_child))
+      return false;
+  }
+  return true;
+}
+
+
+// Reads every string of an image, to catch offsets outside it
+static size_t WalkCache(const json_cache_node *node) {
+  size_t sum = json_cache_type(node);
+  if (json_cache_name(node))
+    sum += strlen(json_cache_name(node));
+  if (json_cache_string(node))
+    sum += strlen(json_cache_string(node));
+  for (size_t i = 0; i < json_cache_size(node); ++i)
+    sum += WalkCache(json_cache_child(node, i));
+  return sum;
+}
+
+
+// The image must hold the same tree, and the validator must reject
+// images that are truncated or corrupt enough to be unsafe
+static bool CheckCache(const std::string &doc) {
+  std::vector<char> work(doc.begin(), doc.end());
+  work.push_back('\0');
+  char *errorPos = 0, *errorDesc = 0;
+  int errorLine = 0;
+  json_value *root = json_parse(&work[0], &errorPos, &errorDesc, &errorLine);
+  size_t size = 0;
+  void *image = json_cache_encode(root, &size);
+  const json_cache_node *node = json_cache_open(image, size);
+  bool ok = node && json_cache_type(node) == root->type &&
+            SameCache(node, root->first_child) &&
+            !json_cache_open(image, size - 1);
+  json_free(root);
+  if (!ok) {
+    free(image);
+    return Fail(kSuite, "Cache image differs from json_parse");
+  }
+  
+  Random rnd(37);
+  std::vector<uint64_t> corrupt((size + 7) / sizeof(uint64_t)); // Aligned
+  size_t rejected = 0;
+  for (size_t i = 0; i < 2000; ++i) {
+    memcpy(&corrupt[0], image, size);
+    char *bytes = (char *)&corrupt[0];
+    size_t nodes = size - doc.size() / 4;           // Mostly header and nodes
+    for (size_t n = 1 + rnd.Next(4); n; --n)
+      bytes[rnd.Next(nodes < size ? nodes : size)] ^= char(1 << rnd.Next(8));
+    node = json_cache_open(bytes, size);
+    if (node)
+      WalkCache(node);
+    else
+      ++rejected;
+  }
+  free(image);
+  if (!rejected)
+    return Fail(kSuite, "Validator accepted all corrupt cache images");
+  
+  // Images without strings or names have an empty pool
+  static const char *kBare[] = { "[]", "{}", "[1, 2, 3]",
+                                 "[[], 2.5, true, null]" };
+  for (size_t i = 0; i < sizeof(kBare) / sizeof(kBare[0]); ++i) {
+    work.assign(kBare[i], kBare[i] + strlen(kBare[i]) + 1);
+    root = json_parse(&work[0], &errorPos, &errorDesc, &errorLine);
+    image = json_cache_encode(root, &size);
+    node = json_cache_open(image, size);
+    ok = node && json_cache_type(node) == root->type &&
+         SameCache(node, root->first_child);
+    json_free(root);
+    free(image);
+    if (!ok)
+      return Fail(kSuite, "Cache image of %s differs from json_parse", kBare[i]);
+  }
+  if (json_cache_encode(NULL, &size))
+    return Fail(kSuite, "Cache image of no document");
+  return true;
+}
+
+
+static const json_cache_node *CacheField(const json_cache_node *root,
+                                         const char *album, size_t a,
+                                         size_t i, const char *field) {
+  const json_cache_node *node =
+    json_cache_child(json_cache_member(root, album), a);
+  if (i != size_t(-1))
+    node = json_cache_child(json_cache_member(node, "images"), i);
+  return node ? json_cache_member(node, field) : NULL;
+}
+
+
+// Startup reading four fields of a large document, from the JSON text
+// or from a mapped cache image of it
+static bool CacheBench() {
+  const std::string doc = AlbumJson(10, 8500 * gScale, false);
+  char jsonPath[] = "/tmp/utilbenchXXXXXX", cachePath[] = "/tmp/utilbenchXXXXXX";
+  int jsonFd = mkstemp(jsonPath), cacheFd = mkstemp(cachePath);
+  bool ok = jsonFd >= 0 && cacheFd >= 0 &&
+            write(jsonFd, doc.data(), doc.size()) == ssize_t(doc.size());
+  
+  std::vector<char> work(doc.size() + 1);
+  json_arena *arena = json_arena_create();
+  char *errorPos = 0, *errorDesc = 0;
+  int errorLine = 0;
+  std::string expected[4];
+  double sec = 0;
+  size_t iters = 0;
+  do {
+    Timer timer;
+    FILE *file = fopen(jsonPath, "rb");
+    size_t size = file ? fread(&work[0], 1, doc.size(), file) : 0;
+    if (file)
+      fclose(file);
+    work[size] = '\0';
+    json_arena_reset(arena);
+    json_value *root = json_parse(&work[0], &errorPos, &errorDesc, &errorLine,
+                                  arena);
+    const json_value *albums = FindMember(root, "albums");
+    const json_value *field[4] = {
+      FindMember(FindElement(albums, 3), "name"),
+      FindMember(FindElement(FindMember(FindElement(albums, 3), "images"), 7),
+                 "url"),
+      FindMember(FindElement(albums, 9), "count"),
+      FindMember(FindElement(FindMember(FindElement(albums, 0), "images"), 0),
+                 "date"),
+    };
+    sec += timer.Elapsed();
+    ++iters;
+    if (!field[0] || !field[1] || !field[2] || !field[3]) {
+      ok = false;
+      break;
+    }
+    char buf[64];
+    expected[0] = field[0]->string_value;
+    expected[1] = field[1]->string_value;
+    snprintf(buf, sizeof(buf), "%lld", (long long)field[2]->int_value);
+    expected[2] = buf;
+    snprintf(buf, sizeof(buf), "%.17g", field[3]->float_value);
+    expected[3] = buf;
+    if (iters == 1)
+      ok = ok && json_cache_save(root, cachePath);
+  } while (ok && sec < gMinSec);
+  json_arena_destroy(arena);
+  if (!ok) {
+    unlink(jsonPath);
+    unlink(cachePath);
+    return Fail(kSuite, "Cannot parse and cache the document in /tmp");
+  }
+  char name[64];
+  snprintf(name, sizeof(name), "read + json_parse %zuMB",
+           doc.size() / (1024 * 1024));
+  Report(kSuite, name, sec, iters, double(doc.size()) * iters);
+  
+  // The image is in the page cache, as on a relaunch
+  size_t imageSize = 0;
+  for (int validate = 0; ok && validate < 2; ++validate) {
+    sec = 0;
+    iters = 0;
+    do {
+      Timer timer;
+      int fd = open(cachePath, O_RDONLY);
+      struct stat info;
+      void *map = MAP_FAILED;
+      if (fd >= 0 && !fstat(fd, &info)) {
+        imageSize = info.st_size;
+        map = mmap(NULL, imageSize, PROT_READ, MAP_PRIVATE, fd, 0);
+      }
+      const json_cache_node *root = map == MAP_FAILED ? NULL :
+        json_cache_open(map, imageSize, validate != 0);
+      const json_cache_node *field[4] = {
+        CacheField(root, "albums", 3, size_t(-1), "name"),
+        CacheField(root, "albums", 3, 7, "url"),
+        CacheField(root, "albums", 9, size_t(-1), "count"),
+        CacheField(root, "albums", 0, 0, "date"),
+      };
+      std::string value[4];
+      char buf[64];
+      if (root && field[0] && field[1] && field[2] && field[3]) {
+        value[0] = json_cache_string(field[0]);
+        value[1] = json_cache_string(field[1]);
+        snprintf(buf, sizeof(buf), "%lld", (long long)json_cache_int(field[2]));
+        value[2] = buf;
+        snprintf(buf, sizeof(buf), "%.17g", json_cache_double(field[3]));
+        value[3] = buf;
+      }
+      if (map != MAP_FAILED)
+        munmap(map, imageSize);
+      if (fd >= 0)
+        close(fd);
+      sec += timer.Elapsed();
+      ++iters;
+      for (size_t i = 0; i < 4; ++i)
+        ok = ok && value[i] == expected[i];
+    } while (ok && sec < gMinSec);
+    Report(kSuite, validate ? "mmap + json_cache_open, validated" :
+           "mmap + json_cache_open", sec, iters);
+  }
+  if (ok)
+    printf("%-10s %-36s %.1f MB for %.1f MB of JSON\n", kSuite, "json_cache",
+           imageSize / (1024.0 * 1024.0), doc.size() / (1024.0 * 1024.0));
+  unlink(jsonPath);
+  unlink(cachePath);
+  if (!ok)
+    return Fail(kSuite, "Cached fields differ from json_parse");
+  return true;
+}
+
+
+// Array of one object per photo, as written by the bridge
+static std::string PhotoArrayJson(size_t count) {
+  static const char *caption[] = { "Beach, \\\"sunset\\\"", "line one\\nline two",
+                                   "caf\\u00e9 [table]", "{not an object}" };
+  Random rnd(38);
+  std::string s = "[\n";
+  char buf[512];
+  for (size_t i = 0; i < count; ++i) {
+    snprintf(buf, sizeof(buf), "  {\"name\": \"IMG_%06zu.JPG\", \"url\": "
+             "\"assets-library://asset/asset.JPG?id=%08X\", \"date\": %u.%03u, "
+             "\"size\": %u, \"w\": %u, \"h\": %u, \"flagged\": %s, "
+             "\"caption\": \"%s\", \"faces\": [%u, %u]}%s\n", i, rnd.Next(),
+             1300000000 + rnd.Next(100000000), rnd.Next(1000),
+             100000 + rnd.Next(20000000), 640 + rnd.Next(4000),
+             480 + rnd.Next(3000), rnd.Next(8) ? "false" : "true",
+             caption[rnd.Next(4)], rnd.Next(16), rnd.Next(16),
+             i + 1 < count ? "," : "");
+    s += buf;
+  }
+  s += "]\n";
+  return s;
+}
+
+
+// Parses a large array with 1 to 16 tasks, on as many threads
+static bool ParallelBench() {
+  const std::string doc = PhotoArrayJson(100000 * gScale);
+  std::vector<char> expectedWork(doc.begin(), doc.end());
+  expectedWork.push_back('\0');
+  char *errorPos = 0, *errorDesc = 0;
+  int errorLine = 0;
+  json_value *expected = json_parse(&expectedWork[0], &errorPos, &errorDesc,
+                                    &errorLine);
+  if (!expected)
+    return Fail(kSuite, "Photo array: %s at line %d", errorDesc, errorLine);
+  
+  // Errors must be those of json_parse, after the newlines unescaped in
+  // the captions of the ranges before, parsed after the failing one when
+  // there is no TaskMgr
+  std::string bad = doc;
+  bad.insert(bad.find("\"size\"", bad.size() * 3 / 4), "#");
+  std::vector<char> work(bad.begin(), bad.end());
+  work.push_back('\0');
+  json_parse(&work[0], &errorPos, &errorDesc, &errorLine);
+  const size_t errorOffset = errorPos - &work[0];
+  const int expectedLine = errorLine;
+  mt::TaskMgr taskMgr;
+  bool ok = taskMgr.Init(3);
+  char *parallelDesc = 0;
+  for (int serial = 0; ok && serial < 2; ++serial) {
+    work.assign(bad.begin(), bad.end());
+    work.push_back('\0');
+    ok = !json_parse_parallel(&work[0], &errorPos, &parallelDesc, &errorLine,
+                              NULL, serial ? NULL : &taskMgr, 4) &&
+         size_t(errorPos - &work[0]) == errorOffset &&
+         errorLine == expectedLine && !strcmp(errorDesc, parallelDesc);
+  }
+  if (!ok) {
+    json_free(expected);
+    return Fail(kSuite, "Parallel error \"%s\" line %d, expected \"%s\" line %d",
+                parallelDesc, errorLine, errorDesc, expectedLine);
+  }
+  
+  json_arena *arena = json_arena_create();
+  work.resize(doc.size() + 1);
+  double sec = 0;
+  size_t iters = 0;
+  do {
+    memcpy(&work[0], doc.c_str(), doc.size() + 1);
+    Timer timer;
+    json_arena_reset(arena);
+    json_parse(&work[0], &errorPos, &errorDesc, &errorLine, arena);
+    sec += timer.Elapsed();
+    ++iters;
+  } while (sec < gMinSec);
+  char name[64];
+  snprintf(name, sizeof(name), "json_parse %zuMB array",
+           doc.size() / (1024 * 1024));
+  Report(kSuite, name, sec, iters, double(doc.size()) * iters);
+  
+  for (size_t cores = 2; ok && cores <= 16; cores *= 2) {
+    mt::TaskMgr *workers = new mt::TaskMgr;
+    ok = workers->Init(cores - 1);                  // And the calling thread
+    sec = 0;
+    iters = 0;
+    json_value *root = NULL;
+    do {
+      memcpy(&work[0], doc.c_str(), doc.size() + 1);
+      Timer timer;
+      json_arena_reset(arena);
+      root = json_parse_parallel(&work[0], &errorPos, &errorDesc, &errorLine,
+                                 arena, workers, cores);
+      sec += timer.Elapsed();
+      ++iters;
+    } while (root && sec < gMinSec);
+    delete workers;
+    snprintf(name, sizeof(name), "json_parse_parallel, %zu threads", cores);
+    Report(kSuite, name, sec, iters, double(doc.size()) * iters);
+    ok = ok && root && SameTree(root, expected);
+  }
+  json_arena_destroy(arena);
+  json_free(expected);
+  if (!ok)
+    return Fail(kSuite, "Parallel parse differs from json_parse");
+  return true;
+}
+
+
+// Copy of doc ending where a page that cannot be read begins, as a file
+// mapped to the end of a page, read-only and without a terminating zero
+static const char *GuardedCopy(const std::string &doc, void **map,
+                               size_t *mapSize) {
+  const size_t page = sysconf(_SC_PAGESIZE);
+  const size_t pages = (doc.size() + page - 1) / page;
+  *mapSize = (pages + 1) * page;
+  *map = mmap(NULL, *mapSize, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (*map == MAP_FAILED)
+    return NULL;
+  char *data = (char *)*map + pages * page - doc.size();
+  memcpy(data, doc.data(), doc.size());
+  mprotect(*map, pages * page, PROT_READ);
+  mprotect((char *)*map + pages * page, page, PROT_NONE);
+  return data;
+}
+
+
+// True if the views of b unescape to the strings of a, parsed in place
+static bool SameView(const json_value *a, json_value *b) {
+  for (; a && b; a = a->next_sibling, b = b->next_sibling) {
+    size_t size = 0;
+    const char *name = json_name(b, &size);
+    if (a->type != b->type || !a->name != !name ||
+        (name && (size != a->name_size || memcmp(name, a->name, size))))
+      return false;
+    const char *text = json_string(b, &size);
+    if (a->type == JSON_STRING &&
+        (size != a->string_size || memcmp(text, a->string_value, size)))
+      return false;
+    if ((a->type == JSON_INT || a->type == JSON_BOOL) &&
+        a->int_value != b->int_value)
+      return false;
+    if (a->type == JSON_FLOAT &&
+        memcmp(&a->float_value, &b->float_value, sizeof(double)))
+      return false;
+    if (!SameView(a->first_child, b->first_child))
+      return false;
+  }
+  return !a && !b;
+}
+
+
+// Views of a read-only copy must match json_parse, still escaped when
+// written or cached, unescaped when read, with the same errors
+static bool CheckView(const std::string &doc) {
+  std::vector<char> work(doc.begin(), doc.end());
+  work.push_back('\0');
+  char *errorPos = 0, *errorDesc = 0;
+  int errorLine = 0;
+  json_value *expected = json_parse(&work[0], &errorPos, &errorDesc,
+                                    &errorLine);
+  void *map = MAP_FAILED;
+  size_t mapSize = 0;
+  const char *data = GuardedCopy(doc, &map, &mapSize);
+  size_t errorOffset = 0;
+  json_value *root = data ? json_parse_view(data, doc.size(), &errorOffset,
+                                            &errorDesc, &errorLine) : NULL;
+  bool ok = expected && root;
+  
+  // Escaped views are written and cached from the source
+  size_t escaped = 0;
+  for (const json_value *it = root ? root->first_child : NULL; it;
+       it = it->next_sibling)
+    for (const json_value *v = it->first_child; v; v = v->next_sibling)
+      escaped += (v->escaped & JSON_STRING_ESCAPED) != 0;
+  json_writer *writer = json_writer_create();
+  ok = ok && escaped && json_write_value(writer, root);
+  size_t size = 0;
+  const char *text = json_writer_data(writer, &size);
+  std::vector<char> written(text, text + size);
+  written.push_back('\0');
+  json_writer_destroy(writer);
+  json_value *reparsed = ok ? json_parse(&written[0], &errorPos, &errorDesc,
+                                         &errorLine) : NULL;
+  ok = ok && reparsed && SameTree(reparsed, expected);
+  json_free(reparsed);
+  size_t imageSize = 0, expectedSize = 0;
+  void *image = ok ? json_cache_encode(root, &imageSize) : NULL;
+  void *expectedImage = ok ? json_cache_encode(expected, &expectedSize) : NULL;
+  ok = ok && image && expectedImage && imageSize == expectedSize &&
+       !memcmp(image, expectedImage, imageSize);
+  free(image);
+  free(expectedImage);
+  
+  ok = ok && SameView(expected, root);
+  json_free(root);
+  if (map != MAP_FAILED)
+    munmap(map, mapSize);
+  if (!ok) {
+    json_free(expected);
+    return Fail(kSuite, "Views differ from json_parse");
+  }
+  
+  // Escaped names are found by json_find, walked or indexed
+  for (size_t count = 4; count <= 64; count *= 4) {
+    std::string object = "{";
+    char buf[64];
+    for (size_t i = 0; i < count; ++i) {
+      snprintf(buf, sizeof(buf), "%s\"k\\u00e9%zu\": %zu", i ? ", " : "", i, i);
+      object += buf;
+    }
+    object += "}";
+    root = json_parse_view(object.data(), object.size(), &errorOffset,
+                           &errorDesc, &errorLine);
+    for (size_t i = 0; root && i < count; i += 3) {
+      snprintf(buf, sizeof(buf), "k\xC3\xA9%zu", i);
+      const json_value *found = json_find(root, buf);
+      ok = ok && found && found->int_value == int64_t(i);
+    }
+    ok = ok && root && !json_find(root, "k\\u00e90");
+    json_free(root);
+  }
+  if (!ok) {
+    json_free(expected);
+    return Fail(kSuite, "json_find missed an escaped name");
+  }
+  
+  // Errors are those of json_parse, by offset, on corrupt or cut copies
+  Random rnd(39);
+  static const char kNoise[] = "#\"\\{}[]:,0eu\n";
+  for (size_t i = 0; ok && i < 1000; ++i) {
+    std::string bad = doc;
+    if (i % 4 == 0)
+      bad.resize(rnd.Next(bad.size()));
+    for (size_t n = 1 + rnd.Next(3); i % 4 && n; --n)
+      bad[rnd.Next(bad.size())] = kNoise[rnd.Next(sizeof(kNoise) - 1)];
+    work.assign(bad.begin(), bad.end());
+    work.push_back('\0');
+    char *viewDesc = 0;
+    json_value *inPlace = json_parse(&work[0], &errorPos, &errorDesc,
+                                     &errorLine);
+    data = GuardedCopy(bad, &map, &mapSize);
+    root = data ? json_parse_view(data, bad.size(), &errorOffset, &viewDesc,
+                                  &errorLine) : NULL;
+    if (!inPlace != !root ||
+        (!root && (strcmp(errorDesc, viewDesc) ||
+                   errorOffset != size_t(errorPos - &work[0]))))
+      ok = Fail(kSuite, "View error \"%s\" offset %zu, expected \"%s\" "
+                "offset %zu", root ? "none" : viewDesc, errorOffset,
+                inPlace ? "none" : errorDesc, size_t(errorPos - &work[0]));
+    else if (root && !SameView(inPlace, root))
+      ok = Fail(kSuite, "Corrupt view differs from json_parse");
+    json_free(inPlace);
+    json_free(root);
+    if (map != MAP_FAILED)
+      munmap(map, mapSize);
+  }
+  json_free(expected);
+  return ok;
+}
+
+
+// Parses a read-only copy, against a writable copy for json_parse
+static bool ViewBench(const char *name, const std::string &doc) {
+  std::vector<char> work(doc.size() + 1);
+  json_arena *arena = json_arena_create();
+  char *errorPos = 0, *errorDesc = 0;
+  int errorLine = 0;
+  double sec = 0;
+  size_t iters = 0;
+  do {
+    Timer timer;
+    memcpy(&work[0], doc.c_str(), doc.size() + 1);
+    json_arena_reset(arena);
+    json_parse(&work[0], &errorPos, &errorDesc, &errorLine, arena);
+    sec += timer.Elapsed();
+    ++iters;
+  } while (sec < gMinSec);
+  char title[64];
+  snprintf(title, sizeof(title), "copy + json_parse %s", name);
+  Report(kSuite, title, sec, iters, double(doc.size()) * iters);
+  
+  void *map = MAP_FAILED;
+  size_t mapSize = 0;
+  const char *data = GuardedCopy(doc, &map, &mapSize);
+  size_t errorOffset = 0;
+  json_value *root = NULL;
+  sec = 0;
+  iters = 0;
+  do {
+    Timer timer;
+    json_arena_reset(arena);
+    root = data ? json_parse_view(data, doc.size(), &errorOffset, &errorDesc,
+                                  &errorLine, arena) : NULL;
+    sec += timer.Elapsed();
+    ++iters;
+  } while (root && sec < gMinSec);
+  snprintf(title, sizeof(title), "json_parse_view %s", name);
+  Report(kSuite, title, sec, iters, double(doc.size()) * iters);
+  json_arena_destroy(arena);
+  if (map != MAP_FAILED)
+    munmap(map, mapSize);
+  if (!root)
+    return Fail(kSuite, "View of %s: %s at line %d", name, errorDesc,
+                errorLine);
+  return true;
+}
+
+
+// Loads a document from a file by reading it into a buffer and parsing it
+// in place, against parsing views of a mapping of it
+static bool FileBench(const char *name, const std::string &doc) {
+  char path[] = "/tmp/utilbenchXXXXXX";
+  int fd = mkstemp(path);
+  bool ok = fd >= 0 && write(fd, doc.c_str(), doc.size()) == ssize_t(doc.size());
+  if (fd >= 0)
+    close(fd);
+  
+  std::vector<char> work(doc.begin(), doc.end());
+  work.push_back('\0');
+  char *errorPos = 0, *errorDesc = 0;
+  int errorLine = 0;
+  size_t errorOffset = 0;
+  json_value *expected = json_parse(&work[0], &errorPos, &errorDesc,
+                                    &errorLine);
+  MappedFile file;
+  json_value *root = ok ? json_parse_file(path, &file, &errorOffset,
+                                          &errorDesc, &errorLine) : NULL;
+  ok = root && expected && SameView(expected, root) &&
+       !json_parse_file("/nonexistent/file", &file, &errorOffset, &errorDesc,
+                        &errorLine) && !strcmp(errorDesc, "Cannot open file") &&
+       errorLine == 1;
+  json_free(root);
+  json_free(expected);
+  if (!ok) {
+    unlink(path);
+    return Fail(kSuite, "json_parse_file of %s differs from json_parse", name);
+  }
+  
+  json_arena *arena = json_arena_create();
+  for (int mapped = 0; ok && mapped < 2; ++mapped) {
+    double sec = 0;
+    size_t iters = 0;
+    do {
+      Timer timer;
+      json_arena_reset(arena);
+      if (mapped) {
+        ok = json_parse_file(path, &file, &errorOffset, &errorDesc,
+                             &errorLine, arena) != NULL;
+      } else {
+        FILE *fp = fopen(path, "rb");
+        char *buf = (char *)malloc(doc.size() + 1);
+        ok = fp && buf && fread(buf, 1, doc.size(), fp) == doc.size();
+        if (ok) {
+          buf[doc.size()] = '\0';
+          ok = json_parse(buf, &errorPos, &errorDesc, &errorLine,
+                          arena) != NULL;
+        }
+        free(buf);
+        if (fp)
+          fclose(fp);
+      }
+      sec += timer.Elapsed();
+      ++iters;
+    } while (ok && sec < gMinSec);
+    char title[64];
+    snprintf(title, sizeof(title), "%s %s",
+             mapped ? "json_parse_file" : "fread + json_parse", name);
+    Report(kSuite, title, sec, iters, double(doc.size()) * iters);
+  }
+  json_arena_destroy(arena);
+  unlink(path);
+  if (!ok)
+    return Fail(kSuite, "Loading %s from a file: %s", name, errorDesc);
+  return true;
+}
+
+
+bool bench::JsonSuite() {
+  const std::string minified = AlbumJson(10, 500 * gScale, false);
+  const std::string pretty = AlbumJson(10, 500 * gScale, true);
+  
+  if (!CheckStrings() || !CheckNumbers() || !CheckWriter(pretty) ||
+      !CheckCache(pretty))
+    return false;
+  
+  // Error reporting must locate the offending line
+  std::string bad = pretty;
+  bad.insert(bad.find("\"rating\"", bad.size() / 2), "#");
+  std::vector<char> work(bad.begin(), bad.end());
+  work.push_back('\0');
+  char *errorPos = 0, *errorDesc = 0;
+  int errorLine = 0;
+  if (json_parse(&work[0], &errorPos, &errorDesc, &errorLine) || !errorDesc ||
+      *errorPos != '#')
+    return Fail(kSuite, "Parse error not detected");
+  if (!CheckSaxError(bad, errorPos, &work[0], errorDesc, errorLine) ||
+      !CheckTapeError(bad, errorPos, &work[0], errorDesc, errorLine))
+    return false;
+  if (!CheckTape(pretty))
+    return false;
+  
+  // Only white space may follow the root
+  const char *trailing[] = { "{} 5", "[1],", "{}\n\"a\"", "[] {}", "{} \n" };
+  for (size_t i = 0; i < sizeof(trailing) / sizeof(*trailing); ++i) {
+    std::string doc(trailing[i]);
+    work.assign(doc.begin(), doc.end());
+    work.push_back('\0');
+    errorDesc = 0;
+    errorPos = 0;
+    errorLine = 0;
+    json_value *root = json_parse(&work[0], &errorPos, &errorDesc,
+                                  &errorLine);
+    json_free(root);
+    if (root) {
+      size_t tapeOffset = 0;
+      char *tapeDesc = 0;
+      json_tape *tape = json_tape_parse(doc.data(), doc.size(), &tapeOffset,
+                                        &tapeDesc, &errorLine);
+      json_tape_destroy(tape);
+      if (!tape)
+        return Fail(kSuite, "Tape rejects \"%s\": %s", trailing[i],
+                    tapeDesc);
+    } else if (!CheckTapeError(doc, errorPos, &work[0], errorDesc,
+                               errorLine)) {
+      return false;
+    }
+  }
+  
+  if (mem::Bytes(mem::JsonDOM) != 0)
+    return Fail(kSuite, "Failed parse leaked %zu bytes",
+                mem::Bytes(mem::JsonDOM));
+  
+  if (!ParseBench("json_parse minified", minified, NULL))
+    return false;
+  if (!ParseBench("json_parse pretty", pretty, NULL))
+    return false;
+  
+  json_arena *arena = json_arena_create();
+  bool ok = ParseBench("json_parse minified, reused arena", minified, arena) &&
+            ParseBench("json_parse pretty, reused arena", pretty, arena);
+  if (ok) {
+    // Before the arena every node was a separate malloc
+    const size_t nodes = 1 + 1 + 10 * (5 + 500 * gScale * 14);
+    printf("%-10s %-36s %zu mallocs for %zu nodes, %.1f MB\n", kSuite,
+           "json_arena", json_arena_blocks(arena), nodes,
+           json_arena_bytes(arena) / (1024.0 * 1024.0));
+    if (mem::Bytes(mem::JsonDOM) != json_arena_bytes(arena))
+      ok = Fail(kSuite, "Arena holds %zu bytes, tracked %zu",
+                json_arena_bytes(arena), mem::Bytes(mem::JsonDOM));
+    
+    // json_free ignores values it did not allocate a private arena for
+    char small[] = "[1, [2]]";
+    json_value *root = json_parse(small, &errorPos, &errorDesc, &errorLine,
+                                  arena);
+    json_value local;
+    memset(&local, 0, sizeof(local));
+    const size_t bytes = mem::Bytes(mem::JsonDOM);
+    json_free(root);
+    json_free(root ? root->last_child : NULL);
+    json_free(&local);
+    if (ok && (!root || mem::Bytes(mem::JsonDOM) != bytes))
+      ok = Fail(kSuite, "json_free released a value of a caller's arena");
+  }
+  json_arena_destroy(arena);
+  if (ok && mem::Bytes(mem::JsonDOM) != 0)
+    ok = Fail(kSuite, "Destroyed arena still tracks %zu bytes",
+              mem::Bytes(mem::JsonDOM));
+  
+  ok = ok && SaxBench("json_sax minified, 64KB chunks", minified, 64 * 1024) &&
+       SaxBench("json_sax pretty, 64KB chunks", pretty, 64 * 1024) &&
+       SaxBench("json_sax minified, 1KB chunks", minified, 1024) &&
+       NumberBench() && TapeBench(minified);
+  for (size_t count = 10; ok && count <= 100000; count *= 10)
+    ok = FindBench(count);
+  ok = ok && WriterBench(minified) && CacheBench() && ParallelBench();
+  if (ok) {
+    const std::string photos = PhotoArrayJson(200);
+    ok = CheckView(photos) && ViewBench("minified", minified) &&
+         ViewBench("pretty", pretty) &&
+         ViewBench("photos", PhotoArrayJson(20000 * gScale)) &&
+         FileBench("minified", minified);
+  }
+  return ok;
+}
@@ -0,0 +1,396 @@
+//  Copyright (c) 2013 The 11ers. All rights reserved.
+
+#include "Bench.h"
+
+#include "Timer.h"
+#include "lodepng.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+
+using namespace bench;
+
+
+static const char *kSuite = "png";
+
+
+// The decoder lodepng used before its lookup tables, walking each Huffman
+// code a bit at a time, as the reference for output and speed. Follows
+// RFC 1951 without checking the zlib header or the Adler32 checksum.
+namespace reference {
+
+class Inflater {
+public:
+  Inflater(const unsigned char *in, size_t size)
+    : mIn(in), mBitCount(size * 8), mBit(0), mFail(false) {}
+
+  bool Inflate(std::vector<unsigned char> &out) {
+    mBit = 16;                                      // zlib header
+    bool last = false;
+    while (!last && !mFail) {
+      last = Bits(1);
+      const unsigned type = Bits(2);
+      if (type == 0)
+        Stored(out);
+      else if (type == 1)
+        Fixed(out);
+      else if (type == 2)
+        Dynamic(out);
+      else
+        mFail = true;
+    }
+    return !mFail;
+  }
+
+private:
+  struct Code {
+    unsigned short count[16];                       // Codes of each length
+    unsigned short symbol[288];                     // Ordered by code
+  };
+
+  unsigned Bits(unsigned n) {
+    unsigned v = 0;
+    for (unsigned i = 0; i < n; ++i, ++mBit) {
+      if (mBit >= mBitCount) {
+        mFail = true;
+        return 0;
+      }
+      v |= ((mIn[mBit >> 3] >> (mBit & 7)) & 1u) << i;
+    }
+    return v;
+  }
+
+  void Build(Code &code, const unsigned char *length, unsigned n) {
+    unsigned short offset[16];
+    memset(code.count, 0, sizeof(code.count));
+    for (unsigned i = 0; i < n; ++i)
+      ++code.count[length[i]];
+    code.count[0] = 0;
+    offset[1] = 0;
+    for (unsigned len = 1; len < 15; ++len)
+      offset[len + 1] = offset[len] + code.count[len];
+    for (unsigned i = 0; i < n; ++i) {
+      if (length[i])
+        code.symbol[offset[length[i]]++] = (unsigned short)i;
+    }
+  }
+
+  int Decode(const Code &code) {
+    int value = 0, first = 0, index = 0;
+    for (unsigned len = 1; len <= 15; ++len) {
+      value |= Bits(1);
+      const int count = code.count[len];
+      if (value - count < first)
+        return code.symbol[index + (value - first)];
+      index += count;
+      first = (first + count) << 1;
+      value <<= 1;
+    }
+    mFail = true;
+    return -1;
+  }
+
+  void Stored(std::vector<unsigned char> &out) {
+    mBit = (mBit + 7) & ~size_t(7);
+    const unsigned len = Bits(16), nlen = Bits(16);
+    if (mFail || len + nlen != 65535 || mBit + len * 8 > mBitCount) {
+      mFail = true;
+      return;
+    }
+    out.insert(out.end(), mIn + mBit / 8, mIn + mBit / 8 + len);
+    mBit += len * 8;
+  }
+
+  void Codes(std::vector<unsigned char> &out, const Code &lit,
+             const Code &dist) {
+    static const unsigned short kLenBase[] = {
+      3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59,
+      67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const unsigned short kLenExtra[] = {
+      0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4,
+      5, 5, 5, 5, 0 };
+    static const unsigned short kDistBase[] = {
+      1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385,
+      513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385,
+      24577 };
+    static const unsigned short kDistExtra[] = {
+      0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10,
+      11, 11, 12, 12, 13, 13 };
+    for (;;) {
+      int symbol = Decode(lit);
+      if (mFail || symbol == 256)
+        return;
+      if (symbol < 256) {
+        out.push_back((unsigned char)symbol);
+        continue;
+      }
+      symbol -= 257;
+      if (symbol >= 29) {
+        mFail = true;
+        return;
+      }
+      const size_t len = kLenBase[symbol] + Bits(kLenExtra[symbol]);
+      const int d = Decode(dist);
+      if (mFail || d >= 30) {
+        mFail = true;
+        return;
+      }
+      const size_t distance = kDistBase[d] + Bits(kDistExtra[d]);
+      if (mFail || distance > out.size()) {
+        mFail = true;
+        return;
+      }
+      for (size_t i = 0; i < len; ++i)
+        out.push_back(out[out.size() - distance]);
+    }
+  }
+
+  void Fixed(std::vector<unsigned char> &out) {
+    unsigned char length[288];
+    memset(length, 8, 144);
+    memset(length + 144, 9, 112);
+    memset(length + 256, 7, 24);
+    memset(length + 280, 8, 8);
+    Code lit, dist;
+    Build(lit, length, 288);
+    memset(length, 5, 30);
+    Build(dist, length, 30);
+    Codes(out, lit, dist);
+  }
+
+  void Dynamic(std::vector<unsigned char> &out) {
+    static const unsigned char kOrder[19] = {
+      16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+    const unsigned nlen = Bits(5) + 257, ndist = Bits(5) + 1;
+    const unsigned ncode = Bits(4) + 4;
+    unsigned char length[320];
+    memset(length, 0, sizeof(length));
+    for (unsigned i = 0; i < ncode; ++i)
+      length[kOrder[i]] = (unsigned char)Bits(3);
+    Code code, lit, dist;
+    Build(code, length, 19);
+    for (unsigned i = 0; i < nlen + ndist && !mFail;) {
+      const int symbol = Decode(code);
+      if (symbol < 16) {
+        length[i++] = (unsigned char)symbol;
+        continue;
+      }
+      unsigned char value = 0;
+      unsigned repeat;
+      if (symbol == 16) {
+        if (i == 0)
+          mFail = true;
+        value = i ? length[i - 1] : 0;
+        repeat = 3 + Bits(2);
+      } else if (symbol == 17) {
+        repeat = 3 + Bits(3);
+      } else {
+        repeat = 11 + Bits(7);
+      }
+      if (i + repeat > nlen + ndist)
+        mFail = true;
+      while (repeat-- && !mFail)
+        length[i++] = value;
+    }
+    if (mFail)
+      return;
+    Build(lit, length, nlen);
+    Build(dist, length + nlen, ndist);
+    Codes(out, lit, dist);
+  }
+
+  const unsigned char *mIn;
+  size_t mBitCount;
+  size_t mBit;
+  bool mFail;
+};
+
+}       // namespace reference
+
+
+// Image content, as RGBA
+enum Content { Photo, Screen, Noise, Skewed };
+
+static void MakeImage(Content content, unsigned w, unsigned h,
+                      std::vector<unsigned char> &rgba) {
+  Random rnd(17 + content);
+  rgba.resize(size_t(w) * h * 4);
+  for (unsigned y = 0; y < h; ++y) {
+    for (unsigned x = 0; x < w; ++x) {
+      unsigned char *p = &rgba[(size_t(y) * w + x) * 4];
+      switch (content) {
+        case Photo:                                 // Gradients and grain
+          p[0] = (unsigned char)(128 + 100 * sin(x * 0.01 + y * 0.003) +
+                                 rnd.Next(12));
+          p[1] = (unsigned char)(x * 255 / w / 2 + y * 255 / h / 2 +
+                                 rnd.Next(8));
+          p[2] = (unsigned char)(96 + 80 * cos(y * 0.02) + rnd.Next(10));
+          p[3] = 255;
+          break;
+        case Screen: {                              // Panels and text
+          const bool glyph = (y / 12) % 3 == 1 && (x / 7) % 9 < 7 &&
+                             rnd.Next(3) == 0;
+          const unsigned panel = (x / 160 + y / 120) % 4;
+          p[0] = glyph ? 20 : (unsigned char)(230 - panel * 30);
+          p[1] = glyph ? 20 : (unsigned char)(235 - panel * 20);
+          p[2] = glyph ? 30 : (unsigned char)(240 - panel * 10);
+          p[3] = 255;
+          break;
+        }
+        case Noise:
+          for (int i = 0; i < 4; ++i)
+            p[i] = (unsigned char)(rnd.Next() >> 24);
+          break;
+        case Skewed:                                // Long Huffman codes
+          for (int i = 0; i < 4; ++i) {
+            const double v = -log(1 - rnd.Unit()) * 12;
+            p[i] = v < 255 ? (unsigned char)v : 255;
+          }
+          break;
+      }
+    }
+  }
+}
+
+
+// Compare lodepng_zlib_decompress with the original data and the reference
+static bool CheckInflate(const char *name, const std::vector<unsigned char> &raw,
+                         const LodePNGCompressSettings &compress) {
+  unsigned char *zlib = NULL, *out = NULL;
+  size_t zlibSize = 0, outSize = 0;
+  std::vector<unsigned char> expected;
+  bool ok = !lodepng_zlib_compress(&zlib, &zlibSize, &raw[0], raw.size(),
+                                   &compress);
+  reference::Inflater inflater(zlib, zlibSize);
+  ok = ok && inflater.Inflate(expected) && expected == raw &&
+       !lodepng_zlib_decompress(&out, &outSize, zlib, zlibSize,
+                                &lodepng_default_decompress_settings) &&
+       outSize == raw.size() && !memcmp(out, &raw[0], outSize);
+  free(out);
+
+  // Truncated and corrupted streams fail without reading past the end
+  for (size_t i = 1; ok && i < 64; ++i) {
+    const size_t size = 8 + (zlibSize - 8) * i / 64;
+    unsigned char *copy = (unsigned char *)malloc(size);
+    memcpy(copy, zlib, size);
+    out = NULL;
+    outSize = 0;
+    ok = lodepng_zlib_decompress(&out, &outSize, copy, size,
+                                 &lodepng_default_decompress_settings) != 0;
+    free(out);
+    copy[2 + (size - 2) * (i % 7) / 7] ^= (unsigned char)(1 << (i % 8));
+    out = NULL;
+    outSize = 0;
+    lodepng_zlib_decompress(&out, &outSize, copy, size,
+                            &lodepng_default_decompress_settings);
+    free(out);
+    free(copy);
+  }
+  free(zlib);
+  if (!ok)
+    return Fail(kSuite, "Inflate of %s (btype %u, lz77 %u, window %u) differs",
+                name, compress.btype, compress.use_lz77, compress.windowsize);
+  return true;
+}
+
+
+// Time inflating a zlib stream of the image with lodepng and the reference
+static bool InflatePasses(const char *name,
+                          const std::vector<unsigned char> &raw) {
+  unsigned char *zlib = NULL;
+  size_t zlibSize = 0;
+  if (lodepng_zlib_compress(&zlib, &zlibSize, &raw[0], raw.size(),
+                            &lodepng_default_compress_settings))
+    return Fail(kSuite, "lodepng_zlib_compress of %s", name);
+  char label[64];
+  bool ok = true;
+  for (int method = 0; ok && method < 2; ++method) {
+    Timer timer;
+    size_t iters = 0;
+    do {
+      if (method == 0) {
+        std::vector<unsigned char> out;
+        out.reserve(raw.size());
+        reference::Inflater inflater(zlib, zlibSize);
+        ok = inflater.Inflate(out) && out.size() == raw.size();
+      } else {
+        unsigned char *out = NULL;
+        size_t outSize = 0;
+        ok = !lodepng_zlib_decompress(&out, &outSize, zlib, zlibSize,
+                                      &lodepng_default_decompress_settings) &&
+             outSize == raw.size();
+        free(out);
+      }
+      ++iters;
+    } while (ok && timer.Elapsed() < gMinSec);
+    snprintf(label, sizeof(label), "%s %s %zuKB", method ? "lodepng" :
+             "bit-walk", name, raw.size() / 1024);
+    Report(kSuite, label, timer.Elapsed(), iters, double(raw.size()) * iters);
+  }
+  free(zlib);
+  if (!ok)
+    return Fail(kSuite, "Inflate of %s failed", name);
+  return true;
+}
+
+
+bool bench::PngSuite() {
+  static const char *kName[] = { "photo", "screen", "noise", "skewed" };
+  const unsigned w = 512, h = 384 * unsigned(gScale);
+  std::vector<unsigned char> image[4];
+  for (int c = 0; c < 4; ++c)
+    MakeImage(Content(c), w, h, image[c]);
+
+  // Every block type, with and without LZ77, against the reference. The
+  // encoder writes dynamic blocks without LZ77 past the end of its buffer
+  // after the first, so those streams are kept to one block.
+  for (int c = 0; c < 4; ++c) {
+    LodePNGCompressSettings compress = lodepng_default_compress_settings;
+    const std::vector<unsigned char> block(image[c].begin(),
+                                           image[c].begin() + 60000);
+    for (unsigned btype = 0; btype < 3; ++btype) {
+      compress.btype = btype;
+      for (unsigned lz77 = 0; lz77 < 2; ++lz77) {
+        compress.use_lz77 = lz77;
+        compress.windowsize = lz77 ? 32768 : 2048;
+        if (!CheckInflate(kName[c], btype == 2 && !lz77 ? block : image[c],
+                          compress))
+          return false;
+      }
+    }
+  }
+
+  for (int c = 0; c < 4; ++c) {
+    if (!InflatePasses(kName[c], image[c]))
+      return false;
+  }
+
+  // Whole PNG decodes, inflate followed by unfiltering
+  for (int c = 0; c < 2; ++c) {
+    unsigned char *png = NULL, *decoded = NULL;
+    size_t pngSize = 0;
+    unsigned dw = 0, dh = 0;
+    bool ok = !lodepng_encode32(&png, &pngSize, &image[c][0], w, h);
+    Timer timer;
+    size_t iters = 0;
+    do {
+      decoded = NULL;
+      ok = ok && !lodepng_decode32(&decoded, &dw, &dh, png, pngSize) &&
+           dw == w && dh == h && !memcmp(decoded, &image[c][0], image[c].size());
+      lodepng_free_decoded(decoded);
+      ++iters;
+    } while (ok && timer.Elapsed() < gMinSec);
+    free(png);
+    if (!ok)
+      return Fail(kSuite, "lodepng_decode32 of %s differs", kName[c]);
+    char label[64];
+    snprintf(label, sizeof(label), "lodepng_decode32 %s %ux%u", kName[c], w, h);
+    Report(kSuite, label, timer.Elapsed(), iters,
+           double(image[c].size()) * iters);
+  }
+  return true;
+}
@@ -0,0 +1,76 @@
+//  Copyright (c) 2013 The 11ers. All rights reserved.
+
+#include "Bench.h"
+
+#include "Timer.h"
+#include "Watchdog.h"
+
+#include <string.h>
+#include <unistd.h>
+
+
+using namespace bench;
+
+
+static const char *kSuite = "watchdog";
+
+
+struct StallLog {
+  StallLog() : count(0), depth(0), stallSec(0) { inner[0] = '\0'; }
+  volatile int count;
+  int depth;
+  double stallSec;
+  char inner[64];
+};
+
+
+static void OnStall(const mt::StallReport &report, void *data) {
+  StallLog *log = (StallLog *)data;
+  log->depth = report.zoneDepth;
+  log->stallSec = report.stallSec;
+  if (report.zoneDepth > 0)
+    strncpy(log->inner, report.zone[report.zoneDepth - 1], 63);
+  log->count = log->count + 1;
+}
+
+
+bool bench::WatchdogSuite() {
+  StallLog log;
+  if (!mt::StartWatchdog(0.05, OnStall, &log))
+    return Fail(kSuite, "Cannot start watchdog");
+  
+  // Cost of instrumentation on the UI thread while the watchdog runs
+  const size_t n = 1000000;
+  mt::WatchdogBeat();
+  Timer timer;
+  for (size_t i = 0; i < n; ++i) {
+    mt::StallZone outer("Bench outer");
+    mt::StallZone inner("Bench inner");
+  }
+  Report(kSuite, "StallZone enter+exit x2M", timer.Elapsed(), 2 * n);
+  
+  timer.Restart();
+  for (size_t i = 0; i < n; ++i)
+    mt::WatchdogBeat();
+  Report(kSuite, "WatchdogBeat x1M", timer.Elapsed(), n);
+  if (log.count)
+    return Fail(kSuite, "Stall reported while beating");
+  
+  // A blocked frame must be reported once, naming the innermost zone
+  mt::WatchdogBeat();
+  {
+    mt::StallZone outer("Bench frame");
+    mt::StallZone inner("Bench blocking decode");
+    usleep(200000);
+  }
+  mt::WatchdogBeat();
+  mt::StopWatchdog();
+  if (log.count != 1)
+    return Fail(kSuite, "Reported %d stalls, expected 1", log.count);
+  if (log.depth != 2 || strcmp(log.inner, "Bench blocking decode"))
+    return Fail(kSuite, "Stall reported in %d zones, innermost \"%s\"",
+                log.depth, log.inner);
+  if (log.stallSec < 0.05)
+    return Fail(kSuite, "Stall of %.3fs is below threshold", log.stallSec);
+  return true;
+}
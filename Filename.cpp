@@ -1,44 +1,165 @@
 //  Copyright (c) 2012 The 11ers. All rights reserved.
 
 #include "Filename.h"
+#include "TaskMgr.h"
+#include "Thread.h"
+#include "Timer.h"
 
 #include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fnmatch.h>
 #include <sys/stat.h>
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/syscall.h>
+#endif
 #include <string>
 #include <string.h>
 #include <unistd.h>
 #include <vector>
 
 
+// Copy a view into a zero-terminated array of size chars, truncating it
+static void CopyView(const Filename::PathView &view, char *dst, size_t size) {
+  const size_t len = view.len < size ? view.len : size - 1;
+  memcpy(dst, view.str, len);
+  dst[len] = '\0';
+}
+
+
 void Filename::Split(const char *full, char dir[PATH_MAX], char base[NAME_MAX],
                      char ext[NAME_MAX]) {
   if (full == NULL || full[0] == '\0')
     return;
 
-  dir[0] = '\0';
-  base[0] = '\0';
+  PathView dirView, baseView, extView;
+  SplitView(full, &dirView, &baseView, ext != NULL ? &extView : NULL);
+  CopyView(dirView, dir, PATH_MAX);
+  CopyView(baseView, base, NAME_MAX);
   if (ext != NULL)
-    ext[0] = '\0';
-
-  const char *s = strrchr(full, '/');
-  if (s != NULL) {
-    int len = s - full + 1;
-    memcpy(dir, full, len);
-    dir[len] = '\0';
-    s++;
-  } else {
-    s = full;
-  }
+    CopyView(extView, ext, NAME_MAX);
+}
 
-  strcpy(base, s);
 
+void Filename::SplitView(const PathView &full, PathView *dir, PathView *base,
+                         PathView *ext) {
+  size_t slash = full.len;                          // After the last slash
+  while (slash > 0 && full.str[slash - 1] != '/')
+    --slash;
+  if (dir != NULL)
+    *dir = PathView(full.str, slash);
+
+  size_t dot = full.len;                            // Of the local name
   if (ext != NULL) {
-    char *b = strrchr(base, '.');
-    if (b != NULL) {
-      strcpy(ext, b);
-      *b = '\0';
+    while (dot > slash && full.str[dot - 1] != '.')
+      --dot;
+    dot = dot > slash ? dot - 1 : full.len;
+    *ext = PathView(full.str + dot, full.len - dot);
+  }
+  if (base != NULL)
+    *base = PathView(full.str + slash, dot - slash);
+}
+
+
+// Append len chars to buf at *pos, failing if the zero would not fit
+static bool AppendChars(char *buf, size_t bufSize, size_t *pos, const char *str,
+                   size_t len) {
+  if (len >= bufSize - *pos)
+    return false;
+  memmove(buf + *pos, str, len);
+  *pos += len;
+  return true;
+}
+
+
+// Terminate buf at pos, or empty it on failure
+static bool Terminate(bool ok, char *buf, size_t bufSize, size_t pos,
+                   size_t *len) {
+  if (!ok) {
+    if (bufSize > 0)
+      buf[0] = '\0';
+    return false;
+  }
+  buf[pos] = '\0';
+  if (len != NULL)
+    *len = pos;
+  return true;
+}
+
+
+bool Filename::Join(const PathView &dir, const PathView &name, char *buf,
+                    size_t bufSize, size_t *len) {
+  size_t pos = 0;
+  const char *str = name.str;
+  size_t n = name.len;
+  bool ok = bufSize > 0 && AppendChars(buf, bufSize, &pos, dir.str, dir.len);
+  if (!dir.Empty()) {
+    const bool dirSlash = dir.str[dir.len - 1] == '/';
+    if (n > 0 && str[0] == '/') {
+      if (dirSlash) {
+        ++str;
+        --n;
+      }
+    } else if (!dirSlash) {
+      ok = ok && AppendChars(buf, bufSize, &pos, "/", 1);
     }
   }
+  ok = ok && AppendChars(buf, bufSize, &pos, str, n);
+  return Terminate(ok, buf, bufSize, pos, len);
+}
+
+
+bool Filename::ChangeExt(const PathView &path, const PathView &ext, char *buf,
+                         size_t bufSize, size_t *len) {
+  PathView base, oldExt;
+  SplitView(path, NULL, &base, &oldExt);
+  size_t pos = 0;
+  bool ok = bufSize > 0 &&
+            AppendChars(buf, bufSize, &pos, path.str, path.len - oldExt.len) &&
+            AppendChars(buf, bufSize, &pos, ext.str, ext.len);
+  return Terminate(ok, buf, bufSize, pos, len);
+}
+
+
+bool Filename::Normalize(const PathView &path, char *buf, size_t bufSize,
+                         size_t *len) {
+  const char *s = path.str;
+  const size_t n = path.len;
+  const size_t root = n > 0 && s[0] == '/' ? 1 : 0; // Kept before all
+  size_t pos = 0;
+  bool ok = bufSize > 0 && AppendChars(buf, bufSize, &pos, "/", root);
+  for (size_t i = 0; ok && i < n;) {
+    while (i < n && s[i] == '/')
+      ++i;
+    const size_t start = i;
+    while (i < n && s[i] != '/')
+      ++i;
+    const size_t part = i - start;
+    if (part == 0 || (part == 1 && s[start] == '.'))
+      continue;
+    if (part == 2 && s[start] == '.' && s[start + 1] == '.') {
+      size_t last = pos;                            // Start of last part
+      while (last > root && buf[last - 1] != '/')
+        --last;
+      const bool parent = pos - last == 2 && buf[last] == '.' &&
+                          buf[last + 1] == '.';
+      if (pos > root && !parent) {
+        pos = last > root ? last - 1 : root;        // Drop it and its slash
+        continue;
+      }
+      if (root)
+        continue;                                   // No parent of root
+    }
+    // In place, the slash and part end before s[i], so nothing unread is lost
+    if (pos > root)
+      ok = AppendChars(buf, bufSize, &pos, "/", 1);
+    ok = ok && AppendChars(buf, bufSize, &pos, s + start, part);
+  }
+  if (ok && pos == 0)
+    ok = AppendChars(buf, bufSize, &pos, ".", 1);
+  return Terminate(ok, buf, bufSize, pos, len);
 }
 
 
@@ -54,7 +175,11 @@ double Filename::ModEpochSec(const char *filename) {
   struct stat sbuf;
   if (stat(filename, &sbuf) < 0)
     return 0;
+#if defined(__APPLE__)
   double sec = sbuf.st_mtimespec.tv_sec + 1e-9 * sbuf.st_mtimespec.tv_nsec;
+#else
+  double sec = sbuf.st_mtim.tv_sec + 1e-9 * sbuf.st_mtim.tv_nsec;
+#endif
   return sec;
 }
 
@@ -63,7 +188,11 @@ double Filename::AccessEpochSec(const char *filename) {
   struct stat sbuf;
   if (stat(filename, &sbuf) < 0)
     return 0;
+#if defined(__APPLE__)
   double sec = sbuf.st_atimespec.tv_sec + 1e-9 * sbuf.st_atimespec.tv_nsec;
+#else
+  double sec = sbuf.st_atim.tv_sec + 1e-9 * sbuf.st_atim.tv_nsec;
+#endif
   return sec;
 }
 
@@ -76,6 +205,129 @@ size_t Filename::FileSize(const char *filename) {
 }
 
 
+// True if the real user is in group gid
+static bool InGroup(gid_t gid) {
+  if (gid == getgid())
+    return true;
+  gid_t groups[64];
+  int count = getgroups(64, groups);
+  for (int i = 0; i < count; ++i) {
+    if (groups[i] == gid)
+      return true;
+  }
+  return false;
+}
+
+
+// Fill the permissions in info from the mode bits, as access() checks them
+static void SetAccess(mode_t mode, uid_t uid, gid_t gid,
+                      Filename::StatInfo *info) {
+  if (getuid() == 0) {                              // Root may read & write
+    info->isReadable = info->isWritable = true;
+    return;
+  }
+  const int shift = uid == getuid() ? 6 : InGroup(gid) ? 3 : 0;
+  info->isReadable = (mode >> shift & S_IROTH) != 0;
+  info->isWritable = (mode >> shift & S_IWOTH) != 0;
+}
+
+
+static bool StatFallback(const char *filename, Filename::StatInfo *info) {
+  struct stat sbuf;
+  if (stat(filename, &sbuf) < 0)
+    return false;
+#if defined(__APPLE__)
+  info->modEpochSec = sbuf.st_mtimespec.tv_sec +
+                      1e-9 * sbuf.st_mtimespec.tv_nsec;
+  info->accessEpochSec = sbuf.st_atimespec.tv_sec +
+                         1e-9 * sbuf.st_atimespec.tv_nsec;
+#else
+  info->modEpochSec = sbuf.st_mtim.tv_sec + 1e-9 * sbuf.st_mtim.tv_nsec;
+  info->accessEpochSec = sbuf.st_atim.tv_sec + 1e-9 * sbuf.st_atim.tv_nsec;
+#endif
+  info->size = size_t(sbuf.st_size);
+  info->isDirectory = S_ISDIR(sbuf.st_mode);
+  SetAccess(sbuf.st_mode, sbuf.st_uid, sbuf.st_gid, info);
+  return true;
+}
+
+
+bool Filename::Stat(const char *filename, StatInfo *info) {
+  memset(info, 0, sizeof(*info));
+#if defined(STATX_BASIC_STATS)
+  // Only the fields used, which spares network file systems the rest
+  const unsigned int mask = STATX_TYPE | STATX_MODE | STATX_UID | STATX_GID |
+                            STATX_ATIME | STATX_MTIME | STATX_SIZE;
+  struct statx sbuf;
+  if (statx(AT_FDCWD, filename, 0, mask, &sbuf) < 0) {
+    if (errno == ENOSYS)                            // Kernel before 4.11
+      return StatFallback(filename, info);
+    return false;
+  }
+  info->modEpochSec = sbuf.stx_mtime.tv_sec + 1e-9 * sbuf.stx_mtime.tv_nsec;
+  info->accessEpochSec = sbuf.stx_atime.tv_sec + 1e-9 * sbuf.stx_atime.tv_nsec;
+  info->size = size_t(sbuf.stx_size);
+  info->isDirectory = S_ISDIR(sbuf.stx_mode);
+  SetAccess(sbuf.stx_mode, sbuf.stx_uid, sbuf.stx_gid, info);
+  return true;
+#else
+  return StatFallback(filename, info);
+#endif
+}
+
+
+namespace {
+
+// Range of a batch queried by one task
+struct StatRange {
+  const std::string *path;
+  Filename::StatInfo *info;
+  size_t count;
+  size_t found;
+};
+
+
+void StatRangeFiles(void *ranges, size_t index) {
+  StatRange *range = (StatRange *)ranges + index;
+  range->found = 0;
+  for (size_t i = 0; i < range->count; ++i) {
+    if (Filename::Stat(range->path[i].c_str(), &range->info[i]))
+      range->found++;
+  }
+}
+
+}       // namespace
+
+
+size_t Filename::StatBatch(const std::vector<std::string> &pathVec,
+                           std::vector<StatInfo> &infoVec,
+                           mt::TaskMgr *taskMgr, size_t tasks) {
+  infoVec.resize(pathVec.size());
+  if (pathVec.empty())
+    return 0;
+  if (tasks > pathVec.size())
+    tasks = pathVec.size();
+  if (tasks < 1)
+    tasks = 1;
+  
+  std::vector<StatRange> ranges(tasks);
+  const size_t per = pathVec.size() / tasks;
+  for (size_t i = 0; i < tasks; ++i) {
+    ranges[i].path = &pathVec[i * per];
+    ranges[i].info = &infoVec[i * per];
+    ranges[i].count = i + 1 < tasks ? per : pathVec.size() - i * per;
+  }
+  
+  mt::RunRanges(taskMgr, "Filename::StatBatch", tasks, StatRangeFiles,
+                &ranges[0]);
+  
+  size_t found = 0;
+  for (size_t i = 0; i < tasks; ++i)
+    found += ranges[i].found;
+  return found;
+}
+
+
 bool Filename::ListDirectory(const char *dirname,
                              std::vector<std::string> &filenameVec) {
   DIR *dir = opendir(dirname);
@@ -89,3 +341,444 @@ bool Filename::ListDirectory(const char *dirname,
   
   return true;
 }
+
+
+void Filename::PathList::Add(const char *path, size_t len) {
+  mOffsetVec.push_back(mTextVec.size());
+  mTextVec.insert(mTextVec.end(), path, path + len);
+  mTextVec.push_back('\0');
+}
+
+
+void Filename::PathList::Append(const PathList &rhs) {
+  const size_t base = mTextVec.size();
+  mTextVec.insert(mTextVec.end(), rhs.mTextVec.begin(), rhs.mTextVec.end());
+  for (size_t i = 0; i < rhs.mOffsetVec.size(); ++i)
+    mOffsetVec.push_back(base + rhs.mOffsetVec[i]);
+}
+
+
+namespace {
+
+const size_t kScanBufferSize = 128 * 1024;          // Entries per syscall
+
+
+#if defined(__linux__)
+// Record returned by getdents64, which glibc only declares since 2.30
+struct Dirent64 {
+  unsigned long long d_ino;
+  long long d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[1];                                   // Zero-terminated
+};
+#endif
+
+
+// Matches file names against a glob, or anything without one
+class NameMatcher {
+public:
+  explicit NameMatcher(const char *pattern)
+    : mPattern(pattern), mSuffix(NULL), mSuffixLen(0) {
+    if (pattern && pattern[0] == '*' && !strpbrk(pattern + 1, "*?[\\")) {
+      mSuffix = pattern + 1;                        // "*.ext"
+      mSuffixLen = strlen(mSuffix);
+    }
+  }
+  bool operator()(const char *name, size_t len) const {
+    if (!mPattern)
+      return true;
+    if (mSuffix)
+      return len >= mSuffixLen &&
+             !memcmp(name + len - mSuffixLen, mSuffix, mSuffixLen);
+    return fnmatch(mPattern, name, 0) == 0;
+  }
+  
+private:
+  const char *mPattern;
+  const char *mSuffix;
+  size_t mSuffixLen;
+};
+
+
+// Lists directories into path lists, reusing one buffer for their entries
+class DirScanner {
+public:
+  DirScanner(const NameMatcher &matcher, bool recursive)
+    : mMatcher(matcher), mRecursive(recursive), mBuffer(kScanBufferSize) {}
+  
+  // Add the matching files in the directory at path to pathList, and
+  // its subdirectories to dirList if recursive. False if not readable.
+  bool ScanDir(std::string &path, Filename::PathList &pathList,
+               Filename::PathList &dirList);
+  
+  // Add the files in the directory and below it, depth first
+  void ScanTree(std::string &path, Filename::PathList &pathList);
+  
+private:
+  void AddEntry(std::string &path, const char *name, unsigned char type,
+                Filename::PathList &pathList, Filename::PathList &dirList);
+  
+  const NameMatcher &mMatcher;
+  bool mRecursive;
+  std::vector<char> mBuffer;                        // Directory entries
+};
+
+
+void DirScanner::AddEntry(std::string &path, const char *name,
+                          unsigned char type, Filename::PathList &pathList,
+                          Filename::PathList &dirList) {
+  if (name[0] == '.' && (!name[1] || (name[1] == '.' && !name[2])))
+    return;
+  const size_t len = strlen(name);
+  const size_t base = path.size();
+  if (base && path[base - 1] != '/')
+    path += '/';
+  path.append(name, len);
+  if (type == DT_UNKNOWN) {                         // File system without it
+    struct stat sbuf;
+    if (lstat(path.c_str(), &sbuf) == 0)
+      type = S_ISREG(sbuf.st_mode) ? DT_REG : S_ISDIR(sbuf.st_mode) ? DT_DIR : 0;
+  }
+  if (type == DT_REG && mMatcher(name, len))
+    pathList.Add(path.c_str(), path.size());
+  else if (type == DT_DIR && mRecursive)
+    dirList.Add(path.c_str(), path.size());
+  path.resize(base);
+}
+
+
+bool DirScanner::ScanDir(std::string &path, Filename::PathList &pathList,
+                         Filename::PathList &dirList) {
+#if defined(__linux__)
+  int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+  long len;
+  while ((len = syscall(SYS_getdents64, fd, &mBuffer[0], mBuffer.size())) > 0) {
+    for (long offset = 0; offset < len; /*EMPTY*/) {
+      const Dirent64 *entry = (const Dirent64 *)&mBuffer[offset];
+      AddEntry(path, entry->d_name, entry->d_type, pathList, dirList);
+      offset += entry->d_reclen;
+    }
+  }
+  close(fd);
+#else
+  DIR *dir = opendir(path.c_str());
+  if (!dir)
+    return false;
+  for (struct dirent *f = readdir(dir); f != NULL; f = readdir(dir))
+    AddEntry(path, f->d_name, f->d_type, pathList, dirList);
+  closedir(dir);
+#endif
+  return true;
+}
+
+
+void DirScanner::ScanTree(std::string &path, Filename::PathList &pathList) {
+  Filename::PathList dirList;
+  if (!ScanDir(path, pathList, dirList))
+    return;
+  for (size_t i = 0; i < dirList.Size(); ++i) {
+    std::string subdir(dirList[i]);
+    ScanTree(subdir, pathList);
+  }
+}
+
+
+// Subdirectories scanned concurrently, each claimed by the next free
+// thread and listed into its own part
+struct ScanTrees {
+  mt::Mutex mutex;
+  const NameMatcher *matcher;
+  const Filename::PathList *dirList;
+  std::vector<Filename::PathList> *partVec;
+  size_t next;                                      // First unclaimed
+};
+
+
+// Each range scans trees until none is left unclaimed
+void ScanClaimedTrees(void *context, size_t /*range*/) {
+  ScanTrees *trees = (ScanTrees *)context;
+  DirScanner scanner(*trees->matcher, true);
+  for (;;) {
+    size_t i;
+    {
+      mt::MutexLockGuard guard(trees->mutex);
+      i = trees->next++;
+    }
+    if (i >= trees->dirList->Size())
+      return;
+    std::string path((*trees->dirList)[i]);
+    scanner.ScanTree(path, (*trees->partVec)[i]);
+  }
+}
+
+}       // namespace
+
+
+bool Filename::ScanDirectory(const char *dirname, const char *pattern,
+                             bool recursive, PathList &pathList,
+                             mt::TaskMgr *taskMgr, size_t tasks) {
+  NameMatcher matcher(pattern);
+  DirScanner scanner(matcher, recursive);
+  std::string path(dirname);
+  PathList dirList;
+  if (!scanner.ScanDir(path, pathList, dirList))
+    return false;
+  if (tasks < 2 || dirList.Size() < 2) {
+    for (size_t i = 0; i < dirList.Size(); ++i) {
+      path = dirList[i];
+      scanner.ScanTree(path, pathList);
+    }
+    return true;
+  }
+  
+  if (tasks > dirList.Size())
+    tasks = dirList.Size();
+  std::vector<PathList> partVec(dirList.Size());
+  ScanTrees trees;
+  trees.matcher = &matcher;
+  trees.dirList = &dirList;
+  trees.partVec = &partVec;
+  trees.next = 0;
+  mt::RunRanges(taskMgr, "Filename::ScanDirectory", tasks, ScanClaimedTrees,
+                &trees);
+  
+  for (size_t i = 0; i < partVec.size(); ++i)
+    pathList.Append(partVec[i]);
+  return true;
+}
+
+
+static const double kPollIntervalSec = 0.1;         // Rescans while waiting
+
+#if defined(__linux__)
+static const uint32_t kWatchMask = IN_CREATE | IN_DELETE | IN_MODIFY |
+                                   IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVED_FROM |
+                                   IN_MOVED_TO | IN_ONLYDIR | IN_EXCL_UNLINK;
+#endif
+
+
+Filename::DirWatch::DirWatch() : mFd(-1), mWatching(false) {}
+
+
+Filename::DirWatch::~DirWatch() {
+  if (mFd >= 0)
+    close(mFd);
+}
+
+
+bool Filename::DirWatch::Init(const char *dirname, bool polling) {
+  if (mFd >= 0)
+    close(mFd);
+  mFd = -1;
+  mDirMap.clear();
+  mChangeMap.clear();
+  mFileStateMap.clear();
+  mRoot = dirname;
+  while (mRoot.size() > 1 && mRoot[mRoot.size() - 1] == '/')
+    mRoot.resize(mRoot.size() - 1);
+  StatInfo info;
+  mWatching = Stat(mRoot.c_str(), &info) && info.isDirectory;
+  if (!mWatching)
+    return false;
+  
+#if defined(__linux__)
+  // Fall back to polling if inotify is out of instances or watches
+  if (!polling && (mFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) >= 0 &&
+      !AddWatchTree(mRoot, false)) {
+    close(mFd);
+    mFd = -1;
+    mDirMap.clear();
+  }
+#endif
+  if (mFd < 0) {
+    Rescan();                                       // Files already there
+    mChangeMap.clear();
+  }
+  return true;
+}
+
+
+bool Filename::DirWatch::Poll(std::vector<Event> &eventVec, double waitSec) {
+  eventVec.clear();
+  if (!mWatching)
+    return false;
+  bool ok = true;
+  if (mFd >= 0) {
+    ok = ReadEvents(waitSec);
+  } else {
+    Timer timer;
+    for (;;) {
+      Rescan();
+      const double remaining = waitSec - timer.Elapsed();
+      if (!mChangeMap.empty() || remaining <= 0)
+        break;
+      usleep(useconds_t(1e6 * (remaining < kPollIntervalSec ?
+                               remaining : kPollIntervalSec)));
+    }
+  }
+  eventVec.resize(mChangeMap.size());
+  size_t i = 0;
+  for (std::map<std::string, Change>::const_iterator it = mChangeMap.begin();
+       it != mChangeMap.end(); ++it, ++i) {
+    eventVec[i].path = it->first;
+    eventVec[i].change = it->second;
+  }
+  mChangeMap.clear();
+  return ok;
+}
+
+
+void Filename::DirWatch::Add(const std::string &path, Change change) {
+  std::map<std::string, Change>::iterator it = mChangeMap.find(path);
+  if (it == mChangeMap.end()) {
+    mChangeMap[path] = change;
+    return;
+  }
+  const Change previous = it->second;
+  if (previous == Overflow || change == Overflow)
+    it->second = Overflow;
+  else if (change == Deleted && previous == Created)
+    mChangeMap.erase(it);                           // Never seen
+  else if (change == Deleted)
+    it->second = Deleted;
+  else if (previous != Created)
+    it->second = Modified;                          // Replaced or changed
+}
+
+
+// Watch a directory and those below it, reporting the files in it if it
+// was created after the watch on its parent, whose events it missed.
+// False if a watch could not be added.
+bool Filename::DirWatch::AddWatchTree(const std::string &dirname,
+                                      bool created) {
+#if defined(__linux__)
+  int wd = inotify_add_watch(mFd, dirname.c_str(), kWatchMask);
+  if (wd < 0)
+    return false;
+  mDirMap[wd] = dirname;
+  DIR *dir = opendir(dirname.c_str());
+  if (!dir)
+    return true;                                    // Deleted meanwhile
+  bool ok = true;
+  for (struct dirent *f = readdir(dir); f != NULL; f = readdir(dir)) {
+    if (!strcmp(f->d_name, ".") || !strcmp(f->d_name, ".."))
+      continue;
+    std::string path = dirname + "/" + f->d_name;
+    unsigned char type = f->d_type;
+    struct stat sbuf;
+    if (type == DT_UNKNOWN && lstat(path.c_str(), &sbuf) == 0)
+      type = S_ISREG(sbuf.st_mode) ? DT_REG : S_ISDIR(sbuf.st_mode) ? DT_DIR : 0;
+    if (type == DT_DIR)
+      ok = AddWatchTree(path, created) && ok;
+    else if (type == DT_REG && created)
+      Add(path, Created);
+  }
+  closedir(dir);
+  return ok;
+#else
+  return false;
+#endif
+}
+
+
+// Read the pending inotify events, waiting up to waitSec for the first
+bool Filename::DirWatch::ReadEvents(double waitSec) {
+#if defined(__linux__)
+  if (waitSec > 0 && mChangeMap.empty()) {
+    struct pollfd pfd = { mFd, POLLIN, 0 };
+    poll(&pfd, 1, int(1000 * waitSec));
+  }
+  long buffer[4096];                                // Aligned for events
+  ssize_t len;
+  while ((len = read(mFd, buffer, sizeof(buffer))) > 0) {
+    for (ssize_t offset = 0; offset < len; /*EMPTY*/) {
+      const struct inotify_event *event =
+        (const struct inotify_event *)((const char *)buffer + offset);
+      offset += sizeof(struct inotify_event) + event->len;
+      if (event->mask & IN_Q_OVERFLOW) {
+        Add(mRoot, Overflow);
+        AddWatchTree(mRoot, false);                 // Directories missed
+        continue;
+      }
+      std::map<int, std::string>::iterator dir = mDirMap.find(event->wd);
+      if (dir == mDirMap.end())
+        continue;
+      if (event->mask & IN_IGNORED) {               // Deleted or unwatched
+        mDirMap.erase(dir);
+        continue;
+      }
+      if (!event->len)
+        continue;
+      const std::string path = dir->second + "/" + event->name;
+      if (event->mask & IN_ISDIR) {
+        if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+          if (!AddWatchTree(path, true))
+            Add(mRoot, Overflow);
+        } else if (event->mask & IN_MOVED_FROM) {
+          // Stop watching the tree moved out, which keeps its watches
+          const std::string prefix = path + "/";
+          for (std::map<int, std::string>::iterator it = mDirMap.begin();
+               it != mDirMap.end(); /*EMPTY*/) {
+            if (it->second == path || !it->second.compare(0, prefix.size(),
+                                                          prefix)) {
+              inotify_rm_watch(mFd, it->first);
+              mDirMap.erase(it++);
+            } else {
+              ++it;
+            }
+          }
+          Add(path, Deleted);
+        }
+      } else if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+        Add(path, Created);
+      } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+        Add(path, Deleted);
+      } else {
+        Add(path, Modified);
+      }
+    }
+  }
+  return len == 0 || errno == EAGAIN;
+#else
+  return false;
+#endif
+}
+
+
+// Compare a new scan of the tree with the last one
+void Filename::DirWatch::Rescan() {
+  PathList pathList;
+  ScanDirectory(mRoot.c_str(), NULL, true, pathList);
+  FileStateMap fileStateMap;
+  StatInfo info;
+  for (size_t i = 0; i < pathList.Size(); ++i) {
+    if (Stat(pathList[i], &info)) {
+      FileState &state = fileStateMap[pathList[i]];
+      state.modEpochSec = info.modEpochSec;
+      state.size = info.size;
+    }
+  }
+  
+  FileStateMap::const_iterator last = mFileStateMap.begin();
+  FileStateMap::const_iterator next = fileStateMap.begin();
+  while (last != mFileStateMap.end() || next != fileStateMap.end()) {
+    if (next == fileStateMap.end() ||
+        (last != mFileStateMap.end() && last->first < next->first)) {
+      Add(last->first, Deleted);
+      ++last;
+    } else if (last == mFileStateMap.end() || next->first < last->first) {
+      Add(next->first, Created);
+      ++next;
+    } else {
+      if (last->second.modEpochSec != next->second.modEpochSec ||
+          last->second.size != next->second.size)
+        Add(next->first, Modified);
+      ++last;
+      ++next;
+    }
+  }
+  mFileStateMap.swap(fileStateMap);
+}
@@ -11,18 +11,81 @@
   #define NAME_MAX PATH_MAX
 #endif
 
+#include <map>
 #include <string>
+#include <string.h>
 #include <vector>
 
+namespace mt { class TaskMgr; }
+
 namespace Filename {
 
 
 // Splits up the full filename into three components. Retains the trailing
 // slash at the end of dir and the period at the beginning of ext.
-// If ext==NULL, base contains the entire local name.
+// If ext==NULL, base contains the entire local name. Components longer
+// than the arrays are truncated.
 void Split(const char *full, char dir[PATH_MAX], char base[NAME_MAX],
            char ext[NAME_MAX]);
 
+// A range of characters in a path owned by the caller, which must outlive
+// the view. Not zero-terminated, so views of a path never copy it.
+struct PathView {
+  PathView() : str(""), len(0) {}
+  PathView(const char *s) : str(s), len(strlen(s)) {}
+  PathView(const char *s, size_t n) : str(s), len(n) {}
+  PathView(const std::string &s) : str(s.data()), len(s.size()) {}
+
+  bool Empty() const { return len == 0; }
+  bool Equals(const PathView &rhs) const {
+    return len == rhs.len && !memcmp(str, rhs.str, len);
+  }
+  std::string String() const { return std::string(str, len); }
+
+  const char *str;                                  // Not zero-terminated
+  size_t len;
+};
+
+// Views of the components of a path, as Split but without copying: dir
+// keeps its trailing slash, and ext its period. Any may be NULL, and if
+// ext is NULL, base is the entire local name.
+void SplitView(const PathView &full, PathView *dir, PathView *base,
+               PathView *ext);
+inline PathView DirView(const PathView &full) {
+  PathView dir;
+  SplitView(full, &dir, NULL, NULL);
+  return dir;
+}
+inline PathView NameView(const PathView &full) {    // Base and ext
+  PathView name;
+  SplitView(full, NULL, &name, NULL);
+  return name;
+}
+inline PathView ExtView(const PathView &full) {
+  PathView base, ext;
+  SplitView(full, NULL, &base, &ext);
+  return ext;
+}
+
+// Write dir and name into buf, with one slash between them unless dir is
+// empty, and a terminating zero. Return false, leaving buf empty, if the
+// result does not fit in bufSize, otherwise its length in len if not NULL.
+bool Join(const PathView &dir, const PathView &name, char *buf,
+          size_t bufSize, size_t *len = NULL);
+
+// Write path into buf with the extension of its local name replaced by
+// ext, which includes the period, or added if it has none. Returns as Join.
+bool ChangeExt(const PathView &path, const PathView &ext, char *buf,
+               size_t bufSize, size_t *len = NULL);
+
+// Write path into buf without repeated slashes, "." components, trailing
+// slashes or, where a parent precedes them, ".." components, as "." if
+// nothing remains. Lexical only: symbolic links are not resolved. The
+// result is never longer than path, except for ".", so buf may be
+// path.str to normalize in place. Returns as Join.
+bool Normalize(const PathView &path, char *buf, size_t bufSize,
+               size_t *len = NULL);
+
 // Tests to see if we can access the specified filename.
 bool IsAccessible(const char *filename, bool isForWriting=false);
 
@@ -33,8 +96,119 @@ double AccessEpochSec(const char *filename);
 // Return the size of the file in bytes, or zero if it is a directory or error
 size_t FileSize(const char *filename);
   
+// Metadata of a file, returned by a single query
+struct StatInfo {
+  double modEpochSec;                               // As ModEpochSec
+  double accessEpochSec;                            // As AccessEpochSec
+  size_t size;                                      // As FileSize
+  bool isDirectory;
+  bool isReadable;                                  // As IsAccessible, from
+  bool isWritable;                                  //   the permission bits
+};
+
+// Fill info with one statx (or stat) call, returning false and clearing
+// info if the file cannot be found. Readable and writable are derived from
+// the permission bits for the real user, ignoring ACLs and read-only mounts.
+bool Stat(const char *filename, StatInfo *info);
+
+// Stat each path into infoVec, splitting the list into up to tasks ranges
+// queried concurrently, one on the calling thread and the others on the
+// workers of taskMgr, or all on the calling thread if it is NULL. Return
+// the number of files found. Must not be called from a task of taskMgr.
+size_t StatBatch(const std::vector<std::string> &pathVec,
+                 std::vector<StatInfo> &infoVec, mt::TaskMgr *taskMgr,
+                 size_t tasks);
+
 // Return the list of filenames in a directory
 bool ListDirectory(const char *dirname, std::vector<std::string> &filenameVec);
+
+// Zero-terminated paths kept end to end in one buffer, instead of a
+// std::string each. Pointers are invalidated by Add and Append.
+class PathList {
+public:
+  size_t Size() const { return mOffsetVec.size(); }
+  const char *operator[](size_t i) const { return &mTextVec[mOffsetVec[i]]; }
+  size_t Bytes() const { return mTextVec.size(); }  // Text, with zeros
+  
+  void Clear() { mTextVec.clear(); mOffsetVec.clear(); }
+  void Add(const char *path, size_t len);           // Copy len chars
+  void Append(const PathList &rhs);
+  
+private:
+  std::vector<char> mTextVec;                       // Paths and zeros
+  std::vector<size_t> mOffsetVec;                   // Start of each path
+};
+
+// Append the paths of the regular files in a directory to pathList, like
+// ListDirectory but prefixed with dirname, and recursing into
+// subdirectories unless recursive is false. Symbolic links are not
+// followed. If pattern is not NULL, only the files whose names match the
+// glob are listed, with "*.ext" patterns matched by comparing suffixes.
+// Linux reads directories with getdents64 into large buffers. With
+// tasks > 1, the subdirectories of dirname are scanned concurrently, on
+// the calling thread and on the workers of taskMgr, and listed in the
+// same order as by a sequential scan. Returns false if dirname cannot be
+// read, skipping its subdirectories that cannot be.
+bool ScanDirectory(const char *dirname, const char *pattern, bool recursive,
+                   PathList &pathList, mt::TaskMgr *taskMgr = NULL,
+                   size_t tasks = 1);
+
+// Reports the files created, modified and deleted under a directory tree,
+// so that caches can be updated without rescanning it. Linux uses inotify,
+// watching each directory of the tree, including new ones. Elsewhere, or
+// if polling is requested, each Poll rescans the tree with ScanDirectory
+// and Stat, and compares it with the previous scan.
+// Changes are coalesced by path between calls to Poll: a file created and
+// modified is reported as created, one created and deleted is not
+// reported, and one deleted and created again is reported as modified.
+// Not thread safe.
+class DirWatch {
+public:
+  enum Change {
+    Created,
+    Modified,                                       // Content or metadata
+    Deleted,                                        // Also moved out
+    Overflow,                                       // Changes lost, rescan
+  };
+  
+  struct Event {
+    std::string path;                               // File, a directory
+    Change change;                                  //   moved out, or root
+  };
+  
+  DirWatch();
+  ~DirWatch();
+  
+  bool Init(const char *dirname, bool polling = false); // Start watching
+  bool IsPolling() const { return mFd < 0; }
+  
+  // Replace eventVec with the changes since the last call, sorted by path,
+  // waiting up to waitSec for the first one. False if not watching or if
+  // the events could not be read.
+  bool Poll(std::vector<Event> &eventVec, double waitSec = 0);
+  
+private:
+  DirWatch(const DirWatch &);                       // Disallow copy
+  void operator=(const DirWatch &);                 // Disallow assignment
+  
+  struct FileState {                                // Compared by polling
+    double modEpochSec;
+    size_t size;
+  };
+  typedef std::map<std::string, FileState> FileStateMap;
+  
+  void Add(const std::string &path, Change change); // Coalesce a change
+  bool AddWatchTree(const std::string &dirname, bool created);
+  bool ReadEvents(double waitSec);                  // From inotify
+  void Rescan();                                    // When polling
+  
+  std::string mRoot;                                // Watched tree
+  int mFd;                                          // inotify, or -1
+  std::map<int, std::string> mDirMap;               // Watched directories
+  std::map<std::string, Change> mChangeMap;         // Since last Poll
+  FileStateMap mFileStateMap;                       // Last scan if polling
+  bool mWatching;                                   // Init succeeded
+};
   
   
 };      // namespace Filename
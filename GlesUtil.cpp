@@ -2,6 +2,8 @@
 
 #include "GlesUtil.h"
 
+#include "Memory.h"
+
 #include <assert.h>
 #include <limits>
 #include <stdlib.h>
@@ -682,6 +684,14 @@ bool glt::StoreTexture(GLuint tex, GLenum target,
   if (Error())
     return false;
   
+  // Cube map faces are stored one at a time but must all be the same size
+  size_t bytes = TextureBytes(w, h, format, type);
+  if (needs_mip_chain)
+    bytes += bytes / 3;                               // Full chain ~= 4/3
+  if (bindTarget == GL_TEXTURE_CUBE_MAP)
+    bytes *= 6;
+  mem::Track(mem::GLTexture, tex, bytes);
+  
 #if DEBUG
   bool isPow2 = w == 1;
   for (size_t i = 1; i < 16; ++i) {
@@ -713,6 +723,36 @@ bool glt::StoreSubTexture(GLuint tex, GLenum target, GLint miplevel,
 }
 
 
+void glt::DeleteTexture(GLuint tex) {
+  if (!tex)
+    return;
+  mem::Untrack(mem::GLTexture, tex);
+  glDeleteTextures(1, &tex);
+}
+
+
+size_t glt::TextureBytes(GLsizei w, GLsizei h, GLenum format, GLenum type) {
+  if (w <= 0 || h <= 0)
+    return 0;
+  switch (type) {
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_5_5_5_1:
+    case GL_UNSIGNED_SHORT_5_6_5:
+      return size_t(w) * h * 2;
+  }
+  size_t channels = 4;
+  switch (format) {
+    case GL_ALPHA:
+    case GL_LUMINANCE:       channels = 1; break;
+    case GL_LUMINANCE_ALPHA: channels = 2; break;
+    case GL_RGB:             channels = 3; break;
+  }
+  const size_t channelBytes = type == GL_FLOAT ? 4 :
+                              type == GL_UNSIGNED_SHORT ? 2 : 1;
+  return size_t(w) * h * channels * channelBytes;
+}
+
+
 GLint glt::MaxTextureSize() {
   GLint texSize;
   glGetIntegerv(GL_MAX_TEXTURE_SIZE, &texSize);
@@ -1394,10 +1434,19 @@ GLuint glt::CreateBuffer(GLenum target, GLsizeiptr bytes, void *data,
   glBindBuffer(target, 0);
   if (Error())
     return 0;
+  mem::Track(mem::GLBuffer, buf, bytes);
   return buf;
 }
 
 
+void glt::DeleteBuffer(GLuint id) {
+  if (!id)
+    return;
+  mem::Untrack(mem::GLBuffer, id);
+  glDeleteBuffers(1, &id);
+}
+
+
 bool glt::StoreSubBuffer(GLuint id, GLenum target, GLintptr offset,
                          GLsizeiptr size, void *data) {
   glBindBuffer(target, id);
@@ -12,11 +12,17 @@
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
 #define glLabelObjectEXT(A,B,C,D)                     // Apple debugger info
+#elif defined(LINUX)
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#define glLabelObjectEXT(A,B,C,D)                     // Apple debugger info
 #elif defined(OSX)
 #include <OpenGL/gl.h>
 #include <OpenGL/glext.h>
 #endif
 
+#include <stddef.h>
+
 
 // Helpful routines for common OpenGLES 2 operations.
 // Objects created by these routines must be destroyed by the caller
@@ -236,6 +242,13 @@ bool StoreSubTexture(GLuint tex, GLenum target, GLint miplevel, GLint x,GLint y,
                      const void *pix);
 GLint MaxTextureSize();
 
+// Deletes a texture created with StoreTexture, releasing its memory
+// accounting (see Memory.h). Use instead of glDeleteTextures.
+void DeleteTexture(GLuint tex);
+
+// Bytes used by one w x h mip level of the given format and type
+size_t TextureBytes(GLsizei w, GLsizei h, GLenum format, GLenum type);
+
 
 // Shader functions:
 //   Type: GL_VERTEX_SHADER, GL_FRAGMENT_SHADER
@@ -277,6 +290,7 @@ GLuint CreateBuffer(GLenum target, GLsizeiptr bytes, void *data,
                     GLenum usage, const char *name=0);
 bool StoreSubBuffer(GLuint id, GLenum target, GLintptr offset,
                     GLsizeiptr size, void *data);
+void DeleteBuffer(GLuint id);                         // Instead of glDelete*
 
 
 // Tristrip builders:
@@ -1,22 +1,39 @@
 // Code adapted from http://code.google.com/p/vjson/
 // Distributed under the MIT license
 
+#include <errno.h>
+#include <locale.h>
 #include <memory.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include "Json.h"
+#include "MappedFile.h"
+#include "Memory.h"
+#include "TaskMgr.h"
+#include "Watchdog.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define JSON_SIMD_WIDTH 32
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define JSON_SIMD_WIDTH 16
+#endif
 
 // true if character represent a digit
 #define IS_DIGIT(c) (c >= '0' && c <= '9')
 
-// convert string to integer
-static char *atoi(char *first, char *last, int *out)
+// convert string to integer, returning NULL if it exceeds 64 bits
+static char *atoi(char *first, char *last, int64_t *out)
 {
-  int sign = 1;
+  bool negative = false;
   if (first != last)
   {
     if (*first == '-')
     {
-      sign = -1;
+      negative = true;
       ++first;
     }
     else if (*first == '+')
@@ -25,12 +42,24 @@ static char *atoi(char *first, char *last, int *out)
     }
   }
   
-  int result = 0;
+  const uint64_t max = ~(uint64_t)0;
+  uint64_t result = 0;
   for (; first != last && IS_DIGIT(*first); ++first)
   {
-    result = 10 * result + (*first - '0');
+    unsigned int digit = *first - '0';
+    if (result > (max - digit) / 10)
+    {
+      return 0;
+    }
+    result = 10 * result + digit;
+  }
+  
+  const uint64_t limit = (max >> 1) + negative;
+  if (result > limit)
+  {
+    return 0;
   }
-  *out = result * sign;
+  *out = negative ? (int64_t)(0 - result) : (int64_t)result;
   
   return first;
 }
@@ -65,16 +94,826 @@ static char *hatoui(char *first, char *last, unsigned int *out)
   return first;
 }
 
+// Decimal to double conversion, exact and independent of the locale.
+// Up to 19 significant digits the result is computed directly: with one
+// floating point operation when both the mantissa and the power of ten are
+// exact doubles (Clinger's fast path), otherwise from a 128-bit product
+// with a truncated power of five (Eisel-Lemire). The rare cases these
+// cannot round correctly fall back to strtod.
+
+// 10^0 .. 10^22 are exact doubles
+static const double json_exact_pow10[] =
+{
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13,
+  1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+#define JSON_POW5_MIN -342
+#define JSON_POW5_MAX 308
+
+// 5^q for q in [JSON_POW5_MIN, JSON_POW5_MAX] as 128-bit fractions with
+// the top bit set, high word first: truncated for q >= 0, rounded up for
+// q < 0. Same values as the table of the fast_float library.
+static const uint64_t json_pow5[JSON_POW5_MAX - JSON_POW5_MIN + 1][2] =
+{
+  {0xEEF453D6923BD65A, 0x113FAA2906A13B3F},
+  {0x9558B4661B6565F8, 0x4AC7CA59A424C507},
+  {0xBAAEE17FA23EBF76, 0x5D79BCF00D2DF649},
+  {0xE95A99DF8ACE6F53, 0xF4D82C2C107973DC},
+  {0x91D8A02BB6C10594, 0x79071B9B8A4BE869},
+  {0xB64EC836A47146F9, 0x9748E2826CDEE284},
+  {0xE3E27A444D8D98B7, 0xFD1B1B2308169B25},
+  {0x8E6D8C6AB0787F72, 0xFE30F0F5E50E20F7},
+  {0xB208EF855C969F4F, 0xBDBD2D335E51A935},
+  {0xDE8B2B66B3BC4723, 0xAD2C788035E61382},
+  {0x8B16FB203055AC76, 0x4C3BCB5021AFCC31},
+  {0xADDCB9E83C6B1793, 0xDF4ABE242A1BBF3D},
+  {0xD953E8624B85DD78, 0xD71D6DAD34A2AF0D},
+  {0x87D4713D6F33AA6B, 0x8672648C40E5AD68},
+  {0xA9C98D8CCB009506, 0x680EFDAF511F18C2},
+  {0xD43BF0EFFDC0BA48, 0x0212BD1B2566DEF2},
+  {0x84A57695FE98746D, 0x014BB630F7604B57},
+  {0xA5CED43B7E3E9188, 0x419EA3BD35385E2D},
+  {0xCF42894A5DCE35EA, 0x52064CAC828675B9},
+  {0x818995CE7AA0E1B2, 0x7343EFEBD1940993},
+  {0xA1EBFB4219491A1F, 0x1014EBE6C5F90BF8},
+  {0xCA66FA129F9B60A6, 0xD41A26E077774EF6},
+  {0xFD00B897478238D0, 0x8920B098955522B4},
+  {0x9E20735E8CB16382, 0x55B46E5F5D5535B0},
+  {0xC5A890362FDDBC62, 0xEB2189F734AA831D},
+  {0xF712B443BBD52B7B, 0xA5E9EC7501D523E4},
+  {0x9A6BB0AA55653B2D, 0x47B233C92125366E},
+  {0xC1069CD4EABE89F8, 0x999EC0BB696E840A},
+  {0xF148440A256E2C76, 0xC00670EA43CA250D},
+  {0x96CD2A865764DBCA, 0x380406926A5E5728},
+  {0xBC807527ED3E12BC, 0xC605083704F5ECF2},
+  {0xEBA09271E88D976B, 0xF7864A44C633682E},
+  {0x93445B8731587EA3, 0x7AB3EE6AFBE0211D},
+  {0xB8157268FDAE9E4C, 0x5960EA05BAD82964},
+  {0xE61ACF033D1A45DF, 0x6FB92487298E33BD},
+  {0x8FD0C16206306BAB, 0xA5D3B6D479F8E056},
+  {0xB3C4F1BA87BC8696, 0x8F48A4899877186C},
+  {0xE0B62E2929ABA83C, 0x331ACDABFE94DE87},
+  {0x8C71DCD9BA0B4925, 0x9FF0C08B7F1D0B14},
+  {0xAF8E5410288E1B6F, 0x07ECF0AE5EE44DD9},
+  {0xDB71E91432B1A24A, 0xC9E82CD9F69D6150},
+  {0x892731AC9FAF056E, 0xBE311C083A225CD2},
+  {0xAB70FE17C79AC6CA, 0x6DBD630A48AAF406},
+  {0xD64D3D9DB981787D, 0x092CBBCCDAD5B108},
+  {0x85F0468293F0EB4E, 0x25BBF56008C58EA5},
+  {0xA76C582338ED2621, 0xAF2AF2B80AF6F24E},
+  {0xD1476E2C07286FAA, 0x1AF5AF660DB4AEE1},
+  {0x82CCA4DB847945CA, 0x50D98D9FC890ED4D},
+  {0xA37FCE126597973C, 0xE50FF107BAB528A0},
+  {0xCC5FC196FEFD7D0C, 0x1E53ED49A96272C8},
+  {0xFF77B1FCBEBCDC4F, 0x25E8E89C13BB0F7A},
+  {0x9FAACF3DF73609B1, 0x77B191618C54E9AC},
+  {0xC795830D75038C1D, 0xD59DF5B9EF6A2417},
+  {0xF97AE3D0D2446F25, 0x4B0573286B44AD1D},
+  {0x9BECCE62836AC577, 0x4EE367F9430AEC32},
+  {0xC2E801FB244576D5, 0x229C41F793CDA73F},
+  {0xF3A20279ED56D48A, 0x6B43527578C1110F},
+  {0x9845418C345644D6, 0x830A13896B78AAA9},
+  {0xBE5691EF416BD60C, 0x23CC986BC656D553},
+  {0xEDEC366B11C6CB8F, 0x2CBFBE86B7EC8AA8},
+  {0x94B3A202EB1C3F39, 0x7BF7D71432F3D6A9},
+  {0xB9E08A83A5E34F07, 0xDAF5CCD93FB0CC53},
+  {0xE858AD248F5C22C9, 0xD1B3400F8F9CFF68},
+  {0x91376C36D99995BE, 0x23100809B9C21FA1},
+  {0xB58547448FFFFB2D, 0xABD40A0C2832A78A},
+  {0xE2E69915B3FFF9F9, 0x16C90C8F323F516C},
+  {0x8DD01FAD907FFC3B, 0xAE3DA7D97F6792E3},
+  {0xB1442798F49FFB4A, 0x99CD11CFDF41779C},
+  {0xDD95317F31C7FA1D, 0x40405643D711D583},
+  {0x8A7D3EEF7F1CFC52, 0x482835EA666B2572},
+  {0xAD1C8EAB5EE43B66, 0xDA3243650005EECF},
+  {0xD863B256369D4A40, 0x90BED43E40076A82},
+  {0x873E4F75E2224E68, 0x5A7744A6E804A291},
+  {0xA90DE3535AAAE202, 0x711515D0A205CB36},
+  {0xD3515C2831559A83, 0x0D5A5B44CA873E03},
+  {0x8412D9991ED58091, 0xE858790AFE9486C2},
+  {0xA5178FFF668AE0B6, 0x626E974DBE39A872},
+  {0xCE5D73FF402D98E3, 0xFB0A3D212DC8128F},
+  {0x80FA687F881C7F8E, 0x7CE66634BC9D0B99},
+  {0xA139029F6A239F72, 0x1C1FFFC1EBC44E80},
+  {0xC987434744AC874E, 0xA327FFB266B56220},
+  {0xFBE9141915D7A922, 0x4BF1FF9F0062BAA8},
+  {0x9D71AC8FADA6C9B5, 0x6F773FC3603DB4A9},
+  {0xC4CE17B399107C22, 0xCB550FB4384D21D3},
+  {0xF6019DA07F549B2B, 0x7E2A53A146606A48},
+  {0x99C102844F94E0FB, 0x2EDA7444CBFC426D},
+  {0xC0314325637A1939, 0xFA911155FEFB5308},
+  {0xF03D93EEBC589F88, 0x793555AB7EBA27CA},
+  {0x96267C7535B763B5, 0x4BC1558B2F3458DE},
+  {0xBBB01B9283253CA2, 0x9EB1AAEDFB016F16},
+  {0xEA9C227723EE8BCB, 0x465E15A979C1CADC},
+  {0x92A1958A7675175F, 0x0BFACD89EC191EC9},
+  {0xB749FAED14125D36, 0xCEF980EC671F667B},
+  {0xE51C79A85916F484, 0x82B7E12780E7401A},
+  {0x8F31CC0937AE58D2, 0xD1B2ECB8B0908810},
+  {0xB2FE3F0B8599EF07, 0x861FA7E6DCB4AA15},
+  {0xDFBDCECE67006AC9, 0x67A791E093E1D49A},
+  {0x8BD6A141006042BD, 0xE0C8BB2C5C6D24E0},
+  {0xAECC49914078536D, 0x58FAE9F773886E18},
+  {0xDA7F5BF590966848, 0xAF39A475506A899E},
+  {0x888F99797A5E012D, 0x6D8406C952429603},
+  {0xAAB37FD7D8F58178, 0xC8E5087BA6D33B83},
+  {0xD5605FCDCF32E1D6, 0xFB1E4A9A90880A64},
+  {0x855C3BE0A17FCD26, 0x5CF2EEA09A55067F},
+  {0xA6B34AD8C9DFC06F, 0xF42FAA48C0EA481E},
+  {0xD0601D8EFC57B08B, 0xF13B94DAF124DA26},
+  {0x823C12795DB6CE57, 0x76C53D08D6B70858},
+  {0xA2CB1717B52481ED, 0x54768C4B0C64CA6E},
+  {0xCB7DDCDDA26DA268, 0xA9942F5DCF7DFD09},
+  {0xFE5D54150B090B02, 0xD3F93B35435D7C4C},
+  {0x9EFA548D26E5A6E1, 0xC47BC5014A1A6DAF},
+  {0xC6B8E9B0709F109A, 0x359AB6419CA1091B},
+  {0xF867241C8CC6D4C0, 0xC30163D203C94B62},
+  {0x9B407691D7FC44F8, 0x79E0DE63425DCF1D},
+  {0xC21094364DFB5636, 0x985915FC12F542E4},
+  {0xF294B943E17A2BC4, 0x3E6F5B7B17B2939D},
+  {0x979CF3CA6CEC5B5A, 0xA705992CEECF9C42},
+  {0xBD8430BD08277231, 0x50C6FF782A838353},
+  {0xECE53CEC4A314EBD, 0xA4F8BF5635246428},
+  {0x940F4613AE5ED136, 0x871B7795E136BE99},
+  {0xB913179899F68584, 0x28E2557B59846E3F},
+  {0xE757DD7EC07426E5, 0x331AEADA2FE589CF},
+  {0x9096EA6F3848984F, 0x3FF0D2C85DEF7621},
+  {0xB4BCA50B065ABE63, 0x0FED077A756B53A9},
+  {0xE1EBCE4DC7F16DFB, 0xD3E8495912C62894},
+  {0x8D3360F09CF6E4BD, 0x64712DD7ABBBD95C},
+  {0xB080392CC4349DEC, 0xBD8D794D96AACFB3},
+  {0xDCA04777F541C567, 0xECF0D7A0FC5583A0},
+  {0x89E42CAAF9491B60, 0xF41686C49DB57244},
+  {0xAC5D37D5B79B6239, 0x311C2875C522CED5},
+  {0xD77485CB25823AC7, 0x7D633293366B828B},
+  {0x86A8D39EF77164BC, 0xAE5DFF9C02033197},
+  {0xA8530886B54DBDEB, 0xD9F57F830283FDFC},
+  {0xD267CAA862A12D66, 0xD072DF63C324FD7B},
+  {0x8380DEA93DA4BC60, 0x4247CB9E59F71E6D},
+  {0xA46116538D0DEB78, 0x52D9BE85F074E608},
+  {0xCD795BE870516656, 0x67902E276C921F8B},
+  {0x806BD9714632DFF6, 0x00BA1CD8A3DB53B6},
+  {0xA086CFCD97BF97F3, 0x80E8A40ECCD228A4},
+  {0xC8A883C0FDAF7DF0, 0x6122CD128006B2CD},
+  {0xFAD2A4B13D1B5D6C, 0x796B805720085F81},
+  {0x9CC3A6EEC6311A63, 0xCBE3303674053BB0},
+  {0xC3F490AA77BD60FC, 0xBEDBFC4411068A9C},
+  {0xF4F1B4D515ACB93B, 0xEE92FB5515482D44},
+  {0x991711052D8BF3C5, 0x751BDD152D4D1C4A},
+  {0xBF5CD54678EEF0B6, 0xD262D45A78A0635D},
+  {0xEF340A98172AACE4, 0x86FB897116C87C34},
+  {0x9580869F0E7AAC0E, 0xD45D35E6AE3D4DA0},
+  {0xBAE0A846D2195712, 0x8974836059CCA109},
+  {0xE998D258869FACD7, 0x2BD1A438703FC94B},
+  {0x91FF83775423CC06, 0x7B6306A34627DDCF},
+  {0xB67F6455292CBF08, 0x1A3BC84C17B1D542},
+  {0xE41F3D6A7377EECA, 0x20CABA5F1D9E4A93},
+  {0x8E938662882AF53E, 0x547EB47B7282EE9C},
+  {0xB23867FB2A35B28D, 0xE99E619A4F23AA43},
+  {0xDEC681F9F4C31F31, 0x6405FA00E2EC94D4},
+  {0x8B3C113C38F9F37E, 0xDE83BC408DD3DD04},
+  {0xAE0B158B4738705E, 0x9624AB50B148D445},
+  {0xD98DDAEE19068C76, 0x3BADD624DD9B0957},
+  {0x87F8A8D4CFA417C9, 0xE54CA5D70A80E5D6},
+  {0xA9F6D30A038D1DBC, 0x5E9FCF4CCD211F4C},
+  {0xD47487CC8470652B, 0x7647C3200069671F},
+  {0x84C8D4DFD2C63F3B, 0x29ECD9F40041E073},
+  {0xA5FB0A17C777CF09, 0xF468107100525890},
+  {0xCF79CC9DB955C2CC, 0x7182148D4066EEB4},
+  {0x81AC1FE293D599BF, 0xC6F14CD848405530},
+  {0xA21727DB38CB002F, 0xB8ADA00E5A506A7C},
+  {0xCA9CF1D206FDC03B, 0xA6D90811F0E4851C},
+  {0xFD442E4688BD304A, 0x908F4A166D1DA663},
+  {0x9E4A9CEC15763E2E, 0x9A598E4E043287FE},
+  {0xC5DD44271AD3CDBA, 0x40EFF1E1853F29FD},
+  {0xF7549530E188C128, 0xD12BEE59E68EF47C},
+  {0x9A94DD3E8CF578B9, 0x82BB74F8301958CE},
+  {0xC13A148E3032D6E7, 0xE36A52363C1FAF01},
+  {0xF18899B1BC3F8CA1, 0xDC44E6C3CB279AC1},
+  {0x96F5600F15A7B7E5, 0x29AB103A5EF8C0B9},
+  {0xBCB2B812DB11A5DE, 0x7415D448F6B6F0E7},
+  {0xEBDF661791D60F56, 0x111B495B3464AD21},
+  {0x936B9FCEBB25C995, 0xCAB10DD900BEEC34},
+  {0xB84687C269EF3BFB, 0x3D5D514F40EEA742},
+  {0xE65829B3046B0AFA, 0x0CB4A5A3112A5112},
+  {0x8FF71A0FE2C2E6DC, 0x47F0E785EABA72AB},
+  {0xB3F4E093DB73A093, 0x59ED216765690F56},
+  {0xE0F218B8D25088B8, 0x306869C13EC3532C},
+  {0x8C974F7383725573, 0x1E414218C73A13FB},
+  {0xAFBD2350644EEACF, 0xE5D1929EF90898FA},
+  {0xDBAC6C247D62A583, 0xDF45F746B74ABF39},
+  {0x894BC396CE5DA772, 0x6B8BBA8C328EB783},
+  {0xAB9EB47C81F5114F, 0x066EA92F3F326564},
+  {0xD686619BA27255A2, 0xC80A537B0EFEFEBD},
+  {0x8613FD0145877585, 0xBD06742CE95F5F36},
+  {0xA798FC4196E952E7, 0x2C48113823B73704},
+  {0xD17F3B51FCA3A7A0, 0xF75A15862CA504C5},
+  {0x82EF85133DE648C4, 0x9A984D73DBE722FB},
+  {0xA3AB66580D5FDAF5, 0xC13E60D0D2E0EBBA},
+  {0xCC963FEE10B7D1B3, 0x318DF905079926A8},
+  {0xFFBBCFE994E5C61F, 0xFDF17746497F7052},
+  {0x9FD561F1FD0F9BD3, 0xFEB6EA8BEDEFA633},
+  {0xC7CABA6E7C5382C8, 0xFE64A52EE96B8FC0},
+  {0xF9BD690A1B68637B, 0x3DFDCE7AA3C673B0},
+  {0x9C1661A651213E2D, 0x06BEA10CA65C084E},
+  {0xC31BFA0FE5698DB8, 0x486E494FCFF30A62},
+  {0xF3E2F893DEC3F126, 0x5A89DBA3C3EFCCFA},
+  {0x986DDB5C6B3A76B7, 0xF89629465A75E01C},
+  {0xBE89523386091465, 0xF6BBB397F1135823},
+  {0xEE2BA6C0678B597F, 0x746AA07DED582E2C},
+  {0x94DB483840B717EF, 0xA8C2A44EB4571CDC},
+  {0xBA121A4650E4DDEB, 0x92F34D62616CE413},
+  {0xE896A0D7E51E1566, 0x77B020BAF9C81D17},
+  {0x915E2486EF32CD60, 0x0ACE1474DC1D122E},
+  {0xB5B5ADA8AAFF80B8, 0x0D819992132456BA},
+  {0xE3231912D5BF60E6, 0x10E1FFF697ED6C69},
+  {0x8DF5EFABC5979C8F, 0xCA8D3FFA1EF463C1},
+  {0xB1736B96B6FD83B3, 0xBD308FF8A6B17CB2},
+  {0xDDD0467C64BCE4A0, 0xAC7CB3F6D05DDBDE},
+  {0x8AA22C0DBEF60EE4, 0x6BCDF07A423AA96B},
+  {0xAD4AB7112EB3929D, 0x86C16C98D2C953C6},
+  {0xD89D64D57A607744, 0xE871C7BF077BA8B7},
+  {0x87625F056C7C4A8B, 0x11471CD764AD4972},
+  {0xA93AF6C6C79B5D2D, 0xD598E40D3DD89BCF},
+  {0xD389B47879823479, 0x4AFF1D108D4EC2C3},
+  {0x843610CB4BF160CB, 0xCEDF722A585139BA},
+  {0xA54394FE1EEDB8FE, 0xC2974EB4EE658828},
+  {0xCE947A3DA6A9273E, 0x733D226229FEEA32},
+  {0x811CCC668829B887, 0x0806357D5A3F525F},
+  {0xA163FF802A3426A8, 0xCA07C2DCB0CF26F7},
+  {0xC9BCFF6034C13052, 0xFC89B393DD02F0B5},
+  {0xFC2C3F3841F17C67, 0xBBAC2078D443ACE2},
+  {0x9D9BA7832936EDC0, 0xD54B944B84AA4C0D},
+  {0xC5029163F384A931, 0x0A9E795E65D4DF11},
+  {0xF64335BCF065D37D, 0x4D4617B5FF4A16D5},
+  {0x99EA0196163FA42E, 0x504BCED1BF8E4E45},
+  {0xC06481FB9BCF8D39, 0xE45EC2862F71E1D6},
+  {0xF07DA27A82C37088, 0x5D767327BB4E5A4C},
+  {0x964E858C91BA2655, 0x3A6A07F8D510F86F},
+  {0xBBE226EFB628AFEA, 0x890489F70A55368B},
+  {0xEADAB0ABA3B2DBE5, 0x2B45AC74CCEA842E},
+  {0x92C8AE6B464FC96F, 0x3B0B8BC90012929D},
+  {0xB77ADA0617E3BBCB, 0x09CE6EBB40173744},
+  {0xE55990879DDCAABD, 0xCC420A6A101D0515},
+  {0x8F57FA54C2A9EAB6, 0x9FA946824A12232D},
+  {0xB32DF8E9F3546564, 0x47939822DC96ABF9},
+  {0xDFF9772470297EBD, 0x59787E2B93BC56F7},
+  {0x8BFBEA76C619EF36, 0x57EB4EDB3C55B65A},
+  {0xAEFAE51477A06B03, 0xEDE622920B6B23F1},
+  {0xDAB99E59958885C4, 0xE95FAB368E45ECED},
+  {0x88B402F7FD75539B, 0x11DBCB0218EBB414},
+  {0xAAE103B5FCD2A881, 0xD652BDC29F26A119},
+  {0xD59944A37C0752A2, 0x4BE76D3346F0495F},
+  {0x857FCAE62D8493A5, 0x6F70A4400C562DDB},
+  {0xA6DFBD9FB8E5B88E, 0xCB4CCD500F6BB952},
+  {0xD097AD07A71F26B2, 0x7E2000A41346A7A7},
+  {0x825ECC24C873782F, 0x8ED400668C0C28C8},
+  {0xA2F67F2DFA90563B, 0x728900802F0F32FA},
+  {0xCBB41EF979346BCA, 0x4F2B40A03AD2FFB9},
+  {0xFEA126B7D78186BC, 0xE2F610C84987BFA8},
+  {0x9F24B832E6B0F436, 0x0DD9CA7D2DF4D7C9},
+  {0xC6EDE63FA05D3143, 0x91503D1C79720DBB},
+  {0xF8A95FCF88747D94, 0x75A44C6397CE912A},
+  {0x9B69DBE1B548CE7C, 0xC986AFBE3EE11ABA},
+  {0xC24452DA229B021B, 0xFBE85BADCE996168},
+  {0xF2D56790AB41C2A2, 0xFAE27299423FB9C3},
+  {0x97C560BA6B0919A5, 0xDCCD879FC967D41A},
+  {0xBDB6B8E905CB600F, 0x5400E987BBC1C920},
+  {0xED246723473E3813, 0x290123E9AAB23B68},
+  {0x9436C0760C86E30B, 0xF9A0B6720AAF6521},
+  {0xB94470938FA89BCE, 0xF808E40E8D5B3E69},
+  {0xE7958CB87392C2C2, 0xB60B1D1230B20E04},
+  {0x90BD77F3483BB9B9, 0xB1C6F22B5E6F48C2},
+  {0xB4ECD5F01A4AA828, 0x1E38AEB6360B1AF3},
+  {0xE2280B6C20DD5232, 0x25C6DA63C38DE1B0},
+  {0x8D590723948A535F, 0x579C487E5A38AD0E},
+  {0xB0AF48EC79ACE837, 0x2D835A9DF0C6D851},
+  {0xDCDB1B2798182244, 0xF8E431456CF88E65},
+  {0x8A08F0F8BF0F156B, 0x1B8E9ECB641B58FF},
+  {0xAC8B2D36EED2DAC5, 0xE272467E3D222F3F},
+  {0xD7ADF884AA879177, 0x5B0ED81DCC6ABB0F},
+  {0x86CCBB52EA94BAEA, 0x98E947129FC2B4E9},
+  {0xA87FEA27A539E9A5, 0x3F2398D747B36224},
+  {0xD29FE4B18E88640E, 0x8EEC7F0D19A03AAD},
+  {0x83A3EEEEF9153E89, 0x1953CF68300424AC},
+  {0xA48CEAAAB75A8E2B, 0x5FA8C3423C052DD7},
+  {0xCDB02555653131B6, 0x3792F412CB06794D},
+  {0x808E17555F3EBF11, 0xE2BBD88BBEE40BD0},
+  {0xA0B19D2AB70E6ED6, 0x5B6ACEAEAE9D0EC4},
+  {0xC8DE047564D20A8B, 0xF245825A5A445275},
+  {0xFB158592BE068D2E, 0xEED6E2F0F0D56712},
+  {0x9CED737BB6C4183D, 0x55464DD69685606B},
+  {0xC428D05AA4751E4C, 0xAA97E14C3C26B886},
+  {0xF53304714D9265DF, 0xD53DD99F4B3066A8},
+  {0x993FE2C6D07B7FAB, 0xE546A8038EFE4029},
+  {0xBF8FDB78849A5F96, 0xDE98520472BDD033},
+  {0xEF73D256A5C0F77C, 0x963E66858F6D4440},
+  {0x95A8637627989AAD, 0xDDE7001379A44AA8},
+  {0xBB127C53B17EC159, 0x5560C018580D5D52},
+  {0xE9D71B689DDE71AF, 0xAAB8F01E6E10B4A6},
+  {0x9226712162AB070D, 0xCAB3961304CA70E8},
+  {0xB6B00D69BB55C8D1, 0x3D607B97C5FD0D22},
+  {0xE45C10C42A2B3B05, 0x8CB89A7DB77C506A},
+  {0x8EB98A7A9A5B04E3, 0x77F3608E92ADB242},
+  {0xB267ED1940F1C61C, 0x55F038B237591ED3},
+  {0xDF01E85F912E37A3, 0x6B6C46DEC52F6688},
+  {0x8B61313BBABCE2C6, 0x2323AC4B3B3DA015},
+  {0xAE397D8AA96C1B77, 0xABEC975E0A0D081A},
+  {0xD9C7DCED53C72255, 0x96E7BD358C904A21},
+  {0x881CEA14545C7575, 0x7E50D64177DA2E54},
+  {0xAA242499697392D2, 0xDDE50BD1D5D0B9E9},
+  {0xD4AD2DBFC3D07787, 0x955E4EC64B44E864},
+  {0x84EC3C97DA624AB4, 0xBD5AF13BEF0B113E},
+  {0xA6274BBDD0FADD61, 0xECB1AD8AEACDD58E},
+  {0xCFB11EAD453994BA, 0x67DE18EDA5814AF2},
+  {0x81CEB32C4B43FCF4, 0x80EACF948770CED7},
+  {0xA2425FF75E14FC31, 0xA1258379A94D028D},
+  {0xCAD2F7F5359A3B3E, 0x096EE45813A04330},
+  {0xFD87B5F28300CA0D, 0x8BCA9D6E188853FC},
+  {0x9E74D1B791E07E48, 0x775EA264CF55347E},
+  {0xC612062576589DDA, 0x95364AFE032A819E},
+  {0xF79687AED3EEC551, 0x3A83DDBD83F52205},
+  {0x9ABE14CD44753B52, 0xC4926A9672793543},
+  {0xC16D9A0095928A27, 0x75B7053C0F178294},
+  {0xF1C90080BAF72CB1, 0x5324C68B12DD6339},
+  {0x971DA05074DA7BEE, 0xD3F6FC16EBCA5E04},
+  {0xBCE5086492111AEA, 0x88F4BB1CA6BCF585},
+  {0xEC1E4A7DB69561A5, 0x2B31E9E3D06C32E6},
+  {0x9392EE8E921D5D07, 0x3AFF322E62439FD0},
+  {0xB877AA3236A4B449, 0x09BEFEB9FAD487C3},
+  {0xE69594BEC44DE15B, 0x4C2EBE687989A9B4},
+  {0x901D7CF73AB0ACD9, 0x0F9D37014BF60A11},
+  {0xB424DC35095CD80F, 0x538484C19EF38C95},
+  {0xE12E13424BB40E13, 0x2865A5F206B06FBA},
+  {0x8CBCCC096F5088CB, 0xF93F87B7442E45D4},
+  {0xAFEBFF0BCB24AAFE, 0xF78F69A51539D749},
+  {0xDBE6FECEBDEDD5BE, 0xB573440E5A884D1C},
+  {0x89705F4136B4A597, 0x31680A88F8953031},
+  {0xABCC77118461CEFC, 0xFDC20D2B36BA7C3E},
+  {0xD6BF94D5E57A42BC, 0x3D32907604691B4D},
+  {0x8637BD05AF6C69B5, 0xA63F9A49C2C1B110},
+  {0xA7C5AC471B478423, 0x0FCF80DC33721D54},
+  {0xD1B71758E219652B, 0xD3C36113404EA4A9},
+  {0x83126E978D4FDF3B, 0x645A1CAC083126EA},
+  {0xA3D70A3D70A3D70A, 0x3D70A3D70A3D70A4},
+  {0xCCCCCCCCCCCCCCCC, 0xCCCCCCCCCCCCCCCD},
+  {0x8000000000000000, 0x0000000000000000},
+  {0xA000000000000000, 0x0000000000000000},
+  {0xC800000000000000, 0x0000000000000000},
+  {0xFA00000000000000, 0x0000000000000000},
+  {0x9C40000000000000, 0x0000000000000000},
+  {0xC350000000000000, 0x0000000000000000},
+  {0xF424000000000000, 0x0000000000000000},
+  {0x9896800000000000, 0x0000000000000000},
+  {0xBEBC200000000000, 0x0000000000000000},
+  {0xEE6B280000000000, 0x0000000000000000},
+  {0x9502F90000000000, 0x0000000000000000},
+  {0xBA43B74000000000, 0x0000000000000000},
+  {0xE8D4A51000000000, 0x0000000000000000},
+  {0x9184E72A00000000, 0x0000000000000000},
+  {0xB5E620F480000000, 0x0000000000000000},
+  {0xE35FA931A0000000, 0x0000000000000000},
+  {0x8E1BC9BF04000000, 0x0000000000000000},
+  {0xB1A2BC2EC5000000, 0x0000000000000000},
+  {0xDE0B6B3A76400000, 0x0000000000000000},
+  {0x8AC7230489E80000, 0x0000000000000000},
+  {0xAD78EBC5AC620000, 0x0000000000000000},
+  {0xD8D726B7177A8000, 0x0000000000000000},
+  {0x878678326EAC9000, 0x0000000000000000},
+  {0xA968163F0A57B400, 0x0000000000000000},
+  {0xD3C21BCECCEDA100, 0x0000000000000000},
+  {0x84595161401484A0, 0x0000000000000000},
+  {0xA56FA5B99019A5C8, 0x0000000000000000},
+  {0xCECB8F27F4200F3A, 0x0000000000000000},
+  {0x813F3978F8940984, 0x4000000000000000},
+  {0xA18F07D736B90BE5, 0x5000000000000000},
+  {0xC9F2C9CD04674EDE, 0xA400000000000000},
+  {0xFC6F7C4045812296, 0x4D00000000000000},
+  {0x9DC5ADA82B70B59D, 0xF020000000000000},
+  {0xC5371912364CE305, 0x6C28000000000000},
+  {0xF684DF56C3E01BC6, 0xC732000000000000},
+  {0x9A130B963A6C115C, 0x3C7F400000000000},
+  {0xC097CE7BC90715B3, 0x4B9F100000000000},
+  {0xF0BDC21ABB48DB20, 0x1E86D40000000000},
+  {0x96769950B50D88F4, 0x1314448000000000},
+  {0xBC143FA4E250EB31, 0x17D955A000000000},
+  {0xEB194F8E1AE525FD, 0x5DCFAB0800000000},
+  {0x92EFD1B8D0CF37BE, 0x5AA1CAE500000000},
+  {0xB7ABC627050305AD, 0xF14A3D9E40000000},
+  {0xE596B7B0C643C719, 0x6D9CCD05D0000000},
+  {0x8F7E32CE7BEA5C6F, 0xE4820023A2000000},
+  {0xB35DBF821AE4F38B, 0xDDA2802C8A800000},
+  {0xE0352F62A19E306E, 0xD50B2037AD200000},
+  {0x8C213D9DA502DE45, 0x4526F422CC340000},
+  {0xAF298D050E4395D6, 0x9670B12B7F410000},
+  {0xDAF3F04651D47B4C, 0x3C0CDD765F114000},
+  {0x88D8762BF324CD0F, 0xA5880A69FB6AC800},
+  {0xAB0E93B6EFEE0053, 0x8EEA0D047A457A00},
+  {0xD5D238A4ABE98068, 0x72A4904598D6D880},
+  {0x85A36366EB71F041, 0x47A6DA2B7F864750},
+  {0xA70C3C40A64E6C51, 0x999090B65F67D924},
+  {0xD0CF4B50CFE20765, 0xFFF4B4E3F741CF6D},
+  {0x82818F1281ED449F, 0xBFF8F10E7A8921A4},
+  {0xA321F2D7226895C7, 0xAFF72D52192B6A0D},
+  {0xCBEA6F8CEB02BB39, 0x9BF4F8A69F764490},
+  {0xFEE50B7025C36A08, 0x02F236D04753D5B4},
+  {0x9F4F2726179A2245, 0x01D762422C946590},
+  {0xC722F0EF9D80AAD6, 0x424D3AD2B7B97EF5},
+  {0xF8EBAD2B84E0D58B, 0xD2E0898765A7DEB2},
+  {0x9B934C3B330C8577, 0x63CC55F49F88EB2F},
+  {0xC2781F49FFCFA6D5, 0x3CBF6B71C76B25FB},
+  {0xF316271C7FC3908A, 0x8BEF464E3945EF7A},
+  {0x97EDD871CFDA3A56, 0x97758BF0E3CBB5AC},
+  {0xBDE94E8E43D0C8EC, 0x3D52EEED1CBEA317},
+  {0xED63A231D4C4FB27, 0x4CA7AAA863EE4BDD},
+  {0x945E455F24FB1CF8, 0x8FE8CAA93E74EF6A},
+  {0xB975D6B6EE39E436, 0xB3E2FD538E122B44},
+  {0xE7D34C64A9C85D44, 0x60DBBCA87196B616},
+  {0x90E40FBEEA1D3A4A, 0xBC8955E946FE31CD},
+  {0xB51D13AEA4A488DD, 0x6BABAB6398BDBE41},
+  {0xE264589A4DCDAB14, 0xC696963C7EED2DD1},
+  {0x8D7EB76070A08AEC, 0xFC1E1DE5CF543CA2},
+  {0xB0DE65388CC8ADA8, 0x3B25A55F43294BCB},
+  {0xDD15FE86AFFAD912, 0x49EF0EB713F39EBE},
+  {0x8A2DBF142DFCC7AB, 0x6E3569326C784337},
+  {0xACB92ED9397BF996, 0x49C2C37F07965404},
+  {0xD7E77A8F87DAF7FB, 0xDC33745EC97BE906},
+  {0x86F0AC99B4E8DAFD, 0x69A028BB3DED71A3},
+  {0xA8ACD7C0222311BC, 0xC40832EA0D68CE0C},
+  {0xD2D80DB02AABD62B, 0xF50A3FA490C30190},
+  {0x83C7088E1AAB65DB, 0x792667C6DA79E0FA},
+  {0xA4B8CAB1A1563F52, 0x577001B891185938},
+  {0xCDE6FD5E09ABCF26, 0xED4C0226B55E6F86},
+  {0x80B05E5AC60B6178, 0x544F8158315B05B4},
+  {0xA0DC75F1778E39D6, 0x696361AE3DB1C721},
+  {0xC913936DD571C84C, 0x03BC3A19CD1E38E9},
+  {0xFB5878494ACE3A5F, 0x04AB48A04065C723},
+  {0x9D174B2DCEC0E47B, 0x62EB0D64283F9C76},
+  {0xC45D1DF942711D9A, 0x3BA5D0BD324F8394},
+  {0xF5746577930D6500, 0xCA8F44EC7EE36479},
+  {0x9968BF6ABBE85F20, 0x7E998B13CF4E1ECB},
+  {0xBFC2EF456AE276E8, 0x9E3FEDD8C321A67E},
+  {0xEFB3AB16C59B14A2, 0xC5CFE94EF3EA101E},
+  {0x95D04AEE3B80ECE5, 0xBBA1F1D158724A12},
+  {0xBB445DA9CA61281F, 0x2A8A6E45AE8EDC97},
+  {0xEA1575143CF97226, 0xF52D09D71A3293BD},
+  {0x924D692CA61BE758, 0x593C2626705F9C56},
+  {0xB6E0C377CFA2E12E, 0x6F8B2FB00C77836C},
+  {0xE498F455C38B997A, 0x0B6DFB9C0F956447},
+  {0x8EDF98B59A373FEC, 0x4724BD4189BD5EAC},
+  {0xB2977EE300C50FE7, 0x58EDEC91EC2CB657},
+  {0xDF3D5E9BC0F653E1, 0x2F2967B66737E3ED},
+  {0x8B865B215899F46C, 0xBD79E0D20082EE74},
+  {0xAE67F1E9AEC07187, 0xECD8590680A3AA11},
+  {0xDA01EE641A708DE9, 0xE80E6F4820CC9495},
+  {0x884134FE908658B2, 0x3109058D147FDCDD},
+  {0xAA51823E34A7EEDE, 0xBD4B46F0599FD415},
+  {0xD4E5E2CDC1D1EA96, 0x6C9E18AC7007C91A},
+  {0x850FADC09923329E, 0x03E2CF6BC604DDB0},
+  {0xA6539930BF6BFF45, 0x84DB8346B786151C},
+  {0xCFE87F7CEF46FF16, 0xE612641865679A63},
+  {0x81F14FAE158C5F6E, 0x4FCB7E8F3F60C07E},
+  {0xA26DA3999AEF7749, 0xE3BE5E330F38F09D},
+  {0xCB090C8001AB551C, 0x5CADF5BFD3072CC5},
+  {0xFDCB4FA002162A63, 0x73D9732FC7C8F7F6},
+  {0x9E9F11C4014DDA7E, 0x2867E7FDDCDD9AFA},
+  {0xC646D63501A1511D, 0xB281E1FD541501B8},
+  {0xF7D88BC24209A565, 0x1F225A7CA91A4226},
+  {0x9AE757596946075F, 0x3375788DE9B06958},
+  {0xC1A12D2FC3978937, 0x0052D6B1641C83AE},
+  {0xF209787BB47D6B84, 0xC0678C5DBD23A49A},
+  {0x9745EB4D50CE6332, 0xF840B7BA963646E0},
+  {0xBD176620A501FBFF, 0xB650E5A93BC3D898},
+  {0xEC5D3FA8CE427AFF, 0xA3E51F138AB4CEBE},
+  {0x93BA47C980E98CDF, 0xC66F336C36B10137},
+  {0xB8A8D9BBE123F017, 0xB80B0047445D4184},
+  {0xE6D3102AD96CEC1D, 0xA60DC059157491E5},
+  {0x9043EA1AC7E41392, 0x87C89837AD68DB2F},
+  {0xB454E4A179DD1877, 0x29BABE4598C311FB},
+  {0xE16A1DC9D8545E94, 0xF4296DD6FEF3D67A},
+  {0x8CE2529E2734BB1D, 0x1899E4A65F58660C},
+  {0xB01AE745B101E9E4, 0x5EC05DCFF72E7F8F},
+  {0xDC21A1171D42645D, 0x76707543F4FA1F73},
+  {0x899504AE72497EBA, 0x6A06494A791C53A8},
+  {0xABFA45DA0EDBDE69, 0x0487DB9D17636892},
+  {0xD6F8D7509292D603, 0x45A9D2845D3C42B6},
+  {0x865B86925B9BC5C2, 0x0B8A2392BA45A9B2},
+  {0xA7F26836F282B732, 0x8E6CAC7768D7141E},
+  {0xD1EF0244AF2364FF, 0x3207D795430CD926},
+  {0x8335616AED761F1F, 0x7F44E6BD49E807B8},
+  {0xA402B9C5A8D3A6E7, 0x5F16206C9C6209A6},
+  {0xCD036837130890A1, 0x36DBA887C37A8C0F},
+  {0x802221226BE55A64, 0xC2494954DA2C9789},
+  {0xA02AA96B06DEB0FD, 0xF2DB9BAA10B7BD6C},
+  {0xC83553C5C8965D3D, 0x6F92829494E5ACC7},
+  {0xFA42A8B73ABBF48C, 0xCB772339BA1F17F9},
+  {0x9C69A97284B578D7, 0xFF2A760414536EFB},
+  {0xC38413CF25E2D70D, 0xFEF5138519684ABA},
+  {0xF46518C2EF5B8CD1, 0x7EB258665FC25D69},
+  {0x98BF2F79D5993802, 0xEF2F773FFBD97A61},
+  {0xBEEEFB584AFF8603, 0xAAFB550FFACFD8FA},
+  {0xEEAABA2E5DBF6784, 0x95BA2A53F983CF38},
+  {0x952AB45CFA97A0B2, 0xDD945A747BF26183},
+  {0xBA756174393D88DF, 0x94F971119AEEF9E4},
+  {0xE912B9D1478CEB17, 0x7A37CD5601AAB85D},
+  {0x91ABB422CCB812EE, 0xAC62E055C10AB33A},
+  {0xB616A12B7FE617AA, 0x577B986B314D6009},
+  {0xE39C49765FDF9D94, 0xED5A7E85FDA0B80B},
+  {0x8E41ADE9FBEBC27D, 0x14588F13BE847307},
+  {0xB1D219647AE6B31C, 0x596EB2D8AE258FC8},
+  {0xDE469FBD99A05FE3, 0x6FCA5F8ED9AEF3BB},
+  {0x8AEC23D680043BEE, 0x25DE7BB9480D5854},
+  {0xADA72CCC20054AE9, 0xAF561AA79A10AE6A},
+  {0xD910F7FF28069DA4, 0x1B2BA1518094DA04},
+  {0x87AA9AFF79042286, 0x90FB44D2F05D0842},
+  {0xA99541BF57452B28, 0x353A1607AC744A53},
+  {0xD3FA922F2D1675F2, 0x42889B8997915CE8},
+  {0x847C9B5D7C2E09B7, 0x69956135FEBADA11},
+  {0xA59BC234DB398C25, 0x43FAB9837E699095},
+  {0xCF02B2C21207EF2E, 0x94F967E45E03F4BB},
+  {0x8161AFB94B44F57D, 0x1D1BE0EEBAC278F5},
+  {0xA1BA1BA79E1632DC, 0x6462D92A69731732},
+  {0xCA28A291859BBF93, 0x7D7B8F7503CFDCFE},
+  {0xFCB2CB35E702AF78, 0x5CDA735244C3D43E},
+  {0x9DEFBF01B061ADAB, 0x3A0888136AFA64A7},
+  {0xC56BAEC21C7A1916, 0x088AAA1845B8FDD0},
+  {0xF6C69A72A3989F5B, 0x8AAD549E57273D45},
+  {0x9A3C2087A63F6399, 0x36AC54E2F678864B},
+  {0xC0CB28A98FCF3C7F, 0x84576A1BB416A7DD},
+  {0xF0FDF2D3F3C30B9F, 0x656D44A2A11C51D5},
+  {0x969EB7C47859E743, 0x9F644AE5A4B1B325},
+  {0xBC4665B596706114, 0x873D5D9F0DDE1FEE},
+  {0xEB57FF22FC0C7959, 0xA90CB506D155A7EA},
+  {0x9316FF75DD87CBD8, 0x09A7F12442D588F2},
+  {0xB7DCBF5354E9BECE, 0x0C11ED6D538AEB2F},
+  {0xE5D3EF282A242E81, 0x8F1668C8A86DA5FA},
+  {0x8FA475791A569D10, 0xF96E017D694487BC},
+  {0xB38D92D760EC4455, 0x37C981DCC395A9AC},
+  {0xE070F78D3927556A, 0x85BBE253F47B1417},
+  {0x8C469AB843B89562, 0x93956D7478CCEC8E},
+  {0xAF58416654A6BABB, 0x387AC8D1970027B2},
+  {0xDB2E51BFE9D0696A, 0x06997B05FCC0319E},
+  {0x88FCF317F22241E2, 0x441FECE3BDF81F03},
+  {0xAB3C2FDDEEAAD25A, 0xD527E81CAD7626C3},
+  {0xD60B3BD56A5586F1, 0x8A71E223D8D3B074},
+  {0x85C7056562757456, 0xF6872D5667844E49},
+  {0xA738C6BEBB12D16C, 0xB428F8AC016561DB},
+  {0xD106F86E69D785C7, 0xE13336D701BEBA52},
+  {0x82A45B450226B39C, 0xECC0024661173473},
+  {0xA34D721642B06084, 0x27F002D7F95D0190},
+  {0xCC20CE9BD35C78A5, 0x31EC038DF7B441F4},
+  {0xFF290242C83396CE, 0x7E67047175A15271},
+  {0x9F79A169BD203E41, 0x0F0062C6E984D386},
+  {0xC75809C42C684DD1, 0x52C07B78A3E60868},
+  {0xF92E0C3537826145, 0xA7709A56CCDF8A82},
+  {0x9BBCC7A142B17CCB, 0x88A66076400BB691},
+  {0xC2ABF989935DDBFE, 0x6ACFF893D00EA435},
+  {0xF356F7EBF83552FE, 0x0583F6B8C4124D43},
+  {0x98165AF37B2153DE, 0xC3727A337A8B704A},
+  {0xBE1BF1B059E9A8D6, 0x744F18C0592E4C5C},
+  {0xEDA2EE1C7064130C, 0x1162DEF06F79DF73},
+  {0x9485D4D1C63E8BE7, 0x8ADDCB5645AC2BA8},
+  {0xB9A74A0637CE2EE1, 0x6D953E2BD7173692},
+  {0xE8111C87C5C1BA99, 0xC8FA8DB6CCDD0437},
+  {0x910AB1D4DB9914A0, 0x1D9C9892400A22A2},
+  {0xB54D5E4A127F59C8, 0x2503BEB6D00CAB4B},
+  {0xE2A0B5DC971F303A, 0x2E44AE64840FD61D},
+  {0x8DA471A9DE737E24, 0x5CEAECFED289E5D2},
+  {0xB10D8E1456105DAD, 0x7425A83E872C5F47},
+  {0xDD50F1996B947518, 0xD12F124E28F77719},
+  {0x8A5296FFE33CC92F, 0x82BD6B70D99AAA6F},
+  {0xACE73CBFDC0BFB7B, 0x636CC64D1001550B},
+  {0xD8210BEFD30EFA5A, 0x3C47F7E05401AA4E},
+  {0x8714A775E3E95C78, 0x65ACFAEC34810A71},
+  {0xA8D9D1535CE3B396, 0x7F1839A741A14D0D},
+  {0xD31045A8341CA07C, 0x1EDE48111209A050},
+  {0x83EA2B892091E44D, 0x934AED0AAB460432},
+  {0xA4E4B66B68B65D60, 0xF81DA84D5617853F},
+  {0xCE1DE40642E3F4B9, 0x36251260AB9D668E},
+  {0x80D2AE83E9CE78F3, 0xC1D72B7C6B426019},
+  {0xA1075A24E4421730, 0xB24CF65B8612F81F},
+  {0xC94930AE1D529CFC, 0xDEE033F26797B627},
+  {0xFB9B7CD9A4A7443C, 0x169840EF017DA3B1},
+  {0x9D412E0806E88AA5, 0x8E1F289560EE864E},
+  {0xC491798A08A2AD4E, 0xF1A6F2BAB92A27E2},
+  {0xF5B5D7EC8ACB58A2, 0xAE10AF696774B1DB},
+  {0x9991A6F3D6BF1765, 0xACCA6DA1E0A8EF29},
+  {0xBFF610B0CC6EDD3F, 0x17FD090A58D32AF3},
+  {0xEFF394DCFF8A948E, 0xDDFC4B4CEF07F5B0},
+  {0x95F83D0A1FB69CD9, 0x4ABDAF101564F98E},
+  {0xBB764C4CA7A4440F, 0x9D6D1AD41ABE37F1},
+  {0xEA53DF5FD18D5513, 0x84C86189216DC5ED},
+  {0x92746B9BE2F8552C, 0x32FD3CF5B4E49BB4},
+  {0xB7118682DBB66A77, 0x3FBC8C33221DC2A1},
+  {0xE4D5E82392A40515, 0x0FABAF3FEAA5334A},
+  {0x8F05B1163BA6832D, 0x29CB4D87F2A7400E},
+  {0xB2C71D5BCA9023F8, 0x743E20E9EF511012},
+  {0xDF78E4B2BD342CF6, 0x914DA9246B255416},
+  {0x8BAB8EEFB6409C1A, 0x1AD089B6C2F7548E},
+  {0xAE9672ABA3D0C320, 0xA184AC2473B529B1},
+  {0xDA3C0F568CC4F3E8, 0xC9E5D72D90A2741E},
+  {0x8865899617FB1871, 0x7E2FA67C7A658892},
+  {0xAA7EEBFB9DF9DE8D, 0xDDBB901B98FEEAB7},
+  {0xD51EA6FA85785631, 0x552A74227F3EA565},
+  {0x8533285C936B35DE, 0xD53A88958F87275F},
+  {0xA67FF273B8460356, 0x8A892ABAF368F137},
+  {0xD01FEF10A657842C, 0x2D2B7569B0432D85},
+  {0x8213F56A67F6B29B, 0x9C3B29620E29FC73},
+  {0xA298F2C501F45F42, 0x8349F3BA91B47B8F},
+  {0xCB3F2F7642717713, 0x241C70A936219A73},
+  {0xFE0EFB53D30DD4D7, 0xED238CD383AA0110},
+  {0x9EC95D1463E8A506, 0xF4363804324A40AA},
+  {0xC67BB4597CE2CE48, 0xB143C6053EDCD0D5},
+  {0xF81AA16FDC1B81DA, 0xDD94B7868E94050A},
+  {0x9B10A4E5E9913128, 0xCA7CF2B4191C8326},
+  {0xC1D4CE1F63F57D72, 0xFD1C2F611F63A3F0},
+  {0xF24A01A73CF2DCCF, 0xBC633B39673C8CEC},
+  {0x976E41088617CA01, 0xD5BE0503E085D813},
+  {0xBD49D14AA79DBC82, 0x4B2D8644D8A74E18},
+  {0xEC9C459D51852BA2, 0xDDF8E7D60ED1219E},
+  {0x93E1AB8252F33B45, 0xCABB90E5C942B503},
+  {0xB8DA1662E7B00A17, 0x3D6A751F3B936243},
+  {0xE7109BFBA19C0C9D, 0x0CC512670A783AD4},
+  {0x906A617D450187E2, 0x27FB2B80668B24C5},
+  {0xB484F9DC9641E9DA, 0xB1F9F660802DEDF6},
+  {0xE1A63853BBD26451, 0x5E7873F8A0396973},
+  {0x8D07E33455637EB2, 0xDB0B487B6423E1E8},
+  {0xB049DC016ABC5E5F, 0x91CE1A9A3D2CDA62},
+  {0xDC5C5301C56B75F7, 0x7641A140CC7810FB},
+  {0x89B9B3E11B6329BA, 0xA9E904C87FCB0A9D},
+  {0xAC2820D9623BF429, 0x546345FA9FBDCD44},
+  {0xD732290FBACAF133, 0xA97C177947AD4095},
+  {0x867F59A9D4BED6C0, 0x49ED8EABCCCC485D},
+  {0xA81F301449EE8C70, 0x5C68F256BFFF5A74},
+  {0xD226FC195C6A2F8C, 0x73832EEC6FFF3111},
+  {0x83585D8FD9C25DB7, 0xC831FD53C5FF7EAB},
+  {0xA42E74F3D032F525, 0xBA3E7CA8B77F5E55},
+  {0xCD3A1230C43FB26F, 0x28CE1BD2E55F35EB},
+  {0x80444B5E7AA7CF85, 0x7980D163CF5B81B3},
+  {0xA0555E361951C366, 0xD7E105BCC332621F},
+  {0xC86AB5C39FA63440, 0x8DD9472BF3FEFAA7},
+  {0xFA856334878FC150, 0xB14F98F6F0FEB951},
+  {0x9C935E00D4B9D8D2, 0x6ED1BF9A569F33D3},
+  {0xC3B8358109E84F07, 0x0A862F80EC4700C8},
+  {0xF4A642E14C6262C8, 0xCD27BB612758C0FA},
+  {0x98E7E9CCCFBD7DBD, 0x8038D51CB897789C},
+  {0xBF21E44003ACDD2C, 0xE0470A63E6BD56C3},
+  {0xEEEA5D5004981478, 0x1858CCFCE06CAC74},
+  {0x95527A5202DF0CCB, 0x0F37801E0C43EBC8},
+  {0xBAA718E68396CFFD, 0xD30560258F54E6BA},
+  {0xE950DF20247C83FD, 0x47C6B82EF32A2069},
+  {0x91D28B7416CDD27E, 0x4CDC331D57FA5441},
+  {0xB6472E511C81471D, 0xE0133FE4ADF8E952},
+  {0xE3D8F9E563A198E5, 0x58180FDDD97723A6},
+  {0x8E679C2F5E44FF8F, 0x570F09EAA7EA7648},
+};
+
+// full 64 x 64 -> 128 bit product
+static inline uint64_t json_mul128(uint64_t a, uint64_t b, uint64_t *high)
+{
+#if defined(__SIZEOF_INT128__)
+  unsigned __int128 r = (unsigned __int128)a * b;
+  *high = (uint64_t)(r >> 64);
+  return (uint64_t)r;
+#else
+  uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+  uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+  uint64_t lo_lo = a_lo * b_lo;
+  uint64_t hi_lo = a_hi * b_lo;
+  uint64_t lo_hi = a_lo * b_hi;
+  uint64_t hi_hi = a_hi * b_hi;
+  uint64_t cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;
+  *high = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+  return (cross << 32) | (uint32_t)lo_lo;
+#endif
+}
+
+// w * 10^q for w != 0, false if the result may be incorrectly rounded
+static bool json_eisel_lemire(uint64_t w, int q, double *out)
+{
+  uint64_t bits;
+  if (q < JSON_POW5_MIN)
+  {
+    bits = 0;                               // underflow to zero
+  }
+  else if (q > JSON_POW5_MAX)
+  {
+    bits = (uint64_t)0x7FF << 52;           // overflow to infinity
+  }
+  else
+  {
+    int lz = __builtin_clzll(w);
+    w <<= lz;
+    
+    // 55 significant bits are needed, to round 53 bits with a guard bit
+    const uint64_t *pow5 = json_pow5[q - JSON_POW5_MIN];
+    uint64_t high;
+    uint64_t low = json_mul128(w, pow5[0], &high);
+    if ((high & 0x1FF) == 0x1FF)
+    {
+      uint64_t high2;
+      json_mul128(w, pow5[1], &high2);
+      low += high2;
+      if (high2 > low)
+      {
+        ++high;
+      }
+      if (low == ~(uint64_t)0 && (q < -27 || q > 55))
+      {
+        return false;                       // product not known exactly
+      }
+    }
+    
+    int upper_bit = (int)(high >> 63);
+    uint64_t mantissa = high >> (upper_bit + 9);
+    int power2 = (((152170 + 65536) * q) >> 16) + 63 + upper_bit - lz + 1023;
+    
+    if (power2 <= 0)
+    {
+      // subnormal
+      if (-power2 + 1 >= 64)
+      {
+        mantissa = 0;
+      }
+      else
+      {
+        mantissa >>= -power2 + 1;
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+      }
+      power2 = mantissa < ((uint64_t)1 << 52) ? 0 : 1;
+    }
+    else
+    {
+      // exactly halfway between two doubles: round to even
+      if (low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 &&
+          (mantissa << (upper_bit + 9)) == high)
+      {
+        mantissa &= ~(uint64_t)1;
+      }
+      mantissa += mantissa & 1;
+      mantissa >>= 1;
+      if (mantissa >= ((uint64_t)2 << 52))
+      {
+        mantissa = (uint64_t)1 << 52;
+        ++power2;
+      }
+      mantissa &= ~((uint64_t)1 << 52);
+      if (power2 >= 0x7FF)
+      {
+        power2 = 0x7FF;                     // infinity
+        mantissa = 0;
+      }
+    }
+    bits = mantissa | (uint64_t)power2 << 52;
+  }
+  memcpy(out, &bits, sizeof(bits));
+  return true;
+}
+
+// strtod with '.' as decimal point in any locale
+static double json_strtod(const char *first, const char *last)
+{
+  char buffer[128];
+  size_t size = last - first;
+  char *text = size < sizeof(buffer) ? buffer : (char *)malloc(size + 1);
+  if (!text)
+  {
+    return 0;
+  }
+  memcpy(text, first, size);
+  text[size] = 0;
+  
+  const char *point = localeconv()->decimal_point;
+  if (point[0] != '.' && point[0] && !point[1])
+  {
+    for (char *c = text; *c; ++c)
+    {
+      if (*c == '.')
+      {
+        *c = point[0];
+      }
+    }
+  }
+  double result = strtod(text, 0);
+  if (text != buffer)
+  {
+    free(text);
+  }
+  return result;
+}
+
 // convert string to floating point
-static char *atof(char *first, char *last, float *out)
+static char *atof(char *first, char *last, double *out)
 {
   // sign
-  float sign = 1;
+  bool negative = false;
   if (first != last)
   {
     if (*first == '-')
     {
-      sign = -1;
+      negative = true;
       ++first;
     }
     else if (*first == '+')
@@ -82,12 +921,27 @@ static char *atof(char *first, char *last, float *out)
       ++first;
     }
   }
+  char *number = first;
+  
+  // up to 19 significant digits, scaled by 10^exponent
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+  bool truncated = false;
   
   // integer part
-  float result = 0;
   for (; first != last && IS_DIGIT(*first); ++first)
   {
-    result = 10 * result + (*first - '0');
+    if (digits < 19)
+    {
+      mantissa = 10 * mantissa + (*first - '0');
+      digits += mantissa != 0;
+    }
+    else
+    {
+      ++exponent;
+      truncated |= *first != '0';
+    }
   }
   
   // fraction part
@@ -95,67 +949,499 @@ static char *atof(char *first, char *last, float *out)
   {
     ++first;
     
-    float inv_base = 0.1f;
     for (; first != last && IS_DIGIT(*first); ++first)
     {
-      result += (*first - '0') * inv_base;
-      inv_base *= 0.1f;
+      if (digits < 19)
+      {
+        mantissa = 10 * mantissa + (*first - '0');
+        digits += mantissa != 0;
+        --exponent;
+      }
+      else
+      {
+        truncated |= *first != '0';
+      }
     }
   }
   
-  // result w\o exponent
-  result *= sign;
-  
   // exponent
-  bool exponent_negative = false;
-  int exponent = 0;
   if (first != last && (*first == 'e' || *first == 'E'))
   {
     ++first;
     
-    if (*first == '-')
+    bool exponent_negative = false;
+    if (first != last && *first == '-')
     {
       exponent_negative = true;
       ++first;
     }
-    else if (*first == '+')
+    else if (first != last && *first == '+')
     {
       ++first;
     }
     
+    int value = 0;
     for (; first != last && IS_DIGIT(*first); ++first)
     {
-      exponent = 10 * exponent + (*first - '0');
+      if (value < 100000)
+      {
+        value = 10 * value + (*first - '0');
+      }
     }
+    exponent += exponent_negative ? -value : value;
   }
   
-  if (exponent)
+  double result;
+  if (mantissa == 0)
   {
-    float power_of_ten = 10;
-    for (; exponent > 1; exponent--)
-    {
-      power_of_ten *= 10;
-    }
-    
-    if (exponent_negative)
+    result = 0;
+  }
+  else if (!truncated && mantissa <= ((uint64_t)1 << 53) &&
+           exponent >= -22 && exponent <= 22)
+  {
+    result = (double)mantissa;
+    if (exponent < 0)
     {
-      result /= power_of_ten;
+      result /= json_exact_pow10[-exponent];
     }
     else
     {
-      result *= power_of_ten;
+      result *= json_exact_pow10[exponent];
     }
   }
-  
-  *out = result;
+  else if (truncated || !json_eisel_lemire(mantissa, exponent, &result))
+  {
+    result = json_strtod(number, first);
+  }
+  *out = negative ? -result : result;
   
   return first;
 }
 
-static json_value *json_alloc()
+// true if character is JSON white space
+#define IS_SPACE(c) (c == '\x20' || c == '\x9' || c == '\xD' || c == '\xA')
+
+// The scanners below test JSON_SIMD_WIDTH bytes at a time. For zero
+// terminated input loads are aligned, so they never cross a page boundary
+// past the terminating zero, and bits for the bytes before the starting
+// position are masked off. They stop at the terminating zero, like the
+// scalar versions. Input with an explicit end is loaded unaligned, and
+// the remainder shorter than a vector is scanned one byte at a time.
+
+#if JSON_SIMD_WIDTH == 32
+
+typedef __m256i json_simd;
+#define SIMD_LOAD(p) _mm256_load_si256((const __m256i *)(p))
+#define SIMD_LOADU(p) _mm256_loadu_si256((const __m256i *)(p))
+#define SIMD_SET1(c) _mm256_set1_epi8(c)
+#define SIMD_EQ(a, b) _mm256_cmpeq_epi8(a, b)
+#define SIMD_OR(a, b) _mm256_or_si256(a, b)
+#define SIMD_MAX(a, b) _mm256_max_epu8(a, b)
+#define SIMD_MASK(a) (uint32_t)_mm256_movemask_epi8(a)
+
+#elif JSON_SIMD_WIDTH == 16
+
+typedef __m128i json_simd;
+#define SIMD_LOAD(p) _mm_load_si128((const __m128i *)(p))
+#define SIMD_LOADU(p) _mm_loadu_si128((const __m128i *)(p))
+#define SIMD_SET1(c) _mm_set1_epi8(c)
+#define SIMD_EQ(a, b) _mm_cmpeq_epi8(a, b)
+#define SIMD_OR(a, b) _mm_or_si128(a, b)
+#define SIMD_MAX(a, b) _mm_max_epu8(a, b)
+#define SIMD_MASK(a) (uint32_t)_mm_movemask_epi8(a)
+
+#endif
+
+#ifdef JSON_SIMD_WIDTH
+
+// reads past the terminating zero within its aligned block are intended
+#if defined(__GNUC__) || defined(__clang__)
+#define JSON_NO_SANITIZE __attribute__((no_sanitize_address))
+#endif
+
+// bit set for each '"', '\\' or control character, including zero
+static inline uint32_t json_string_mask(json_simd v)
+{
+  json_simd control = SIMD_EQ(SIMD_MAX(v, SIMD_SET1(0x1F)), SIMD_SET1(0x1F));
+  json_simd quote = SIMD_EQ(v, SIMD_SET1('"'));
+  json_simd escape = SIMD_EQ(v, SIMD_SET1('\\'));
+  return SIMD_MASK(SIMD_OR(control, SIMD_OR(quote, escape)));
+}
+
+// bit set for each character that is not white space
+static inline uint32_t json_nonspace_mask(json_simd v)
+{
+  json_simd space = SIMD_OR(SIMD_OR(SIMD_EQ(v, SIMD_SET1('\x20')),
+                                    SIMD_EQ(v, SIMD_SET1('\x9'))),
+                            SIMD_OR(SIMD_EQ(v, SIMD_SET1('\xD')),
+                                    SIMD_EQ(v, SIMD_SET1('\xA'))));
+  return ~SIMD_MASK(space) & (uint32_t)((1ull << JSON_SIMD_WIDTH) - 1);
+}
+
+// apply mask_func from it, returning the position of the first set bit
+#define JSON_SCAN(it, mask_func)\
+const char *block = (const char *)((uintptr_t)it & ~(uintptr_t)(JSON_SIMD_WIDTH - 1));\
+uint32_t mask = mask_func(SIMD_LOAD(block)) & (~0u << (it - block));\
+while (!mask)\
+{\
+  block += JSON_SIMD_WIDTH;\
+  mask = mask_func(SIMD_LOAD(block));\
+}\
+return (char *)block + __builtin_ctz(mask)
+
+#endif
+
+#ifndef JSON_NO_SANITIZE
+#define JSON_NO_SANITIZE
+#endif
+
+// find the first '"', '\\' or control character at or after it
+JSON_NO_SANITIZE static inline char *json_scan_string(char *it)
+{
+#ifdef JSON_SIMD_WIDTH
+  JSON_SCAN(it, json_string_mask);
+#else
+  while (*it != '"' && *it != '\\' && (unsigned char)*it >= '\x20')
+  {
+    ++it;
+  }
+  return it;
+#endif
+}
+
+// find the first '"', '\\' or control character in [it, end), or end,
+// for input that is not zero terminated
+static inline const char *json_scan_string(const char *it, const char *end)
+{
+#ifdef JSON_SIMD_WIDTH
+  for (; end - it >= JSON_SIMD_WIDTH; it += JSON_SIMD_WIDTH)
+  {
+    uint32_t mask = json_string_mask(SIMD_LOADU(it));
+    if (mask)
+    {
+      return it + __builtin_ctz(mask);
+    }
+  }
+#endif
+  while (it != end && *it != '"' && *it != '\\' && (unsigned char)*it >= '\x20')
+  {
+    ++it;
+  }
+  return it;
+}
+
+// skip white space
+JSON_NO_SANITIZE static inline char *json_skip_space(char *it)
+{
+  if (!IS_SPACE(*it) || !IS_SPACE(it[1]))
+  {
+    return it + IS_SPACE(*it);              // common short cases
+  }
+#ifdef JSON_SIMD_WIDTH
+  JSON_SCAN(it, json_nonspace_mask);
+#else
+  while (IS_SPACE(*it))
+  {
+    ++it;
+  }
+  return it;
+#endif
+}
+
+// skip white space in [it, end), for input that is not zero terminated
+static inline const char *json_skip_space(const char *it, const char *end)
 {
-  json_value *value = (json_value *)malloc(sizeof(json_value));
-  memset(value, 0, sizeof(json_value));
+  if (it == end || !IS_SPACE(*it) || end - it < 2 || !IS_SPACE(it[1]))
+  {
+    return it + (it != end && IS_SPACE(*it));
+  }
+#ifdef JSON_SIMD_WIDTH
+  for (; end - it >= JSON_SIMD_WIDTH; it += JSON_SIMD_WIDTH)
+  {
+    uint32_t mask = json_nonspace_mask(SIMD_LOADU(it));
+    if (mask)
+    {
+      return it + __builtin_ctz(mask);
+    }
+  }
+#endif
+  while (it != end && IS_SPACE(*it))
+  {
+    ++it;
+  }
+  return it;
+}
+
+// decode the string after '"' at it into out, which must hold end - it
+// bytes, returning the end of the output or NULL for a bad escape
+static char *json_unescape(const char *it, const char *end, char *out)
+{
+  for (;;)
+  {
+    const char *plain = json_scan_string(it, end);
+    memcpy(out, it, plain - it);
+    out += plain - it;
+    it = plain;
+    if (it == end || *it != '\\')
+    {
+      return it != end && *it == '"' ? out : 0;
+    }
+    if (end - it < 2)
+    {
+      return 0;
+    }
+    switch (it[1])
+    {
+      case '"':
+        *out++ = '"';
+        break;
+      case '\\':
+        *out++ = '\\';
+        break;
+      case '/':
+        *out++ = '/';
+        break;
+      case 'b':
+        *out++ = '\b';
+        break;
+      case 'f':
+        *out++ = '\f';
+        break;
+      case 'n':
+        *out++ = '\n';
+        break;
+      case 'r':
+        *out++ = '\r';
+        break;
+      case 't':
+        *out++ = '\t';
+        break;
+      case 'u':
+      {
+        unsigned int codepoint;
+        char *digits = (char *)it + 2;
+        if (end - it < 6 || hatoui(digits, digits + 4, &codepoint) != digits + 4)
+        {
+          return 0;
+        }
+        if (codepoint <= 0x7F)
+        {
+          *out++ = (char)codepoint;
+        }
+        else if (codepoint <= 0x7FF)
+        {
+          *out++ = (char)(0xC0 | (codepoint >> 6));
+          *out++ = (char)(0x80 | (codepoint & 0x3F));
+        }
+        else
+        {
+          *out++ = (char)(0xE0 | (codepoint >> 12));
+          *out++ = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+          *out++ = (char)(0x80 | (codepoint & 0x3F));
+        }
+        it += 4;
+      }
+        break;
+      default:
+        return 0;
+    }
+    it += 2;
+  }
+}
+
+// arena memory is a list of blocks, each followed by its data
+struct json_block
+{
+  json_block *next;
+  size_t size;
+};
+
+// hash table of the members of an object, built by json_find
+struct json_index_slot
+{
+  uint64_t hash;
+  json_value *value;                        // NULL if empty
+};
+
+struct json_index
+{
+  json_arena *arena;                        // of the object
+  size_t mask;                              // slot count - 1
+  json_index_slot *slots;                   // NULL until built
+};
+
+// the arena header lives at the start of its first block, so that a
+// private arena can be found from the root node that directly follows it
+struct json_arena
+{
+  json_block *first;
+  json_block *current;
+  char *next;
+  char *end;
+  size_t block_size;
+  size_t bytes;
+  size_t blocks;
+  json_value *root;
+  json_index unindexed;                     // shared by objects until found
+  json_arena *parallel;                     // list of json_parse_parallel
+};
+
+static const size_t JSON_ALIGN = 8;
+static const size_t JSON_DEFAULT_BLOCK_SIZE = 64 * 1024;
+static const size_t JSON_MAX_BLOCK_SIZE = 8 * 1024 * 1024;
+static const size_t JSON_MAX_STRING = 0xFFFFFFFF; // json_value::string_size
+
+#define JSON_ROUND(n) (((n) + JSON_ALIGN - 1) & ~(JSON_ALIGN - 1))
+#define JSON_BLOCK_HEADER JSON_ROUND(sizeof(json_block))
+#define JSON_ARENA_HEADER JSON_ROUND(sizeof(json_arena))
+
+static json_block *json_block_alloc(json_arena *arena, size_t size)
+{
+  json_block *block = (json_block *)malloc(JSON_BLOCK_HEADER + size);
+  if (!block)
+  {
+    return 0;
+  }
+  block->next = 0;
+  block->size = size;
+  if (arena)
+  {
+    arena->bytes += JSON_BLOCK_HEADER + size;
+    arena->blocks++;
+    mem::Track(mem::JsonDOM, (uintptr_t)arena, arena->bytes);
+  }
+  return block;
+}
+
+static char *json_block_data(json_block *block)
+{
+  return (char *)block + JSON_BLOCK_HEADER;
+}
+
+json_arena *json_arena_create(size_t block_size)
+{
+  if (block_size == 0)
+  {
+    block_size = JSON_DEFAULT_BLOCK_SIZE;
+  }
+  block_size = JSON_ROUND(block_size);
+  json_block *block = json_block_alloc(0, JSON_ARENA_HEADER + block_size);
+  if (!block)
+  {
+    return 0;
+  }
+  json_arena *arena = (json_arena *)json_block_data(block);
+  arena->first = arena->current = block;
+  arena->next = json_block_data(block) + JSON_ARENA_HEADER;
+  arena->end = json_block_data(block) + block->size;
+  arena->block_size = block_size;
+  arena->bytes = JSON_BLOCK_HEADER + block->size;
+  arena->blocks = 1;
+  arena->root = 0;
+  arena->unindexed.arena = arena;
+  arena->unindexed.mask = 0;
+  arena->unindexed.slots = 0;
+  arena->parallel = 0;
+  mem::Track(mem::JsonDOM, (uintptr_t)arena, arena->bytes);
+  return arena;
+}
+
+void json_arena_reset(json_arena *arena)
+{
+  arena->current = arena->first;
+  arena->next = json_block_data(arena->first) + JSON_ARENA_HEADER;
+  arena->end = json_block_data(arena->first) + arena->first->size;
+  arena->root = 0;
+  if (arena->parallel)
+  {
+    json_arena_reset(arena->parallel);
+  }
+}
+
+void json_arena_destroy(json_arena *arena)
+{
+  if (!arena)
+  {
+    return;
+  }
+  json_arena_destroy(arena->parallel);
+  mem::Untrack(mem::JsonDOM, (uintptr_t)arena);
+  json_block *block = arena->first->next;
+  while (block)
+  {
+    json_block *next = block->next;
+    free(block);
+    block = next;
+  }
+  free(arena->first);                       // contains the arena itself
+}
+
+size_t json_arena_bytes(const json_arena *arena)
+{
+  return arena->bytes + (arena->parallel ? json_arena_bytes(arena->parallel) : 0);
+}
+
+size_t json_arena_blocks(const json_arena *arena)
+{
+  return arena->blocks + (arena->parallel ? json_arena_blocks(arena->parallel) : 0);
+}
+
+// move to the next block, reusing blocks retained by json_arena_reset
+static bool json_arena_grow(json_arena *arena, size_t size)
+{
+  json_block *block = arena->current->next;
+  while (block && block->size < size)
+  {
+    block = block->next;                    // skip blocks that are too small
+  }
+  if (!block)
+  {
+    size_t block_size = arena->current->size * 2;
+    if (block_size > JSON_MAX_BLOCK_SIZE)
+    {
+      block_size = JSON_MAX_BLOCK_SIZE;
+    }
+    if (block_size < arena->block_size)
+    {
+      block_size = arena->block_size;
+    }
+    if (block_size < size)
+    {
+      block_size = JSON_ROUND(size);
+    }
+    block = json_block_alloc(arena, block_size);
+    if (!block)
+    {
+      return false;
+    }
+    block->next = arena->current->next;
+    arena->current->next = block;
+  }
+  arena->current = block;
+  arena->next = json_block_data(block);
+  arena->end = arena->next + block->size;
+  return true;
+}
+
+static void *json_arena_alloc(json_arena *arena, size_t size)
+{
+  size = JSON_ROUND(size);
+  if (arena->next + size > arena->end && !json_arena_grow(arena, size))
+  {
+    return 0;
+  }
+  void *p = arena->next;
+  arena->next += size;
+  return p;
+}
+
+static json_value *json_alloc(json_arena *arena)
+{
+  json_value *value = (json_value *)json_arena_alloc(arena, sizeof(json_value));
+  if (value)
+  {
+    memset(value, 0, sizeof(json_value));
+  }
   return value;
 }
 
@@ -182,14 +1468,25 @@ return 0
 
 #define CHECK_TOP() if (!top) {ERROR(it, "Unexpected character");}
 
-json_value *json_parse(char *source,
-                       char **error_pos, char **error_desc, int *error_line)
+// parse the document at source, or with root, a range of the elements of
+// its root array from it: root is then that array, already open, and the
+// range ends at the closing bracket, or with partial at the terminating
+// zero; error lines are counted from source, and the number of newlines
+// made by unescaping is added to newlines
+static json_value *json_parse_arena(char *source, char **error_pos,
+                                    char **error_desc, int *error_line,
+                                    json_arena *arena, json_value *root = 0,
+                                    char *it = 0, bool partial = false,
+                                    int *newlines = 0)
 {
-  json_value *root = 0;
-  json_value *top = 0;
+  json_value *top = root;
   
   char *name = 0;
-  char *it = source;
+  uint32_t name_size = 0;
+  if (!it)
+  {
+    it = source;
+  }
   
   int escaped_newlines = 0;
   
@@ -201,14 +1498,24 @@ json_value *json_parse(char *source,
       case '[':
       {
         // create new value
-        json_value *object = json_alloc();
+        json_value *object = json_alloc(arena);
+        if (!object)
+        {
+          ERROR(it, "Out of memory");
+        }
         
         // name
         object->name = name;
+        object->name_size = name_size;
         name = 0;
+        name_size = 0;
         
         // type
         object->type = (*it == '{') ? JSON_OBJECT : JSON_ARRAY;
+        if (object->type == JSON_OBJECT)
+        {
+          object->index = &arena->unindexed;
+        }
         
         // skip open character
         ++it;
@@ -270,7 +1577,20 @@ json_value *json_parse(char *source,
         char *last = it;
         while (*it)
         {
-          if ((unsigned char)*it < '\x20')
+          // copy plain characters in bulk, shifted left past unescaping
+          char *plain = json_scan_string(it);
+          if (last != it)
+          {
+            memmove(last, it, plain - it);
+          }
+          last += plain - it;
+          it = plain;
+          
+          if (!*it)
+          {
+            break;                          // unterminated, reported below
+          }
+          else if ((unsigned char)*it < '\x20')
           {
             ERROR(first, "Control characters not allowed in strings");
           }
@@ -342,27 +1662,36 @@ json_value *json_parse(char *source,
             ++it;
             break;
           }
-          else
-          {
-            *last++ = *it++;
-          }
+        }
+        
+        if ((size_t)(last - first) > JSON_MAX_STRING)
+        {
+          ERROR(first, "String too long");
         }
         
         if (!name && top->type == JSON_OBJECT)
         {
           // field name in object
           name = first;
+          name_size = (uint32_t)(last - first);
         }
         else
         {
           // new string value
-          json_value *object = json_alloc();
+          json_value *object = json_alloc(arena);
+          if (!object)
+          {
+            ERROR(it, "Out of memory");
+          }
           
           object->name = name;
+          object->name_size = name_size;
           name = 0;
+          name_size = 0;
           
           object->type = JSON_STRING;
           object->string_value = first;
+          object->string_size = (uint32_t)(last - first);
           
           json_append(top, object);
         }
@@ -376,10 +1705,16 @@ json_value *json_parse(char *source,
         CHECK_TOP();
         
         // new null/bool value
-        json_value *object = json_alloc();
+        json_value *object = json_alloc(arena);
+        if (!object)
+        {
+          ERROR(it, "Out of memory");
+        }
         
         object->name = name;
+        object->name_size = name_size;
         name = 0;
+        name_size = 0;
         
         // null
         if (it[0] == 'n' && it[1] == 'u' && it[2] == 'l' && it[3] == 'l')
@@ -425,15 +1760,21 @@ json_value *json_parse(char *source,
         CHECK_TOP();
         
         // new number value
-        json_value *object = json_alloc();
+        json_value *object = json_alloc(arena);
+        if (!object)
+        {
+          ERROR(it, "Out of memory");
+        }
         
         object->name = name;
+        object->name_size = name_size;
         name = 0;
+        name_size = 0;
         
         object->type = JSON_INT;
         
         char *first = it;
-        while (*it != '\x20' && *it != '\x9' && *it != '\xD' && *it != '\xA' && *it != ',' && *it != ']' && *it != '}')
+        while (*it && *it != '\x20' && *it != '\x9' && *it != '\xD' && *it != '\xA' && *it != ',' && *it != ']' && *it != '}')
         {
           if (*it == '.' || *it == 'e' || *it == 'E')
           {
@@ -442,9 +1783,17 @@ json_value *json_parse(char *source,
           ++it;
         }
         
-        if (object->type == JSON_INT && atoi(first, it, &object->int_value) != it)
+        if (object->type == JSON_INT)
         {
-          ERROR(first, "Bad integer number");
+          char *end = atoi(first, it, &object->int_value);
+          if (!end)
+          {
+            object->type = JSON_FLOAT;      // beyond 64 bits
+          }
+          else if (end != it)
+          {
+            ERROR(first, "Bad integer number");
+          }
         }
         
         if (object->type == JSON_FLOAT && atof(first, it, &object->float_value) != it)
@@ -461,16 +1810,3135 @@ json_value *json_parse(char *source,
     }
     
     // skip white space
-    while (*it == '\x20' || *it == '\x9' || *it == '\xD' || *it == '\xA')
+    it = json_skip_space(it);
+  }
+  
+  if (top && !(partial && top == root))
+  {
+    ERROR(it, "Not all objects/arrays have been properly closed");
+  }
+  
+  if (newlines)
+  {
+    *newlines += escaped_newlines;
+  }
+  return root;
+}
+
+json_value *json_parse(char *source,
+                       char **error_pos, char **error_desc, int *error_line,
+                       json_arena *arena)
+{
+  mt::StallZone zone("json_parse");
+  
+  if (arena)
+  {
+    return json_parse_arena(source, error_pos, error_desc, error_line, arena);
+  }
+  
+  // private arena, released by json_free
+  arena = json_arena_create();
+  if (!arena)
+  {
+    *error_pos = source;
+    *error_desc = (char *)"Out of memory";
+    *error_line = 1;
+    return 0;
+  }
+  json_value *root = json_parse_arena(source, error_pos, error_desc,
+                                      error_line, arena);
+  if (!root)
+  {
+    json_arena_destroy(arena);
+    return 0;
+  }
+  arena->root = root;
+  root->escaped |= JSON_PRIVATE_ARENA;
+  return root;
+}
+
+void json_free(json_value *root)
+{
+  if (!root)
+  {
+    return;
+  }
+  if (!(root->escaped & JSON_PRIVATE_ARENA))
+  {
+    return;                                 // not a private arena document
+  }
+  json_arena *arena = (json_arena *)((char *)root - JSON_ARENA_HEADER);
+  if (arena->root == root)
+  {
+    json_arena_destroy(arena);
+  }
+}
+
+//
+// Views
+//
+
+#define VIEW_ERROR(pos, desc)\
+*error_offset = pos - source;\
+*error_desc = (char *)desc;\
+*error_line = 1;\
+for (const char *c = source; c != pos; ++c)\
+if (*c == '\n') ++*error_line;\
+return 0
+
+// parse like json_parse_arena, with the same grammar and errors, keeping
+// strings and names in source
+static json_value *json_parse_view_arena(const char *source, size_t size,
+                                         size_t *error_offset,
+                                         char **error_desc, int *error_line,
+                                         json_arena *arena)
+{
+  json_value *root = 0;
+  json_value *top = 0;
+  
+  const char *name = 0;
+  uint32_t name_size = 0;
+  unsigned char name_escaped = 0;
+  
+  const char *it = source;
+  const char *end = source + size;
+  
+  while (it != end && *it)
+  {
+    switch (*it)
     {
-      ++it;
+      case '{':
+      case '[':
+      {
+        json_value *object = json_alloc(arena);
+        if (!object)
+        {
+          VIEW_ERROR(it, "Out of memory");
+        }
+        
+        object->name = (char *)name;
+        object->name_size = name_size;
+        object->escaped = name_escaped;
+        name = 0;
+        name_size = 0;
+        name_escaped = 0;
+        
+        // containers lead to the arena, for json_string
+        object->type = (*it == '{') ? JSON_OBJECT : JSON_ARRAY;
+        object->index = &arena->unindexed;
+        
+        ++it;
+        
+        if (top)
+        {
+          json_append(top, object);
+        }
+        else if (!root)
+        {
+          root = object;
+        }
+        else
+        {
+          VIEW_ERROR(it, "Second root. Only one root allowed");
+        }
+        top = object;
+      }
+        break;
+        
+      case '}':
+      case ']':
+      {
+        if (!top || top->type != ((*it == '}') ? JSON_OBJECT : JSON_ARRAY))
+        {
+          VIEW_ERROR(it, "Mismatch closing brace/bracket");
+        }
+        ++it;
+        top = top->parent;
+      }
+        break;
+        
+      case ':':
+        if (!top || top->type != JSON_OBJECT)
+        {
+          VIEW_ERROR(it, "Unexpected character");
+        }
+        ++it;
+        break;
+        
+      case ',':
+        if (!top)
+        {
+          VIEW_ERROR(it, "Unexpected character");
+        }
+        ++it;
+        break;
+        
+      case '"':
+      {
+        if (!top)
+        {
+          VIEW_ERROR(it, "Unexpected character");
+        }
+        
+        // skip '"' character
+        ++it;
+        
+        // check escapes without decoding them
+        const char *first = it;
+        bool escaped = false;
+        for (;;)
+        {
+          it = json_scan_string(it, end);
+          if (it == end || !*it)
+          {
+            break;                          // unterminated, reported below
+          }
+          else if (*it == '"')
+          {
+            break;
+          }
+          else if (*it != '\\')
+          {
+            VIEW_ERROR(first, "Control characters not allowed in strings");
+          }
+          
+          escaped = true;
+          char c = end - it > 1 ? it[1] : 0;
+          if (c == 'u')
+          {
+            unsigned int codepoint;
+            char *digits = (char *)it + 2;
+            char *last = end - it >= 6 ? digits + 4 : (char *)end;
+            if (hatoui(digits, last, &codepoint) != digits + 4)
+            {
+              VIEW_ERROR(it, "Bad unicode codepoint");
+            }
+            it += 4;
+          }
+          else if (!c || !strchr("\"\\/bfnrt", c))
+          {
+            VIEW_ERROR(first, "Unrecognized escape sequence");
+          }
+          it += 2;
+        }
+        
+        if ((size_t)(it - first) > JSON_MAX_STRING)
+        {
+          VIEW_ERROR(first, "String too long");
+        }
+        
+        if (!name && top->type == JSON_OBJECT)
+        {
+          // field name in object
+          name = first;
+          name_size = (uint32_t)(it - first);
+          name_escaped = escaped ? JSON_NAME_ESCAPED : 0;
+        }
+        else
+        {
+          // new string value
+          json_value *object = json_alloc(arena);
+          if (!object)
+          {
+            VIEW_ERROR(it, "Out of memory");
+          }
+          
+          object->name = (char *)name;
+          object->name_size = name_size;
+          object->escaped = name_escaped | (escaped ? JSON_STRING_ESCAPED : 0);
+          name = 0;
+          name_size = 0;
+          name_escaped = 0;
+          
+          object->type = JSON_STRING;
+          object->string_value = (char *)first;
+          object->string_size = (uint32_t)(it - first);
+          
+          json_append(top, object);
+        }
+        
+        if (it != end && *it == '"')
+        {
+          ++it;
+        }
+      }
+        break;
+        
+      case 'n':
+      case 't':
+      case 'f':
+      {
+        if (!top)
+        {
+          VIEW_ERROR(it, "Unexpected character");
+        }
+        
+        // new null/bool value
+        json_value *object = json_alloc(arena);
+        if (!object)
+        {
+          VIEW_ERROR(it, "Out of memory");
+        }
+        
+        object->name = (char *)name;
+        object->name_size = name_size;
+        object->escaped = name_escaped;
+        name = 0;
+        name_size = 0;
+        name_escaped = 0;
+        
+        if (end - it >= 4 && !memcmp(it, "null", 4))
+        {
+          object->type = JSON_NULL;
+          it += 4;
+        }
+        else if (end - it >= 4 && !memcmp(it, "true", 4))
+        {
+          object->type = JSON_BOOL;
+          object->int_value = 1;
+          it += 4;
+        }
+        else if (end - it >= 5 && !memcmp(it, "false", 5))
+        {
+          object->type = JSON_BOOL;
+          object->int_value = 0;
+          it += 5;
+        }
+        else
+        {
+          VIEW_ERROR(it, "Unknown identifier");
+        }
+        
+        json_append(top, object);
+      }
+        break;
+        
+      case '-':
+      case '0':
+      case '1':
+      case '2':
+      case '3':
+      case '4':
+      case '5':
+      case '6':
+      case '7':
+      case '8':
+      case '9':
+      {
+        if (!top)
+        {
+          VIEW_ERROR(it, "Unexpected character");
+        }
+        
+        // new number value
+        json_value *object = json_alloc(arena);
+        if (!object)
+        {
+          VIEW_ERROR(it, "Out of memory");
+        }
+        
+        object->name = (char *)name;
+        object->name_size = name_size;
+        object->escaped = name_escaped;
+        name = 0;
+        name_size = 0;
+        name_escaped = 0;
+        
+        object->type = JSON_INT;
+        
+        char *first = (char *)it;
+        while (it != end && *it && !IS_SPACE(*it) && *it != ',' && *it != ']' && *it != '}')
+        {
+          if (*it == '.' || *it == 'e' || *it == 'E')
+          {
+            object->type = JSON_FLOAT;
+          }
+          ++it;
+        }
+        
+        if (object->type == JSON_INT)
+        {
+          char *last = atoi(first, (char *)it, &object->int_value);
+          if (!last)
+          {
+            object->type = JSON_FLOAT;      // beyond 64 bits
+          }
+          else if (last != it)
+          {
+            VIEW_ERROR(first, "Bad integer number");
+          }
+        }
+        
+        if (object->type == JSON_FLOAT && atof(first, (char *)it, &object->float_value) != it)
+        {
+          VIEW_ERROR(first, "Bad float number");
+        }
+        
+        json_append(top, object);
+      }
+        break;
+        
+      default:
+        VIEW_ERROR(it, "Unexpected character");
     }
+    
+    it = json_skip_space(it, end);
   }
   
   if (top)
   {
-    ERROR(it, "Not all objects/arrays have been properly closed");
+    VIEW_ERROR(it, "Not all objects/arrays have been properly closed");
+  }
+  
+  return root;
+}
+
+json_value *json_parse_view(const char *source, size_t size,
+                            size_t *error_offset, char **error_desc,
+                            int *error_line, json_arena *arena)
+{
+  mt::StallZone zone("json_parse_view");
+  
+  if (arena)
+  {
+    return json_parse_view_arena(source, size, error_offset, error_desc,
+                                 error_line, arena);
   }
   
+  // private arena, released by json_free
+  arena = json_arena_create();
+  if (!arena)
+  {
+    *error_offset = 0;
+    *error_desc = (char *)"Out of memory";
+    *error_line = 1;
+    return 0;
+  }
+  json_value *root = json_parse_view_arena(source, size, error_offset,
+                                           error_desc, error_line, arena);
+  if (!root)
+  {
+    json_arena_destroy(arena);
+    return 0;
+  }
+  arena->root = root;
+  root->escaped |= JSON_PRIVATE_ARENA;
+  return root;
+}
+
+json_value *json_parse_file(const char *path, MappedFile *file,
+                            size_t *error_offset, char **error_desc,
+                            int *error_line, json_arena *arena)
+{
+  if (!file->Open(path, MappedFile::ReadOnly, MappedFile::Sequential))
+  {
+    *error_offset = 0;
+    *error_desc = (char *)"Cannot open file";
+    *error_line = 1;
+    return 0;
+  }
+  return json_parse_view((const char *)file->Data(), file->Size(),
+                         error_offset, error_desc, error_line, arena);
+}
+
+// unescape the view of size bytes at text into the arena of the document
+// of value, returning NULL if out of memory
+static char *json_view_unescape(json_value *value, char *text, uint32_t *size)
+{
+  json_value *root = value;
+  while (root->parent)
+  {
+    root = root->parent;
+  }
+  char *out = (char *)json_arena_alloc(root->index->arena,
+                                       JSON_ROUND(*size + 1));
+  if (!out)
+  {
+    return 0;
+  }
+  char *last = json_unescape(text, text + *size + 1, out); // to the '"'
+  *last = 0;
+  *size = (uint32_t)(last - out);
+  return out;
+}
+
+const char *json_string(json_value *value, size_t *size)
+{
+  if (!value || value->type != JSON_STRING)
+  {
+    return 0;
+  }
+  if (value->escaped & JSON_STRING_ESCAPED)
+  {
+    char *text = json_view_unescape(value, value->string_value,
+                                    &value->string_size);
+    if (!text)
+    {
+      return 0;
+    }
+    value->string_value = text;
+    value->escaped &= ~JSON_STRING_ESCAPED;
+  }
+  if (size)
+  {
+    *size = value->string_size;
+  }
+  return value->string_value;
+}
+
+const char *json_name(json_value *value, size_t *size)
+{
+  if (!value || !value->name)
+  {
+    return 0;
+  }
+  if (value->escaped & JSON_NAME_ESCAPED)
+  {
+    char *text = json_view_unescape(value, value->name, &value->name_size);
+    if (!text)
+    {
+      return 0;
+    }
+    value->name = text;
+    value->escaped &= ~JSON_NAME_ESCAPED;
+  }
+  if (size)
+  {
+    *size = value->name_size;
+  }
+  return value->name;
+}
+
+// objects with fewer members are searched by walking them
+static const size_t JSON_INDEX_MIN = 16;
+
+// FNV-1a
+static uint64_t json_hash(const char *name, size_t size)
+{
+  uint64_t hash = 14695981039346656037ull;
+  for (const char *end = name + size; name != end; ++name)
+  {
+    hash = (hash ^ (unsigned char)*name) * 1099511628211ull;
+  }
+  return hash;
+}
+
+// index the members of object in its arena, returning NULL if it is too
+// small or out of memory
+static json_index *json_index_build(json_value *object)
+{
+  size_t count = 0;
+  for (json_value *it = object->first_child; it; it = it->next_sibling)
+  {
+    ++count;
+  }
+  if (count < JSON_INDEX_MIN)
+  {
+    return 0;
+  }
+  
+  // at most half full, for short probe sequences
+  size_t size = JSON_INDEX_MIN;
+  while (size < 2 * count)
+  {
+    size *= 2;
+  }
+  json_arena *arena = object->index->arena;
+  json_index *index = (json_index *)json_arena_alloc(arena,
+    JSON_ROUND(sizeof(json_index)) + size * sizeof(json_index_slot));
+  if (!index)
+  {
+    return 0;
+  }
+  index->arena = arena;
+  index->mask = size - 1;
+  index->slots = (json_index_slot *)((char *)index +
+                                     JSON_ROUND(sizeof(json_index)));
+  memset(index->slots, 0, size * sizeof(json_index_slot));
+  
+  // members are inserted in order, so the first of duplicate names is
+  // found first, as by a walk
+  for (json_value *it = object->first_child; it; it = it->next_sibling)
+  {
+    size_t name_size;
+    const char *name = json_name(it, &name_size);
+    if (!name)
+    {
+      continue;
+    }
+    uint64_t hash = json_hash(name, name_size);
+    size_t i = (size_t)hash & index->mask;
+    while (index->slots[i].value)
+    {
+      i = (i + 1) & index->mask;
+    }
+    index->slots[i].hash = hash;
+    index->slots[i].value = it;
+  }
+  object->index = index;
+  return index;
+}
+
+json_value *json_find(json_value *object, const char *name)
+{
+  if (!object || object->type != JSON_OBJECT)
+  {
+    return 0;
+  }
+  
+  json_index *index = object->index;
+  if (index && !index->slots)
+  {
+    index = json_index_build(object);
+  }
+  size_t size = strlen(name);
+  if (!index)
+  {
+    for (json_value *it = object->first_child; it; it = it->next_sibling)
+    {
+      size_t it_size;
+      const char *it_name = json_name(it, &it_size);
+      if (it_name && it_size == size && !memcmp(it_name, name, size))
+      {
+        return it;
+      }
+    }
+    return 0;
+  }
+  
+  uint64_t hash = json_hash(name, size);
+  for (size_t i = (size_t)hash & index->mask; index->slots[i].value;
+       i = (i + 1) & index->mask)
+  {
+    json_value *it = index->slots[i].value;
+    if (index->slots[i].hash == hash && it->name_size == size &&
+        !memcmp(it->name, name, size))
+    {
+      return it;
+    }
+  }
+  return 0;
+}
+
+//
+// Streaming parser
+//
+
+enum json_sax_state
+{
+  JSON_SAX_SPACE,                           // between tokens
+  JSON_SAX_STRING,                          // in a string or name
+  JSON_SAX_ESCAPE,                          // after '\\' in a string
+  JSON_SAX_UNICODE,                         // in the digits of "\\u"
+  JSON_SAX_NUMBER,
+  JSON_SAX_LITERAL,                         // null, true or false
+  JSON_SAX_ERROR,
+};
+
+// growable byte buffer
+struct json_sax_buffer
+{
+  char *data;
+  size_t size;
+  size_t capacity;
+};
+
+struct json_sax_parser
+{
+  const json_sax_handler *handler;
+  void *data;
+  json_sax_state state;
+  json_sax_buffer token;                    // string, number or literal
+  json_sax_buffer name;                     // pending member name
+  json_sax_buffer stack;                    // json_type of open containers
+  bool has_name;
+  bool has_root;
+  const char *literal;                      // expected literal text
+  size_t offset;                            // stream offset of chunk start
+  int line;                                 // line at current position
+  size_t token_offset;                      // first character of token
+  int token_line;
+  size_t escape_offset;                     // '\\' of "\\u" escape
+  unsigned int codepoint;
+  int hex_digits;
+  size_t error_offset;
+  char *error_desc;
+  int error_line;
+};
+
+static bool json_buffer_reserve(json_sax_buffer *buffer, size_t size)
+{
+  if (size <= buffer->capacity)
+  {
+    return true;
+  }
+  size_t capacity = buffer->capacity ? buffer->capacity * 2 : 256;
+  while (capacity < size)
+  {
+    capacity *= 2;
+  }
+  char *data = (char *)realloc(buffer->data, capacity);
+  if (!data)
+  {
+    return false;
+  }
+  buffer->data = data;
+  buffer->capacity = capacity;
+  return true;
+}
+
+static bool json_buffer_append(json_sax_buffer *buffer, const char *p,
+                               size_t size)
+{
+  if (!json_buffer_reserve(buffer, buffer->size + size + 1))
+  {
+    return false;
+  }
+  memcpy(buffer->data + buffer->size, p, size);
+  buffer->size += size;
+  buffer->data[buffer->size] = 0;           // always zero terminated
+  return true;
+}
+
+static bool json_sax_fail(json_sax_parser *parser, size_t offset, int line,
+                          const char *desc)
+{
+  parser->state = JSON_SAX_ERROR;
+  parser->error_offset = offset;
+  parser->error_desc = (char *)desc;
+  parser->error_line = line;
+  return false;
+}
+
+json_sax_parser *json_sax_create(const json_sax_handler *handler, void *data)
+{
+  json_sax_parser *parser = (json_sax_parser *)malloc(sizeof(json_sax_parser));
+  if (!parser)
+  {
+    return 0;
+  }
+  memset(parser, 0, sizeof(json_sax_parser));
+  parser->handler = handler;
+  parser->data = data;
+  parser->state = JSON_SAX_SPACE;
+  parser->line = 1;
+  return parser;
+}
+
+void json_sax_destroy(json_sax_parser *parser)
+{
+  if (!parser)
+  {
+    return;
+  }
+  free(parser->token.data);
+  free(parser->name.data);
+  free(parser->stack.data);
+  free(parser);
+}
+
+void json_sax_error(const json_sax_parser *parser, size_t *error_offset,
+                    char **error_desc, int *error_line)
+{
+  *error_offset = parser->error_offset;
+  *error_desc = parser->error_desc;
+  *error_line = parser->error_line;
+}
+
+// type of the innermost open container, or JSON_NULL at the top level
+static json_type json_sax_top(const json_sax_parser *parser)
+{
+  if (!parser->stack.size)
+  {
+    return JSON_NULL;
+  }
+  return (json_type)parser->stack.data[parser->stack.size - 1];
+}
+
+// report a scalar value completed in parser->token
+static bool json_sax_value(json_sax_parser *parser, json_value *value)
+{
+  value->name = parser->has_name ? parser->name.data : 0;
+  value->name_size = parser->has_name ? (uint32_t)parser->name.size : 0;
+  parser->has_name = false;
+  parser->state = JSON_SAX_SPACE;
+  if (parser->handler->value && !parser->handler->value(parser->data, value))
+  {
+    return json_sax_fail(parser, parser->token_offset, parser->token_line,
+                         "Stopped by handler");
+  }
+  return true;
+}
+
+// the closing quote of the string in parser->token was read
+static bool json_sax_string(json_sax_parser *parser)
+{
+  if (!parser->has_name && json_sax_top(parser) == JSON_OBJECT)
+  {
+    // field name in object, keep by swapping buffers
+    json_sax_buffer name = parser->name;
+    parser->name = parser->token;
+    parser->token = name;
+    parser->has_name = true;
+    parser->state = JSON_SAX_SPACE;
+    return true;
+  }
+  json_value value;
+  memset(&value, 0, sizeof(value));
+  value.type = JSON_STRING;
+  value.string_value = parser->token.data;
+  value.string_size = (uint32_t)parser->token.size;
+  return json_sax_value(parser, &value);
+}
+
+// the number in parser->token was ended by a delimiter or end of input
+static bool json_sax_number(json_sax_parser *parser)
+{
+  json_value value;
+  memset(&value, 0, sizeof(value));
+  value.type = JSON_INT;
+  char *first = parser->token.data;
+  char *last = first + parser->token.size;
+  for (char *c = first; c != last; ++c)
+  {
+    if (*c == '.' || *c == 'e' || *c == 'E')
+    {
+      value.type = JSON_FLOAT;
+    }
+  }
+  
+  if (value.type == JSON_INT)
+  {
+    char *end = atoi(first, last, &value.int_value);
+    if (!end)
+    {
+      value.type = JSON_FLOAT;              // beyond 64 bits
+    }
+    else if (end != last)
+    {
+      return json_sax_fail(parser, parser->token_offset, parser->token_line,
+                           "Bad integer number");
+    }
+  }
+  
+  if (value.type == JSON_FLOAT && atof(first, last, &value.float_value) != last)
+  {
+    return json_sax_fail(parser, parser->token_offset, parser->token_line,
+                         "Bad float number");
+  }
+  return json_sax_value(parser, &value);
+}
+
+// start a token at offset on the current line, in an open container
+static bool json_sax_token(json_sax_parser *parser, size_t offset,
+                           json_sax_state state)
+{
+  if (!parser->stack.size)
+  {
+    return json_sax_fail(parser, offset, parser->line,
+                         "Unexpected character");
+  }
+  parser->token.size = 0;
+  if (!json_buffer_reserve(&parser->token, 1))
+  {
+    return json_sax_fail(parser, offset, parser->line, "Out of memory");
+  }
+  parser->token.data[0] = 0;
+  parser->token_offset = offset;
+  parser->token_line = parser->line;
+  parser->state = state;
+  return true;
+}
+
+// handle one character between tokens
+static bool json_sax_space(json_sax_parser *parser, char c, size_t offset)
+{
+  const json_sax_handler *handler = parser->handler;
+  switch (c)
+  {
+    case '\x20':
+    case '\x9':
+    case '\xD':
+      return true;
+      
+    case '\xA':
+      ++parser->line;
+      return true;
+      
+    case '{':
+    case '[':
+    {
+      if (!parser->stack.size && parser->has_root)
+      {
+        return json_sax_fail(parser, offset + 1, parser->line,
+                             "Second root. Only one root allowed");
+      }
+      parser->has_root = true;
+      
+      json_type type = (c == '{') ? JSON_OBJECT : JSON_ARRAY;
+      char stack_type = (char)type;
+      if (!json_buffer_append(&parser->stack, &stack_type, 1))
+      {
+        return json_sax_fail(parser, offset, parser->line, "Out of memory");
+      }
+      
+      const char *name = parser->has_name ? parser->name.data : 0;
+      parser->has_name = false;
+      bool (*start)(void *, const char *) =
+        type == JSON_OBJECT ? handler->start_object : handler->start_array;
+      if (start && !start(parser->data, name))
+      {
+        return json_sax_fail(parser, offset, parser->line,
+                             "Stopped by handler");
+      }
+      return true;
+    }
+      
+    case '}':
+    case ']':
+    {
+      json_type type = (c == '}') ? JSON_OBJECT : JSON_ARRAY;
+      if (!parser->stack.size || json_sax_top(parser) != type)
+      {
+        return json_sax_fail(parser, offset, parser->line,
+                             "Mismatch closing brace/bracket");
+      }
+      --parser->stack.size;
+      
+      bool (*end)(void *) =
+        type == JSON_OBJECT ? handler->end_object : handler->end_array;
+      if (end && !end(parser->data))
+      {
+        return json_sax_fail(parser, offset, parser->line,
+                             "Stopped by handler");
+      }
+      return true;
+    }
+      
+    case ':':
+      if (json_sax_top(parser) != JSON_OBJECT)
+      {
+        return json_sax_fail(parser, offset, parser->line,
+                             "Unexpected character");
+      }
+      return true;
+      
+    case ',':
+      if (!parser->stack.size)
+      {
+        return json_sax_fail(parser, offset, parser->line,
+                             "Unexpected character");
+      }
+      return true;
+      
+    case '"':
+      if (!json_sax_token(parser, offset, JSON_SAX_STRING))
+      {
+        return false;
+      }
+      ++parser->token_offset;               // errors reported after '"'
+      return true;
+      
+    case 'n':
+    case 't':
+    case 'f':
+      if (!json_sax_token(parser, offset, JSON_SAX_LITERAL))
+      {
+        return false;
+      }
+      parser->literal = c == 'n' ? "null" : c == 't' ? "true" : "false";
+      return json_buffer_append(&parser->token, &c, 1) ||
+             json_sax_fail(parser, offset, parser->line, "Out of memory");
+      
+    case '-':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+      if (!json_sax_token(parser, offset, JSON_SAX_NUMBER))
+      {
+        return false;
+      }
+      return json_buffer_append(&parser->token, &c, 1) ||
+             json_sax_fail(parser, offset, parser->line, "Out of memory");
+      
+    default:
+      return json_sax_fail(parser, offset, parser->line,
+                           "Unexpected character");
+  }
+}
+
+bool json_sax_feed(json_sax_parser *parser, const char *chunk, size_t size)
+{
+  if (parser->state == JSON_SAX_ERROR)
+  {
+    return false;
+  }
+  
+  const char *it = chunk;
+  const char *end = chunk + size;
+  while (it != end)
+  {
+    size_t offset = parser->offset + (it - chunk);
+    switch (parser->state)
+    {
+      case JSON_SAX_SPACE:
+        if (!json_sax_space(parser, *it, offset))
+        {
+          return false;
+        }
+        ++it;
+        break;
+        
+      case JSON_SAX_STRING:
+      {
+        // copy plain characters in bulk
+        const char *plain = json_scan_string(it, end);
+        if (plain != it && !json_buffer_append(&parser->token, it, plain - it))
+        {
+          return json_sax_fail(parser, offset, parser->line, "Out of memory");
+        }
+        it = plain;
+        if (it == end)
+        {
+          break;
+        }
+        
+        if (*it == '"')
+        {
+          ++it;
+          if (!json_sax_string(parser))
+          {
+            return false;
+          }
+        }
+        else if (*it == '\\')
+        {
+          parser->escape_offset = parser->offset + (it - chunk);
+          parser->state = JSON_SAX_ESCAPE;
+          ++it;
+        }
+        else
+        {
+          return json_sax_fail(parser, parser->token_offset, parser->line,
+                               "Control characters not allowed in strings");
+        }
+      }
+        break;
+        
+      case JSON_SAX_ESCAPE:
+      {
+        char c;
+        switch (*it)
+        {
+          case '"':
+            c = '"';
+            break;
+          case '\\':
+            c = '\\';
+            break;
+          case '/':
+            c = '/';
+            break;
+          case 'b':
+            c = '\b';
+            break;
+          case 'f':
+            c = '\f';
+            break;
+          case 'n':
+            c = '\n';
+            break;
+          case 'r':
+            c = '\r';
+            break;
+          case 't':
+            c = '\t';
+            break;
+          case 'u':
+            parser->codepoint = 0;
+            parser->hex_digits = 0;
+            parser->state = JSON_SAX_UNICODE;
+            ++it;
+            continue;
+          default:
+            return json_sax_fail(parser, parser->token_offset, parser->line,
+                                 "Unrecognized escape sequence");
+        }
+        if (!json_buffer_append(&parser->token, &c, 1))
+        {
+          return json_sax_fail(parser, offset, parser->line, "Out of memory");
+        }
+        parser->state = JSON_SAX_STRING;
+        ++it;
+      }
+        break;
+        
+      case JSON_SAX_UNICODE:
+      {
+        unsigned int digit;
+        char hex = *it;
+        if (hatoui(&hex, &hex + 1, &digit) != &hex + 1)
+        {
+          return json_sax_fail(parser, parser->escape_offset, parser->line,
+                               "Bad unicode codepoint");
+        }
+        parser->codepoint = 16 * parser->codepoint + digit;
+        ++it;
+        if (++parser->hex_digits < 4)
+        {
+          break;
+        }
+        
+        unsigned int codepoint = parser->codepoint;
+        char utf8[3];
+        size_t n = 0;
+        if (codepoint <= 0x7F)
+        {
+          utf8[n++] = (char)codepoint;
+        }
+        else if (codepoint <= 0x7FF)
+        {
+          utf8[n++] = (char)(0xC0 | (codepoint >> 6));
+          utf8[n++] = (char)(0x80 | (codepoint & 0x3F));
+        }
+        else
+        {
+          utf8[n++] = (char)(0xE0 | (codepoint >> 12));
+          utf8[n++] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+          utf8[n++] = (char)(0x80 | (codepoint & 0x3F));
+        }
+        if (!json_buffer_append(&parser->token, utf8, n))
+        {
+          return json_sax_fail(parser, offset, parser->line, "Out of memory");
+        }
+        parser->state = JSON_SAX_STRING;
+      }
+        break;
+        
+      case JSON_SAX_NUMBER:
+      {
+        const char *first = it;
+        while (it != end && *it && !IS_SPACE(*it) && *it != ',' && *it != ']' && *it != '}')
+        {
+          ++it;
+        }
+        if (it != first && !json_buffer_append(&parser->token, first, it - first))
+        {
+          return json_sax_fail(parser, offset, parser->line, "Out of memory");
+        }
+        if (it != end && !json_sax_number(parser))
+        {
+          return false;                     // delimiter handled as space
+        }
+      }
+        break;
+        
+      case JSON_SAX_LITERAL:
+        if (*it != parser->literal[parser->token.size])
+        {
+          return json_sax_fail(parser, parser->token_offset,
+                               parser->token_line, "Unknown identifier");
+        }
+        ++it;
+        if (parser->literal[++parser->token.size] == 0)
+        {
+          json_value value;
+          memset(&value, 0, sizeof(value));
+          value.type = parser->literal[0] == 'n' ? JSON_NULL : JSON_BOOL;
+          value.int_value = parser->literal[0] == 't';
+          if (!json_sax_value(parser, &value))
+          {
+            return false;
+          }
+        }
+        break;
+        
+      case JSON_SAX_ERROR:
+        return false;
+    }
+  }
+  parser->offset += size;
+  return true;
+}
+
+bool json_sax_finish(json_sax_parser *parser)
+{
+  switch (parser->state)
+  {
+    case JSON_SAX_ERROR:
+      return false;
+    case JSON_SAX_ESCAPE:
+      return json_sax_fail(parser, parser->token_offset, parser->line,
+                           "Unrecognized escape sequence");
+    case JSON_SAX_UNICODE:
+      return json_sax_fail(parser, parser->escape_offset, parser->line,
+                           "Bad unicode codepoint");
+    case JSON_SAX_LITERAL:
+      return json_sax_fail(parser, parser->token_offset, parser->token_line,
+                           "Unknown identifier");
+    case JSON_SAX_NUMBER:
+      if (!json_sax_number(parser))
+      {
+        return false;
+      }
+      break;
+    default:
+      break;
+  }
+  
+  if (parser->stack.size || parser->state == JSON_SAX_STRING)
+  {
+    return json_sax_fail(parser, parser->offset, parser->line,
+                         "Not all objects/arrays have been properly closed");
+  }
+  return true;
+}
+
+bool json_sax_parse_file(json_sax_parser *parser, const char *path)
+{
+  mt::StallZone zone("json_sax_parse_file");
+  
+  FILE *fp = fopen(path, "rb");
+  if (!fp)
+  {
+    return json_sax_fail(parser, 0, 0, "Cannot open file");
+  }
+  
+  char chunk[64 * 1024];
+  bool ok = true;
+  size_t size;
+  while (ok && (size = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+  {
+    ok = json_sax_feed(parser, chunk, size);
+  }
+  if (ok && ferror(fp))
+  {
+    ok = json_sax_fail(parser, parser->offset, parser->line, "Read error");
+  }
+  fclose(fp);
+  return ok && json_sax_finish(parser);
+}
+
+//
+// On-demand access
+//
+
+// The document is indexed by the brackets outside strings, as two bit
+// masks per 64 byte block, found as in stage 1 of simdjson: quotes that
+// are not escaped delimit strings by a prefix xor. Values are positions
+// in the source. Navigation walks the members of one container at a time,
+// skipping nested containers by walking their bracket bits.
+struct json_tape_decoded
+{
+  size_t first;                             // after '"', or 0 if empty
+  const char *decoded;                      // NULL if invalid
+};
+
+struct json_tape
+{
+  const char *source;
+  size_t size;
+  uint64_t *brackets;                       // open, close mask per block
+  size_t blocks;
+  json_arena *strings;                      // decoded strings
+  json_tape_decoded *decoded;               // by first, at most half full
+  size_t decoded_slots;
+  size_t decoded_count;
+};
+
+// Bit masks of the characters in a 64 byte block, bit i for byte i
+struct json_block_masks
+{
+  uint64_t quote;
+  uint64_t backslash;
+  uint64_t open;                            // { [
+  uint64_t close;                           // } ]
+  uint64_t separator;                       // : , and white space
+  uint64_t control;
+};
+
+static inline void json_classify(const char *p, json_block_masks *m)
+{
+  memset(m, 0, sizeof(*m));
+#ifdef JSON_SIMD_WIDTH
+  for (int i = 0; i < 64; i += JSON_SIMD_WIDTH)
+  {
+    json_simd v = SIMD_LOADU(p + i);
+    json_simd lower = SIMD_OR(v, SIMD_SET1(0x20));  // '[' -> '{', ']' -> '}'
+    json_simd open = SIMD_EQ(lower, SIMD_SET1('{'));
+    json_simd close = SIMD_EQ(lower, SIMD_SET1('}'));
+    json_simd separator =
+      SIMD_OR(SIMD_OR(SIMD_OR(SIMD_EQ(v, SIMD_SET1(':')),
+                              SIMD_EQ(v, SIMD_SET1(','))),
+                      SIMD_OR(SIMD_EQ(v, SIMD_SET1('\x20')),
+                              SIMD_EQ(v, SIMD_SET1('\x9')))),
+              SIMD_OR(SIMD_EQ(v, SIMD_SET1('\xD')),
+                      SIMD_EQ(v, SIMD_SET1('\xA'))));
+    json_simd control = SIMD_EQ(SIMD_MAX(v, SIMD_SET1(0x1F)), SIMD_SET1(0x1F));
+    m->quote |= (uint64_t)SIMD_MASK(SIMD_EQ(v, SIMD_SET1('"'))) << i;
+    m->backslash |= (uint64_t)SIMD_MASK(SIMD_EQ(v, SIMD_SET1('\\'))) << i;
+    m->open |= (uint64_t)SIMD_MASK(open) << i;
+    m->close |= (uint64_t)SIMD_MASK(close) << i;
+    m->separator |= (uint64_t)SIMD_MASK(separator) << i;
+    m->control |= (uint64_t)SIMD_MASK(control) << i;
+  }
+#else
+  for (int i = 0; i < 64; ++i)
+  {
+    uint64_t bit = (uint64_t)1 << i;
+    char c = p[i];
+    m->quote |= c == '"' ? bit : 0;
+    m->backslash |= c == '\\' ? bit : 0;
+    m->open |= c == '{' || c == '[' ? bit : 0;
+    m->close |= c == '}' || c == ']' ? bit : 0;
+    m->separator |= c == ':' || c == ',' || IS_SPACE(c) ? bit : 0;
+    m->control |= (unsigned char)c < '\x20' ? bit : 0;
+  }
+#endif
+}
+
+// characters escaped by a backslash, carrying an escape across blocks
+static inline uint64_t json_escaped(uint64_t backslash, uint64_t *carry)
+{
+  uint64_t escaped = *carry;
+  backslash &= ~escaped;
+  *carry = 0;
+  while (backslash)
+  {
+    uint64_t bit = backslash & (0 - backslash);
+    uint64_t next = bit << 1;
+    if (!next)
+    {
+      *carry = 1;                           // escapes the next block
+      break;
+    }
+    escaped |= next;
+    backslash &= ~(bit | next);
+  }
+  return escaped;
+}
+
+// bit i set to the xor of bits 0..i
+static inline uint64_t json_prefix_xor(uint64_t x)
+{
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+#define TAPE_ERROR(pos, desc)\
+*error_offset = pos - source;\
+*error_desc = (char *)desc;\
+*error_line = 1;\
+for (const char *c = source; c != pos; ++c)\
+if (*c == '\n') ++*error_line;\
+free(stack);\
+json_tape_destroy(tape);\
+return 0
+
+json_tape *json_tape_parse(const char *source, size_t size,
+                           size_t *error_offset, char **error_desc,
+                           int *error_line)
+{
+  mt::StallZone zone("json_tape_parse");
+  
+  char *stack = 0;                          // open brackets
+  size_t depth = 0, stack_capacity = 0;
+  json_tape *tape = (json_tape *)malloc(sizeof(json_tape));
+  if (!tape)
+  {
+    TAPE_ERROR(source, "Out of memory");
+  }
+  memset(tape, 0, sizeof(json_tape));
+  tape->source = source;
+  tape->size = size;
+  tape->blocks = (size + 63) / 64;
+  tape->brackets = (uint64_t *)malloc(2 * tape->blocks * sizeof(uint64_t) + 1);
+  if (!tape->brackets)
+  {
+    TAPE_ERROR(source, "Out of memory");
+  }
+  
+  // the root must be an object or array, at the first character
+  if (!size)
+  {
+    TAPE_ERROR(source, 0);                  // empty, like json_parse
+  }
+  if (*source == '}' || *source == ']')
+  {
+    TAPE_ERROR(source, "Mismatch closing brace/bracket");
+  }
+  if (*source != '{' && *source != '[')
+  {
+    TAPE_ERROR(source, "Unexpected character");
+  }
+  
+  uint64_t escape_carry = 0;                // first byte is escaped
+  uint64_t string_carry = 0;                // all ones inside a string
+  uint64_t scalar_carry = 0;                // last byte was in a scalar
+  const char *string = 0;                   // after '"' of last string
+  bool has_root = false;
+  for (size_t block = 0; block < tape->blocks; ++block)
+  {
+    const char *first = source + 64 * block;
+    const char *p = first;
+    char padded[64];
+    uint64_t valid = ~(uint64_t)0;
+    if (size - 64 * block < 64)
+    {
+      memset(padded, '\x20', sizeof(padded));
+      memcpy(padded, first, size - 64 * block);
+      valid >>= 64 - (size - 64 * block);
+      p = padded;
+    }
+    
+    json_block_masks m;
+    json_classify(p, &m);
+    uint64_t quote = m.quote & ~json_escaped(m.backslash, &escape_carry);
+    uint64_t in_string = json_prefix_xor(quote) ^ string_carry;
+    string_carry = (uint64_t)((int64_t)in_string >> 63);
+    uint64_t outside = ~in_string & ~quote;
+    uint64_t scalar = outside & ~(m.open | m.close | m.separator);
+    uint64_t scalar_start = scalar & ~((scalar << 1) | scalar_carry);
+    scalar_carry = scalar >> 63;
+    uint64_t open_quote = quote & in_string;
+    
+    uint64_t open = m.open & outside & valid;
+    uint64_t close = m.close & outside & valid;
+    tape->brackets[2 * block] = open;
+    tape->brackets[2 * block + 1] = close;
+    
+    // brackets must match, and errors are reported in document order
+    uint64_t control = m.control & in_string & ~quote & valid;
+    uint64_t events = open | close | control | (scalar_start & valid);
+    while (events)
+    {
+      uint64_t bit = events & (0 - events);
+      events ^= bit;
+      int i = __builtin_ctzll(bit);
+      const char *it = first + i;
+      if (bit & control)
+      {
+        uint64_t before = open_quote & (bit - 1);
+        if (before)
+        {
+          string = first + (63 - __builtin_clzll(before)) + 1;
+        }
+        TAPE_ERROR(string, "Control characters not allowed in strings");
+      }
+      else if (bit & scalar_start)
+      {
+        char c = *it;
+        if (!IS_DIGIT(c) && c != '-' && c != 'n' && c != 't' && c != 'f')
+        {
+          TAPE_ERROR(it, "Unexpected character");
+        }
+      }
+      else if (bit & open)
+      {
+        if (!depth && has_root)
+        {
+          TAPE_ERROR(it + 1, "Second root. Only one root allowed");
+        }
+        has_root = true;
+        if (depth == stack_capacity)
+        {
+          stack_capacity = stack_capacity ? 2 * stack_capacity : 64;
+          char *grown = (char *)realloc(stack, stack_capacity);
+          if (!grown)
+          {
+            TAPE_ERROR(it, "Out of memory");
+          }
+          stack = grown;
+        }
+        stack[depth++] = *it;
+      }
+      else if (!depth || stack[--depth] != (*it == '}' ? '{' : '['))
+      {
+        TAPE_ERROR(it, "Mismatch closing brace/bracket");
+      }
+      else if (!depth)
+      {
+        // only white space follows the root, or a second root reported
+        // when it opens
+        const char *rest = it + 1;
+        while (rest != source + size && IS_SPACE(*rest))
+        {
+          ++rest;
+        }
+        if (rest != source + size && *rest != '{' && *rest != '[')
+        {
+          TAPE_ERROR(rest, "Unexpected character");
+        }
+      }
+    }
+    if (open_quote)
+    {
+      string = first + (63 - __builtin_clzll(open_quote)) + 1;
+    }
+  }
+  
+  if (depth || string_carry)
+  {
+    TAPE_ERROR(source + size, "Not all objects/arrays have been properly closed");
+  }
+  tape->strings = json_arena_create(4096);
+  if (!tape->strings)
+  {
+    TAPE_ERROR(source, "Out of memory");
+  }
+  free(stack);
+  
+  mem::Track(mem::JsonDOM, (uintptr_t)tape, 2 * tape->blocks * sizeof(uint64_t));
+  return tape;
+}
+
+void json_tape_destroy(json_tape *tape)
+{
+  if (!tape)
+  {
+    return;
+  }
+  mem::Untrack(mem::JsonDOM, (uintptr_t)tape);
+  json_arena_destroy(tape->strings);
+  free(tape->decoded);
+  free(tape->brackets);
+  free(tape);
+}
+
+// end of the string starting after '"' at it, at the closing '"',
+// or at the first control character or end of input if unterminated
+static const char *json_tape_string_end(const char *it, const char *end)
+{
+  for (;;)
+  {
+    it = json_scan_string(it, end);
+    if (it == end || *it != '\\')
+    {
+      return it;
+    }
+    it += 2;                                // skip escaped character
+    if (it >= end)
+    {
+      return end;
+    }
+  }
+}
+
+// end of the number at it
+static const char *json_tape_number_end(const char *it, const char *end)
+{
+  while (it != end && *it && !IS_SPACE(*it) && *it != ',' && *it != ']' && *it != '}')
+  {
+    ++it;
+  }
+  return it;
+}
+
+static inline size_t json_tape_skip_space(const json_tape *tape, size_t p)
+{
+  while (p < tape->size && IS_SPACE(tape->source[p]))
+  {
+    ++p;
+  }
+  return p;
+}
+
+// position after the bracket closing the container opened at p
+static size_t json_tape_skip_container(const json_tape *tape, size_t p)
+{
+  size_t depth = 0;
+  uint64_t from = ~(uint64_t)0 << (p % 64);
+  for (size_t block = p / 64; block < tape->blocks; ++block)
+  {
+    uint64_t open = tape->brackets[2 * block] & from;
+    uint64_t close = tape->brackets[2 * block + 1] & from;
+    from = ~(uint64_t)0;
+    for (uint64_t both = open | close; both; both &= both - 1)
+    {
+      uint64_t bit = both & (0 - both);
+      if (open & bit)
+      {
+        ++depth;
+      }
+      else if (--depth == 0)
+      {
+        return 64 * block + __builtin_ctzll(bit) + 1;
+      }
+    }
+  }
+  return tape->size;
+}
+
+// position after the value at p
+static size_t json_tape_skip_value(const json_tape *tape, size_t p)
+{
+  const char *source = tape->source;
+  const char *end = source + tape->size;
+  switch (source[p])
+  {
+    case '{':
+    case '[':
+      return json_tape_skip_container(tape, p);
+    case '"':
+    {
+      const char *last = json_tape_string_end(source + p + 1, end);
+      return last == end ? tape->size : last + 1 - source;
+    }
+  }
+  return json_tape_number_end(source + p, end) - source;
+}
+
+// the value of the member or element at p, after any "name":, or
+// JSON_TAPE_NONE if there is none, as for p of JSON_TAPE_NONE
+static size_t json_tape_value_at(const json_tape *tape, size_t p)
+{
+  p = json_tape_skip_space(tape, p);
+  if (p < tape->size && tape->source[p] == '"')
+  {
+    size_t q = json_tape_skip_space(tape, json_tape_skip_value(tape, p));
+    if (q < tape->size && tape->source[q] == ':')
+    {
+      p = json_tape_skip_space(tape, q + 1);
+    }
+  }
+  return p < tape->size ? p : JSON_TAPE_NONE;
+}
+
+json_type json_tape_type(const json_tape *tape, size_t value)
+{
+  value = json_tape_value_at(tape, value);
+  if (value == JSON_TAPE_NONE)
+  {
+    return JSON_NULL;
+  }
+  const char *it = tape->source + value;
+  switch (*it)
+  {
+    case '{':
+      return JSON_OBJECT;
+    case '[':
+      return JSON_ARRAY;
+    case '"':
+      return JSON_STRING;
+    case 'n':
+      return JSON_NULL;
+    case 't':
+    case 'f':
+      return JSON_BOOL;
+  }
+  const char *last = json_tape_number_end(it, tape->source + tape->size);
+  for (const char *c = it; c != last; ++c)
+  {
+    if (*c == '.' || *c == 'e' || *c == 'E')
+    {
+      return JSON_FLOAT;
+    }
+  }
+  
+  // integers beyond 64 bits are floats, as in json_parse
+  int64_t value_int;
+  return atoi((char *)it, (char *)last, &value_int) ? JSON_INT : JSON_FLOAT;
+}
+
+size_t json_tape_child(const json_tape *tape, size_t value)
+{
+  value = json_tape_value_at(tape, value);
+  char c = value != JSON_TAPE_NONE ? tape->source[value] : 0;
+  if (c != '{' && c != '[')
+  {
+    return JSON_TAPE_NONE;
+  }
+  size_t p = json_tape_skip_space(tape, value + 1);
+  if (p >= tape->size || tape->source[p] == '}' || tape->source[p] == ']')
+  {
+    return JSON_TAPE_NONE;
+  }
+  return p;
+}
+
+size_t json_tape_next(const json_tape *tape, size_t value)
+{
+  // siblings are separated by ',' but like json_parse do not require it
+  value = json_tape_value_at(tape, value);
+  if (value == JSON_TAPE_NONE)
+  {
+    return JSON_TAPE_NONE;
+  }
+  size_t p = json_tape_skip_space(tape, json_tape_skip_value(tape, value));
+  if (p < tape->size && tape->source[p] == ',')
+  {
+    p = json_tape_skip_space(tape, p + 1);
+  }
+  if (p >= tape->size || tape->source[p] == '}' || tape->source[p] == ']')
+  {
+    return JSON_TAPE_NONE;
+  }
+  return p;
+}
+
+size_t json_tape_size(const json_tape *tape, size_t value)
+{
+  size_t size = 0;
+  for (size_t child = json_tape_child(tape, value); child != JSON_TAPE_NONE;
+       child = json_tape_next(tape, child))
+  {
+    ++size;
+  }
+  return size;
+}
+
+size_t json_tape_element(const json_tape *tape, size_t array, size_t i)
+{
+  array = json_tape_value_at(tape, array);
+  if (array == JSON_TAPE_NONE || tape->source[array] != '[')
+  {
+    return JSON_TAPE_NONE;
+  }
+  size_t value = json_tape_child(tape, array);
+  for (; i && value != JSON_TAPE_NONE; --i)
+  {
+    value = json_tape_next(tape, value);
+  }
+  return value;
+}
+
+// compare the name of the member at p with the length bytes at name
+static bool json_tape_name_equal(json_tape *tape, size_t p, const char *name,
+                                 size_t length)
+{
+  const char *first = tape->source + p + 1;
+  const char *end = tape->source + tape->size;
+  const char *last = json_scan_string(first, end);
+  if (last != end && *last == '"')
+  {
+    return (size_t)(last - first) == length && !memcmp(first, name, length);
+  }
+  const char *decoded = json_tape_name(tape, p);   // has escapes
+  return decoded && strlen(decoded) == length && !memcmp(decoded, name, length);
+}
+
+static size_t json_tape_member_n(json_tape *tape, size_t object,
+                                 const char *name, size_t length)
+{
+  object = json_tape_value_at(tape, object);
+  if (object == JSON_TAPE_NONE || tape->source[object] != '{')
+  {
+    return JSON_TAPE_NONE;
+  }
+  for (size_t member = json_tape_child(tape, object); member != JSON_TAPE_NONE;
+       member = json_tape_next(tape, member))
+  {
+    if (tape->source[member] == '"' &&
+        json_tape_name_equal(tape, member, name, length))
+    {
+      return member;
+    }
+  }
+  return JSON_TAPE_NONE;
+}
+
+size_t json_tape_member(json_tape *tape, size_t object, const char *name)
+{
+  return json_tape_member_n(tape, object, name, strlen(name));
+}
+
+size_t json_tape_find(json_tape *tape, size_t value, const char *path)
+{
+  const char *it = path;
+  while (*it && value != JSON_TAPE_NONE)
+  {
+    if (*it == '[')
+    {
+      if (!IS_DIGIT(it[1]))
+      {
+        return JSON_TAPE_NONE;
+      }
+      size_t i = 0;
+      for (++it; IS_DIGIT(*it); ++it)
+      {
+        i = 10 * i + (*it - '0');
+      }
+      if (*it++ != ']')
+      {
+        return JSON_TAPE_NONE;
+      }
+      value = json_tape_element(tape, value, i);
+    }
+    else
+    {
+      if (*it == '.')
+      {
+        ++it;
+      }
+      const char *name = it;
+      while (*it && *it != '.' && *it != '[')
+      {
+        ++it;
+      }
+      value = json_tape_member_n(tape, value, name, it - name);
+    }
+  }
+  return value;
+}
+
+// first slot probed for the string after '"' at first, by Fibonacci hashing
+static inline size_t json_tape_decoded_slot(const json_tape *tape,
+                                            size_t first)
+{
+  return (size_t)((first * 11400714819323198485ull) >> 17) &
+         (tape->decoded_slots - 1);
+}
+
+// double the slots of the decoded strings, returning false if out of memory
+static bool json_tape_grow_decoded(json_tape *tape)
+{
+  json_tape_decoded *old = tape->decoded;
+  size_t old_slots = tape->decoded_slots;
+  size_t slots = old_slots ? 2 * old_slots : 64;
+  tape->decoded = (json_tape_decoded *)calloc(slots, sizeof(json_tape_decoded));
+  if (!tape->decoded)
+  {
+    tape->decoded = old;
+    return false;
+  }
+  tape->decoded_slots = slots;
+  for (size_t i = 0; i < old_slots; ++i)
+  {
+    if (old[i].first)
+    {
+      size_t j = json_tape_decoded_slot(tape, old[i].first);
+      while (tape->decoded[j].first)
+      {
+        j = (j + 1) & (slots - 1);
+      }
+      tape->decoded[j] = old[i];
+    }
+  }
+  free(old);
+  mem::Track(mem::JsonDOM, (uintptr_t)tape,
+             2 * tape->blocks * sizeof(uint64_t) +
+             slots * sizeof(json_tape_decoded));
+  return true;
+}
+
+// decode the string after '"' at first into the tape's arena, once, so
+// that accessing it again neither allocates nor decodes
+static const char *json_tape_decode(json_tape *tape, size_t first)
+{
+  if (2 * (tape->decoded_count + 1) > tape->decoded_slots &&
+      !json_tape_grow_decoded(tape))
+  {
+    return 0;
+  }
+  size_t i = json_tape_decoded_slot(tape, first);
+  for (; tape->decoded[i].first; i = (i + 1) & (tape->decoded_slots - 1))
+  {
+    if (tape->decoded[i].first == first)
+    {
+      return tape->decoded[i].decoded;
+    }
+  }
+  
+  const char *it = tape->source + first;
+  const char *end = tape->source + tape->size;
+  const char *last = json_tape_string_end(it, end);
+  char *out = (char *)json_arena_alloc(tape->strings, last - it + 1);
+  if (!out)
+  {
+    return 0;                               // not cached, may be retried
+  }
+  char *out_end = json_unescape(it, end, out);
+  if (out_end)
+  {
+    *out_end = 0;
+  }
+  tape->decoded[i].first = first;
+  tape->decoded[i].decoded = out_end ? out : 0;
+  tape->decoded_count++;
+  return tape->decoded[i].decoded;
+}
+
+const char *json_tape_name(json_tape *tape, size_t value)
+{
+  value = json_tape_skip_space(tape, value);
+  if (value >= tape->size || json_tape_value_at(tape, value) == value)
+  {
+    return 0;                               // array element or root
+  }
+  return json_tape_decode(tape, value + 1);
+}
+
+const char *json_tape_string(json_tape *tape, size_t value)
+{
+  value = json_tape_value_at(tape, value);
+  if (value == JSON_TAPE_NONE || tape->source[value] != '"')
+  {
+    return 0;
+  }
+  return json_tape_decode(tape, value + 1);
+}
+
+bool json_tape_int(const json_tape *tape, size_t value, int64_t *out)
+{
+  if (json_tape_type(tape, value) != JSON_INT)
+  {
+    return false;
+  }
+  value = json_tape_value_at(tape, value);
+  char *first = (char *)tape->source + value;
+  char *last = (char *)json_tape_number_end(first, tape->source + tape->size);
+  return atoi(first, last, out) == last;
+}
+
+bool json_tape_double(const json_tape *tape, size_t value, double *out)
+{
+  json_type type = json_tape_type(tape, value);
+  if (type != JSON_INT && type != JSON_FLOAT)
+  {
+    return false;
+  }
+  value = json_tape_value_at(tape, value);
+  char *first = (char *)tape->source + value;
+  char *last = (char *)json_tape_number_end(first, tape->source + tape->size);
+  return atof(first, last, out) == last;
+}
+
+bool json_tape_bool(const json_tape *tape, size_t value, bool *out)
+{
+  value = json_tape_value_at(tape, value);
+  if (value == JSON_TAPE_NONE)
+  {
+    return false;
+  }
+  const char *it = tape->source + value;
+  size_t left = tape->size - value;
+  if (left >= 4 && !memcmp(it, "true", 4))
+  {
+    *out = true;
+  }
+  else if (left >= 5 && !memcmp(it, "false", 5))
+  {
+    *out = false;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+//
+// Writer
+//
+
+// buffered output is written to the file descriptor in chunks of this size
+static const size_t JSON_WRITER_CHUNK = 64 * 1024;
+
+struct json_writer
+{
+  int fd;                                   // -1 to write to memory
+  bool pretty;
+  bool first;                               // no value in container yet
+  bool failed;
+  size_t depth;
+  char *buffer;
+  size_t size;
+  size_t capacity;
+};
+
+json_writer *json_writer_create(int fd, bool pretty)
+{
+  json_writer *writer = (json_writer *)malloc(sizeof(json_writer));
+  if (!writer)
+  {
+    return 0;
+  }
+  writer->fd = fd;
+  writer->pretty = pretty;
+  writer->first = true;
+  writer->failed = false;
+  writer->depth = 0;
+  writer->buffer = 0;
+  writer->size = 0;
+  writer->capacity = 0;
+  return writer;
+}
+
+void json_writer_destroy(json_writer *writer)
+{
+  if (!writer)
+  {
+    return;
+  }
+  json_writer_flush(writer);
+  free(writer->buffer);
+  free(writer);
+}
+
+void json_writer_reset(json_writer *writer)
+{
+  writer->first = true;
+  writer->failed = false;
+  writer->depth = 0;
+  writer->size = 0;
+}
+
+bool json_writer_flush(json_writer *writer)
+{
+  if (writer->fd < 0 || writer->failed)
+  {
+    return !writer->failed;
+  }
+  const char *it = writer->buffer;
+  const char *end = writer->buffer + writer->size;
+  while (it != end)
+  {
+    ssize_t written = write(writer->fd, it, end - it);
+    if (written < 0 && errno != EINTR)
+    {
+      writer->failed = true;
+      return false;
+    }
+    it += written > 0 ? written : 0;
+  }
+  writer->size = 0;
+  return true;
+}
+
+const char *json_writer_data(json_writer *writer, size_t *size)
+{
+  *size = writer->size;
+  if (!writer->buffer)
+  {
+    return "";
+  }
+  writer->buffer[writer->size] = 0;         // room kept by json_reserve
+  return writer->buffer;
+}
+
+// make room for size more characters, returning NULL on failure
+static char *json_reserve(json_writer *writer, size_t size)
+{
+  if (writer->failed)
+  {
+    return 0;
+  }
+  if (writer->size + size < writer->capacity)
+  {
+    return writer->buffer + writer->size;
+  }
+  if (writer->fd >= 0 && writer->size && !json_writer_flush(writer))
+  {
+    return 0;
+  }
+  if (writer->size + size >= writer->capacity)
+  {
+    size_t capacity = writer->capacity ? 2 * writer->capacity : JSON_WRITER_CHUNK;
+    while (writer->size + size >= capacity)
+    {
+      capacity *= 2;
+    }
+    char *buffer = (char *)realloc(writer->buffer, capacity);
+    if (!buffer)
+    {
+      writer->failed = true;
+      return 0;
+    }
+    writer->buffer = buffer;
+    writer->capacity = capacity;
+  }
+  return writer->buffer + writer->size;
+}
+
+static const char json_digit_pairs[] =
+  "00010203040506070809101112131415161718192021222324252627282930313233343536"
+  "37383940414243444546474849505152535455565758596061626364656667686970717273"
+  "7475767778798081828384858687888990919293949596979899";
+
+// write the digits of value, at least min_digits with leading zeros,
+// returning the end
+static char *json_format_uint(uint64_t value, int min_digits, char *out)
+{
+  char digits[24];
+  char *it = digits + sizeof(digits);
+  while (value >= 100)
+  {
+    it -= 2;
+    memcpy(it, json_digit_pairs + 2 * (value % 100), 2);
+    value /= 100;
+  }
+  if (value >= 10)
+  {
+    it -= 2;
+    memcpy(it, json_digit_pairs + 2 * value, 2);
+  }
+  else
+  {
+    *--it = (char)('0' + value);
+  }
+  while (digits + sizeof(digits) - it < min_digits)
+  {
+    *--it = '0';
+  }
+  size_t size = digits + sizeof(digits) - it;
+  memcpy(out, it, size);
+  return out + size;
+}
+
+static char *json_format_int(int64_t value, char *out)
+{
+  if (value < 0)
+  {
+    *out++ = '-';
+    return json_format_uint(0 - (uint64_t)value, 1, out);
+  }
+  return json_format_uint(value, 1, out);
+}
+
+// write the shortest digits that parse back to value, in fixed notation
+// where it is short, always with a '.' or exponent so that it is read as
+// a float, and null for infinity and NaN, returning the end; out must
+// hold 32 characters
+static char *json_format_double(double value, char *out)
+{
+  if (value != value || value - value != 0)
+  {
+    memcpy(out, "null", 4);
+    return out + 4;
+  }
+  
+  // value with k fractional digits is m / 10^k for an integer m below
+  // 2^53, which converts exactly like the fast path of atof; the first k
+  // for which m, or a neighbor when value * 10^k rounds, converts back
+  // to value gives the shortest digits
+  double magnitude = value < 0 ? -value : value;
+  if (magnitude >= 1e-5 && magnitude < 9007199254740992.0)
+  {
+    for (int k = 0; k <= 22; ++k)
+    {
+      double scaled = magnitude * json_exact_pow10[k];
+      if (scaled >= 9007199254740992.0)
+      {
+        break;
+      }
+      uint64_t m = (uint64_t)(scaled + 0.5);
+      for (int delta = 0; delta < 3; ++delta)
+      {
+        uint64_t candidate = delta == 0 ? m : delta == 1 ? m - 1 : m + 1;
+        if ((double)candidate / json_exact_pow10[k] != magnitude)
+        {
+          continue;
+        }
+        if (value < 0)
+        {
+          *out++ = '-';
+        }
+        char *end = json_format_uint(candidate, k + 1, out);
+        if (k == 0)
+        {
+          memcpy(end, ".0", 2);
+          return end + 2;
+        }
+        memmove(end - k + 1, end - k, k);
+        end[-k] = '.';
+        return end + 1;
+      }
+    }
+  }
+  
+  // otherwise the shortest of 15, 16 or 17 significant digits that
+  // converts back, as %g
+  char *end = out;
+  for (int precision = 15; precision <= 17; ++precision)
+  {
+    end = out + snprintf(out, 32, "%.*g", precision, value);
+    double parsed = 0;
+    const char *point = localeconv()->decimal_point;
+    for (char *c = out; c != end; ++c)
+    {
+      if (*c == point[0] && point[0] != '.')
+      {
+        *c = '.';
+      }
+    }
+    if (atof(out, end, &parsed) == end && parsed == value)
+    {
+      break;
+    }
+  }
+  bool is_float = false;
+  for (char *c = out; c != end; ++c)
+  {
+    is_float = is_float || *c == '.' || *c == 'e';
+  }
+  if (!is_float)
+  {
+    memcpy(end, ".0", 2);
+    end += 2;
+  }
+  return end;
+}
+
+static void json_write_raw(json_writer *writer, const char *text, size_t size)
+{
+  char *out = json_reserve(writer, size);
+  if (out)
+  {
+    memcpy(out, text, size);
+    writer->size += size;
+  }
+}
+
+// write the size bytes of text between quotes, escaping runs found by the
+// string scanner, or as they are if escaped, from json_parse_view
+static void json_write_quoted(json_writer *writer, const char *text,
+                              size_t size, bool escaped = false)
+{
+  static const char hex[] = "0123456789abcdef";
+  const char *end = text + size;
+  json_write_raw(writer, "\"", 1);
+  if (escaped)
+  {
+    json_write_raw(writer, text, size);
+    text = end;
+  }
+  for (;;)
+  {
+    const char *plain = json_scan_string(text, end);
+    json_write_raw(writer, text, plain - text);
+    if (plain == end)
+    {
+      break;
+    }
+    
+    char escape[6] = { '\\', 0, '0', '0', 0, 0 };
+    size_t size = 2;
+    switch (*plain)
+    {
+      case '"': escape[1] = '"'; break;
+      case '\\': escape[1] = '\\'; break;
+      case '\b': escape[1] = 'b'; break;
+      case '\f': escape[1] = 'f'; break;
+      case '\n': escape[1] = 'n'; break;
+      case '\r': escape[1] = 'r'; break;
+      case '\t': escape[1] = 't'; break;
+      default:
+        escape[1] = 'u';
+        escape[4] = hex[(unsigned char)*plain >> 4];
+        escape[5] = hex[*plain & 0xF];
+        size = 6;
+        break;
+    }
+    json_write_raw(writer, escape, size);
+    text = plain + 1;
+  }
+  json_write_raw(writer, "\"", 1);
+}
+
+// separator, indentation and name before a value
+static bool json_write_prefix(json_writer *writer, const char *name,
+                              size_t name_size, bool escaped)
+{
+  char *out = json_reserve(writer, 2 + 2 * writer->depth);
+  if (!out)
+  {
+    return false;
+  }
+  if (!writer->first)
+  {
+    *out++ = ',';
+  }
+  if (writer->pretty && writer->depth)
+  {
+    *out++ = '\n';
+    memset(out, ' ', 2 * writer->depth);
+    out += 2 * writer->depth;
+  }
+  writer->size = out - writer->buffer;
+  writer->first = false;
+  if (name)
+  {
+    json_write_quoted(writer, name, name_size, escaped);
+    json_write_raw(writer, ": ", writer->pretty ? 2 : 1);
+  }
+  return !writer->failed;
+}
+
+static bool json_write_prefix(json_writer *writer, const char *name)
+{
+  return json_write_prefix(writer, name, name ? strlen(name) : 0, false);
+}
+
+// prefix with the name of value
+static bool json_write_prefix(json_writer *writer, const json_value *value)
+{
+  return json_write_prefix(writer, value->name, value->name_size,
+                           value->escaped & JSON_NAME_ESCAPED);
+}
+
+// open a container after its prefix
+static bool json_write_open(json_writer *writer, char c)
+{
+  json_write_raw(writer, &c, 1);
+  writer->depth++;
+  writer->first = true;
+  return !writer->failed;
+}
+
+static bool json_write_start(json_writer *writer, const char *name, char c)
+{
+  return json_write_prefix(writer, name) && json_write_open(writer, c);
+}
+
+static bool json_write_end(json_writer *writer, char c)
+{
+  if (!writer->depth)
+  {
+    return false;
+  }
+  writer->depth--;
+  char *out = json_reserve(writer, 3 + 2 * writer->depth);
+  if (!out)
+  {
+    return false;
+  }
+  if (writer->pretty && !writer->first)
+  {
+    *out++ = '\n';
+    memset(out, ' ', 2 * writer->depth);
+    out += 2 * writer->depth;
+  }
+  *out++ = c;
+  if (writer->pretty && !writer->depth)
+  {
+    *out++ = '\n';
+  }
+  writer->size = out - writer->buffer;
+  writer->first = false;
+  return true;
+}
+
+bool json_write_start_object(json_writer *writer, const char *name)
+{
+  return json_write_start(writer, name, '{');
+}
+
+bool json_write_end_object(json_writer *writer)
+{
+  return json_write_end(writer, '}');
+}
+
+bool json_write_start_array(json_writer *writer, const char *name)
+{
+  return json_write_start(writer, name, '[');
+}
+
+bool json_write_end_array(json_writer *writer)
+{
+  return json_write_end(writer, ']');
+}
+
+bool json_write_string(json_writer *writer, const char *name, const char *value)
+{
+  if (!json_write_prefix(writer, name))
+  {
+    return false;
+  }
+  json_write_quoted(writer, value, strlen(value));
+  return !writer->failed;
+}
+
+// numbers after their prefix
+static bool json_write_int_text(json_writer *writer, int64_t value)
+{
+  char *out = json_reserve(writer, 24);
+  if (!out)
+  {
+    return false;
+  }
+  writer->size = json_format_int(value, out) - writer->buffer;
+  return true;
+}
+
+static bool json_write_double_text(json_writer *writer, double value)
+{
+  char *out = json_reserve(writer, 32);
+  if (!out)
+  {
+    return false;
+  }
+  writer->size = json_format_double(value, out) - writer->buffer;
+  return true;
+}
+
+bool json_write_int(json_writer *writer, const char *name, int64_t value)
+{
+  return json_write_prefix(writer, name) && json_write_int_text(writer, value);
+}
+
+bool json_write_double(json_writer *writer, const char *name, double value)
+{
+  return json_write_prefix(writer, name) &&
+         json_write_double_text(writer, value);
+}
+
+bool json_write_bool(json_writer *writer, const char *name, bool value)
+{
+  if (!json_write_prefix(writer, name))
+  {
+    return false;
+  }
+  json_write_raw(writer, value ? "true" : "false", value ? 4 : 5);
+  return !writer->failed;
+}
+
+bool json_write_null(json_writer *writer, const char *name)
+{
+  if (!json_write_prefix(writer, name))
+  {
+    return false;
+  }
+  json_write_raw(writer, "null", 4);
+  return !writer->failed;
+}
+
+bool json_write_value(json_writer *writer, const json_value *value)
+{
+  // depth first without recursion, closing containers on the way up
+  const json_value *it = value;
+  const bool top = !writer->depth;          // a document has no name
+  for (;;)
+  {
+    // names and strings are written by size, as they may be views
+    bool ok = it == value && top ? json_write_prefix(writer, (const char *)0) :
+                                   json_write_prefix(writer, it);
+    switch (it->type)
+    {
+      case JSON_OBJECT:
+      case JSON_ARRAY:
+        ok = ok && json_write_open(writer, it->type == JSON_OBJECT ? '{' : '[');
+        if (ok && it->first_child)
+        {
+          it = it->first_child;
+          continue;
+        }
+        ok = ok && json_write_end(writer, it->type == JSON_OBJECT ? '}' : ']');
+        break;
+      case JSON_STRING:
+        json_write_quoted(writer, it->string_value, it->string_size,
+                          it->escaped & JSON_STRING_ESCAPED);
+        ok = !writer->failed;
+        break;
+      case JSON_INT:
+        ok = ok && json_write_int_text(writer, it->int_value);
+        break;
+      case JSON_FLOAT:
+        ok = ok && json_write_double_text(writer, it->float_value);
+        break;
+      case JSON_BOOL:
+        json_write_raw(writer, it->int_value ? "true" : "false",
+                       it->int_value ? 4 : 5);
+        ok = !writer->failed;
+        break;
+      case JSON_NULL:
+        json_write_raw(writer, "null", 4);
+        ok = !writer->failed;
+        break;
+    }
+    while (ok && it != value && !it->next_sibling)
+    {
+      it = it->parent;
+      ok = json_write_end(writer, it->type == JSON_OBJECT ? '}' : ']');
+    }
+    if (!ok || it == value)
+    {
+      return ok;
+    }
+    it = it->next_sibling;
+  }
+}
+
+//
+// Binary cache
+//
+
+// A cache image is a header, the nodes, and a pool of zero terminated
+// strings. The children of a container are consecutive nodes after it,
+// and nodes refer to their children and strings by offsets from
+// themselves, so that an image can be used wherever it is mapped.
+struct json_cache_header
+{
+  char magic[4];                            // "JSC1"
+  uint32_t byte_order;                      // JSON_CACHE_BYTE_ORDER
+  uint32_t nodes;
+  uint32_t pool;                            // bytes of strings
+};
+
+struct json_cache_node
+{
+  uint32_t type;
+  uint32_t name;                            // offset of name or 0
+  union
+  {
+    struct
+    {
+      uint32_t offset;                      // of first child or string
+      uint32_t size;                        // children or string length
+    } range;
+    int64_t int_value;                      // JSON_INT and JSON_BOOL
+    double float_value;                     // JSON_FLOAT
+  };
+};
+
+static const uint32_t JSON_CACHE_BYTE_ORDER = 0x01020304;
+
+// growable buffer of the strings of an image, with names deduplicated
+struct json_cache_pool
+{
+  char *data;
+  size_t size;
+  size_t capacity;
+  uint32_t *names;                          // offset + 1 of names, or 0
+  size_t names_mask;
+  size_t names_count;
+  bool failed;
+};
+
+// append the size bytes of text and a zero, unescaping views with escapes,
+// whose size is updated
+static uint32_t json_cache_add(json_cache_pool *pool, const char *text,
+                               size_t *size, bool escaped)
+{
+  if (pool->size + *size + 1 > pool->capacity)
+  {
+    size_t capacity = pool->capacity ? 2 * pool->capacity : 4096;
+    while (pool->size + *size + 1 > capacity)
+    {
+      capacity *= 2;
+    }
+    char *data = (char *)realloc(pool->data, capacity);
+    if (!data)
+    {
+      pool->failed = true;
+      return 0;
+    }
+    pool->data = data;
+    pool->capacity = capacity;
+  }
+  uint32_t offset = (uint32_t)pool->size;
+  char *out = pool->data + offset;
+  char *last = escaped ? json_unescape(text, text + *size + 1, out) :
+                         (char *)memcpy(out, text, *size) + *size;
+  *last = 0;
+  *size = last - out;
+  pool->size += *size + 1;
+  return offset;
+}
+
+static uint32_t json_cache_add_name(json_cache_pool *pool, const char *name,
+                                    size_t size, bool escaped)
+{
+  if (2 * (pool->names_count + 1) > pool->names_mask + 1)
+  {
+    // rehash into twice the slots
+    size_t mask = pool->names_mask ? 2 * pool->names_mask + 1 : 255;
+    uint32_t *names = (uint32_t *)calloc(mask + 1, sizeof(uint32_t));
+    if (!names)
+    {
+      pool->failed = true;
+      return 0;
+    }
+    for (size_t i = 0; pool->names && i <= pool->names_mask; ++i)
+    {
+      if (pool->names[i])
+      {
+        const char *text = pool->data + pool->names[i] - 1;
+        size_t j = (size_t)json_hash(text, strlen(text)) & mask;
+        while (names[j])
+        {
+          j = (j + 1) & mask;
+        }
+        names[j] = pool->names[i];
+      }
+    }
+    free(pool->names);
+    pool->names = names;
+    pool->names_mask = mask;
+  }
+  
+  // add the name as it is unescaped, and take it back if already there
+  uint32_t offset = json_cache_add(pool, name, &size, escaped);
+  if (pool->failed)
+  {
+    return 0;
+  }
+  const char *text = pool->data + offset;
+  size_t i = (size_t)json_hash(text, size) & pool->names_mask;
+  for (; pool->names[i]; i = (i + 1) & pool->names_mask)
+  {
+    if (!memcmp(pool->data + pool->names[i] - 1, text, size + 1))
+    {
+      pool->size = offset;
+      return pool->names[i] - 1;
+    }
+  }
+  pool->names[i] = offset + 1;
+  pool->names_count++;
+  return offset;
+}
+
+void *json_cache_encode(const json_value *root, size_t *size)
+{
+  if (!root)
+  {
+    return 0;
+  }
+  mt::StallZone zone("json_cache_encode");
+  
+  // nodes are laid out breadth first, so that children are consecutive
+  size_t count = 0;
+  for (const json_value *it = root; it; )
+  {
+    ++count;
+    if (it->first_child)
+    {
+      it = it->first_child;
+      continue;
+    }
+    while (it != root && !it->next_sibling)
+    {
+      it = it->parent;
+    }
+    it = it == root ? 0 : it->next_sibling;
+  }
+  const json_value **order =
+    (const json_value **)malloc(count * sizeof(json_value *));
+  json_cache_node *nodes =
+    (json_cache_node *)calloc(count, sizeof(json_cache_node));
+  json_cache_pool pool;
+  memset(&pool, 0, sizeof(pool));
+  void *image = 0;
+  if (order && nodes)
+  {
+    size_t end = 1;
+    order[0] = root;
+    for (size_t i = 0; i < count; ++i)
+    {
+      const json_value *value = order[i];
+      json_cache_node *node = nodes + i;
+      node->type = value->type;
+      if (value->name)
+      {
+        node->name = json_cache_add_name(&pool, value->name, value->name_size,
+                                         value->escaped & JSON_NAME_ESCAPED) + 1;
+      }
+      switch (value->type)
+      {
+        case JSON_OBJECT:
+        case JSON_ARRAY:
+          node->range.offset = (uint32_t)end;
+          for (const json_value *it = value->first_child; it;
+               it = it->next_sibling)
+          {
+            order[end++] = it;
+          }
+          node->range.size = (uint32_t)(end - node->range.offset);
+          break;
+        case JSON_STRING:
+        {
+          size_t length = value->string_size;
+          node->range.offset = json_cache_add(&pool, value->string_value,
+                                              &length, value->escaped &
+                                              JSON_STRING_ESCAPED);
+          node->range.size = (uint32_t)length;
+        }
+          break;
+        case JSON_INT:
+        case JSON_BOOL:
+          node->int_value = value->int_value;
+          break;
+        case JSON_FLOAT:
+          node->float_value = value->float_value;
+          break;
+        case JSON_NULL:
+          break;
+      }
+    }
+    
+    // turn indices into offsets from each node
+    size_t pool_start = sizeof(json_cache_header) + count * sizeof(json_cache_node);
+    *size = pool_start + pool.size;
+    if (!pool.failed && *size <= UINT32_MAX && (image = malloc(*size)))
+    {
+      json_cache_header *header = (json_cache_header *)image;
+      memcpy(header->magic, "JSC1", 4);
+      header->byte_order = JSON_CACHE_BYTE_ORDER;
+      header->nodes = (uint32_t)count;
+      header->pool = (uint32_t)pool.size;
+      json_cache_node *out = (json_cache_node *)(header + 1);
+      for (size_t i = 0; i < count; ++i)
+      {
+        uint32_t from = (uint32_t)(sizeof(json_cache_header) +
+                                   i * sizeof(json_cache_node));
+        json_cache_node *node = nodes + i;
+        if (node->name)
+        {
+          node->name = (uint32_t)(pool_start + node->name - 1 - from);
+        }
+        if (node->type == JSON_OBJECT || node->type == JSON_ARRAY)
+        {
+          node->range.offset = (uint32_t)((node->range.offset - i) *
+                                          sizeof(json_cache_node));
+        }
+        else if (node->type == JSON_STRING)
+        {
+          node->range.offset = (uint32_t)(pool_start + node->range.offset - from);
+        }
+        out[i] = *node;
+      }
+      if (pool.size)
+      {
+        memcpy((char *)image + pool_start, pool.data, pool.size);
+      }
+    }
+  }
+  free(order);
+  free(nodes);
+  free(pool.data);
+  free(pool.names);
+  return image;
+}
+
+bool json_cache_save(const json_value *root, const char *path)
+{
+  size_t size = 0;
+  void *image = json_cache_encode(root, &size);
+  if (!image)
+  {
+    return false;
+  }
+  FILE *file = fopen(path, "wb");
+  bool ok = file && fwrite(image, 1, size, file) == size;
+  ok = file && !fclose(file) && ok;
+  free(image);
+  return ok;
+}
+
+// check every offset and string of an image, so that no access through
+// it leaves the image and every container is after its parent
+static bool json_cache_valid(const char *data, size_t size)
+{
+  const json_cache_header *header = (const json_cache_header *)data;
+  const json_cache_node *nodes = (const json_cache_node *)(header + 1);
+  size_t pool_start = sizeof(json_cache_header) +
+                      header->nodes * sizeof(json_cache_node);
+  if (!header->nodes || (header->pool && data[size - 1]))
+  {
+    return false;                           // strings must end in the pool
+  }
+  for (size_t i = 0; i < header->nodes; ++i)
+  {
+    const json_cache_node *node = nodes + i;
+    uint64_t from = sizeof(json_cache_header) + i * sizeof(json_cache_node);
+    uint64_t offset = from + node->range.offset;
+    if (node->name && (from + node->name < pool_start || from + node->name >= size))
+    {
+      return false;
+    }
+    switch (node->type)
+    {
+      case JSON_OBJECT:
+      case JSON_ARRAY:
+        if (node->range.offset % sizeof(json_cache_node) ||
+            (!node->range.offset && node->range.size) ||
+            i + node->range.offset / sizeof(json_cache_node) +
+            node->range.size > header->nodes)
+        {
+          return false;
+        }
+        break;
+      case JSON_STRING:
+        if (offset < pool_start || offset + node->range.size >= size ||
+            data[offset + node->range.size])
+        {
+          return false;
+        }
+        break;
+      case JSON_BOOL:
+        if ((uint64_t)node->int_value > 1)
+        {
+          return false;
+        }
+        break;
+      case JSON_NULL:
+      case JSON_INT:
+      case JSON_FLOAT:
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+const json_cache_node *json_cache_open(const void *data, size_t size,
+                                       bool validate)
+{
+  const json_cache_header *header = (const json_cache_header *)data;
+  if (!data || size < sizeof(json_cache_header) ||
+      (uintptr_t)data % sizeof(int64_t) || memcmp(header->magic, "JSC1", 4) ||
+      header->byte_order != JSON_CACHE_BYTE_ORDER ||
+      header->nodes > (size - sizeof(json_cache_header)) / sizeof(json_cache_node) ||
+      size != sizeof(json_cache_header) +
+              header->nodes * sizeof(json_cache_node) + (size_t)header->pool)
+  {
+    return 0;
+  }
+  if (validate)
+  {
+    mt::StallZone zone("json_cache_open");
+    if (!json_cache_valid((const char *)data, size))
+    {
+      return 0;
+    }
+  }
+  return (const json_cache_node *)(header + 1);
+}
+
+json_type json_cache_type(const json_cache_node *node)
+{
+  return (json_type)node->type;
+}
+
+const char *json_cache_name(const json_cache_node *node)
+{
+  return node->name ? (const char *)node + node->name : 0;
+}
+
+const char *json_cache_string(const json_cache_node *node)
+{
+  if (node->type != JSON_STRING)
+  {
+    return 0;
+  }
+  return (const char *)node + node->range.offset;
+}
+
+int64_t json_cache_int(const json_cache_node *node)
+{
+  if (node->type == JSON_FLOAT)
+  {
+    return (int64_t)node->float_value;
+  }
+  return node->type == JSON_INT || node->type == JSON_BOOL ? node->int_value : 0;
+}
+
+double json_cache_double(const json_cache_node *node)
+{
+  if (node->type == JSON_INT)
+  {
+    return (double)node->int_value;
+  }
+  return node->type == JSON_FLOAT ? node->float_value : 0;
+}
+
+bool json_cache_bool(const json_cache_node *node)
+{
+  return node->type == JSON_BOOL && node->int_value;
+}
+
+size_t json_cache_size(const json_cache_node *node)
+{
+  if (node->type != JSON_OBJECT && node->type != JSON_ARRAY)
+  {
+    return 0;
+  }
+  return node->range.size;
+}
+
+const json_cache_node *json_cache_child(const json_cache_node *node, size_t i)
+{
+  if (i >= json_cache_size(node))
+  {
+    return 0;
+  }
+  return (const json_cache_node *)((const char *)node + node->range.offset) + i;
+}
+
+const json_cache_node *json_cache_member(const json_cache_node *node,
+                                         const char *name)
+{
+  if (node->type != JSON_OBJECT)
+  {
+    return 0;
+  }
+  const json_cache_node *child =
+    (const json_cache_node *)((const char *)node + node->range.offset);
+  for (size_t i = 0; i < node->range.size; ++i, ++child)
+  {
+    if (child->name && !strcmp((const char *)child + child->name, name))
+    {
+      return child;
+    }
+  }
+  return 0;
+}
+
+//
+// Parallel parser
+//
+
+// smaller documents are parsed by json_parse
+static const size_t JSON_PARALLEL_MIN = 256 * 1024;
+
+// find up to count - 1 commas between the elements of the root array at
+// source, splitting it into count ranges of similar size, by the string
+// and bracket masks of the on-demand index; returns the commas found
+static size_t json_split_array(char *source, size_t size, size_t count,
+                               char **commas)
+{
+  size_t found = 0;
+  size_t target = size / count;             // next split at or after
+  size_t depth = 0;
+  uint64_t escape_carry = 0;
+  uint64_t string_carry = 0;
+  for (size_t block = 0; 64 * block < size && found + 1 < count; ++block)
+  {
+    char *first = source + 64 * block;
+    const char *p = first;
+    char padded[64];
+    uint64_t valid = ~(uint64_t)0;
+    if (size - 64 * block < 64)
+    {
+      memset(padded, '\x20', sizeof(padded));
+      memcpy(padded, first, size - 64 * block);
+      valid >>= 64 - (size - 64 * block);
+      p = padded;
+    }
+    
+    json_block_masks m;
+    json_classify(p, &m);
+    uint64_t quote = m.quote & ~json_escaped(m.backslash, &escape_carry);
+    uint64_t in_string = json_prefix_xor(quote) ^ string_carry;
+    string_carry = (uint64_t)((int64_t)in_string >> 63);
+    uint64_t outside = ~in_string & ~quote & valid;
+    uint64_t open = m.open & outside;
+    uint64_t close = m.close & outside;
+    if (64 * block + 64 <= target)
+    {
+      depth += __builtin_popcountll(open);
+      depth -= __builtin_popcountll(close);
+      continue;
+    }
+    
+    // separators include ':' and white space, skipped by character
+    uint64_t events = open | close | (m.separator & outside);
+    for (; events; events &= events - 1)
+    {
+      int i = __builtin_ctzll(events);
+      if (open & ((uint64_t)1 << i))
+      {
+        ++depth;
+      }
+      else if (close & ((uint64_t)1 << i))
+      {
+        --depth;
+      }
+      else if (p[i] == ',' && depth == 1 && 64 * block + i >= target)
+      {
+        commas[found++] = first + i;
+        if (found + 1 == count)
+        {
+          break;
+        }
+        target = (found + 1) * size / count;
+      }
+    }
+  }
+  // a document ending in a string is left to json_parse to report; the
+  // scan usually stops before the end, often inside a string
+  return found + 1 < count && string_carry ? 0 : found;
+}
+
+// a range of the elements of the root array, parsed by one task into
+// its own array in its own arena
+struct json_range
+{
+  char *first;
+  char *end;                                // the zero replacing its comma
+  bool partial;                             // ends before the last element
+  json_arena *arena;
+  json_value *root;                         // of the document
+  json_value *array;                        // of the range, or NULL
+  int newlines;
+  char *error_pos;
+  char *error_desc;
+  int error_line;
+};
+
+static void json_parse_range(json_range *range)
+{
+  range->array = json_alloc(range->arena);
+  if (!range->array)
+  {
+    range->error_pos = range->first;
+    range->error_desc = (char *)"Out of memory";
+    range->error_line = 1;
+    return;
+  }
+  range->array->type = JSON_ARRAY;
+  range->newlines = 0;
+  // lines are counted within the range, which is all this task reads and
+  // unescapes, from the bracket or zero before it, which the count skips
+  if (!json_parse_arena(range->first - 1, &range->error_pos, &range->error_desc,
+                        &range->error_line, range->arena, range->array,
+                        json_skip_space(range->first), range->partial,
+                        &range->newlines))
+  {
+    range->array = 0;
+    return;
+  }
+  for (json_value *it = range->array->first_child; it; it = it->next_sibling)
+  {
+    it->parent = range->root;
+  }
+}
+
+static void json_parse_range_at(void *ranges, size_t range)
+{
+  json_parse_range((json_range *)ranges + range);
+}
+
+json_value *json_parse_parallel(char *source,
+                                char **error_pos, char **error_desc,
+                                int *error_line, json_arena *arena,
+                                mt::TaskMgr *task_mgr, size_t tasks)
+{
+  mt::StallZone zone("json_parse_parallel");
+  
+  size_t size = strlen(source);
+  if (tasks < 2 || size < JSON_PARALLEL_MIN || *source != '[')
+  {
+    return json_parse(source, error_pos, error_desc, error_line, arena);
+  }
+  char **commas = (char **)malloc((tasks - 1) * sizeof(char *));
+  json_range *ranges = (json_range *)malloc(tasks * sizeof(json_range));
+  size_t count = commas && ranges ? json_split_array(source, size, tasks, commas) + 1 : 0;
+  if (count < 2)
+  {
+    free(commas);
+    free(ranges);
+    return json_parse(source, error_pos, error_desc, error_line, arena);
+  }
+  
+  // the root is first in a private arena, for json_free
+  bool private_arena = !arena;
+  if (private_arena)
+  {
+    arena = json_arena_create();
+  }
+  json_value *root = arena ? json_alloc(arena) : 0;
+  
+  // one arena per range, kept by the arena of the document for reuse
+  json_arena **next = arena ? &arena->parallel : 0;
+  for (size_t i = 0; root && i < count; ++i)
+  {
+    if (!*next && !(*next = json_arena_create()))
+    {
+      root = 0;
+      break;
+    }
+    json_range *range = ranges + i;
+    range->first = i ? commas[i - 1] + 1 : source + 1;
+    range->end = i + 1 < count ? commas[i] : source + size;
+    range->partial = i + 1 < count;
+    range->arena = *next;
+    range->root = root;
+    next = &(*next)->parallel;
+  }
+  if (!root)
+  {
+    if (private_arena)
+    {
+      json_arena_destroy(arena);            // NULL if out of memory
+    }
+    free(commas);
+    free(ranges);
+    *error_pos = source;
+    *error_desc = (char *)"Out of memory";
+    *error_line = 1;
+    return 0;
+  }
+  root->type = JSON_ARRAY;
+  
+  // ranges end at the zero replacing their comma; scanners may read past
+  // it, as past the end of the document, and ignore what they read
+  for (size_t i = 0; i + 1 < count; ++i)
+  {
+    *commas[i] = 0;
+  }
+  mt::RunRanges(task_mgr, "json_parse_parallel", count, json_parse_range_at,
+                ranges);
+  
+  // the first error is in the first range that failed, whose lines follow
+  // those of the ranges before it, counted as json_parse would once they
+  // are all parsed: without the newlines they unescaped
+  int lines = 0;
+  for (size_t i = 0; i < count && root; ++i)
+  {
+    json_range *range = ranges + i;
+    if (!range->array)
+    {
+      *error_pos = range->error_pos;
+      *error_desc = range->error_desc;
+      *error_line = range->error_line + lines;
+      root = 0;
+    }
+    else if (range->array->first_child)
+    {
+      if (root->last_child)
+      {
+        root->last_child->next_sibling = range->array->first_child;
+      }
+      else
+      {
+        root->first_child = range->array->first_child;
+      }
+      root->last_child = range->array->last_child;
+    }
+    lines -= range->newlines;
+    for (const char *c = range->first; c != range->end; ++c)
+    {
+      if (*c == '\n')
+      {
+        ++lines;
+      }
+    }
+  }
+  free(commas);
+  free(ranges);
+  
+  if (private_arena)
+  {
+    if (!root)
+    {
+      json_arena_destroy(arena);
+      return 0;
+    }
+    arena->root = root;
+    root->escaped |= JSON_PRIVATE_ARENA;
+  }
   return root;
 }
@@ -4,6 +4,14 @@
 #ifndef JSON_H
 #define JSON_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+struct json_index;
+
+namespace mt { class TaskMgr; }
+class MappedFile;
+
 enum json_type
 {
   JSON_NULL,
@@ -26,14 +34,216 @@ struct json_value
   union
   {
     char *string_value;
-    int int_value;
-    float float_value;
+    int64_t int_value;                      // JSON_INT and JSON_BOOL
+    double float_value;                     // JSON_FLOAT
+    json_index *index;                      // JSON_OBJECT, see json_find
   };
   
   json_type type;
+  uint32_t name_size;                       // Lengths of name and
+  uint32_t string_size;                     // string_value, in bytes
+  unsigned char escaped;                    // Flags below
+};
+
+// Flags of json_value::escaped
+enum
+{
+  JSON_NAME_ESCAPED = 1,
+  JSON_STRING_ESCAPED = 2,
+  JSON_PRIVATE_ARENA = 4,                   // Root for json_free
 };
 
+// Bump-pointer allocator owning the json_value nodes of parsed documents.
+// Reset releases every node at once and keeps the memory for reuse by the
+// next json_parse, avoiding per-node malloc and heap fragmentation.
+// The arena capacity is reported to mem::JsonDOM (see Memory.h).
+struct json_arena;
+
+json_arena *json_arena_create(size_t block_size = 0); // 0 = default size
+void json_arena_reset(json_arena *arena);             // Free all nodes
+void json_arena_destroy(json_arena *arena);           // Free all memory
+size_t json_arena_bytes(const json_arena *arena);     // Total capacity
+size_t json_arena_blocks(const json_arena *arena);    // malloc'ed blocks
+
+// Parses source in place, modifying it, and returns the root value or NULL
+// on error. Nodes are allocated in arena, and remain valid until it is
+// reset or destroyed. If arena is NULL, a private arena is created for
+// the document, which must then be released with json_free(root), which
+// ignores any other value.
 json_value *json_parse(char *source,
-                       char **error_pos, char **error_desc, int *error_line);
+                       char **error_pos, char **error_desc, int *error_line,
+                       json_arena *arena = 0);
+void json_free(json_value *root);                     // Private arena only
+
+// Parses size bytes at source like json_parse, without modifying them or
+// needing a terminating zero, e.g. from a read-only file mapped in memory.
+// Errors are reported by offset, like json_tape_parse. Strings and names
+// are views: they point into source, which must outlive the tree, and are
+// not zero terminated. Those with escape sequences are checked, but left
+// escaped and flagged in escaped until read by json_string or json_name.
+json_value *json_parse_view(const char *source, size_t size,
+                            size_t *error_offset, char **error_desc,
+                            int *error_line, json_arena *arena = 0);
+
+// Maps the file at path into file, read-only, and parses it without a copy
+// by json_parse_view. The views point into the mapping, so file must stay
+// open while the tree is used. Errors are reported as by json_parse_view,
+// or as "Cannot open file".
+json_value *json_parse_file(const char *path, MappedFile *file,
+                            size_t *error_offset, char **error_desc,
+                            int *error_line, json_arena *arena = 0);
+
+// Return the string or name of a value, or NULL if it has none, and its
+// length in size. Escaped views are unescaped into the arena of their
+// document on the first call, which is not thread safe, and are zero
+// terminated from then on. Other views are returned as they are.
+const char *json_string(json_value *value, size_t *size = 0);
+const char *json_name(json_value *value, size_t *size = 0);
+
+// Parses a document whose root is a large array like json_parse, with its
+// elements split into up to tasks ranges that are parsed concurrently,
+// one on the calling thread and the others on the workers of task_mgr,
+// or all on the calling thread if it is NULL. Each range is parsed into
+// an arena of its own, kept by arena, and its elements are appended to
+// the root. Other documents are passed to json_parse. Must not be called
+// from a task of task_mgr, whose workers could all be waiting.
+json_value *json_parse_parallel(char *source,
+                                char **error_pos, char **error_desc,
+                                int *error_line, json_arena *arena,
+                                mt::TaskMgr *task_mgr, size_t tasks);
+
+// Returns the first member of object with the given name, or NULL.
+// Objects with many members are indexed on the first call by a hash table
+// allocated in the arena of the document, making later calls O(1) on
+// average. Indexing modifies the object, so the first call on an object
+// is not thread safe, and members must not be added after it.
+json_value *json_find(json_value *object, const char *name);
+
+// Event-based streaming parser, for documents too large to hold in memory
+// with their tree. Input is fed in chunks of any size, e.g. as read from a
+// file or socket, and each value is reported to the handler as soon as it
+// is complete. No tree is built: strings and names passed to the handler
+// are only valid during the call. Member names are passed with the value
+// they name, and are NULL for array elements. A handler returns false to
+// stop parsing. Unused handler functions may be NULL.
+struct json_sax_handler
+{
+  bool (*start_object)(void *data, const char *name);
+  bool (*end_object)(void *data);
+  bool (*start_array)(void *data, const char *name);
+  bool (*end_array)(void *data);
+  bool (*value)(void *data, const json_value *value); // No children
+};
+
+struct json_sax_parser;
+
+json_sax_parser *json_sax_create(const json_sax_handler *handler, void *data);
+void json_sax_destroy(json_sax_parser *parser);
+
+// Returns false on error, reported with the same descriptions as json_parse
+// and the offset from the start of the stream instead of a pointer.
+bool json_sax_feed(json_sax_parser *parser, const char *chunk, size_t size);
+bool json_sax_finish(json_sax_parser *parser);        // Call at end of input
+bool json_sax_parse_file(json_sax_parser *parser, const char *path);
+void json_sax_error(const json_sax_parser *parser, size_t *error_offset,
+                    char **error_desc, int *error_line);
+
+// On-demand access for reading a few fields of a large document. A single
+// vectorized pass indexes the brackets outside strings, without decoding
+// strings or numbers or allocating nodes. Values are identified by their
+// position in the source, with the root at 0, and are decoded only when
+// accessed; walking a container skips nested ones by the bracket index.
+// The source is not modified and must outlive the tape. json_tape_parse
+// checks strings, brackets and the characters that start values, with the
+// same error descriptions as json_parse. The rest of the grammar, escapes
+// and numbers are checked when accessed, and the accessors fail for
+// invalid ones.
+#define JSON_TAPE_NONE ((size_t)-1)
+
+struct json_tape;
+
+json_tape *json_tape_parse(const char *source, size_t size,
+                           size_t *error_offset, char **error_desc,
+                           int *error_line);
+void json_tape_destroy(json_tape *tape);
+
+// Values past the end of the source, as JSON_TAPE_NONE, are null, with no
+// children, name or string
+json_type json_tape_type(const json_tape *tape, size_t value);
+size_t json_tape_size(const json_tape *tape, size_t value); // Children, O(n)
+size_t json_tape_child(const json_tape *tape, size_t value); // First child
+size_t json_tape_next(const json_tape *tape, size_t value); // Next sibling
+size_t json_tape_element(const json_tape *tape, size_t array, size_t i);
+size_t json_tape_member(json_tape *tape, size_t object, const char *name);
+
+// Path of members and elements from value, e.g. "albums[3].name",
+// or JSON_TAPE_NONE if any step is missing
+size_t json_tape_find(json_tape *tape, size_t value, const char *path);
+
+// Strings are decoded into memory owned by the tape when first accessed
+const char *json_tape_name(json_tape *tape, size_t value); // NULL if none
+const char *json_tape_string(json_tape *tape, size_t value);
+bool json_tape_int(const json_tape *tape, size_t value, int64_t *out);
+bool json_tape_double(const json_tape *tape, size_t value, double *out);
+bool json_tape_bool(const json_tape *tape, size_t value, bool *out);
+
+// Streaming writer of compact or indented JSON, to a file descriptor or
+// to a growable buffer in memory when fd is -1. Calls mirror
+// json_sax_handler: values are written with their member name inside
+// objects, and NULL in arrays. Strings are UTF-8 and escaped as needed,
+// and doubles are written with the fewest digits that parse back to the
+// same value, as null if not finite. Functions return false on a write
+// error or out of memory, which is sticky until reset.
+struct json_writer;
+
+json_writer *json_writer_create(int fd = -1, bool pretty = false);
+void json_writer_destroy(json_writer *writer);        // Flushes
+void json_writer_reset(json_writer *writer);          // Empty, no error
+bool json_writer_flush(json_writer *writer);          // Write buffer to fd
+const char *json_writer_data(json_writer *writer, size_t *size); // In memory
+
+bool json_write_start_object(json_writer *writer, const char *name);
+bool json_write_end_object(json_writer *writer);
+bool json_write_start_array(json_writer *writer, const char *name);
+bool json_write_end_array(json_writer *writer);
+bool json_write_string(json_writer *writer, const char *name, const char *value);
+bool json_write_int(json_writer *writer, const char *name, int64_t value);
+bool json_write_double(json_writer *writer, const char *name, double value);
+bool json_write_bool(json_writer *writer, const char *name, bool value);
+bool json_write_null(json_writer *writer, const char *name);
+// Write the tree of value, with its name unless it is written at the top
+// level, where it is the document
+bool json_write_value(json_writer *writer, const json_value *value);
+
+// Binary cache of a parsed document, for reading it again without parsing
+// or allocating, e.g. from a file mapped in memory. An image holds nodes
+// and strings at offsets from each other, so it can be used at any
+// address aligned to 8 bytes, and on machines of the same byte order.
+// The children of a container are consecutive, so that json_cache_child
+// is O(1). Strings are zero terminated in the image and are returned
+// without copying. Images are at most 4GB.
+struct json_cache_node;
+
+// Returns an image allocated with malloc, or NULL if root is NULL or if
+// out of memory
+void *json_cache_encode(const json_value *root, size_t *size);
+bool json_cache_save(const json_value *root, const char *path);
+
+// Returns the root of the image, or NULL if its header or size is wrong.
+// With validate, every node is checked to be safe to read, for images
+// that may be corrupt; this reads the whole image.
+const json_cache_node *json_cache_open(const void *data, size_t size,
+                                       bool validate = true);
+
+json_type json_cache_type(const json_cache_node *node);
+const char *json_cache_name(const json_cache_node *node);   // NULL if none
+const char *json_cache_string(const json_cache_node *node); // NULL if not
+int64_t json_cache_int(const json_cache_node *node);
+double json_cache_double(const json_cache_node *node);
+bool json_cache_bool(const json_cache_node *node);
+size_t json_cache_size(const json_cache_node *node);        // Children
+const json_cache_node *json_cache_child(const json_cache_node *node, size_t i);
+const json_cache_node *json_cache_member(const json_cache_node *node,
+                                         const char *name);
 
 #endif
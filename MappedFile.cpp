@@ -0,0 +1,133 @@
+//  Copyright (c) 2013 The 11ers. All rights reserved.
+
+#include "MappedFile.h"
+#include "Watchdog.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+static int AdviceFlag(MappedFile::Advice advice) {
+  switch (advice) {
+    case MappedFile::Normal:     return MADV_NORMAL;
+    case MappedFile::Sequential: return MADV_SEQUENTIAL;
+    case MappedFile::Random:     return MADV_RANDOM;
+    case MappedFile::WillNeed:   return MADV_WILLNEED;
+    case MappedFile::DontNeed:   return MADV_DONTNEED;
+  }
+  return MADV_NORMAL;
+}
+
+
+// Read the rest of fd into buf, returning the number of bytes read
+static size_t ReadAll(int fd, unsigned char *buf, size_t size) {
+  size_t done = 0;
+  while (done < size) {
+    ssize_t len = read(fd, buf + done, size - done);
+    if (len <= 0)
+      break;
+    done += size_t(len);
+  }
+  return done;
+}
+
+
+// Read a file of unknown size into a growing buffer
+bool MappedFile::ReadStream(int fd) {
+  size_t capacity = 64 * 1024;
+  mSize = 0;
+  for (;;) {
+    unsigned char *data = (unsigned char *)realloc(mData, capacity);
+    if (!data)
+      return false;
+    mData = data;
+    const size_t len = ReadAll(fd, mData + mSize, capacity - mSize);
+    mSize += len;
+    if (mSize < capacity)
+      break;
+    capacity *= 2;
+  }
+  if (!mSize) {
+    free(mData);
+    mData = 0;
+  }
+  return true;
+}
+
+
+bool MappedFile::Open(const char *filename, Mode mode, Advice advice) {
+  mt::StallZone zone("MappedFile::Open");
+  Close();
+  int fd = open(filename, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+  struct stat sbuf;
+  if (fstat(fd, &sbuf) < 0 || S_ISDIR(sbuf.st_mode)) {
+    close(fd);
+    return false;
+  }
+
+  mSize = size_t(sbuf.st_size);
+  mIsWritable = mode == CopyOnWrite;
+  if (S_ISREG(sbuf.st_mode) && mSize) {
+    const int prot = mIsWritable ? PROT_READ | PROT_WRITE : PROT_READ;
+    const int flags = mIsWritable ? MAP_PRIVATE : MAP_SHARED;
+    void *map = mmap(NULL, mSize, prot, flags, fd, 0);
+    if (map != MAP_FAILED) {
+      mData = (unsigned char *)map;
+      mIsMapped = true;
+    }
+  }
+  if (!mIsMapped) {
+    // Read it instead, to the end if its size is unknown, as for pipes
+    // and the files of /proc
+    bool ok;
+    if (S_ISREG(sbuf.st_mode) && mSize) {
+      mData = (unsigned char *)malloc(mSize);
+      ok = mData && ReadAll(fd, mData, mSize) == mSize;
+    } else {
+      ok = ReadStream(fd);
+    }
+    if (!ok) {
+      close(fd);
+      Close();
+      return false;
+    }
+  }
+  close(fd);                                          // Mapping keeps file
+  mIsOpen = true;
+  if (advice != Normal)
+    Advise(advice);
+  return true;
+}
+
+
+void MappedFile::Close() {
+  if (mIsMapped)
+    munmap(mData, mSize);
+  else
+    free(mData);
+  mData = 0;
+  mSize = 0;
+  mIsMapped = false;
+  mIsWritable = false;
+  mIsOpen = false;
+}
+
+
+bool MappedFile::Advise(Advice advice, size_t offset, size_t len) {
+  if (!mIsMapped)
+    return mIsOpen;                                   // Already in memory
+  if (advice == DontNeed && mIsWritable)
+    return false;                                     // Would drop writes
+  if (offset >= mSize)
+    return false;
+  if (!len || len > mSize - offset)
+    len = mSize - offset;
+  const size_t page = size_t(sysconf(_SC_PAGESIZE));
+  const size_t start = offset / page * page;          // Aligned down
+  return madvise(mData + start, len + offset - start, AdviceFlag(advice)) == 0;
+}
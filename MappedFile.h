@@ -0,0 +1,66 @@
+//  Copyright (c) 2013 The 11ers. All rights reserved.
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <stddef.h>
+
+
+// Maps a whole file into memory, so that it can be parsed or decoded
+// without reading it into a buffer first. Pages are read from the page
+// cache on first access, as hinted by the advice. Read-only mappings
+// share their pages with the cache. Copy-on-write mappings can also be
+// modified, which copies the pages written and never changes the file.
+// Files that cannot be mapped, like pipes, are read into a buffer
+// instead. The file is unmapped by Close or the destructor.
+//
+// The file must not be truncated while it is mapped, which would raise
+// SIGBUS on access to the pages beyond its new end.
+
+class MappedFile {
+public:
+  enum Mode {
+    ReadOnly,                                         // Shared with cache
+    CopyOnWrite,                                      // Private writes
+  };
+
+  enum Advice {                                       // madvise hints
+    Normal,
+    Sequential,                                       // Read ahead more
+    Random,                                           // Do not read ahead
+    WillNeed,                                         // Read ahead now
+    DontNeed,                                         // Free pages read
+  };
+
+  MappedFile() : mData(0), mSize(0), mIsMapped(false), mIsWritable(false),
+                 mIsOpen(false) {}
+  ~MappedFile() { Close(); }
+
+  bool Open(const char *filename, Mode mode = ReadOnly,
+            Advice advice = Sequential);             // False on error
+  void Close();                                       // Unmap or free
+
+  // Hint the use of len bytes from offset, to the end if len is zero.
+  // DontNeed is refused for CopyOnWrite, whose private pages it discards.
+  bool Advise(Advice advice, size_t offset = 0, size_t len = 0);
+
+  bool IsOpen() const { return mIsOpen; }
+  bool IsMapped() const { return mIsMapped; }         // Else read
+  const unsigned char *Data() const { return mData; } // NULL if empty
+  unsigned char *MutableData() { return mIsWritable ? mData : 0; }
+  size_t Size() const { return mSize; }
+
+private:
+  MappedFile(const MappedFile &);                     // Disallow copy
+  bool ReadStream(int fd);                            // Unknown size
+  void operator=(const MappedFile &);                 // Disallow assignment
+
+  unsigned char *mData;                               // Mapping or buffer
+  size_t mSize;                                       // File size in bytes
+  bool mIsMapped;                                     // Else malloc'd
+  bool mIsWritable;                                   // CopyOnWrite
+  bool mIsOpen;                                       // Even if empty
+};
+
+
+#endif  // MAPPEDFILE_H
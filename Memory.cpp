@@ -0,0 +1,132 @@
+//  Copyright (c) 2013 The 11ers. All rights reserved.
+
+#include "Memory.h"
+
+#include "Thread.h"
+
+#include <map>
+#include <string.h>
+
+
+typedef std::map<uintptr_t, size_t> KeyBytesMap;
+
+static mt::Mutex gLock;                               // Protects all below
+static size_t gBytes[mem::CategoryCount];
+static size_t gHighWater[mem::CategoryCount];
+static KeyBytesMap gKeyBytes[mem::CategoryCount];
+
+static const char *gCategoryName[mem::CategoryCount] = {
+  "GL textures", "GL buffers", "Decoded images", "Geometry", "JSON DOM"
+};
+
+
+// Adjust the current total for a category, lock must be held
+static void Adjust(mem::Category category, ptrdiff_t bytes) {
+  if (bytes < 0 && size_t(-bytes) > gBytes[category])
+    gBytes[category] = 0;                             // Clamp mismatched frees
+  else
+    gBytes[category] += bytes;
+  if (gBytes[category] > gHighWater[category])
+    gHighWater[category] = gBytes[category];
+}
+
+
+const char *mem::CategoryName(Category category) {
+  return category < CategoryCount ? gCategoryName[category] : "Unknown";
+}
+
+
+void mem::Add(Category category, ptrdiff_t bytes) {
+  mt::MutexLockGuard guard(gLock);
+  Adjust(category, bytes);
+}
+
+
+void mem::Track(Category category, uintptr_t key, size_t bytes) {
+  mt::MutexLockGuard guard(gLock);
+  size_t &tracked = gKeyBytes[category][key];
+  Adjust(category, ptrdiff_t(bytes) - ptrdiff_t(tracked));
+  tracked = bytes;
+}
+
+
+size_t mem::Untrack(Category category, uintptr_t key) {
+  mt::MutexLockGuard guard(gLock);
+  KeyBytesMap::iterator i = gKeyBytes[category].find(key);
+  if (i == gKeyBytes[category].end())
+    return 0;
+  const size_t bytes = i->second;
+  gKeyBytes[category].erase(i);
+  Adjust(category, -ptrdiff_t(bytes));
+  return bytes;
+}
+
+
+size_t mem::Tracked(Category category, uintptr_t key) {
+  mt::MutexLockGuard guard(gLock);
+  KeyBytesMap::const_iterator i = gKeyBytes[category].find(key);
+  return i == gKeyBytes[category].end() ? 0 : i->second;
+}
+
+
+size_t mem::Bytes(Category category) {
+  mt::MutexLockGuard guard(gLock);
+  return gBytes[category];
+}
+
+
+size_t mem::HighWater(Category category) {
+  mt::MutexLockGuard guard(gLock);
+  return gHighWater[category];
+}
+
+
+size_t mem::TotalBytes() {
+  mt::MutexLockGuard guard(gLock);
+  size_t total = 0;
+  for (size_t i = 0; i < CategoryCount; ++i)
+    total += gBytes[i];
+  return total;
+}
+
+
+mem::Snapshot::Snapshot() {
+  memset(bytes, 0, sizeof(bytes));
+  memset(highWater, 0, sizeof(highWater));
+  memset(objects, 0, sizeof(objects));
+}
+
+
+size_t mem::Snapshot::Total() const {
+  size_t total = 0;
+  for (size_t i = 0; i < CategoryCount; ++i)
+    total += bytes[i];
+  return total;
+}
+
+
+void mem::TakeSnapshot(Snapshot *snapshot) {
+  mt::MutexLockGuard guard(gLock);
+  for (size_t i = 0; i < CategoryCount; ++i) {
+    snapshot->bytes[i] = gBytes[i];
+    snapshot->highWater[i] = gHighWater[i];
+    snapshot->objects[i] = gKeyBytes[i].size();
+  }
+}
+
+
+void mem::ResetHighWater() {
+  mt::MutexLockGuard guard(gLock);
+  for (size_t i = 0; i < CategoryCount; ++i)
+    gHighWater[i] = gBytes[i];
+}
+
+
+void mem::Print(const Snapshot &snapshot, FILE *fp) {
+  fprintf(fp, "  %-16s %14s %14s %10s\n", "Category", "Bytes", "High water",
+          "Objects");
+  for (size_t i = 0; i < CategoryCount; ++i)
+    fprintf(fp, "  %-16s %14zu %14zu %10zu\n", gCategoryName[i],
+            snapshot.bytes[i], snapshot.highWater[i], snapshot.objects[i]);
+  fprintf(fp, "  %-16s %14zu\n", "Total", snapshot.Total());
+}
@@ -0,0 +1,60 @@
+//  Copyright (c) 2013 The 11ers. All rights reserved.
+
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+// Global accounting of the bytes held by textures, buffers and CPU caches.
+// Modules report their allocations by category, either anonymously with
+// Add, or keyed by object (GL name or pointer) with Track and Untrack,
+// which lets the owner release an object without remembering its size.
+// Use Snapshot to decide what to evict in App::ReduceMemory and
+// App::DeleteCache, and ResetHighWater to measure the peak of a phase.
+// All functions are thread safe.
+
+namespace mem {
+
+
+enum Category {
+  GLTexture,                                          // glt::StoreTexture
+  GLBuffer,                                           // glt::CreateBuffer
+  DecodedImage,                                       // lodepng output
+  Geometry,                                           // TriStrip vertices
+  JsonDOM,                                            // json_parse nodes
+  CategoryCount
+};
+
+const char *CategoryName(Category category);
+
+// Anonymous accounting, bytes may be negative to release
+void Add(Category category, ptrdiff_t bytes);
+
+// Keyed accounting, replacing any bytes previously tracked for key
+void Track(Category category, uintptr_t key, size_t bytes);
+size_t Untrack(Category category, uintptr_t key);     // Returns bytes freed
+size_t Tracked(Category category, uintptr_t key);     // Zero if not tracked
+
+size_t Bytes(Category category);                      // Currently held
+size_t HighWater(Category category);                  // Peak since reset
+size_t TotalBytes();                                  // All categories
+
+struct Snapshot {
+  Snapshot();
+  size_t Total() const;                               // Sum of bytes
+  size_t bytes[CategoryCount];                        // Currently held
+  size_t highWater[CategoryCount];                    // Peak since reset
+  size_t objects[CategoryCount];                      // Keyed objects
+};
+
+void TakeSnapshot(Snapshot *snapshot);                // Consistent copy
+void ResetHighWater();                                // High water = current
+void Print(const Snapshot &snapshot, FILE *fp = stdout);
+
+
+}       // namespace mem
+
+#endif  // MEMORY_H
@@ -0,0 +1,225 @@
+//  Copyright (c) 2013 The 11ers. All rights reserved.
+
+#ifndef STUB_GL2_H
+#define STUB_GL2_H
+
+#include <stddef.h>
+
+// Minimal OpenGLES 2 declarations used by GlesUtil and TouchUI.
+// Lets the library compile on machines without GL development headers.
+// Only the entry points and enums referenced by this library are declared,
+// using the values from the Khronos gl2.h. Link against GlStub.cpp for
+// a headless implementation, or against a real libGLESv2.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void             GLvoid;
+typedef char             GLchar;
+typedef unsigned int     GLenum;
+typedef unsigned char    GLboolean;
+typedef unsigned int     GLbitfield;
+typedef signed char      GLbyte;
+typedef short            GLshort;
+typedef int              GLint;
+typedef int              GLsizei;
+typedef unsigned char    GLubyte;
+typedef unsigned short   GLushort;
+typedef unsigned int     GLuint;
+typedef float            GLfloat;
+typedef float            GLclampf;
+typedef ptrdiff_t        GLintptr;
+typedef ptrdiff_t        GLsizeiptr;
+
+// Boolean & errors
+#define GL_FALSE                                        0
+#define GL_TRUE                                         1
+#define GL_NO_ERROR                                     0
+#define GL_INVALID_ENUM                                 0x0500
+#define GL_INVALID_VALUE                                0x0501
+#define GL_INVALID_OPERATION                            0x0502
+#define GL_OUT_OF_MEMORY                                0x0505
+#define GL_INVALID_FRAMEBUFFER_OPERATION                0x0506
+
+// Primitives
+#define GL_POINTS                                       0x0000
+#define GL_LINES                                        0x0001
+#define GL_LINE_LOOP                                    0x0002
+#define GL_LINE_STRIP                                   0x0003
+#define GL_TRIANGLES                                    0x0004
+#define GL_TRIANGLE_STRIP                               0x0005
+#define GL_TRIANGLE_FAN                                 0x0006
+
+// Blending
+#define GL_ZERO                                         0
+#define GL_ONE                                          1
+#define GL_SRC_COLOR                                    0x0300
+#define GL_ONE_MINUS_SRC_COLOR                          0x0301
+#define GL_SRC_ALPHA                                    0x0302
+#define GL_ONE_MINUS_SRC_ALPHA                          0x0303
+#define GL_DST_ALPHA                                    0x0304
+#define GL_ONE_MINUS_DST_ALPHA                          0x0305
+#define GL_FUNC_ADD                                     0x8006
+#define GL_FUNC_SUBTRACT                                0x800A
+#define GL_FUNC_REVERSE_SUBTRACT                        0x800B
+
+// Capabilities
+#define GL_BLEND                                        0x0BE2
+#define GL_DEPTH_TEST                                   0x0B71
+#define GL_CULL_FACE                                    0x0B44
+#define GL_SCISSOR_TEST                                 0x0C11
+
+// Queries
+#define GL_VIEWPORT                                     0x0BA2
+#define GL_SCISSOR_BOX                                  0x0C10
+#define GL_MAX_TEXTURE_SIZE                             0x0D33
+#define GL_ARRAY_BUFFER_BINDING                         0x8894
+#define GL_ELEMENT_ARRAY_BUFFER_BINDING                 0x8895
+#define GL_CURRENT_PROGRAM                              0x8B8D
+#define GL_TEXTURE_BINDING_2D                           0x8069
+#define GL_VENDOR                                       0x1F00
+#define GL_RENDERER                                     0x1F01
+#define GL_VERSION                                      0x1F02
+#define GL_EXTENSIONS                                   0x1F03
+
+// Data types
+#define GL_BYTE                                         0x1400
+#define GL_UNSIGNED_BYTE                                0x1401
+#define GL_SHORT                                        0x1402
+#define GL_UNSIGNED_SHORT                               0x1403
+#define GL_INT                                          0x1404
+#define GL_UNSIGNED_INT                                 0x1405
+#define GL_FLOAT                                        0x1406
+#define GL_UNSIGNED_SHORT_4_4_4_4                       0x8033
+#define GL_UNSIGNED_SHORT_5_5_5_1                       0x8034
+#define GL_UNSIGNED_SHORT_5_6_5                         0x8363
+
+// Pixel formats
+#define GL_ALPHA                                        0x1906
+#define GL_RGB                                          0x1907
+#define GL_RGBA                                         0x1908
+#define GL_LUMINANCE                                    0x1909
+#define GL_LUMINANCE_ALPHA                              0x190A
+#define GL_UNPACK_ALIGNMENT                             0x0CF5
+#define GL_PACK_ALIGNMENT                               0x0D05
+
+// Shaders
+#define GL_FRAGMENT_SHADER                              0x8B30
+#define GL_VERTEX_SHADER                                0x8B31
+#define GL_COMPILE_STATUS                               0x8B81
+#define GL_LINK_STATUS                                  0x8B82
+#define GL_INFO_LOG_LENGTH                              0x8B84
+
+// Textures
+#define GL_NEAREST                                      0x2600
+#define GL_LINEAR                                       0x2601
+#define GL_NEAREST_MIPMAP_NEAREST                       0x2700
+#define GL_LINEAR_MIPMAP_NEAREST                        0x2701
+#define GL_NEAREST_MIPMAP_LINEAR                        0x2702
+#define GL_LINEAR_MIPMAP_LINEAR                         0x2703
+#define GL_TEXTURE_MAG_FILTER                           0x2800
+#define GL_TEXTURE_MIN_FILTER                           0x2801
+#define GL_TEXTURE_WRAP_S                               0x2802
+#define GL_TEXTURE_WRAP_T                               0x2803
+#define GL_TEXTURE                                      0x1702
+#define GL_TEXTURE_2D                                   0x0DE1
+#define GL_TEXTURE_CUBE_MAP                             0x8513
+#define GL_TEXTURE_CUBE_MAP_POSITIVE_X                  0x8515
+#define GL_TEXTURE_CUBE_MAP_NEGATIVE_X                  0x8516
+#define GL_TEXTURE_CUBE_MAP_POSITIVE_Y                  0x8517
+#define GL_TEXTURE_CUBE_MAP_NEGATIVE_Y                  0x8518
+#define GL_TEXTURE_CUBE_MAP_POSITIVE_Z                  0x8519
+#define GL_TEXTURE_CUBE_MAP_NEGATIVE_Z                  0x851A
+#define GL_TEXTURE0                                     0x84C0
+#define GL_TEXTURE1                                     0x84C1
+#define GL_REPEAT                                       0x2901
+#define GL_CLAMP_TO_EDGE                                0x812F
+#define GL_MIRRORED_REPEAT                              0x8370
+
+// Buffers
+#define GL_ARRAY_BUFFER                                 0x8892
+#define GL_ELEMENT_ARRAY_BUFFER                         0x8893
+#define GL_STREAM_DRAW                                  0x88E0
+#define GL_STATIC_DRAW                                  0x88E4
+#define GL_DYNAMIC_DRAW                                 0x88E8
+
+// Framebuffers
+#define GL_FRAMEBUFFER                                  0x8D40
+#define GL_RENDERBUFFER                                 0x8D41
+#define GL_FRAMEBUFFER_COMPLETE                         0x8CD5
+#define GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT            0x8CD6
+#define GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT    0x8CD7
+#define GL_FRAMEBUFFER_INCOMPLETE_DIMENSIONS            0x8CD9
+#define GL_FRAMEBUFFER_UNSUPPORTED                      0x8CDD
+
+void glActiveTexture(GLenum texture);
+void glAttachShader(GLuint program, GLuint shader);
+void glBindBuffer(GLenum target, GLuint buffer);
+void glBindTexture(GLenum target, GLuint texture);
+void glBlendEquation(GLenum mode);
+void glBlendFunc(GLenum sfactor, GLenum dfactor);
+void glBlendFuncSeparate(GLenum srcRGB, GLenum dstRGB,
+                         GLenum srcAlpha, GLenum dstAlpha);
+void glBufferData(GLenum target, GLsizeiptr size, const GLvoid *data,
+                  GLenum usage);
+void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size,
+                     const GLvoid *data);
+GLenum glCheckFramebufferStatus(GLenum target);
+void glCompileShader(GLuint shader);
+GLuint glCreateProgram(void);
+GLuint glCreateShader(GLenum type);
+void glDeleteBuffers(GLsizei n, const GLuint *buffers);
+void glDeleteProgram(GLuint program);
+void glDeleteShader(GLuint shader);
+void glDeleteTextures(GLsizei n, const GLuint *textures);
+void glDisable(GLenum cap);
+void glDisableVertexAttribArray(GLuint index);
+void glDrawArrays(GLenum mode, GLint first, GLsizei count);
+void glDrawElements(GLenum mode, GLsizei count, GLenum type,
+                    const GLvoid *indices);
+void glEnable(GLenum cap);
+void glEnableVertexAttribArray(GLuint index);
+void glGenBuffers(GLsizei n, GLuint *buffers);
+void glGenerateMipmap(GLenum target);
+void glGenTextures(GLsizei n, GLuint *textures);
+GLint glGetAttribLocation(GLuint program, const GLchar *name);
+GLenum glGetError(void);
+void glGetIntegerv(GLenum pname, GLint *params);
+void glGetProgramInfoLog(GLuint program, GLsizei bufsize, GLsizei *length,
+                         GLchar *infolog);
+void glGetProgramiv(GLuint program, GLenum pname, GLint *params);
+void glGetShaderInfoLog(GLuint shader, GLsizei bufsize, GLsizei *length,
+                        GLchar *infolog);
+void glGetShaderiv(GLuint shader, GLenum pname, GLint *params);
+const GLubyte *glGetString(GLenum name);
+GLint glGetUniformLocation(GLuint program, const GLchar *name);
+void glLinkProgram(GLuint program);
+void glPixelStorei(GLenum pname, GLint param);
+void glScissor(GLint x, GLint y, GLsizei width, GLsizei height);
+void glShaderSource(GLuint shader, GLsizei count, const GLchar **string,
+                    const GLint *length);
+void glTexImage2D(GLenum target, GLint level, GLint internalformat,
+                  GLsizei width, GLsizei height, GLint border, GLenum format,
+                  GLenum type, const GLvoid *pixels);
+void glTexParameteri(GLenum target, GLenum pname, GLint param);
+void glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset,
+                     GLsizei width, GLsizei height, GLenum format, GLenum type,
+                     const GLvoid *pixels);
+void glUniform1f(GLint location, GLfloat x);
+void glUniform1i(GLint location, GLint x);
+void glUniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+void glUniform4fv(GLint location, GLsizei count, const GLfloat *v);
+void glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose,
+                        const GLfloat *value);
+void glUseProgram(GLuint program);
+void glVertexAttribPointer(GLuint indx, GLint size, GLenum type,
+                           GLboolean normalized, GLsizei stride,
+                           const GLvoid *ptr);
+void glViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // STUB_GL2_H
@@ -0,0 +1,9 @@
+//  Copyright (c) 2013 The 11ers. All rights reserved.
+
+#ifndef STUB_GL2EXT_H
+#define STUB_GL2EXT_H
+
+// Extensions are not available in the stub implementation.
+// See GLES2/gl2.h in this directory.
+
+#endif  // STUB_GL2EXT_H
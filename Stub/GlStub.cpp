@@ -0,0 +1,541 @@
+//  Copyright (c) 2013 The 11ers. All rights reserved.
+
+// Headless implementation of the OpenGLES 2 entry points declared in
+// Stub/GLES2/gl2.h. Every call succeeds without touching a GPU.
+// Object names are allocated sequentially and the small amount of
+// state that GlesUtil queries back (buffer bindings, viewport, ...)
+// is retained so that save/restore code paths behave normally.
+// Calls are recorded for performance testing, see GlStub.h.
+
+#include "GlStub.h"
+
+#include <GLES2/gl2.h>
+
+#include <string.h>
+
+
+//
+// Recording
+//
+
+static const size_t kMaxTextureUnit = 8;              // Tracked units
+static const size_t kMaxCap = 4;                      // Tracked Enable caps
+static const GLenum kCap[kMaxCap] = { GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE,
+                                      GL_SCISSOR_TEST };
+
+static GLuint gNextName = 1;                          // Shared name counter
+static GLint gArrayBuffer = 0;                        // GL_ARRAY_BUFFER
+static GLint gElementArrayBuffer = 0;                 // GL_ELEMENT_ARRAY...
+static GLint gProgram = 0;                            // glUseProgram
+static size_t gActiveUnit = 0;                        // glActiveTexture
+static GLint gTexture2D[kMaxTextureUnit];             // Per-unit binding
+static bool gCapEnabled[kMaxCap];                     // glEnable/glDisable
+static GLenum gBlend[4] = { GL_ONE, GL_ZERO, GL_ONE, GL_ZERO };
+static GLenum gBlendEquation = GL_FUNC_ADD;
+static GLint gViewport[4] = { 0, 0, 1024, 768 };      // Default window
+static GLint gScissor[4] = { 0, 0, 1024, 768 };
+
+static glstub::Stats gFrame;                          // Since BeginFrame
+static glstub::Stats gTotal;                          // Since Reset
+static size_t gFrameCount = 0;
+
+static const char *gCallName[glstub::CallCount] = {
+  "glActiveTexture", "glAttachShader", "glBindBuffer", "glBindTexture",
+  "glBlendEquation", "glBlendFunc", "glBlendFuncSeparate", "glBufferData",
+  "glBufferSubData", "glCheckFramebufferStatus", "glCompileShader",
+  "glCreateProgram", "glCreateShader", "glDeleteBuffers", "glDeleteProgram",
+  "glDeleteShader", "glDeleteTextures", "glDisable",
+  "glDisableVertexAttribArray", "glDrawArrays", "glDrawElements", "glEnable",
+  "glEnableVertexAttribArray", "glGenBuffers", "glGenerateMipmap",
+  "glGenTextures", "glGetAttribLocation", "glGetError", "glGetIntegerv",
+  "glGetProgramInfoLog", "glGetProgramiv", "glGetShaderInfoLog",
+  "glGetShaderiv", "glGetString", "glGetUniformLocation", "glLinkProgram",
+  "glPixelStorei", "glScissor", "glShaderSource", "glTexImage2D",
+  "glTexParameteri", "glTexSubImage2D", "glUniform1f", "glUniform1i",
+  "glUniform4f", "glUniform4fv", "glUniformMatrix4fv", "glUseProgram",
+  "glVertexAttribPointer", "glViewport",
+};
+
+
+static void Record(glstub::Call call) {
+  gFrame.call[call]++;
+  gFrame.calls++;
+  gTotal.call[call]++;
+  gTotal.calls++;
+}
+
+
+static void Count(unsigned long glstub::Stats::*counter, unsigned long n = 1) {
+  gFrame.*counter += n;
+  gTotal.*counter += n;
+}
+
+
+static void CountBytes(size_t glstub::Stats::*counter, size_t n) {
+  gFrame.*counter += n;
+  gTotal.*counter += n;
+}
+
+
+static void SetCap(GLenum cap, bool enable) {
+  for (size_t i = 0; i < kMaxCap; ++i) {
+    if (kCap[i] == cap) {
+      if (gCapEnabled[i] == enable) {
+        Count(&glstub::Stats::redundantEnable);
+      } else {
+        gCapEnabled[i] = enable;
+        Count(&glstub::Stats::stateChanges);
+      }
+      return;
+    }
+  }
+  Count(&glstub::Stats::stateChanges);                // Untracked cap
+}
+
+
+void glstub::Stats::Clear() {
+  memset(call, 0, sizeof(call));
+  calls = drawCalls = vertices = stateChanges = 0;
+  redundantUseProgram = redundantBindTexture = 0;
+  redundantBindBuffer = redundantEnable = 0;
+  textureUploadBytes = bufferUploadBytes = 0;
+}
+
+
+void glstub::Stats::Add(const Stats &rhs) {
+  for (size_t i = 0; i < CallCount; ++i)
+    call[i] += rhs.call[i];
+  calls += rhs.calls;
+  drawCalls += rhs.drawCalls;
+  vertices += rhs.vertices;
+  stateChanges += rhs.stateChanges;
+  redundantUseProgram += rhs.redundantUseProgram;
+  redundantBindTexture += rhs.redundantBindTexture;
+  redundantBindBuffer += rhs.redundantBindBuffer;
+  redundantEnable += rhs.redundantEnable;
+  textureUploadBytes += rhs.textureUploadBytes;
+  bufferUploadBytes += rhs.bufferUploadBytes;
+}
+
+
+const char *glstub::CallName(Call call) {
+  return call < CallCount ? gCallName[call] : "Unknown";
+}
+
+
+void glstub::Reset() {
+  gFrame.Clear();
+  gTotal.Clear();
+  gFrameCount = 0;
+  gArrayBuffer = gElementArrayBuffer = gProgram = 0;
+  gActiveUnit = 0;
+  memset(gTexture2D, 0, sizeof(gTexture2D));
+  memset(gCapEnabled, 0, sizeof(gCapEnabled));
+  gBlend[0] = gBlend[2] = GL_ONE;
+  gBlend[1] = gBlend[3] = GL_ZERO;
+  gBlendEquation = GL_FUNC_ADD;
+}
+
+
+void glstub::BeginFrame() {
+  gFrame.Clear();
+  gFrameCount++;
+}
+
+
+const glstub::Stats &glstub::Frame() { return gFrame; }
+const glstub::Stats &glstub::Total() { return gTotal; }
+size_t glstub::FrameCount() { return gFrameCount; }
+
+
+void glstub::Print(const Stats &stats, FILE *fp) {
+  for (size_t i = 0; i < CallCount; ++i) {
+    if (stats.call[i])
+      fprintf(fp, "  %-28s %10lu\n", gCallName[i], stats.call[i]);
+  }
+  fprintf(fp, "  %-28s %10lu\n", "calls", stats.calls);
+  fprintf(fp, "  %-28s %10lu\n", "draw calls", stats.drawCalls);
+  fprintf(fp, "  %-28s %10lu\n", "vertices", stats.vertices);
+  fprintf(fp, "  %-28s %10lu\n", "state changes", stats.stateChanges);
+  fprintf(fp, "  %-28s %10lu\n", "redundant glUseProgram",
+          stats.redundantUseProgram);
+  fprintf(fp, "  %-28s %10lu\n", "redundant glBindTexture",
+          stats.redundantBindTexture);
+  fprintf(fp, "  %-28s %10lu\n", "redundant glBindBuffer",
+          stats.redundantBindBuffer);
+  fprintf(fp, "  %-28s %10lu\n", "redundant glEnable/Disable",
+          stats.redundantEnable);
+  fprintf(fp, "  %-28s %10zu\n", "texture upload bytes",
+          stats.textureUploadBytes);
+  fprintf(fp, "  %-28s %10zu\n", "buffer upload bytes",
+          stats.bufferUploadBytes);
+}
+
+
+size_t glstub::ImageBytes(int w, int h, unsigned int format,
+                          unsigned int type) {
+  if (w <= 0 || h <= 0)
+    return 0;
+  size_t bpp = 0;
+  switch (type) {
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_5_5_5_1:
+    case GL_UNSIGNED_SHORT_5_6_5:
+      bpp = 2;
+      break;
+    default: {
+      size_t bytesPerChannel = type == GL_FLOAT ? 4 :
+                               type == GL_UNSIGNED_SHORT ? 2 : 1;
+      size_t channels = 4;
+      switch (format) {
+        case GL_ALPHA:
+        case GL_LUMINANCE:       channels = 1; break;
+        case GL_LUMINANCE_ALPHA: channels = 2; break;
+        case GL_RGB:             channels = 3; break;
+      }
+      bpp = channels * bytesPerChannel;
+    }
+  }
+  return size_t(w) * size_t(h) * bpp;
+}
+
+
+//
+// OpenGLES 2 entry points
+//
+
+extern "C" {
+
+void glActiveTexture(GLenum texture) {
+  Record(glstub::ActiveTexture);
+  size_t unit = texture - GL_TEXTURE0;
+  if (unit < kMaxTextureUnit && unit != gActiveUnit) {
+    gActiveUnit = unit;
+    Count(&glstub::Stats::stateChanges);
+  }
+}
+
+void glAttachShader(GLuint /*program*/, GLuint /*shader*/) {
+  Record(glstub::AttachShader);
+}
+
+void glBindBuffer(GLenum target, GLuint buffer) {
+  Record(glstub::BindBuffer);
+  GLint *binding = target == GL_ARRAY_BUFFER ? &gArrayBuffer :
+                   target == GL_ELEMENT_ARRAY_BUFFER ? &gElementArrayBuffer : 0;
+  if (!binding)
+    return;
+  if (*binding == GLint(buffer)) {
+    Count(&glstub::Stats::redundantBindBuffer);
+  } else {
+    *binding = buffer;
+    Count(&glstub::Stats::stateChanges);
+  }
+}
+
+void glBindTexture(GLenum target, GLuint texture) {
+  Record(glstub::BindTexture);
+  if (target != GL_TEXTURE_2D) {
+    Count(&glstub::Stats::stateChanges);
+    return;
+  }
+  if (gTexture2D[gActiveUnit] == GLint(texture)) {
+    Count(&glstub::Stats::redundantBindTexture);
+  } else {
+    gTexture2D[gActiveUnit] = texture;
+    Count(&glstub::Stats::stateChanges);
+  }
+}
+
+void glBlendEquation(GLenum mode) {
+  Record(glstub::BlendEquation);
+  if (mode != gBlendEquation) {
+    gBlendEquation = mode;
+    Count(&glstub::Stats::stateChanges);
+  }
+}
+
+void glBlendFunc(GLenum sfactor, GLenum dfactor) {
+  Record(glstub::BlendFunc);
+  if (sfactor != gBlend[0] || dfactor != gBlend[1] ||
+      sfactor != gBlend[2] || dfactor != gBlend[3]) {
+    gBlend[0] = gBlend[2] = sfactor;
+    gBlend[1] = gBlend[3] = dfactor;
+    Count(&glstub::Stats::stateChanges);
+  }
+}
+
+void glBlendFuncSeparate(GLenum srcRGB, GLenum dstRGB,
+                         GLenum srcAlpha, GLenum dstAlpha) {
+  Record(glstub::BlendFuncSeparate);
+  if (srcRGB != gBlend[0] || dstRGB != gBlend[1] ||
+      srcAlpha != gBlend[2] || dstAlpha != gBlend[3]) {
+    gBlend[0] = srcRGB;
+    gBlend[1] = dstRGB;
+    gBlend[2] = srcAlpha;
+    gBlend[3] = dstAlpha;
+    Count(&glstub::Stats::stateChanges);
+  }
+}
+
+void glBufferData(GLenum /*target*/, GLsizeiptr size, const GLvoid *data,
+                  GLenum /*usage*/) {
+  Record(glstub::BufferData);
+  if (data && size > 0)
+    CountBytes(&glstub::Stats::bufferUploadBytes, size_t(size));
+}
+
+void glBufferSubData(GLenum /*target*/, GLintptr /*offset*/, GLsizeiptr size,
+                     const GLvoid *data) {
+  Record(glstub::BufferSubData);
+  if (data && size > 0)
+    CountBytes(&glstub::Stats::bufferUploadBytes, size_t(size));
+}
+
+GLenum glCheckFramebufferStatus(GLenum /*target*/) {
+  Record(glstub::CheckFramebufferStatus);
+  return GL_FRAMEBUFFER_COMPLETE;
+}
+
+void glCompileShader(GLuint /*shader*/) {
+  Record(glstub::CompileShader);
+}
+
+GLuint glCreateProgram(void) {
+  Record(glstub::CreateProgram);
+  return gNextName++;
+}
+
+GLuint glCreateShader(GLenum /*type*/) {
+  Record(glstub::CreateShader);
+  return gNextName++;
+}
+
+// As in GL, deleting a bound buffer or texture reverts its binding to 0
+void glDeleteBuffers(GLsizei n, const GLuint *buffers) {
+  Record(glstub::DeleteBuffers);
+  for (GLsizei i = 0; i < n; ++i) {
+    if (gArrayBuffer == GLint(buffers[i]))
+      gArrayBuffer = 0;
+    if (gElementArrayBuffer == GLint(buffers[i]))
+      gElementArrayBuffer = 0;
+  }
+}
+
+void glDeleteProgram(GLuint /*program*/) {
+  Record(glstub::DeleteProgram);
+}
+
+void glDeleteShader(GLuint /*shader*/) {
+  Record(glstub::DeleteShader);
+}
+
+void glDeleteTextures(GLsizei n, const GLuint *textures) {
+  Record(glstub::DeleteTextures);
+  for (GLsizei i = 0; i < n; ++i) {
+    for (size_t unit = 0; unit < kMaxTextureUnit; ++unit) {
+      if (gTexture2D[unit] == GLint(textures[i]))
+        gTexture2D[unit] = 0;
+    }
+  }
+}
+
+void glDisable(GLenum cap) {
+  Record(glstub::Disable);
+  SetCap(cap, false);
+}
+
+void glDisableVertexAttribArray(GLuint /*index*/) {
+  Record(glstub::DisableVertexAttribArray);
+}
+
+void glDrawArrays(GLenum /*mode*/, GLint /*first*/, GLsizei count) {
+  Record(glstub::DrawArrays);
+  Count(&glstub::Stats::drawCalls);
+  Count(&glstub::Stats::vertices, count);
+}
+
+void glDrawElements(GLenum /*mode*/, GLsizei count, GLenum /*type*/,
+                    const GLvoid * /*indices*/) {
+  Record(glstub::DrawElements);
+  Count(&glstub::Stats::drawCalls);
+  Count(&glstub::Stats::vertices, count);
+}
+
+void glEnable(GLenum cap) {
+  Record(glstub::Enable);
+  SetCap(cap, true);
+}
+
+void glEnableVertexAttribArray(GLuint /*index*/) {
+  Record(glstub::EnableVertexAttribArray);
+}
+
+void glGenBuffers(GLsizei n, GLuint *buffers) {
+  Record(glstub::GenBuffers);
+  for (GLsizei i = 0; i < n; ++i)
+    buffers[i] = gNextName++;
+}
+
+void glGenerateMipmap(GLenum /*target*/) {
+  Record(glstub::GenerateMipmap);
+}
+
+void glGenTextures(GLsizei n, GLuint *textures) {
+  Record(glstub::GenTextures);
+  for (GLsizei i = 0; i < n; ++i)
+    textures[i] = gNextName++;
+}
+
+GLint glGetAttribLocation(GLuint /*program*/, const GLchar * /*name*/) {
+  Record(glstub::GetAttribLocation);
+  return 0;
+}
+
+GLenum glGetError(void) {
+  Record(glstub::GetError);
+  return GL_NO_ERROR;
+}
+
+void glGetIntegerv(GLenum pname, GLint *params) {
+  Record(glstub::GetIntegerv);
+  switch (pname) {
+    case GL_ARRAY_BUFFER_BINDING:         *params = gArrayBuffer; break;
+    case GL_ELEMENT_ARRAY_BUFFER_BINDING: *params = gElementArrayBuffer; break;
+    case GL_CURRENT_PROGRAM:              *params = gProgram; break;
+    case GL_TEXTURE_BINDING_2D: *params = gTexture2D[gActiveUnit]; break;
+    case GL_MAX_TEXTURE_SIZE:             *params = 4096; break;
+    case GL_VIEWPORT:    memcpy(params, gViewport, sizeof(gViewport)); break;
+    case GL_SCISSOR_BOX: memcpy(params, gScissor, sizeof(gScissor)); break;
+    default:                              *params = 0; break;
+  }
+}
+
+void glGetProgramInfoLog(GLuint /*program*/, GLsizei bufsize, GLsizei *length,
+                         GLchar *infolog) {
+  Record(glstub::GetProgramInfoLog);
+  if (length)
+    *length = 0;
+  if (bufsize > 0)
+    infolog[0] = '\0';
+}
+
+void glGetProgramiv(GLuint /*program*/, GLenum pname, GLint *params) {
+  Record(glstub::GetProgramiv);
+  *params = pname == GL_LINK_STATUS ? GL_TRUE : 0;
+}
+
+void glGetShaderInfoLog(GLuint /*shader*/, GLsizei bufsize, GLsizei *length,
+                        GLchar *infolog) {
+  Record(glstub::GetShaderInfoLog);
+  if (length)
+    *length = 0;
+  if (bufsize > 0)
+    infolog[0] = '\0';
+}
+
+void glGetShaderiv(GLuint /*shader*/, GLenum pname, GLint *params) {
+  Record(glstub::GetShaderiv);
+  *params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+
+const GLubyte *glGetString(GLenum name) {
+  Record(glstub::GetString);
+  switch (name) {
+    case GL_VENDOR:   return (const GLubyte *)"The 11ers";
+    case GL_RENDERER: return (const GLubyte *)"GlStub";
+    case GL_VERSION:  return (const GLubyte *)"OpenGL ES 2.0 GlStub";
+    default:          return (const GLubyte *)"";
+  }
+}
+
+GLint glGetUniformLocation(GLuint /*program*/, const GLchar * /*name*/) {
+  Record(glstub::GetUniformLocation);
+  return 0;
+}
+
+void glLinkProgram(GLuint /*program*/) {
+  Record(glstub::LinkProgram);
+}
+
+void glPixelStorei(GLenum /*pname*/, GLint /*param*/) {
+  Record(glstub::PixelStorei);
+}
+
+void glScissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+  Record(glstub::Scissor);
+  gScissor[0] = x; gScissor[1] = y; gScissor[2] = width; gScissor[3] = height;
+}
+
+void glShaderSource(GLuint /*shader*/, GLsizei /*count*/,
+                    const GLchar ** /*string*/, const GLint * /*length*/) {
+  Record(glstub::ShaderSource);
+}
+
+void glTexImage2D(GLenum /*target*/, GLint /*level*/, GLint /*internalformat*/,
+                  GLsizei width, GLsizei height, GLint /*border*/,
+                  GLenum format, GLenum type, const GLvoid *pixels) {
+  Record(glstub::TexImage2D);
+  if (pixels)
+    CountBytes(&glstub::Stats::textureUploadBytes,
+               glstub::ImageBytes(width, height, format, type));
+}
+
+void glTexParameteri(GLenum /*target*/, GLenum /*pname*/, GLint /*param*/) {
+  Record(glstub::TexParameteri);
+}
+
+void glTexSubImage2D(GLenum /*target*/, GLint /*level*/, GLint /*xoffset*/,
+                     GLint /*yoffset*/, GLsizei width, GLsizei height,
+                     GLenum format, GLenum type, const GLvoid *pixels) {
+  Record(glstub::TexSubImage2D);
+  if (pixels)
+    CountBytes(&glstub::Stats::textureUploadBytes,
+               glstub::ImageBytes(width, height, format, type));
+}
+
+void glUniform1f(GLint /*location*/, GLfloat /*x*/) {
+  Record(glstub::Uniform1f);
+}
+
+void glUniform1i(GLint /*location*/, GLint /*x*/) {
+  Record(glstub::Uniform1i);
+}
+
+void glUniform4f(GLint /*location*/, GLfloat /*x*/, GLfloat /*y*/,
+                 GLfloat /*z*/, GLfloat /*w*/) {
+  Record(glstub::Uniform4f);
+}
+
+void glUniform4fv(GLint /*location*/, GLsizei /*count*/,
+                  const GLfloat * /*v*/) {
+  Record(glstub::Uniform4fv);
+}
+
+void glUniformMatrix4fv(GLint /*location*/, GLsizei /*count*/,
+                        GLboolean /*transpose*/, const GLfloat * /*value*/) {
+  Record(glstub::UniformMatrix4fv);
+}
+
+void glUseProgram(GLuint program) {
+  Record(glstub::UseProgram);
+  if (gProgram == GLint(program)) {
+    Count(&glstub::Stats::redundantUseProgram);
+  } else {
+    gProgram = program;
+    Count(&glstub::Stats::stateChanges);
+  }
+}
+
+void glVertexAttribPointer(GLuint /*indx*/, GLint /*size*/, GLenum /*type*/,
+                           GLboolean /*normalized*/, GLsizei /*stride*/,
+                           const GLvoid * /*ptr*/) {
+  Record(glstub::VertexAttribPointer);
+}
+
+void glViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+  Record(glstub::Viewport);
+  gViewport[0] = x; gViewport[1]= y; gViewport[2] = width; gViewport[3]=height;
+}
+
+}       // extern "C"
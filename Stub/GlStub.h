@@ -0,0 +1,72 @@
+//  Copyright (c) 2013 The 11ers. All rights reserved.
+
+#ifndef GL_STUB_H
+#define GL_STUB_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+
+// Recording interface to the headless GL implementation in GlStub.cpp.
+// Every GL entry point is counted by type, binds that do not change
+// the current binding are counted as redundant, and texture and buffer
+// uploads are summed in bytes. Statistics accumulate per frame, between
+// calls to BeginFrame, and in total since the last Reset.
+// Not thread safe, like the GL context it replaces.
+
+namespace glstub {
+
+
+enum Call {
+  ActiveTexture, AttachShader, BindBuffer, BindTexture, BlendEquation,
+  BlendFunc, BlendFuncSeparate, BufferData, BufferSubData,
+  CheckFramebufferStatus, CompileShader, CreateProgram, CreateShader,
+  DeleteBuffers, DeleteProgram, DeleteShader, DeleteTextures, Disable,
+  DisableVertexAttribArray, DrawArrays, DrawElements, Enable,
+  EnableVertexAttribArray, GenBuffers, GenerateMipmap, GenTextures,
+  GetAttribLocation, GetError, GetIntegerv, GetProgramInfoLog, GetProgramiv,
+  GetShaderInfoLog, GetShaderiv, GetString, GetUniformLocation, LinkProgram,
+  PixelStorei, Scissor, ShaderSource, TexImage2D, TexParameteri,
+  TexSubImage2D, Uniform1f, Uniform1i, Uniform4f, Uniform4fv,
+  UniformMatrix4fv, UseProgram, VertexAttribPointer, Viewport,
+  CallCount
+};
+
+
+struct Stats {
+  Stats() { Clear(); }
+  void Clear();
+  void Add(const Stats &rhs);
+
+  unsigned long call[CallCount];                      // Calls by type
+  unsigned long calls;                                // Total GL calls
+  unsigned long drawCalls;                            // DrawArrays+Elements
+  unsigned long vertices;                             // Count in draw calls
+  unsigned long stateChanges;                         // Effective changes
+  unsigned long redundantUseProgram;                  // Same program again
+  unsigned long redundantBindTexture;                 // Same unit & texture
+  unsigned long redundantBindBuffer;                  // Same target & buffer
+  unsigned long redundantEnable;                      // Enable/Disable no-op
+  size_t textureUploadBytes;                          // TexImage+TexSubImage
+  size_t bufferUploadBytes;                           // BufferData+SubData
+};
+
+
+const char *CallName(Call call);                      // "glBindTexture"
+
+void Reset();                                         // Clear stats & state
+void BeginFrame();                                    // Start new frame
+const Stats &Frame();                                 // Since BeginFrame
+const Stats &Total();                                 // Since Reset
+size_t FrameCount();                                  // BeginFrame calls
+
+// Print non-zero counters, one per line
+void Print(const Stats &stats, FILE *fp = stdout);
+
+// Bytes in one w x h image of the given GL format and type
+size_t ImageBytes(int w, int h, unsigned int format, unsigned int type);
+
+
+}       // namespace glstub
+
+#endif  // GL_STUB_H
@@ -248,6 +248,9 @@ private:
 
 // Implement this class to provide a standard framework invoked from Os-side
 // code to pass system events from the Os down to C++ code.
+// Call mt::WatchdogBeat at the start of Step and Draw to enable UI thread
+// stall detection, and wrap blocking Os calls (e.g. LoadText) in a
+// mt::StallZone so that they are named in stall reports (see Watchdog.h).
 
 class App {
 public:
@@ -3,6 +3,7 @@
 #include "TaskMgr.h"
 
 #include "Thread.h"
+#include "Watchdog.h"
 
 #include <assert.h>
 
@@ -27,10 +28,8 @@ public:
   virtual void Run() {
     while (1) {
       Task *task = mTaskMgr->WaitForTask();       // Wait for task
-      if (!task) {
-        printf("Worker received NULL task -- exiting\n");
+      if (!task)                                  // Manager destroyed
         break;
-      }
       SetName(task->Name());
       if (!(*task)())                             // Process task
         printf("Task error\n");
@@ -80,11 +79,11 @@ bool TaskMgr::Init(size_t workerCount) {
 
 
 void TaskMgr::Schedule(Task *task) {
+  StallZone zone("TaskMgr::Schedule");
   MutexLockGuard guard(*mMutex);
   mTaskHeap.push(task);
   mTaskNameSet.insert(task->Name());
   mNewWorkCond->NotifyOne();
-  printf("Add: Task deque has %zd entries\n", mTaskHeap.size());
 }
 
 
@@ -99,8 +98,6 @@ Task *TaskMgr::WaitForTask() {
       TaskNameSet::iterator n = mTaskNameSet.find(task->Name());
       assert(n != mTaskNameSet.end());
       mTaskNameSet.erase(n);
-      printf("Pop: Task deque has %zd entries after \"%s\"\n", mTaskHeap.size(),
-             task->Name());
       return task;
     }
   }
@@ -110,12 +107,14 @@ Task *TaskMgr::WaitForTask() {
 
 
 bool TaskMgr::IsPending(const char *name) {
+  StallZone zone("TaskMgr::IsPending");
   mt::MutexLockGuard guard(*mMutex);
   return mTaskNameSet.find(name) != mTaskNameSet.end();
 }
 
 
 bool TaskMgr::Dormant() const {
+  StallZone zone("TaskMgr::Dormant");
   MutexLockGuard guard(*mMutex);
   return mTaskHeap.empty();
 }
@@ -132,3 +131,65 @@ bool TaskMgr::Delete(const mt::WorkerThread &thread) {
   }
   return false;
 }
+
+
+//
+// RunRanges
+//
+
+namespace {
+
+// Counts down the ranges run by workers
+struct RangesDone {
+  Mutex mutex;
+  ConditionVariable done;
+  size_t pending;
+};
+
+
+class RangeTask : public Task {
+public:
+  RangeTask(const char *name, RangeFunc func, void *context, size_t range,
+            RangesDone *done)
+    : mName(name), mFunc(func), mContext(context), mRange(range),
+      mDone(done) {}
+  virtual bool operator()() {
+    mFunc(mContext, mRange);
+    MutexLockGuard guard(mDone->mutex);
+    if (--mDone->pending == 0)
+      mDone->done.NotifyOne();
+    return true;
+  }
+  virtual const char *Name() const { return mName; }
+  
+private:
+  const char *mName;
+  RangeFunc mFunc;
+  void *mContext;
+  size_t mRange;
+  RangesDone *mDone;
+};
+
+}       // namespace
+
+
+void mt::RunRanges(TaskMgr *taskMgr, const char *name, size_t count,
+                   RangeFunc func, void *context) {
+  if (!count)
+    return;
+  RangesDone done;
+  done.pending = count - 1;
+  for (size_t i = 1; i < count; ++i) {
+    if (taskMgr) {
+      taskMgr->Schedule(new RangeTask(name, func, context, i, &done));
+    } else {
+      func(context, i);
+      done.pending--;
+    }
+  }
+  func(context, 0);
+  done.mutex.Lock();
+  while (done.pending)
+    done.done.Wait(done.mutex);
+  done.mutex.Unlock();
+}
@@ -36,7 +36,7 @@ public:
 // This is generally useful for sorting or heapifying any pointer type.
   
 template<typename T, typename Compare = std::less<T> >
-struct PtrLess : public std::binary_function<T *, T *, bool> {
+struct PtrLess {
   bool operator()(const T *x, const T *y) const { return Compare()(*x, *y); }
 };
 
@@ -74,6 +74,15 @@ private:
 };
 
 
+// Run func(context, i) for each range i < count: the ranges after the
+// first as tasks named name, or in turn without a taskMgr, and the first
+// on the calling thread. Returns once every range is done.
+
+typedef void (*RangeFunc)(void *context, size_t range);
+void RunRanges(TaskMgr *taskMgr, const char *name, size_t count,
+               RangeFunc func, void *context);
+
+
 }       // namespace mt
 
 #endif /* defined(TASKMGR_H) */
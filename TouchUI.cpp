@@ -18,6 +18,7 @@ const int Widget::kMinPanPix = 40;
 const float ViewportWidget::kDoubleTapSec = 0.25;
 const int InfoBox::kTimeoutSec = 6;
 const float InfoBox::kFadeSec = 0.5;
+const double ToggleLockCheckbox::kLongTouchSec = 2;
 const size_t Toolbar::kStdHeight = 44;
 const int FlinglistImpl::kDragMm = 4;
 const int FlinglistImpl::kJiggleMm = 10;
@@ -902,8 +903,8 @@ void Button::AverageTouchPosition(double *x, double *y) const {
 
 ImageButton::~ImageButton() {
   if (mIsTexOwned) {
-    glDeleteTextures(1, &mDefaultTex);
-    glDeleteTextures(1, &mPressedTex);
+    glt::DeleteTexture(mDefaultTex);
+    glt::DeleteTexture(mPressedTex);
   }
 }
 
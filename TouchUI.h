@@ -6,6 +6,7 @@
 #include <assert.h>
 #include <map>
 #include <math.h>
+#include <string.h>
 #include <vector>
 #include <string>
 
@@ -531,7 +532,7 @@ namespace tui {
     }
 
   protected:
-    static const double kLongTouchSec = 2;
+    static const double kLongTouchSec;
     virtual bool InvokeTouchTap(const Event::Touch &touch) {
       double dt = touch.timestamp - mToggleStartTimestamp;
       if (dt < kLongTouchSec)
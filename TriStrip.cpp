@@ -2,6 +2,8 @@
 
 #include "TriStrip.h"
 
+#include "Memory.h"
+
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,6 +13,42 @@ using Imath::V3f;
 using Imath::V4f;
 
 
+TriStrip::TriStrip(const TriStrip &src)
+: mFlags(src.mFlags), mP(src.mP), mIdx(src.mIdx), mMaterial(src.mMaterial) {
+  for (size_t i = 0; i < kMaxAttr; ++i)
+    mA[i] = src.mA[i];
+  TrackMemory();
+}
+
+
+TriStrip::~TriStrip() {
+  mem::Untrack(mem::Geometry, uintptr_t(this));
+}
+
+
+TriStrip &TriStrip::operator=(const TriStrip &src) {
+  mFlags = src.mFlags;
+  mP = src.mP;
+  mIdx = src.mIdx;
+  for (size_t i = 0; i < kMaxAttr; ++i)
+    mA[i] = src.mA[i];
+  mMaterial = src.mMaterial;
+  TrackMemory();
+  return *this;
+}
+
+
+void TriStrip::TrackMemory() const {
+  size_t bytes = mP.capacity() * sizeof(V3f) +
+                 mIdx.capacity() * sizeof(unsigned short) +
+                 mMaterial.capacity() * sizeof(unsigned short);
+  for (size_t i = 0; i < kMaxAttr; ++i)
+    bytes += mA[i].capacity() * sizeof(V4f);
+  if (bytes)
+    mem::Track(mem::Geometry, uintptr_t(this), bytes);
+}
+
+
 void TriStrip::Clear() {
   mP.resize(0);
   mIdx.resize(0);
@@ -31,6 +69,7 @@ void TriStrip::Init(size_t vertexCount, size_t indexCount, unsigned long flags){
   }
   if (flags & MATERIAL_FLAG)
     mMaterial.resize(vertexCount);
+  TrackMemory();
 }
 
 
@@ -43,6 +82,7 @@ void TriStrip::Reserve(size_t vertexCount, size_t indexCount) {
   }
   if (mFlags & MATERIAL_FLAG)
     mMaterial.reserve(vertexCount);
+  TrackMemory();
 }
 
 
@@ -97,6 +137,7 @@ bool TriStrip::Append(const TriStrip &tristrip) {
     memcpy(&mMaterial[oldVCount], &tristrip.mMaterial[0], bytes);
   }
   
+  TrackMemory();
   return true;
 }
 
@@ -130,6 +171,7 @@ void TriStrip::InitTransform(const TriStrip &src, const Imath::M44f &T) {
   mP.resize(src.mP.size());
   for (size_t i = 0; i < src.mP.size(); ++i)
     mP[i] = src.mP[i] * T;
+  TrackMemory();
 }
 
 
@@ -172,6 +214,7 @@ void TriStrip::InitDisc(const V3f &center, const V3f &N,
       }
     }
   }
+  TrackMemory();
 }
 
 
@@ -233,6 +276,7 @@ void TriStrip::InitExtrusion(size_t vertexCount, const V3f *face,
       abort();
       break;
   }
+  TrackMemory();
 }
 
 
@@ -14,12 +14,14 @@
 // Utility functions for accessing individual vertex and index values,
 // as well as Append, which contacenates two strips, joining them
 // with degenerate vertices.  Flags are used to control which attributes
-// are active.
+// are active.  Allocated vertex memory is reported to mem::Geometry.
 
 class TriStrip {
 public:
   TriStrip() : mFlags(0) {}
-  ~TriStrip() {}
+  TriStrip(const TriStrip &src);
+  ~TriStrip();
+  TriStrip &operator=(const TriStrip &src);
   enum Flags { ATTR_0_FLAG=1, ATTR_1_FLAG=2, ATTR_2_FLAG=4, MATERIAL_FLAG=8 };
   void Init(size_t vertexCount, size_t indexCount, unsigned long flags);
   void InitDisc(const Imath::V3f &center, const Imath::V3f &N, float radius,
@@ -60,6 +62,8 @@ public:
 private:
   static const size_t kMaxAttr = 3;  
   
+  void TrackMemory() const;                     // Update mem::Geometry
+  
   unsigned long mFlags;
   std::vector<Imath::V3f> mP;
   std::vector<unsigned short> mIdx;
@@ -0,0 +1,171 @@
+//  Copyright (c) 2013 The 11ers. All rights reserved.
+
+#include "Watchdog.h"
+
+#include "Thread.h"
+#include "Timer.h"
+
+#include <stdio.h>
+#if !defined(WINDOWS)
+#include <unistd.h>
+#endif
+
+
+using namespace mt;
+
+
+#if defined(WINDOWS)
+typedef DWORD ThreadId;
+static ThreadId CurrentThreadId() { return GetCurrentThreadId(); }
+static bool IsSameThread(ThreadId a, ThreadId b) { return a == b; }
+static void SleepSec(double sec) { Sleep(DWORD(sec * 1000)); }
+#else
+typedef pthread_t ThreadId;
+static ThreadId CurrentThreadId() { return pthread_self(); }
+static bool IsSameThread(ThreadId a, ThreadId b) { return pthread_equal(a,b); }
+static void SleepSec(double sec) { usleep(useconds_t(sec * 1e6)); }
+#endif
+
+
+// UI thread state, written without locks by the UI thread only. The
+// depth, beat and flag are stored with release and loaded with acquire,
+// so that the zone names and the UI thread written before them are seen.
+static Timer gClock;                                  // Shared time base
+static unsigned int gBeatMs = 0;                      // Last beat time
+static unsigned long gFrame = 0;                      // Beat count
+static const char *gZone[kMaxStallZoneDepth];         // Zone stack
+static int gZoneDepth = 0;                            // May exceed max
+static ThreadId gUIThread;                            // First to beat
+static bool gHasUIThread = false;
+
+// Watchdog thread state
+static volatile bool gIsRunning = false;              // Cleared to stop
+static volatile bool gIsThreadAlive = false;          // Set by thread
+static AtomicInt gStallCount;
+
+
+static unsigned int NowMs() {
+  return (unsigned int)(gClock.Elapsed() * 1000);
+}
+
+
+static void PrintStall(const StallReport &report, void * /*data*/) {
+  printf("Stall: frame %lu blocked for %.3fs", report.frame, report.stallSec);
+  for (int i = 0; i < report.zoneDepth; ++i)
+    printf("%s%s", i ? " > " : " in ", report.zone[i]);
+  printf("\n");
+}
+
+
+class WatchdogThread : public Thread {
+public:
+  WatchdogThread(double thresholdSec, double sampleSec, StallFunc func,
+                 void *data)
+  : mThresholdMs((unsigned int)(thresholdSec * 1000)), mSampleSec(sampleSec),
+    mFunc(func ? func : PrintStall), mData(data) {}
+  
+  virtual void Run() {
+    unsigned long reportedFrame = 0;
+    bool hasReported = false;
+    while (gIsRunning) {
+      SleepSec(mSampleSec);
+      if (!__atomic_load_n(&gHasUIThread, __ATOMIC_ACQUIRE))
+        continue;
+      const unsigned long frame = __atomic_load_n(&gFrame, __ATOMIC_ACQUIRE);
+      const unsigned int elapsedMs =
+        NowMs() - __atomic_load_n(&gBeatMs, __ATOMIC_ACQUIRE);
+      if (elapsedMs < mThresholdMs)
+        continue;
+      if (hasReported && frame == reportedFrame)
+        continue;                                   // Once per frame
+      
+      StallReport report;
+      report.stallSec = elapsedMs / 1000.0;
+      report.frame = frame;
+      int depth = __atomic_load_n(&gZoneDepth, __ATOMIC_ACQUIRE);
+      report.zoneDepth = depth < kMaxStallZoneDepth ? depth :kMaxStallZoneDepth;
+      for (int i = 0; i < report.zoneDepth; ++i)
+        report.zone[i] = __atomic_load_n(&gZone[i], __ATOMIC_RELAXED);
+      if (frame != __atomic_load_n(&gFrame, __ATOMIC_ACQUIRE))
+        continue;                                   // Beat while sampling
+      
+      reportedFrame = frame;
+      hasReported = true;
+      ++gStallCount;
+      mFunc(report, mData);
+    }
+    gIsThreadAlive = false;
+    delete this;                                    // SUICIDE!
+  }
+  
+private:
+  unsigned int mThresholdMs;
+  double mSampleSec;
+  StallFunc mFunc;
+  void *mData;
+};
+
+
+bool mt::StartWatchdog(double thresholdSec, StallFunc func, void *data,
+                       double sampleSec) {
+  if (gIsRunning || gIsThreadAlive)
+    return false;
+  __atomic_store_n(&gBeatMs, NowMs(), __ATOMIC_RELEASE);
+  gIsRunning = true;
+  gIsThreadAlive = true;
+  WatchdogThread *thread = new WatchdogThread(thresholdSec, sampleSec, func,
+                                              data);
+  if (!thread->Init()) {
+    delete thread;
+    gIsRunning = false;
+    gIsThreadAlive = false;
+    return false;
+  }
+  thread->SetName("Watchdog");
+  return true;
+}
+
+
+void mt::StopWatchdog() {
+  gIsRunning = false;
+  while (gIsThreadAlive)
+    SleepSec(0.001);
+}
+
+
+bool mt::IsWatchdogRunning() {
+  return gIsRunning;
+}
+
+
+void mt::WatchdogBeat() {
+  if (!gHasUIThread) {
+    gUIThread = CurrentThreadId();
+    __atomic_store_n(&gHasUIThread, true, __ATOMIC_RELEASE); // After thread
+  }
+  __atomic_store_n(&gBeatMs, NowMs(), __ATOMIC_RELEASE);
+  __atomic_store_n(&gFrame, gFrame + 1, __ATOMIC_RELEASE);
+}
+
+
+unsigned long mt::StallCount() {
+  return gStallCount;
+}
+
+
+StallZone::StallZone(const char *name) : mIsPushed(false) {
+  if (!__atomic_load_n(&gHasUIThread, __ATOMIC_ACQUIRE) ||
+      !IsSameThread(gUIThread, CurrentThreadId()))
+    return;
+  const int depth = gZoneDepth;
+  if (depth < kMaxStallZoneDepth)
+    __atomic_store_n(&gZone[depth], name, __ATOMIC_RELAXED);
+  __atomic_store_n(&gZoneDepth, depth + 1, __ATOMIC_RELEASE); // After name
+  mIsPushed = true;
+}
+
+
+StallZone::~StallZone() {
+  if (mIsPushed)
+    __atomic_store_n(&gZoneDepth, gZoneDepth - 1, __ATOMIC_RELEASE);
+}
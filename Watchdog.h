@@ -0,0 +1,64 @@
+//  Copyright (c) 2013 The 11ers. All rights reserved.
+
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <stddef.h>
+
+
+// Sampling stall detector for the UI thread.
+//
+// Call WatchdogBeat once per frame from the UI thread, typically at the
+// top of App::Step and App::Draw. A background thread samples the time
+// since the last beat and, when it exceeds the threshold, reports the
+// stack of StallZones the UI thread is inside, e.g. a lock acquisition,
+// a blocking load or a decode. Each stalled frame is reported once.
+//
+// Beats and zones are a few stores with no locks or system calls, so the
+// watchdog is cheap enough to leave enabled in production builds. Zones
+// opened on threads other than the UI thread are ignored. Zone names
+// must be string literals, or otherwise outlive the watchdog.
+
+namespace mt {
+
+
+static const int kMaxStallZoneDepth = 16;
+
+
+struct StallReport {
+  double stallSec;                                    // Since last beat
+  unsigned long frame;                                // Beat count
+  int zoneDepth;                                      // Nested zone count
+  const char *zone[kMaxStallZoneDepth];               // Outermost first
+};
+
+typedef void (*StallFunc)(const StallReport &report, void *data);
+
+
+// Start the watchdog thread. Reports are delivered on the watchdog thread,
+// printed to stdout if func is NULL. Returns false if already running.
+bool StartWatchdog(double thresholdSec, StallFunc func = 0, void *data = 0,
+                   double sampleSec = 0.005);
+void StopWatchdog();                                  // Blocks until exit
+bool IsWatchdogRunning();
+
+void WatchdogBeat();                                  // UI thread, per frame
+unsigned long StallCount();                           // Reported stalls
+
+
+// Marks a region of UI thread work, named in any stall report
+class StallZone {
+public:
+  explicit StallZone(const char *name);
+  ~StallZone();
+  
+private:
+  StallZone(const StallZone &);                       // Disallow copy
+  void operator=(const StallZone &);                  // Disallow assignment
+  bool mIsPushed;
+};
+
+
+}       // namespace mt
+
+#endif  // WATCHDOG_H
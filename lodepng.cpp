@@ -33,6 +33,12 @@ Rename this file to lodepng.cpp to use it for C++, or to lodepng.c to use it for
 #include <stdio.h>
 #include <stdlib.h>
 
+#ifdef __cplusplus
+#include "MappedFile.h"
+#include "Memory.h"
+#include "Watchdog.h"
+#endif /*__cplusplus*/
+
 #ifdef LODEPNG_COMPILE_CPP
 #include <fstream>
 #endif /*LODEPNG_COMPILE_CPP*/
@@ -404,14 +410,43 @@ static unsigned char readBitFromStream(size_t* bitpointer, const unsigned char*
   return result;
 }
 
-static unsigned readBitsFromStream(size_t* bitpointer, const unsigned char* bitstream, size_t nbits)
-{
-  unsigned result = 0, i;
-  for(i = 0; i < nbits; i++)
+/*
+Returns the bits of the stream from bitpointer on, the first in the least
+significant bit, with one 64-bit read where the input allows it. At least
+57 bits are valid: past the end of the stream, the bits are zero.
+*/
+static inline unsigned long long peekBits(const unsigned char* bitstream, size_t bitpointer, size_t inlength)
+{
+  size_t start = bitpointer >> 3, i;
+  unsigned long long result = 0;
+  if(start + 8 <= inlength)
+  {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(&result, bitstream + start, 8); /*a single unaligned load*/
+#else
+    result = (unsigned long long)bitstream[start]
+           | ((unsigned long long)bitstream[start + 1] << 8)
+           | ((unsigned long long)bitstream[start + 2] << 16)
+           | ((unsigned long long)bitstream[start + 3] << 24)
+           | ((unsigned long long)bitstream[start + 4] << 32)
+           | ((unsigned long long)bitstream[start + 5] << 40)
+           | ((unsigned long long)bitstream[start + 6] << 48)
+           | ((unsigned long long)bitstream[start + 7] << 56);
+#endif
+  }
+  else
   {
-    result += ((unsigned)READBIT(*bitpointer, bitstream)) << i;
-    (*bitpointer)++;
+    for(i = 0; start + i < inlength; i++) result |= (unsigned long long)bitstream[start + i] << (8 * i);
   }
+  return result >> (bitpointer & 0x7);
+}
+
+/*reads up to 32 bits, which are zero past the end of the stream*/
+static unsigned readBitsFromStream(size_t* bitpointer, const unsigned char* bitstream, size_t inlength,
+                                   size_t nbits)
+{
+  unsigned result = (unsigned)peekBits(bitstream, *bitpointer, inlength) & (unsigned)((1ull << nbits) - 1u);
+  (*bitpointer) += nbits;
   return result;
 }
 #endif /*LODEPNG_COMPILE_DECODER*/
@@ -461,7 +496,8 @@ Huffman tree struct, containing multiple representations of the tree
 */
 typedef struct HuffmanTree
 {
-  unsigned* tree2d;
+  unsigned char* table_len; /*the decoder's lookup tables, see HuffmanTree_makeTable*/
+  unsigned short* table_value;
   unsigned* tree1d;
   unsigned* lengths; /*the lengths of the codes of the 1d-tree*/
   unsigned maxbitlen; /*maximum number of bits a single code can get*/
@@ -483,73 +519,116 @@ static void HuffmanTree_draw(HuffmanTree* tree)
 
 static void HuffmanTree_init(HuffmanTree* tree)
 {
-  tree->tree2d = 0;
+  tree->table_len = 0;
+  tree->table_value = 0;
   tree->tree1d = 0;
   tree->lengths = 0;
 }
 
 static void HuffmanTree_cleanup(HuffmanTree* tree)
 {
-  free(tree->tree2d);
+  free(tree->table_len);
+  free(tree->table_value);
   free(tree->tree1d);
   free(tree->lengths);
 }
 
-/*the tree representation used by the decoder. return value is error*/
-static unsigned HuffmanTree_make2DTree(HuffmanTree* tree)
+/*
+The tree representation used by the decoder: lookup tables instead of a
+tree walked one bit at a time. The first FIRSTBITS bits of the stream index
+the root table. Deflate stores codes from their most significant bit, so the
+tables are indexed by reversed codes. A code of at most FIRSTBITS bits fills
+every root entry it starts, with its symbol and length. Longer codes that
+share their first FIRSTBITS bits share a root entry, which holds the length
+of the longest of them and the position of their subtable, indexed by the
+following bits. Entries of no code, as in incomplete trees, have length 0
+and symbol INVALIDSYMBOL.
+*/
+#define FIRSTBITS 9u
+#define INVALIDSYMBOL 65535u
+
+static unsigned reverseBits(unsigned bits, unsigned num)
 {
-  unsigned nodefilled = 0; /*up to which node it is filled*/
-  unsigned treepos = 0; /*position in the tree (1 of the numcodes columns)*/
-  unsigned n, i;
+  unsigned i, result = 0;
+  for(i = 0; i < num; i++) result |= ((bits >> (num - i - 1)) & 1u) << i;
+  return result;
+}
 
-  tree->tree2d = (unsigned*)malloc(tree->numcodes * 2 * sizeof(unsigned));
-  if(!tree->tree2d) return 83; /*alloc fail*/
+/*return value is error*/
+static unsigned HuffmanTree_makeTable(HuffmanTree* tree)
+{
+  static const unsigned headsize = 1u << FIRSTBITS;
+  static const unsigned mask = (1u << FIRSTBITS) - 1u;
+  unsigned maxlens[1u << FIRSTBITS]; /*longest code of each root entry*/
+  unsigned long kraft = 0;
+  size_t size = headsize, pointer, i;
+  unsigned index;
 
-  /*
-  convert tree1d[] to tree2d[][]. In the 2D array, a value of 32767 means
-  uninited, a value >= numcodes is an address to another bit, a value < numcodes
-  is a code. The 2 rows are the 2 possible bit values (0 or 1), there are as
-  many columns as codes - 1.
-  A good huffmann tree has N * 2 - 1 nodes, of which N - 1 are internal nodes.
-  Here, the internal nodes are stored (what their 0 and 1 option point to).
-  There is only memory for such good tree currently, if there are more nodes
-  (due to too long length codes), error 55 will happen
-  */
-  for(n = 0; n < tree->numcodes * 2; n++)
+  /*oversubscribed: more codes than fit in their lengths, see comment in lodepng_error_text*/
+  for(i = 0; i < tree->numcodes; i++)
   {
-    tree->tree2d[n] = 32767; /*32767 here means the tree2d isn't filled there yet*/
+    if(tree->lengths[i] > 15) return 55;
+    if(tree->lengths[i]) kraft += 1ul << (15 - tree->lengths[i]);
   }
+  if(kraft > (1ul << 15)) return 55;
 
-  for(n = 0; n < tree->numcodes; n++) /*the codes*/
+  /*size the subtables, by the longest code starting in each root entry*/
+  for(i = 0; i < headsize; i++) maxlens[i] = 0;
+  for(i = 0; i < tree->numcodes; i++)
   {
-    for(i = 0; i < tree->lengths[n]; i++) /*the bits for this code*/
+    unsigned l = tree->lengths[i];
+    if(l <= FIRSTBITS) continue;
+    index = reverseBits(tree->tree1d[i] >> (l - FIRSTBITS), FIRSTBITS);
+    if(maxlens[index] < l) maxlens[index] = l;
+  }
+  for(i = 0; i < headsize; i++)
+  {
+    if(maxlens[i]) size += (size_t)1 << (maxlens[i] - FIRSTBITS);
+  }
+
+  tree->table_len = (unsigned char*)malloc(size * sizeof(unsigned char));
+  tree->table_value = (unsigned short*)malloc(size * sizeof(unsigned short));
+  if(!tree->table_len || !tree->table_value) return 83; /*alloc fail*/
+  for(i = 0; i < size; i++)
+  {
+    tree->table_len[i] = 0;
+    tree->table_value[i] = INVALIDSYMBOL;
+  }
+
+  /*root entries of long codes point to their subtables*/
+  pointer = headsize;
+  for(i = 0; i < headsize; i++)
+  {
+    if(!maxlens[i]) continue;
+    tree->table_len[i] = (unsigned char)maxlens[i];
+    tree->table_value[i] = (unsigned short)pointer;
+    pointer += (size_t)1 << (maxlens[i] - FIRSTBITS);
+  }
+
+  /*each code fills the entries that start with it, the codes being prefix free*/
+  for(i = 0; i < tree->numcodes; i++)
+  {
+    unsigned l = tree->lengths[i], reverse;
+    if(!l) continue;
+    reverse = reverseBits(tree->tree1d[i], l);
+    if(l <= FIRSTBITS)
     {
-      unsigned char bit = (unsigned char)((tree->tree1d[n] >> (tree->lengths[n] - i - 1)) & 1);
-      if(treepos > tree->numcodes - 2) return 55; /*oversubscribed, see comment in lodepng_error_text*/
-      if(tree->tree2d[2 * treepos + bit] == 32767) /*not yet filled in*/
+      for(index = reverse; index < headsize; index += 1u << l)
       {
-        if(i + 1 == tree->lengths[n]) /*last bit*/
-        {
-          tree->tree2d[2 * treepos + bit] = n; /*put the current code in it*/
-          treepos = 0;
-        }
-        else
-        {
-          /*put address of the next step in here, first that address has to be found of course
-          (it's just nodefilled + 1)...*/
-          nodefilled++;
-          /*addresses encoded with numcodes added to it*/
-          tree->tree2d[2 * treepos + bit] = nodefilled + tree->numcodes;
-          treepos = nodefilled;
-        }
+        tree->table_len[index] = (unsigned char)l;
+        tree->table_value[index] = (unsigned short)i;
+      }
+    }
+    else
+    {
+      unsigned start = tree->table_value[reverse & mask];
+      unsigned subsize = 1u << (tree->table_len[reverse & mask] - FIRSTBITS);
+      for(index = reverse >> FIRSTBITS; index < subsize; index += 1u << (l - FIRSTBITS))
+      {
+        tree->table_len[start + index] = (unsigned char)l;
+        tree->table_value[start + index] = (unsigned short)i;
       }
-      else treepos = tree->tree2d[2 * treepos + bit] - tree->numcodes;
     }
-  }
-
-  for(n = 0;  n < tree->numcodes * 2; n++)
-  {
-    if(tree->tree2d[n] == 32767) tree->tree2d[n] = 0; /*remove possible remaining 32767's*/
   }
 
   return 0;
@@ -595,7 +674,7 @@ static unsigned HuffmanTree_makeFromLengths2(HuffmanTree* tree)
   uivector_cleanup(&blcount);
   uivector_cleanup(&nextcode);
 
-  if(!error) return HuffmanTree_make2DTree(tree);
+  if(!error) return HuffmanTree_makeTable(tree);
   else return error;
 }
 
@@ -884,6 +963,25 @@ static unsigned generateFixedDistanceTree(HuffmanTree* tree)
 
 #ifdef LODEPNG_COMPILE_DECODER
 
+/*
+Looks up the symbol whose code starts bits, storing the length of the code
+in len. Returns INVALIDSYMBOL, with len 0, if no code of the tree does.
+*/
+static inline unsigned huffmanLookup(const HuffmanTree* codetree, unsigned long long bits, unsigned* len)
+{
+  unsigned index = (unsigned)bits & ((1u << FIRSTBITS) - 1u);
+  unsigned l = codetree->table_len[index];
+  unsigned value = codetree->table_value[index];
+  if(l > FIRSTBITS) /*value is the position of the subtable*/
+  {
+    index = value + ((unsigned)(bits >> FIRSTBITS) & ((1u << (l - FIRSTBITS)) - 1u));
+    l = codetree->table_len[index];
+    value = codetree->table_value[index];
+  }
+  *len = l;
+  return value;
+}
+
 /*
 returns the code, or (unsigned)(-1) if error happened
 inbitlength is the length of the complete buffer, in bits (so its byte length times 8)
@@ -891,21 +989,12 @@ inbitlength is the length of the complete buffer, in bits (so its byte length ti
 static unsigned huffmanDecodeSymbol(const unsigned char* in, size_t* bp,
                                     const HuffmanTree* codetree, size_t inbitlength)
 {
-  unsigned treepos = 0, ct;
-  for(;;)
-  {
-    if(*bp >= inbitlength) return (unsigned)(-1); /*error: end of input memory reached without endcode*/
-    /*
-    decode the symbol from the tree. The "readBitFromStream" code is inlined in
-    the expression below because this is the biggest bottleneck while decoding
-    */
-    ct = codetree->tree2d[(treepos << 1) + READBIT(*bp, in)];
-    (*bp)++;
-    if(ct < codetree->numcodes) return ct; /*the symbol is decoded, return it*/
-    else treepos = ct - codetree->numcodes; /*symbol not yet decoded, instead move tree position*/
-
-    if(treepos >= codetree->numcodes) return (unsigned)(-1); /*error: it appeared outside the codetree*/
-  }
+  unsigned len;
+  unsigned code = huffmanLookup(codetree, peekBits(in, *bp, inbitlength >> 3), &len);
+  if(code == INVALIDSYMBOL) return (unsigned)(-1); /*error: no code of the tree starts here*/
+  (*bp) += len;
+  if(*bp > inbitlength) return (unsigned)(-1); /*error: end of input memory reached without endcode*/
+  return code;
 }
 #endif /*LODEPNG_COMPILE_DECODER*/
 
@@ -942,11 +1031,11 @@ static unsigned getTreeInflateDynamic(HuffmanTree* tree_ll, HuffmanTree* tree_d,
   if((*bp) >> 3 >= inlength - 2) return 49; /*error: the bit pointer is or will go past the memory*/
 
   /*number of literal/length codes + 257. Unlike the spec, the value 257 is added to it here already*/
-  HLIT =  readBitsFromStream(bp, in, 5) + 257;
+  HLIT =  readBitsFromStream(bp, in, inlength, 5) + 257;
   /*number of distance codes. Unlike the spec, the value 1 is added to it here already*/
-  HDIST = readBitsFromStream(bp, in, 5) + 1;
+  HDIST = readBitsFromStream(bp, in, inlength, 5) + 1;
   /*number of code length codes. Unlike the spec, the value 4 is added to it here already*/
-  HCLEN = readBitsFromStream(bp, in, 4) + 4;
+  HCLEN = readBitsFromStream(bp, in, inlength, 4) + 4;
 
   HuffmanTree_init(&tree_cl);
   uivector_init(&bitlen_ll);
@@ -961,7 +1050,7 @@ static unsigned getTreeInflateDynamic(HuffmanTree* tree_ll, HuffmanTree* tree_d,
 
     for(i = 0; i < NUM_CODE_LENGTH_CODES; i++)
     {
-      if(i < HCLEN) bitlen_cl.data[CLCL_ORDER[i]] = readBitsFromStream(bp, in, 3);
+      if(i < HCLEN) bitlen_cl.data[CLCL_ORDER[i]] = readBitsFromStream(bp, in, inlength, 3);
       else bitlen_cl.data[CLCL_ORDER[i]] = 0; /*if not, it must stay 0*/
     }
 
@@ -992,7 +1081,7 @@ static unsigned getTreeInflateDynamic(HuffmanTree* tree_ll, HuffmanTree* tree_d,
         if(*bp >= inbitlength) ERROR_BREAK(50); /*error, bit pointer jumps past memory*/
         if (i == 0) ERROR_BREAK(54); /*can't repeat previous if i is 0*/
 
-        replength += readBitsFromStream(bp, in, 2);
+        replength += readBitsFromStream(bp, in, inlength, 2);
 
         if(i < HLIT + 1) value = bitlen_ll.data[i - 1];
         else value = bitlen_d.data[i - HLIT - 1];
@@ -1010,7 +1099,7 @@ static unsigned getTreeInflateDynamic(HuffmanTree* tree_ll, HuffmanTree* tree_d,
         unsigned replength = 3; /*read in the bits that indicate repeat length*/
         if(*bp >= inbitlength) ERROR_BREAK(50); /*error, bit pointer jumps past memory*/
 
-        replength += readBitsFromStream(bp, in, 3);
+        replength += readBitsFromStream(bp, in, inlength, 3);
 
         /*repeat this value in the next lengths*/
         for(n = 0; n < replength; n++)
@@ -1027,7 +1116,7 @@ static unsigned getTreeInflateDynamic(HuffmanTree* tree_ll, HuffmanTree* tree_d,
         unsigned replength = 11; /*read in the bits that indicate repeat length*/
         if(*bp >= inbitlength) ERROR_BREAK(50); /*error, bit pointer jumps past memory*/
 
-        replength += readBitsFromStream(bp, in, 7);
+        replength += readBitsFromStream(bp, in, inlength, 7);
 
         /*repeat this value in the next lengths*/
         for(n = 0; n < replength; n++)
@@ -1091,8 +1180,17 @@ static unsigned inflateHuffmanBlock(ucvector* out, const unsigned char* in, size
 
   while(!error) /*decode all symbols until end reached, breaks at end code*/
   {
+    /*
+    one peek holds a length and a distance with their extra bits, at most
+    15 + 5 + 15 + 13 = 48 bits, so the bits are only read once per symbol
+    */
+    unsigned long long bits = peekBits(in, *bp, inlength);
+    unsigned len;
     /*code_ll is literal, length or end code*/
-    unsigned code_ll = huffmanDecodeSymbol(in, bp, &tree_ll, inbitlength);
+    unsigned code_ll = huffmanLookup(&tree_ll, bits, &len);
+    bits >>= len;
+    (*bp) += len;
+    if(*bp > inbitlength) ERROR_BREAK(10); /*error: end of input memory reached without endcode*/
     if(code_ll <= 255) /*literal symbol*/
     {
       if((*pos) >= out->size)
@@ -1105,7 +1203,7 @@ static unsigned inflateHuffmanBlock(ucvector* out, const unsigned char* in, size
     }
     else if(code_ll >= FIRST_LENGTH_CODE_INDEX && code_ll <= LAST_LENGTH_CODE_INDEX) /*length code*/
     {
-      unsigned code_d, distance;
+      unsigned code_d, distance, len_d;
       unsigned numextrabits_l, numextrabits_d; /*extra bits for length and distance*/
       size_t start, forward, backward, length;
 
@@ -1114,19 +1212,15 @@ static unsigned inflateHuffmanBlock(ucvector* out, const unsigned char* in, size
 
       /*part 2: get extra bits and add the value of that to length*/
       numextrabits_l = LENGTHEXTRA[code_ll - FIRST_LENGTH_CODE_INDEX];
-      if(*bp >= inbitlength) ERROR_BREAK(51); /*error, bit pointer will jump past memory*/
-      length += readBitsFromStream(bp, in, numextrabits_l);
+      length += (unsigned)bits & ((1u << numextrabits_l) - 1u);
+      bits >>= numextrabits_l;
 
       /*part 3: get distance code*/
-      code_d = huffmanDecodeSymbol(in, bp, &tree_d, inbitlength);
+      code_d = huffmanLookup(&tree_d, bits, &len_d);
+      bits >>= len_d;
       if(code_d > 29)
       {
-        if(code_ll == (unsigned)(-1)) /*huffmanDecodeSymbol returns (unsigned)(-1) in case of error*/
-        {
-          /*return error code 10 or 11 depending on the situation that happened in huffmanDecodeSymbol
-          (10=no endcode, 11=wrong jump outside of tree)*/
-          error = (*bp) > inlength * 8 ? 10 : 11;
-        }
+        if(code_d == INVALIDSYMBOL) error = 11; /*error: no code of the distance tree*/
         else error = 18; /*error: invalid distance code (30-31 are never used)*/
         break;
       }
@@ -1134,9 +1228,10 @@ static unsigned inflateHuffmanBlock(ucvector* out, const unsigned char* in, size
 
       /*part 4: get extra bits from distance*/
       numextrabits_d = DISTANCEEXTRA[code_d];
-      if(*bp >= inbitlength) ERROR_BREAK(51); /*error, bit pointer will jump past memory*/
+      distance += (unsigned)bits & ((1u << numextrabits_d) - 1u);
 
-      distance += readBitsFromStream(bp, in, numextrabits_d);
+      (*bp) += numextrabits_l + len_d + numextrabits_d;
+      if(*bp > inbitlength) ERROR_BREAK(51); /*error, bit pointer will jump past memory*/
 
       /*part 5: fill in all the out[n] values based on the length and dist*/
       start = (*pos);
@@ -1148,23 +1243,25 @@ static unsigned inflateHuffmanBlock(ucvector* out, const unsigned char* in, size
         if(!ucvector_resize(out, ((*pos) + length) * 2)) ERROR_BREAK(83 /*alloc fail*/);
       }
 
-      for(forward = 0; forward < length; forward++)
+      /*
+      if distance < length, the copy overlaps its output, repeating the last
+      distance bytes: copy the repeats already written, doubling each time
+      */
+      while(length > 0)
       {
-        out->data[(*pos)] = out->data[backward];
-        (*pos)++;
-        backward++;
-        if(backward >= start) backward = start - distance;
+        forward = (*pos) - backward < length ? (*pos) - backward : length;
+        memcpy(out->data + (*pos), out->data + backward, forward);
+        (*pos) += forward;
+        length -= forward;
       }
     }
     else if(code_ll == 256)
     {
       break; /*end code, break the loop*/
     }
-    else /*if(code == (unsigned)(-1))*/ /*huffmanDecodeSymbol returns (unsigned)(-1) in case of error*/
+    else /*if(code_ll == INVALIDSYMBOL)*/
     {
-      /*return error code 10 or 11 depending on the situation that happened in huffmanDecodeSymbol
-      (10=no endcode, 11=wrong jump outside of tree)*/
-      error = (*bp) > inlength * 8 ? 10 : 11;
+      error = 11; /*error: no code of the literal/length tree starts here, or an unused code 286-287*/
       break;
     }
   }
@@ -4365,6 +4462,9 @@ unsigned lodepng_decode(unsigned char** out, unsigned* w, unsigned* h,
                         LodePNGState* state,
                         const unsigned char* in, size_t insize)
 {
+#ifdef __cplusplus
+  mt::StallZone zone("lodepng_decode");
+#endif /*__cplusplus*/
   *out = 0;
   decodeGeneric(out, w, h, state, in, insize);
   if(state->error) return state->error;
@@ -4402,9 +4502,24 @@ unsigned lodepng_decode(unsigned char** out, unsigned* w, unsigned* h,
     else state->error = lodepng_convert(*out, data, &state->info_raw, &state->info_png.color, *w, *h);
     free(data);
   }
+#ifdef __cplusplus
+  /*account for the image until it is released with lodepng_free_decoded*/
+  if(!state->error && *out)
+  {
+    mem::Track(mem::DecodedImage, (uintptr_t)*out, lodepng_get_raw_size(*w, *h, &state->info_raw));
+  }
+#endif /*__cplusplus*/
   return state->error;
 }
 
+void lodepng_free_decoded(unsigned char* image)
+{
+#ifdef __cplusplus
+  mem::Untrack(mem::DecodedImage, (uintptr_t)image);
+#endif /*__cplusplus*/
+  free(image);
+}
+
 unsigned lodepng_decode_memory(unsigned char** out, unsigned* w, unsigned* h, const unsigned char* in,
                                size_t insize, LodePNGColorType colortype, unsigned bitdepth)
 {
@@ -4432,6 +4547,12 @@ unsigned lodepng_decode24(unsigned char** out, unsigned* w, unsigned* h, const u
 unsigned lodepng_decode_file(unsigned char** out, unsigned* w, unsigned* h, const char* filename,
                              LodePNGColorType colortype, unsigned bitdepth)
 {
+#ifdef __cplusplus
+  /*decode straight from a mapping of the file, without reading it into a copy*/
+  MappedFile file;
+  if(!file.Open(filename, MappedFile::ReadOnly, MappedFile::Sequential)) return 78;
+  return lodepng_decode_memory(out, w, h, file.Data(), file.Size(), colortype, bitdepth);
+#else /*__cplusplus*/
   unsigned char* buffer;
   size_t buffersize;
   unsigned error;
@@ -4439,6 +4560,7 @@ unsigned lodepng_decode_file(unsigned char** out, unsigned* w, unsigned* h, cons
   if(!error) error = lodepng_decode_memory(out, w, h, buffer, buffersize, colortype, bitdepth);
   free(buffer);
   return error;
+#endif /*__cplusplus*/
 }
 
 unsigned lodepng_decode32_file(unsigned char** out, unsigned* w, unsigned* h, const char* filename)
@@ -5676,7 +5798,7 @@ unsigned decode(std::vector<unsigned char>& out, unsigned& w, unsigned& h, const
     state.info_raw.bitdepth = bitdepth;
     size_t buffersize = lodepng_get_raw_size(w, h, &state.info_raw);
     out.insert(out.end(), &buffer[0], &buffer[buffersize]);
-    free(buffer);
+    lodepng_free_decoded(buffer);
   }
   return error;
 }
@@ -5697,7 +5819,7 @@ unsigned decode(std::vector<unsigned char>& out, unsigned& w, unsigned& h,
   {
     size_t buffersize = lodepng_get_raw_size(w, h, &state.info_raw);
     out.insert(out.end(), &buffer[0], &buffer[buffersize]);
-    free(buffer);
+    lodepng_free_decoded(buffer);
   }
   return error;
 }
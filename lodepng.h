@@ -75,7 +75,8 @@ Converts PNG data in memory to raw pixel data.
 out: Output parameter. Pointer to buffer that will contain the raw pixel data.
      After decoding, its size is w * h * (bytes per pixel) bytes larger than
      initially. Bytes per pixel depends on colortype and bitdepth.
-     Must be freed after usage with free(*out).
+     Must be freed after usage with lodepng_free_decoded, not free(*out), which
+     would leave it in the memory accounting (see Memory.h).
 w: Output parameter. Pointer to width of pixel data.
 h: Output parameter. Pointer to height of pixel data.
 in: Memory buffer with the PNG file.
@@ -96,10 +97,15 @@ unsigned lodepng_decode32(unsigned char** out, unsigned* w, unsigned* h,
 unsigned lodepng_decode24(unsigned char** out, unsigned* w, unsigned* h,
                           const unsigned char* in, size_t insize);
 
+/*Frees a raw image returned by any of the decode functions and removes it from
+the mem::DecodedImage accounting category*/
+void lodepng_free_decoded(unsigned char* image);
+
 #ifdef LODEPNG_COMPILE_DISK
 /*
 Load PNG from disk, from file with given name.
 Same as the other decode functions, but instead takes a filename as input.
+In C++, the file is mapped into memory (MappedFile.h) rather than read into a copy.
 */
 unsigned lodepng_decode_file(unsigned char** out, unsigned* w, unsigned* h,
                              const char* filename,
@@ -917,8 +923,10 @@ The following features are _not_ supported:
 --------------------
 
 The C version uses buffers allocated with alloc that you need to free()
-yourself. You need to use init and cleanup functions for each struct whenever
-using a struct from the C version to avoid exploits and memory leaks.
+yourself, except for decoded images, which are released with
+lodepng_free_decoded. You need to use init and cleanup functions for each
+struct whenever using a struct from the C version to avoid exploits and
+memory leaks.
 
 The C++ version has extra functions with std::vectors in the interface and the
 lodepng::State class which is a LodePNGState with constructor and destructor.
@@ -1424,7 +1432,7 @@ int main(int argc, char *argv[])
 
   / * use image here * /
 
-  free(image);
+  lodepng_free_decoded(image);
   return 0;
 }
 